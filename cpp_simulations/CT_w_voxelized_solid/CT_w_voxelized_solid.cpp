@@ -1,11 +1,9 @@
 #include <MIDSX/Core.h>
-#include <pybind11/embed.h>
 #include <numeric>
 #include <chrono>
 #include <iomanip>
 #include <omp.h>
 
-namespace py = pybind11;
 
 Eigen::Vector3d dim_space = Eigen::Vector3d(120.0, 120.0, 26.0);
 Eigen::Vector3d body_origin = Eigen::Vector3d(44.0, 35.0, 0.0);
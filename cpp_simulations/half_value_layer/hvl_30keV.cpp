@@ -1,10 +1,8 @@
 #include <MIDSX/Core.h>
-#include <pybind11/embed.h>
 #include <numeric>
 #include <iomanip>
 #include <omp.h>
 
-namespace py = pybind11;
 
 std::vector<std::unique_ptr<SurfaceTally>> initializeSurfaceTallies() {
     std::vector<std::unique_ptr<SurfaceTally>> tallies = {};
@@ -13,7 +11,7 @@ std::vector<std::unique_ptr<SurfaceTally>> initializeSurfaceTallies() {
             Eigen::Vector3d(2, 2, 100),
             Eigen::Vector3d(0, 0, 1),
             1.0,
-            SurfaceQuantityContainerFactory::AllQuantities()));
+            SurfaceQuantityContainerFactory::AllQuantities(true)));
     return tallies;
 }
 
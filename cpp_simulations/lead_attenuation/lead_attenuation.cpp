@@ -1,11 +1,9 @@
 #include <MIDSX/Core.h>
-#include <pybind11/embed.h>
 #include <numeric>
 #include <chrono>
 #include <iomanip>
 #include <omp.h>
 
-namespace py = pybind11;
 
 struct DIM {
     static constexpr const double X = 10.7;
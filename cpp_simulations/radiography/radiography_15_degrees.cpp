@@ -1,11 +1,9 @@
 #include <MIDSX/Core.h>
-#include <pybind11/embed.h>
 #include <numeric>
 #include <chrono>
 #include <iomanip>
 #include <omp.h>
 
-namespace py = pybind11;
 
 Eigen::Vector3d body_origin(28.730854637602084, 28.730854637602084, 155.0);
 Eigen::Vector3d dim_space(96.46170927520417, 96.46170927520417, 180.0);
@@ -0,0 +1,183 @@
+#include <MIDSX/Core.h>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Compares the linear and bricked voxel layouts on the TG-195 Case 5 volume (320 x 500 x 260 voxels of 1 mm).
+// Run from the directory containing this file. Hardware counters are read with perf_event_open, and are reported as
+// n/a if the kernel does not allow it (see /proc/sys/kernel/perf_event_paranoid).
+
+const std::string voxel_file_path = "../../data/voxels/TG_195_Case_5_Voxelized_Volume.nii.gz";
+const long long N_lookups = 10000000;
+const int N_repeats = 5; // the fastest repeat is reported, as the slower ones are disturbed by other processes
+const double mean_step_lengths[] = {0.1, 1.0}; // cm, about the mean free path between lookups of delta tracking
+
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~PerfCounter() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    void start() {
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    // number of events since start, or -1 if the counter is not available
+    long long stop() {
+        long long count = -1;
+        if (fd_ < 0) {
+            return count;
+        }
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+            return -1;
+        }
+        return count;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+struct BenchmarkResult {
+    double seconds = 0.0;
+    long long l1d_misses = -1;
+    long long llc_misses = -1;
+    long long checksum = 0; // sum of the material indices looked up, which must not depend on the layout
+    double position_sum = 0.0; // keeps the positions of the baseline from being optimized away
+};
+
+// Looks up the voxels along straight tracks with exponentially distributed steps, restarting from a uniformly random
+// position and direction whenever a track leaves the grid. A mean step of 0 looks up uniformly random voxels instead.
+// Each voxel looked up gets a deposit, as in the transport of a photon in a grid which scores dose. The baseline only
+// samples the positions, and its time is subtracted so that the throughput is that of the lookups alone.
+BenchmarkResult runLookups(VoxelGrid& voxel_grid, double mean_step_length, bool is_baseline) {
+    std::mt19937_64 rng(12345);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::exponential_distribution<double> step(mean_step_length > 0 ? 1.0 / mean_step_length : 1.0);
+    const Eigen::Vector3d dim_space = voxel_grid.getDimSpace();
+    auto random_position = [&]() -> Eigen::Vector3d {
+        return Eigen::Vector3d(uniform(rng), uniform(rng), uniform(rng)).cwiseProduct(dim_space);
+    };
+    auto random_direction = [&]() -> Eigen::Vector3d {
+        double cos_theta = 2.0 * uniform(rng) - 1.0;
+        double phi = 2.0 * PI * uniform(rng);
+        double sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
+        return Eigen::Vector3d(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+    };
+
+    PerfCounter l1d_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    PerfCounter llc_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    BenchmarkResult result;
+    Eigen::Vector3d position = random_position();
+    Eigen::Vector3d direction = random_direction();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    l1d_counter.start();
+    llc_counter.start();
+    for (long long i = 0; i < N_lookups; i++) {
+        if (mean_step_length > 0) {
+            position += step(rng) * direction;
+            if (!voxel_grid.withinGrid(position)) {
+                position = random_position();
+                direction = random_direction();
+            }
+        }
+        else {
+            position = random_position();
+        }
+        if (is_baseline) {
+            result.position_sum += position[0];
+            continue;
+        }
+        Voxel voxel = voxel_grid.getVoxelUnchecked(position);
+        voxel.dose_grid->addValue(voxel.voxel_number, 1.0);
+        result.checksum += voxel.materialID;
+    }
+    result.llc_misses = llc_counter.stop();
+    result.l1d_misses = l1d_counter.stop();
+    auto end = std::chrono::high_resolution_clock::now();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    return result;
+}
+
+std::string formatMisses(long long misses) {
+    if (misses < 0) {
+        return "n/a";
+    }
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(3) << static_cast<double>(misses) / N_lookups;
+    return stream.str();
+}
+
+void displayResult(const std::string& layout_name, double mean_step_length, const BenchmarkResult& result,
+                   const BenchmarkResult& baseline) {
+    std::cout << std::left << std::setw(10) << layout_name
+              << std::setw(16) << (mean_step_length > 0 ? std::to_string(mean_step_length).substr(0, 4) + " cm" : "random")
+              << std::setw(16) << std::fixed << std::setprecision(2) << N_lookups / (result.seconds - baseline.seconds) / 1E6
+              << std::setw(16) << formatMisses(result.l1d_misses)
+              << std::setw(16) << formatMisses(result.llc_misses)
+              << result.checksum << std::endl;
+}
+
+int main() {
+    std::vector<std::pair<std::string, VoxelLayout>> layouts = {{"linear", VoxelLayout::LINEAR},
+                                                                {"bricked", VoxelLayout::BRICKED}};
+    std::vector<double> step_lengths(std::begin(mean_step_lengths), std::end(mean_step_lengths));
+    step_lengths.push_back(0.0);
+    std::vector<BenchmarkResult> baselines;
+    auto run_fastest = [](VoxelGrid& voxel_grid, double mean_step_length, bool is_baseline) {
+        BenchmarkResult fastest = runLookups(voxel_grid, mean_step_length, is_baseline);
+        for (int i = 1; i < N_repeats; i++) {
+            BenchmarkResult result = runLookups(voxel_grid, mean_step_length, is_baseline);
+            if (result.seconds < fastest.seconds) {
+                fastest = result;
+            }
+        }
+        return fastest;
+    };
+
+    std::cout << std::left << std::setw(10) << "Layout" << std::setw(16) << "Mean step" << std::setw(16) << "Mlookups/s"
+              << std::setw(16) << "L1d miss/lookup" << std::setw(16) << "LLC miss/lookup" << "Checksum" << std::endl;
+    for (auto& layout : layouts) {
+        auto load_start = std::chrono::high_resolution_clock::now();
+        VoxelGrid voxel_grid(voxel_file_path, "", layout.second);
+        // the dose grid is stored in the same layout as the material IDs
+        voxel_grid.enableDoseScoring();
+        auto load_end = std::chrono::high_resolution_clock::now();
+        std::cout << layout.first << " load time: " << std::chrono::duration<double>(load_end - load_start).count() << " s" << std::endl;
+
+        for (size_t i = 0; i < step_lengths.size(); i++) {
+            if (baselines.size() == i) {
+                baselines.push_back(run_fastest(voxel_grid, step_lengths[i], true));
+            }
+            BenchmarkResult result = run_fastest(voxel_grid, step_lengths[i], false);
+            displayResult(layout.first, step_lengths[i], result, baselines[i]);
+        }
+    }
+    return 0;
+}
@@ -3,18 +3,21 @@
 
 #include "Core/constants.h"
 #include "Core/data_access_object.h"
+#include "Core/element_database.h"
 #include "Core/interaction_data.h"
 #include "Core/interpolators.h"
 #include "Core/material_data.h"
 #include "Core/material.h"
 #include "Core/material_helpers.h"
 #include "Core/material_properties.h"
+#include "Core/nifti_reader.h"
 #include "Core/particle.h"
 #include "Core/particle_interaction_behavior.h"
 #include "Core/photon.h"
 #include "Core/photon_interactions.h"
 #include "Core/physics_engine.h"
 #include "Core/probability_dist.h"
+#include "Core/table_cache.h"
 #include "Core/quantity.h"
 #include "Core/surface_quantity.h"
 #include "Core/surface_quantity_container.h"
@@ -24,10 +27,16 @@
 #include "Core/tally_data.h"
 #include "Core/surface_tally.h"
 #include "Core/volume_tally.h"
+#include "Core/voxel_file.h"
+#include "Core/primitive.h"
+#include "Core/tetrahedral_mesh.h"
+#include "Core/voxel_octree.h"
 #include "Core/voxel_grid.h"
 #include "Core/voxel.h"
 #include "Core/computational_domain.h"
 #include "Core/derived_quantities.h"
+#include "Core/dose_grid.h"
 #include "Core/run_simulation.h"
+#include "Core/batch_simulation.h"
 
 #endif //MCXRAYTRANSPORT_MIDSX_H
\ No newline at end of file
@@ -0,0 +1,73 @@
+/**
+ * @file batch_simulation.h
+ * @brief Contains the runBatchSimulation function, which transports one source through a series of phantoms.
+ */
+
+#ifndef MCXRAYTRANSPORT_BATCH_SIMULATION_H
+#define MCXRAYTRANSPORT_BATCH_SIMULATION_H
+
+#include "run_simulation.h"
+#include "computational_domain.h"
+#include "interaction_data.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Struct which holds a phantom of a batch, loaded and ready to be transported.
+ */
+struct BatchCase {
+    std::string json_file_path;
+    std::unique_ptr<ComputationalDomain> comp_domain;
+    std::unique_ptr<InteractionData> interaction_data;
+    double load_time = 0.0; // time taken to load the computational domain and build its interaction data (s)
+    double wait_time = 0.0; // time transport waited for the loading to finish, after the previous case was done (s)
+    double run_time = 0.0; // time taken to transport the photons (s)
+};
+
+/**
+ * @brief Struct which sums the times of the cases of a batch.
+ */
+struct BatchTimings {
+    double total_load_time = 0.0; // s
+    double total_wait_time = 0.0; // s
+    double total_run_time = 0.0; // s
+    double wall_time = 0.0; // s
+
+    /**
+     * @brief Gets the fraction of the load time which overlapped with transport.
+     *
+     * The first case cannot overlap, as there is nothing to transport while it loads.
+     *
+     * @return the fraction of the load time during which photons were being transported, from 0 to 1
+     */
+    double getOverlapFraction() const {
+        return total_load_time > 0 ? std::max(total_load_time - total_wait_time, 0.0) / total_load_time : 1.0;
+    }
+};
+
+/**
+ * @brief Helper function which runs the same simulation over a series of phantoms, loading each one while the previous one is transported.
+ *
+ * The computational domain and interaction data of case N+1 are built on a background thread while the photons of case
+ * N are transported with runSimulation, so the time spent decompressing voxel grids and building cross sections is
+ * hidden behind transport rather than added to it. At most two cases are in memory at once: each case is released
+ * after its results are processed. The load, wait and transport times of each case are printed as it finishes.
+ *
+ * @param json_file_paths The JSON files of the computational domains, in the order to transport them.
+ * @param source The photon source, which is used for every case.
+ * @param surface_tally_init A function which returns a vector of unique pointers to surface tallies. Called for each case.
+ * @param volume_tally_init A function which returns a vector of unique pointers to volume tallies. Called for each case.
+ * @param N_photons The number of photons to simulate per case.
+ * @param process_results A function which reads the results of a case from its computational domain and physics engine. Called on the calling thread after each case is transported.
+ * @return the total load, wait, transport and wall times of the batch
+ * @throws std::runtime_error If a computational domain cannot be loaded. The error is thrown when the case is reached.
+ */
+BatchTimings runBatchSimulation(const std::vector<std::string>& json_file_paths, PhotonSource& source,
+                                const std::function<std::vector<std::unique_ptr<SurfaceTally>>()>& surface_tally_init,
+                                const std::function<std::vector<std::unique_ptr<VolumeTally>>()>& volume_tally_init,
+                                int N_photons, const std::function<void(BatchCase&, PhysicsEngine&)>& process_results);
+
+#endif //MCXRAYTRANSPORT_BATCH_SIMULATION_H
@@ -2,10 +2,13 @@
 #define HVL_COMPUTATIONAL_DOMAIN_H
 
 #include "voxel_grid.h"
+#include "primitive.h"
+#include "tetrahedral_mesh.h"
 #include "json.h"
 #include "interaction_data.h"
 #include <vector>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 #include <filesystem>
 #include <fstream>
 
@@ -14,8 +17,10 @@ using json = nlohmann::json;
 /**
  * @brief Class which represents the computational domain.
  *
- * The computational domain is the space in which the simulation is run. It is composed of a set of voxel grids.
- * The domain is defined by a JSON file which specifies the voxel grid NIFTI files, origins, and dimensions.
+ * The computational domain is the space in which the simulation is run. It is composed of a set of voxel grids,
+ * tetrahedral meshes and analytic primitives (boxes, spheres, cylinders and slabs of one material).
+ * The domain is defined by a JSON file which specifies the voxel grid NIFTI files, origins, and dimensions, the mesh
+ * files and origins, and the shape and material of each primitive.
  * In addition, the JSON file specifies the background material and dimensions of the computational domain.
  */
 
@@ -26,9 +31,8 @@ public:
      * @brief Constructor for the ComputationalDomain class.
      *
      * @param json_file_path The path to the JSON file which defines the computational domain.
-     * @param is_python_environment True if the simulation is being run in a Python environment, false otherwise.
      */
-    explicit ComputationalDomain(const std::string &json_file_path, bool is_python_environment = false);
+    explicit ComputationalDomain(const std::string &json_file_path);
 
     /**
      * @brief Returns the interaction data generated by the materials in the computational domain.
@@ -37,6 +41,22 @@ public:
      */
     InteractionData getInteractionData() const;
 
+    /**
+     * @brief Returns the largest density scale factor of each material in the computational domain.
+     *
+     * @return A map of material ID to the largest density scale factor of the voxels of that material.
+     */
+    std::unordered_map<int, double> getMaxDensityScales() const;
+
+    /**
+     * @brief Returns the database material ID of each material index in the computational domain.
+     *
+     * The materialID of every voxel, including the background voxel (index 0), is an index into this vector.
+     *
+     * @return The database material IDs, indexed by the materialID of the voxels.
+     */
+    const std::vector<int>& getMaterialIds() const { return material_ids_; }
+
     /**
      * @brief Returns true if the position is within the computational domain, false otherwise.
      *
@@ -48,10 +68,68 @@ public:
     /**
      * @brief Returns the voxel at the given position.
      *
+     * The voxel grids, meshes and primitives which may contain the position are found in a uniform grid of cells over
+     * the computational domain, so the cost does not grow with their number. Voxel grids take precedence over meshes,
+     * which take precedence over primitives, and where bodies of the same kind overlap, the first one in the JSON file
+     * is used.
+     *
+     * @param position The position of the voxel.
+     * @return The voxel at the given position, or the background voxel if no voxel grid, mesh or primitive contains it.
+     */
+    Voxel getVoxel(const Eigen::Vector3d &position);
+
+    /**
+     * @brief Returns the voxel at the given position and the distance to the boundary of its homogeneous region.
+     *
+     * Within a homogeneous region (a primitive, a tetrahedron of a mesh, a node of one material and density of a voxel
+     * grid with an octree, or the background outside of the bounding boxes of every body), the total cross section of the
+     * voxel is a majorant up to the returned distance, so a photon can be transported to the boundary in one step.
+     * Positions in bodies whose bounding box overlaps that of one which takes precedence have no homogeneous region.
+     *
      * @param position The position of the voxel.
-     * @return The voxel at the given position.
+     * @param direction The unit direction of travel.
+     * @param voxel Set to the voxel at the position, as returned by getVoxel.
+     * @return The distance along the direction to the boundary of the homogeneous region (cm), or 0 if the position is in none.
      */
-    Voxel& getVoxel(const Eigen::Vector3d &position);
+    double getHomogeneousDistance(const Eigen::Vector3d &position, const Eigen::Vector3d &direction, Voxel &voxel);
+
+    /**
+     * @brief Returns the distance a photon travels through the background before it reaches the bounding box of a voxel grid, mesh or primitive.
+     *
+     * Only the bounding boxes are looked up, so this is cheaper than getHomogeneousDistance for positions within a
+     * voxel grid without an octree. The background voxel is a majorant up to the returned distance, so air gaps
+     * between the source, the voxel grids and the tallies are crossed in one step. The lookup grid is walked along the
+     * ray, skipping blocks of empty cells, so only the bodies of the cells before the nearest one are tested.
+     *
+     * @param position The position of the photon.
+     * @param direction The unit direction of travel.
+     * @return The distance along the direction to the nearest bounding box or the boundary of the computational domain (cm), or 0 if the position is within a bounding box.
+     */
+    double getBackgroundDistance(const Eigen::Vector3d &position, const Eigen::Vector3d &direction) const;
+
+    /**
+     * @brief Returns true if the computational domain has homogeneous regions, i.e. primitives, meshes or voxel grids which store their material IDs in an octree or are downsampled.
+     *
+     * @return True if getHomogeneousDistance can return a nonzero distance, false otherwise.
+     */
+    bool hasHomogeneousRegions() const;
+
+    /**
+     * @brief Sets the resolution at which the voxel grids are looked up. Meshes and primitives are not affected.
+     *
+     * See VoxelGrid::setResolutionLevel. Not thread safe, so must not be called while photons are transported.
+     *
+     * @param level 0 for the full resolution, or 1, 2 or 3 for the voxel grids downsampled by 2, 4 or 8 along each axis
+     * @throws std::out_of_range If the level is not between 0 and VoxelGrid::NUM_RESOLUTION_LEVELS - 1.
+     */
+    void setResolutionLevel(int level);
+
+    /**
+     * @brief Returns the resolution at which the voxel grids are looked up.
+     *
+     * @return The resolution level, which is 0 for the full resolution.
+     */
+    int getResolutionLevel() const { return resolution_level_; }
 
     /**
      * @brief Returns the voxel grid at index N.
@@ -69,6 +147,27 @@ public:
      */
     Eigen::Vector3d getVoxelGridOriginN(int N);
 
+    /**
+     * @brief Returns the rotation of the voxel grid at index N about its center.
+     *
+     * @param N The index of the voxel grid.
+     * @return The rotation matrix from the axes of the voxel grid to those of the computational domain.
+     */
+    Eigen::Matrix3d getVoxelGridRotationN(int N) const;
+
+    /**
+     * @brief Sets the rotation of the voxel grid at index N about its center.
+     *
+     * The voxel grid is not copied or resampled, as positions and directions are rotated into the voxel grid when it
+     * is looked up, so one loaded voxel grid serves a sweep over angles. Not thread safe, so must not be called while
+     * photons are transported.
+     *
+     * @param N The index of the voxel grid.
+     * @param rotation The rotation matrix from the axes of the voxel grid to those of the computational domain.
+     * @throws std::runtime_error If the matrix is not a rotation.
+     */
+    void setVoxelGridRotationN(int N, const Eigen::Matrix3d& rotation);
+
     /**
      * @brief Returns the spatial dimensions of the voxel grid at index N.
      *
@@ -84,14 +183,77 @@ public:
      */
     int getNumVoxelGrids() const;
 
+    /**
+     * @brief Returns the primitive at index N.
+     *
+     * @param N The index of the primitive.
+     * @return The primitive at index N.
+     */
+    const Primitive& getPrimitiveN(int N) const;
+
+    /**
+     * @brief Returns the number of primitives in the computational domain.
+     *
+     * @return The number of primitives in the computational domain.
+     */
+    int getNumPrimitives() const;
+
+    /**
+     * @brief Returns the tetrahedral mesh at index N.
+     *
+     * @param N The index of the mesh.
+     * @return The mesh at index N.
+     */
+    const TetrahedralMesh& getTetrahedralMeshN(int N) const;
+
+    /**
+     * @brief Returns the origin of the tetrahedral mesh at index N.
+     *
+     * @param N The index of the mesh.
+     * @return The position of the origin of the coordinates of the mesh in the computational domain.
+     */
+    Eigen::Vector3d getTetrahedralMeshOriginN(int N) const;
+
+    /**
+     * @brief Returns the number of tetrahedral meshes in the computational domain.
+     *
+     * @return The number of tetrahedral meshes in the computational domain.
+     */
+    int getNumTetrahedralMeshes() const;
+
     /**
      * @brief Voxel which represents the background material.
      */
     Voxel background_voxel;
 private:
     std::vector<std::pair<VoxelGrid, Eigen::Vector3d>> voxel_grids_;
+    // rotation of each voxel grid about its center, and its inverse, which takes positions into the voxel grid
+    std::vector<Eigen::Matrix3d> voxel_grid_rotations_;
+    std::vector<Eigen::Matrix3d> voxel_grid_inverse_rotations_;
+    std::vector<bool> voxel_grid_is_rotated_;
+    std::vector<std::pair<TetrahedralMesh, Eigen::Vector3d>> tetrahedral_meshes_;
+    std::vector<std::shared_ptr<const Primitive>> primitives_;
+    std::vector<Voxel> primitive_voxels_; // voxel of each primitive, with its material index in the computational domain
+    std::vector<int> material_ids_;
     Eigen::Vector3d dim_space_;
-    bool is_python_environment_;
+    int resolution_level_ = 0;
+
+    // bodies are the voxel grids followed by the meshes and the primitives, in order of precedence. Body b is voxel
+    // grid b if b < voxel_grids_.size(), then mesh b - voxel_grids_.size(), then primitive
+    // b - voxel_grids_.size() - tetrahedral_meshes_.size()
+    // bounds of each body, clipped to the computational domain
+    std::vector<Eigen::AlignedBox3d> body_bounds_;
+    // whether the bounds of each body overlap those of an earlier body, which takes precedence in the overlap
+    std::vector<bool> body_is_overlapped_;
+    // uniform grid of cells over the computational domain. The bodies overlapping cell c are
+    // lookup_cell_bodies_[lookup_cell_offsets_[c]] to lookup_cell_bodies_[lookup_cell_offsets_[c + 1] - 1], in order
+    Eigen::Vector3i lookup_dim_ = Eigen::Vector3i::Ones();
+    Eigen::Vector3d lookup_inv_cell_size_ = Eigen::Vector3d::Zero();
+    std::vector<int> lookup_cell_offsets_ = {0, 0};
+    std::vector<int> lookup_cell_bodies_;
+    // for each cell without bodies, the number of rings of cells without bodies around it, so that the block of cells
+    // within that many cells of it (in each axis) has no bodies. -1 for cells with bodies
+    std::vector<int> lookup_cell_clearances_ = {0};
 
     // related private functions
 
@@ -128,6 +290,74 @@ private:
      */
     void setVoxelGrids(const json &json_object, const std::string &json_directory_path);
 
+    /**
+     * @brief Sets the rotation of a voxel grid, without rebuilding the lookup grid.
+     *
+     * @param N The index of the voxel grid.
+     * @param rotation The rotation matrix from the axes of the voxel grid to those of the computational domain.
+     * @throws std::runtime_error If the matrix is not a rotation.
+     */
+    void setVoxelGridRotation(int N, const Eigen::Matrix3d &rotation);
+
+    /**
+     * @brief Sets the tetrahedral meshes of the computational domain.
+     *
+     * @param json_object The JSON object which defines the computational domain.
+     * @param json_directory_path The path to the directory containing the JSON file.
+     * @throws std::runtime_error If a mesh file cannot be read or its mesh is invalid.
+     */
+    void setTetrahedralMeshes(const json &json_object, const std::string &json_directory_path);
+
+    /**
+     * @brief Sets the primitives of the computational domain.
+     *
+     * @param json_object The JSON object which defines the computational domain.
+     * @throws std::runtime_error If a primitive has an unknown type or invalid dimensions.
+     */
+    void setPrimitives(const json &json_object);
+
+    /**
+     * @brief Assigns a dense index to each material in the computational domain and rewrites the voxels to it.
+     *
+     * @throws std::runtime_error If there are more than 256 materials.
+     */
+    void setMaterialIds();
+
+    /**
+     * @brief Builds the uniform grid of cells used to find the voxel grids, meshes and primitives containing a position.
+     */
+    void setVoxelGridLookup();
+
+    /**
+     * @brief Sets the clearance of each cell of the lookup grid, from which getBackgroundDistance skips blocks of empty cells.
+     */
+    void setLookupCellClearances();
+
+    /**
+     * @brief Returns a position relative to the origin of a voxel grid, along the axes of the voxel grid.
+     *
+     * @param N The index of the voxel grid.
+     * @param position The position in the computational domain.
+     * @return The position in the voxel grid, which is within it if it is in [0, dimensions] along each axis.
+     */
+    Eigen::Vector3d toVoxelGridPosition(int N, const Eigen::Vector3d &position) const;
+
+    /**
+     * @brief Returns the index of the lookup cell containing the position, clamped to the computational domain.
+     *
+     * @param position The position.
+     * @return The index of the lookup cell.
+     */
+    int getLookupCell(const Eigen::Vector3d &position) const;
+
+    /**
+     * @brief Returns the (i, j, k) index of the lookup cell containing the position, clamped to the computational domain.
+     *
+     * @param position The position.
+     * @return The index of the lookup cell along each axis.
+     */
+    Eigen::Vector3i getLookupCellIndex(const Eigen::Vector3d &position) const;
+
     // initializing interaction data
     /**
      * @brief Returns the names of the materials in the computational domain.
@@ -142,7 +372,7 @@ private:
     std::string getBackgroundMaterialName() const;
 
     /**
-     * @brief Adds NIFTI file paths to the given vector.
+     * @brief Adds NIFTI or MIDSX voxel file paths to the given vector.
      *
      * @param voxel_grid_json The JSON object which defines the voxel grid.
      * @param json_directory_path The path to the directory containing the JSON file.
@@ -150,6 +380,15 @@ private:
      */
     static void getNIFTIFilePaths(const json &voxel_grid_json, const std::string &json_directory_path, std::vector<std::string> &nifti_file_paths);
 
+    /**
+     * @brief Adds the density NIFTI file path of a voxel grid to the given vector, or an empty path if it has none.
+     *
+     * @param voxel_grid_json The JSON object which defines the voxel grid.
+     * @param json_directory_path The path to the directory containing the JSON file.
+     * @param density_file_paths The vector to add the density file path to.
+     */
+    static void getDensityFilePaths(const json &voxel_grid_json, const std::string &json_directory_path, std::vector<std::string> &density_file_paths);
+
     /**
      * @brief Adds origins of voxel grids to the given vector.
      *
@@ -158,6 +397,33 @@ private:
      */
     static void getOrigins(const json &voxel_grid_json, std::vector<Eigen::Vector3d> &origins);
 
+    /**
+     * @brief Adds the rotation of a voxel grid to the given vector, or the identity if it has none.
+     *
+     * @param voxel_grid_json The JSON object which defines the voxel grid.
+     * @param rotations The vector to add the rotation to.
+     * @throws std::runtime_error If the rotation is not an axis and angle or a rotation matrix.
+     */
+    static void getRotations(const json &voxel_grid_json, std::vector<Eigen::Matrix3d> &rotations);
+
+    /**
+     * @brief Adds the layout of a voxel grid to the given vector, or the linear layout if it has none.
+     *
+     * @param voxel_grid_json The JSON object which defines the voxel grid.
+     * @param layouts The vector to add the layout to.
+     * @throws std::runtime_error If the layout is not linear or bricked.
+     */
+    static void getLayouts(const json &voxel_grid_json, std::vector<VoxelLayout> &layouts);
+
+    /**
+     * @brief Creates a primitive from its JSON object.
+     *
+     * @param primitive_json The JSON object which defines the primitive.
+     * @return The primitive.
+     * @throws std::runtime_error If the primitive has an unknown type or invalid dimensions.
+     */
+    static std::shared_ptr<const Primitive> createPrimitive(const json &primitive_json);
+
     /**
      * @brief Checks if the given file path is a NIFTI file.
      * @param file_path
@@ -7,6 +7,10 @@
 #include <iostream>
 #include <utility>
 #include <exception>
+#include <memory>
+#include <variant>
+#include <unordered_map>
+#include <Eigen/Core>
 
 /**
  * @brief Exception class for database errors.
@@ -21,16 +25,25 @@ private:
 
 /**
  * @brief Class which provides an interface to a SQLite database.
+ *
+ * The database is opened read-only with one connection per thread, so a single DataAccessObject can be queried from
+ * several threads at once (e.g. when materials are loaded in parallel). Each connection keeps its prepared statements,
+ * so repeated queries are only compiled once per thread. Copies share the same connections.
  */
 class DataAccessObject {
 public:
+    /**
+     * @brief Type of the values bound to the parameters (?) of a query.
+     */
+    using Parameter = std::variant<int, double, std::string>;
+
     /**
      * @brief Constructor for the DataAccessObject class.
      *
      * @param db_name The name of the database.
+     * @throws DatabaseException If the database cannot be opened.
      */
     explicit DataAccessObject(const std::string& db_name);
-    ~DataAccessObject();
 
     /**
      * @brief Executes a query and returns the results as a vector of strings
@@ -40,8 +53,58 @@ public:
      */
     std::vector<std::string> executeQuery(const std::string& query);
 
+    /**
+     * @brief Executes a prepared query and returns the results as a matrix.
+     *
+     * Each row of the result is a row of the matrix. NULL values are returned as NaN.
+     *
+     * @param query The query to execute, with ? for each parameter.
+     * @param parameters The values bound to the parameters of the query.
+     * @return A matrix with one row per result row and one column per result column.
+     */
+    Eigen::MatrixXd queryMatrix(const std::string& query, const std::vector<Parameter>& parameters = {});
+
+    /**
+     * @brief Executes a prepared query and returns the results as strings.
+     *
+     * @param query The query to execute, with ? for each parameter.
+     * @param parameters The values bound to the parameters of the query.
+     * @return The results of the query, row by row.
+     */
+    std::vector<std::string> queryStrings(const std::string& query, const std::vector<Parameter>& parameters = {});
+
+    /**
+     * @brief Returns the (Energy, column) table of each element with a single query.
+     *
+     * Rows are returned in storage order, so repeated energies (e.g. at absorption edges) keep their order.
+     *
+     * @param table_name The name of the table.
+     * @param column_name The name of the data column.
+     * @param element_ids The IDs of the elements, or empty for every element in the table.
+     * @return A map of element ID to a 2 column matrix of the energies and values of the element.
+     * @throws DatabaseException If a name is not a valid identifier.
+     */
+    std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> queryElementTables(const std::string& table_name,
+                                                                                         const std::string& column_name,
+                                                                                         const std::vector<int>& element_ids = {});
+
+    /**
+     * @brief Returns the path of the database.
+     *
+     * @return The path of the database.
+     */
+    const std::string& getPath() const { return db_path_; }
+
 private:
-    sqlite3* db{};
+    struct Connection;
+    class ConnectionPool;
+
+    std::string db_path_;
+    std::shared_ptr<ConnectionPool> pool_;
+
+    // returns the cached statement for the query on this thread's connection, reset and with the parameters bound
+    sqlite3_stmt* prepareStatement(const std::string& query, const std::vector<Parameter>& parameters);
+
     static int callback(void* data, int argc, char** argv, char** azColName);
 };
 
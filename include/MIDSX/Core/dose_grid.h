@@ -0,0 +1,75 @@
+#ifndef MCXRAYTRANSPORT_DOSE_GRID_H
+#define MCXRAYTRANSPORT_DOSE_GRID_H
+
+#include "quantity.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Class which accumulates the energy deposited in each voxel of a voxel grid.
+ *
+ * Stores the count, mean and sum of squared deviations from the mean of the energy deposits of each voxel in separate
+ * dense arrays (24 bytes per voxel), rather than every deposit, so its memory is fixed by the size of the grid. The
+ * deposits are accumulated with Welford's algorithm, as in MomentValue. The counts are 64-bit, so that a voxel hit by
+ * every photon of a long run does not wrap.
+ */
+class DoseGrid {
+public:
+    DoseGrid() = default;
+
+    /**
+     * @brief Constructor for the DoseGrid class.
+     *
+     * @param num_voxels The number of voxels in the voxel grid.
+     */
+    explicit DoseGrid(size_t num_voxels) : counts_(num_voxels), means_(num_voxels), sums_of_squared_deviations_(num_voxels) {}
+
+    /**
+     * @brief Adds an energy deposit to a voxel.
+     *
+     * @param voxel_number The index of the voxel in the voxel grid.
+     * @param energy The energy deposited (eV).
+     */
+    void addValue(size_t voxel_number, double energy) {
+        double delta = energy - means_[voxel_number];
+        means_[voxel_number] += delta / ++counts_[voxel_number];
+        sums_of_squared_deviations_[voxel_number] += delta * (energy - means_[voxel_number]);
+    }
+
+    /**
+     * @brief Adds the energy deposited in a voxel to the given value.
+     *
+     * @param voxel_number The index of the voxel in the voxel grid.
+     * @param value The value to add the deposits of the voxel to.
+     */
+    void addTo(size_t voxel_number, MomentValue& value) const {
+        value.addMoments(counts_[voxel_number], means_[voxel_number], sums_of_squared_deviations_[voxel_number]);
+    }
+
+    /**
+     * @brief Gets the energy deposited in a voxel.
+     *
+     * @param voxel_number The index of the voxel in the voxel grid.
+     * @return the energy deposits of the voxel
+     */
+    MomentValue getValue(size_t voxel_number) const {
+        MomentValue value;
+        addTo(voxel_number, value);
+        return value;
+    }
+
+    /**
+     * @brief Gets the number of voxels of the dose grid.
+     *
+     * @return number of voxels, or 0 if the dose is not scored
+     */
+    size_t getNumOfVoxels() const { return counts_.size(); }
+
+private:
+    std::vector<uint64_t> counts_;
+    std::vector<double> means_;
+    std::vector<double> sums_of_squared_deviations_;
+};
+
+#endif //MCXRAYTRANSPORT_DOSE_GRID_H
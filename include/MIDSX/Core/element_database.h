@@ -0,0 +1,177 @@
+#ifndef MCXRAYTRANSPORT_ELEMENT_DATABASE_H
+#define MCXRAYTRANSPORT_ELEMENT_DATABASE_H
+
+#include "data_access_object.h"
+#include "interpolators.h"
+#include "config.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <unordered_map>
+#include <Eigen/Dense>
+
+namespace {
+    // anonymous namespace. only accessible in this file
+    /**
+     * @brief Relative path to the EPDL database.
+     */
+    const std::string MIDSX_DB_DIR_VAR = MIDSX_DB_DIR;
+    const std::string MIDSX_DB_NAME = "midsx.db";
+    const std::string MIDSX_DB_PATH = MIDSX_DB_DIR_VAR + "/" + MIDSX_DB_NAME;
+}
+
+/**
+ * @brief Class which holds an in-memory snapshot of the database.
+ *
+ * The materials and elements are read when the snapshot is created. Each element table is read with a single query the
+ * first time it is requested, and is kept as columnar arrays of energies and values per element. The interpolator of
+ * each element table is likewise built once and shared by every material containing the element, so the cost of
+ * fitting scales with the number of unique elements rather than materials. Everything returned is immutable, so the
+ * process-wide instance can be shared by all InteractionData objects and threads.
+ */
+class ElementDatabase {
+public:
+    /**
+     * @brief Struct which holds the table of an element.
+     */
+    struct ElementTable {
+        Eigen::VectorXd energies;
+        Eigen::VectorXd values;
+    };
+
+    /**
+     * @brief Struct which holds the data of an element from the Elements table.
+     */
+    struct Element {
+        int atomic_number;
+        double mass;
+        double density;
+        double mass_number;
+    };
+
+    /**
+     * @brief Returns the process-wide snapshot of the MIDSX database, created on first use.
+     *
+     * @return The snapshot of the MIDSX database.
+     * @throws DatabaseException If the database cannot be opened.
+     */
+    static const ElementDatabase& getInstance();
+
+    /**
+     * @brief Constructor for the ElementDatabase class.
+     *
+     * @param db_path The path of the database.
+     * @throws DatabaseException If the database cannot be opened.
+     */
+    explicit ElementDatabase(const std::string& db_path);
+
+    /**
+     * @brief Returns the ID of the material with the given name.
+     *
+     * @param name The name of the material.
+     * @return The ID of the material.
+     * @throws std::runtime_error If the material is not in the database.
+     */
+    int getMaterialId(const std::string& name) const;
+
+    /**
+     * @brief Returns the name of the material with the given ID.
+     *
+     * @param id The ID of the material.
+     * @return The name of the material.
+     * @throws std::runtime_error If the material is not in the database.
+     */
+    const std::string& getMaterialName(int id) const;
+
+    /**
+     * @brief Returns the mass density of the material with the given ID.
+     *
+     * @param id The ID of the material.
+     * @return The mass density (g/cm^3) of the material.
+     * @throws std::runtime_error If the material is not in the database.
+     */
+    double getMaterialDensity(int id) const;
+
+    /**
+     * @brief Returns the elemental composition of the material with the given ID.
+     *
+     * @param id The ID of the material.
+     * @return The composition as a map of element ID to weight fraction.
+     * @throws std::runtime_error If the material is not in the database.
+     */
+    const std::unordered_map<int, double>& getMaterialComposition(int id) const;
+
+    /**
+     * @brief Returns the data of the element with the given ID.
+     *
+     * @param id The ID of the element.
+     * @return The data of the element.
+     * @throws std::runtime_error If the element is not in the database.
+     */
+    const Element& getElement(int id) const;
+
+    /**
+     * @brief Returns the (Energy, column) table of the given elements.
+     *
+     * @param table_name The name of the table.
+     * @param column_name The name of the data column.
+     * @param element_ids The IDs of the elements.
+     * @return A map of element ID to a 2 column matrix of the energies and values of the element.
+     * @throws std::runtime_error If an element has no rows in the table.
+     */
+    std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> getElementTables(const std::string& table_name,
+                                                                                       const std::string& column_name,
+                                                                                       const std::vector<int>& element_ids) const;
+
+    /**
+     * @brief Returns the interpolators of the (Energy, column) table of the given elements.
+     *
+     * Cross section tables are interpolated with log-log splines and all other tables with log-log linear interpolation.
+     *
+     * @param table_name The name of the table.
+     * @param column_name The name of the data column.
+     * @param element_ids The IDs of the elements.
+     * @return A map of element ID to the interpolator of the table of the element.
+     * @throws std::runtime_error If the table is unknown or an element has no rows in the table.
+     */
+    std::unordered_map<int, std::shared_ptr<const Interpolator::Interpolator>> getElementInterpolators(const std::string& table_name,
+                                                                                                       const std::string& column_name,
+                                                                                                       const std::vector<int>& element_ids) const;
+
+    /**
+     * @brief Returns the path of the database.
+     *
+     * @return The path of the database.
+     */
+    const std::string& getPath() const { return dao_.getPath(); }
+
+private:
+    using Table = std::unordered_map<int, ElementTable>;
+
+    // the DAO keeps per-thread statement caches, which are not part of the observable state of the snapshot
+    mutable DataAccessObject dao_;
+    std::unordered_map<std::string, int> material_ids_;
+    std::unordered_map<int, std::string> material_names_;
+    std::unordered_map<int, double> material_densities_;
+    std::unordered_map<int, std::unordered_map<int, double>> material_compositions_;
+    std::unordered_map<int, Element> elements_;
+
+    // element tables are read on first use, keyed by "table.column"
+    mutable std::mutex tables_mutex_;
+    mutable std::unordered_map<std::string, std::shared_ptr<const Table>> tables_;
+
+    // element interpolators are built on first use, keyed by "table.column" and element ID
+    mutable std::mutex interpolators_mutex_;
+    mutable std::unordered_map<std::string, std::unordered_map<int, std::shared_ptr<const Interpolator::Interpolator>>> interpolators_;
+
+    void loadMaterials();
+    void loadElements();
+    std::shared_ptr<const Table> getTable(const std::string& table_name, const std::string& column_name) const;
+    static Eigen::Matrix<double, Eigen::Dynamic, 2> getElementMatrix(const Table& table, const std::string& table_name, int element_id);
+    static std::shared_ptr<const Interpolator::Interpolator> createInterpolator(const std::string& table_name,
+                                                                                const Eigen::Matrix<double, Eigen::Dynamic, 2>& matrix);
+};
+
+#endif //MCXRAYTRANSPORT_ELEMENT_DATABASE_H
@@ -4,28 +4,19 @@
 #ifndef MC_XRAY_TRANSPORT_PHYSICS_ENGINE_DATA_SERVICE_H
 #define MC_XRAY_TRANSPORT_PHYSICS_ENGINE_DATA_SERVICE_H
 
-#include "data_access_object.h"
+#include "element_database.h"
 #include "interpolators.h"
 #include "material.h"
-#include "config.h"
 #include <iostream>
 #include <memory>
 #include <map>
-
-namespace {
-    // anonymous namespace. only accessible in this file
-    /**
-     * @brief Relative path to the EPDL database.
-     */
-    const std::string MIDSX_DB_DIR_VAR = MIDSX_DB_DIR;
-    const std::string MIDSX_DB_NAME = "midsx.db";
-    const std::string MIDSX_DB_PATH = MIDSX_DB_DIR_VAR + "/" + MIDSX_DB_NAME;
-}
+#include <unordered_map>
 
 /**
  * @brief Class which provides access to various simulation significant data.
  *
  * This class provides an interface to the database along with Material objects which contain computed data, along with data that is computed from all materials.
+ * All instances read from the process-wide ElementDatabase snapshot.
  */
 class InteractionData {
 public:
@@ -33,8 +24,11 @@ public:
      * @brief Constructor for the InteractionData class.
      *
      * @param material_names A vector of strings containing the names of the materials to be used in the simulation.
+     * @param max_density_scales The largest density scale factor of each material ID in the simulation. Materials not
+     * in the map are only used at their nominal density (scale factor 1).
      */
-    explicit InteractionData(const std::vector<std::string>& material_names);
+    explicit InteractionData(const std::vector<std::string>& material_names,
+                             std::unordered_map<int, double> max_density_scales = {});
 
     /**
      * @brief Returns the Material object with the given ID.
@@ -42,13 +36,30 @@ public:
      * @param id The ID of the Material object to return.
      * @return The Material object with the given ID.
      */
-    Material& getMaterialFromId(int id) { return material_map_.at(id); }
+    Material& getMaterialFromId(int id) { return materials_[material_indices_.at(id)]; }
+
+    /**
+     * @brief Returns the Material object at the given index.
+     *
+     * Materials are stored contiguously, in the order of the unique material names given to the constructor.
+     *
+     * @param index The index of the Material object to return.
+     * @return The Material object at the given index.
+     */
+    Material& getMaterial(int index) { return materials_[index]; }
+
+    /**
+     * @brief Returns the number of materials.
+     *
+     * @return The number of materials.
+     */
+    int getNumMaterials() const { return static_cast<int>(materials_.size()); }
 
     /**
      * @brief Returns the 2 column matrix containing the maximum total cross sections for all materials.
      *
      * The first column contains the energy values, and the second column contains the maximum total cross sections.
-     * Energy values are in eV and cross sections are in cm^-1.
+     * Energy values are in eV and cross sections are in cm^-1. Each material is taken at its largest density scale factor.
      *
      * @return The 2 column matrix containing the maximum total cross sections for all materials.
      */
@@ -62,6 +73,16 @@ public:
      */
     double interpolateMaxTotalCrossSection(double energy) const { return (max_total_cs_interpolator_)(energy); }
 
+    /**
+     * @brief Returns the largest density scale factor of the material with the given ID.
+     *
+     * The maximum total cross sections are computed with each material at this density.
+     *
+     * @param id The ID of the material.
+     * @return The largest density scale factor of the material.
+     */
+    double getMaxDensityScale(int id) const;
+
     /**
      * @brief Returns the name of the material with the given ID.
      *
@@ -78,9 +99,11 @@ public:
      */
     uint8_t getAnyMaterialIdFromName(std::string name);
 private:
-    DataAccessObject dao_;
+    const ElementDatabase& database_;
     std::vector<std::string> material_names_;
-    std::map<int, Material> material_map_;
+    std::vector<Material> materials_;
+    std::unordered_map<int, int> material_indices_; // database material ID to index in materials_
+    std::unordered_map<int, double> max_density_scales_;
     Eigen::Matrix<double, Eigen::Dynamic, 2> max_total_cs_matrix_;
     Interpolator::LogLogLinear max_total_cs_interpolator_;
 
@@ -90,11 +113,11 @@ private:
     void initializeData();
 
     /**
-     * @brief Sets the material map for the InteractionData object.
+     * @brief Sets the materials for the InteractionData object.
      *
-     * The material map is a map of material IDs to Material objects.
+     * Each unique material is loaded once, and stored at the index of its first appearance in the material names.
      */
-    void setMaterialMap();
+    void setMaterials();
 
     /**
      * @brief Sets the maximum total cross sections and interpolator for the InteractionData object.
@@ -33,6 +33,18 @@ namespace Interpolator {
          */
         explicit Spline(const Eigen::MatrixXd &data);
 
+        /**
+         * @brief Constructor for the Spline class from a previously fitted spline.
+         *
+         * Skips the fit, e.g. when loading a cached spline.
+         *
+         * @param x_min The minimum x value of the fitted data.
+         * @param x_max The maximum x value of the fitted data.
+         * @param knots The knot vector of the fitted spline, as returned by getKnots().
+         * @param control_points The control points of the fitted spline, as returned by getControlPoints().
+         */
+        Spline(double x_min, double x_max, const Eigen::RowVectorXd &knots, const Eigen::RowVectorXd &control_points);
+
         /**
          * @brief Performs 3rd order spline interpolation.
          *
@@ -40,6 +52,11 @@ namespace Interpolator {
          * @return The interpolated y value.
          */
         double operator()(double x) const override;
+
+        double getXMin() const { return x_min_; }
+        double getXMax() const { return x_max_; }
+        Eigen::RowVectorXd getKnots() const { return spline_.knots().matrix(); }
+        Eigen::RowVectorXd getControlPoints() const { return spline_.ctrls(); }
     private:
         double scaledValue(double x) const;
         Eigen::RowVectorXd scaledValues(Eigen::VectorXd const &x_vec) const;
@@ -64,6 +81,17 @@ namespace Interpolator {
          */
         explicit LogLogSpline(const Eigen::Matrix<double, Eigen::Dynamic, 2> &data);
 
+        /**
+         * @brief Constructor for the LogLogSpline class from a previously fitted spline.
+         *
+         * @param log_x_min The minimum log10 x value of the fitted data.
+         * @param log_x_max The maximum log10 x value of the fitted data.
+         * @param knots The knot vector of the fitted spline, as returned by getKnots().
+         * @param control_points The control points of the fitted spline, as returned by getControlPoints().
+         */
+        LogLogSpline(double log_x_min, double log_x_max, const Eigen::RowVectorXd &knots, const Eigen::RowVectorXd &control_points)
+                : Spline(log_x_min, log_x_max, knots, control_points) { };
+
         /**
          * @brief Performs 3rd order spline interpolation on a log-log scale.
          *
@@ -2,7 +2,7 @@
 #define MCXRAYTRANSPORT_MATERIAL_H
 
 #include "interpolators.h"
-#include "data_access_object.h"
+#include "element_database.h"
 #include "material_properties.h"
 #include "material_data.h"
 #include <string>
@@ -21,10 +21,13 @@ public:
     /**
      * @brief Constructor for the Material class.
      *
+     * The derived properties and data are loaded from the on-disk cache if an entry exists for the material name and
+     * the contents of the database. Otherwise they are computed from the database and stored in the cache.
+     *
      * @param name The name of the material.
-     * @param dao The DataAccessObject to use to query the database.
+     * @param database The snapshot of the database to read from.
      */
-    Material(std::string name, DataAccessObject& dao);
+    Material(std::string name, const ElementDatabase& database);
 
     /**
      * @brief Returns the MaterialProperties object for the material.
@@ -40,8 +43,13 @@ public:
      */
     const MaterialData& getData() { return data_;}
 private:
+    // cached is the reader of the cache entry of the material, or nullptr on a cache miss. Reset if the entry cannot be read
+    Material(std::string name, const ElementDatabase& database, std::unique_ptr<TableCache::Reader> cached);
+
+    static TableCache::Key getCacheKey(const std::string& name, const ElementDatabase& database);
+
     std::string name_;
-    DataAccessObject& dao_;
+    const ElementDatabase& database_;
     MaterialProperties properties_;
     MaterialData data_;
 };
@@ -1,11 +1,12 @@
 #ifndef MCXRAYTRANSPORT_MATERIAL_DATA_H
 #define MCXRAYTRANSPORT_MATERIAL_DATA_H
 
-#include "data_access_object.h"
+#include "element_database.h"
 #include "material_properties.h"
 #include "material_helpers.h"
 #include "interpolators.h"
 #include "probability_dist.h"
+#include "table_cache.h"
 #include "constants.h"
 #include <string>
 #include <memory>
@@ -22,9 +23,28 @@ public:
      * @brief Constructor for the MaterialData class.
      *
      * @param properties The MaterialProperties object for the material.
-     * @param dao The DataAccessObject to use to query the database.
+     * @param database The snapshot of the database to read from.
      */
-    MaterialData(MaterialProperties& properties, DataAccessObject& dao);
+    MaterialData(MaterialProperties& properties, const ElementDatabase& database);
+
+    /**
+     * @brief Constructor for the MaterialData class which reads the tables from a cache payload instead of the database.
+     *
+     * No queries, spline fits or sampling table construction are performed.
+     *
+     * @param properties The MaterialProperties object for the material.
+     * @param database The snapshot of the database the payload was derived from.
+     * @param reader The reader positioned at data written by serialize.
+     * @throws std::runtime_error If the payload is inconsistent.
+     */
+    MaterialData(MaterialProperties& properties, const ElementDatabase& database, TableCache::Reader& reader);
+
+    /**
+     * @brief Appends the tables, fitted splines and sampling tables to a cache payload.
+     *
+     * @param payload The payload to append to.
+     */
+    void serialize(std::string& payload) const;
 
     /**
      * @brief Returns the 2 column matrix containing the incoherent scattering cross sections for the material.
@@ -142,17 +162,30 @@ public:
      */
     double interpolateMassEnergyAbsorptionCoefficient(double energy) const { return (mass_energy_absorption_coefficient_interpolator_)(energy); }
 
+    /**
+     * @brief Samples the coherent scattering DCS distribution for the material at the given energy.
+     *
+     * x^2 is sampled from the squared form factor up to its maximum at the given energy, and the result is
+     * accepted with the Thomson probability (1 + mu^2)/2.
+     *
+     * @param energy The energy (eV) at which to sample the coherent scattering DCS distribution.
+     * @return The sampled cosine of the polar scattering angle.
+     */
+    double sampleCoherentScatteringDCS(double energy) const;
+
     /**
      * @brief Samples the incoherent scattering DCS distribution for the material at the given energy.
      *
+     * The distribution is the Klein-Nishina DCS multiplied by the incoherent scattering function of the material.
+     *
      * @param energy The energy (eV) at which to sample the incoherent scattering DCS distribution.
-     * @return The sampled incoherent scattering DCS for the material at the given energy.
+     * @return The sampled cosine of the polar scattering angle.
      */
-    double sampleCoherentScatteringDCS(double energy) const { return coherent_scattering_dcs_dist_.sample(energy); }
+    double sampleIncoherentScatteringDCS(double energy) const { return incoherent_scattering_dcs_dist_.sample(energy); }
 
 private:
     MaterialProperties& properties_;
-    DataAccessObject& dao_;
+    const ElementDatabase& database_;
 
     Eigen::Matrix<double, Eigen::Dynamic, 2> incoherent_cs_matrix_;
     Interpolator::LogLogSpline incoherent_cs_interpolator_;
@@ -168,7 +201,9 @@ private:
     Interpolator::LogLogLinear coherent_form_factor_interpolator_;
     Eigen::Matrix<double, Eigen::Dynamic, 2> mass_energy_absorption_coefficient_matrix_;
     Interpolator::LogLogLinear mass_energy_absorption_coefficient_interpolator_;
-    ProbabilityDist::ContinuousInversion coherent_scattering_dcs_dist_;
+    ProbabilityDist::TruncatedInversion coherent_squared_form_factor_dist_; // F^2 as a function of x^2, independent of energy
+    ProbabilityDist::Uniform uniform_dist_{0.0, 1.0};
+    ProbabilityDist::ContinuousInversion incoherent_scattering_dcs_dist_;
 
     void initializeData();
 
@@ -183,6 +218,12 @@ private:
     void setPhotoelectricCrossSectionAndInterpolator();
 
     void setCoherentScatteringDCSDistribution();
+    void setIncoherentScatteringDCSDistribution();
+
+    void setLinearInterpolators();
+
+    // identifies tables that depend only on the elemental composition of the material and the database contents
+    TableCache::Key getCompositionCacheKey(const std::string& table_name) const;
 
     Eigen::Matrix<double, Eigen::Dynamic, 2> getTotalCrossSectionsMatrixFromInteractionData();
     Eigen::Matrix<double, Eigen::Dynamic, 2> calculateWeightedAverageOfColumns(const std::string &tableName, const std::string &dataColumnName,
@@ -190,12 +231,6 @@ private:
 
     void fillTotalCrossSectionsMatrix(Eigen::MatrixXd& total_cross_sections_matrix, const Eigen::MatrixXd& merged_energy_matrix);
     std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> getTableMatrixForAllElements(const std::string &tableName, const std::string &dataColumnName);
-    std::unordered_map<int, std::shared_ptr<Interpolator::Interpolator>> getInterpolatorsForAllElements(const std::string &tableName,
-            const std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>>& table_matrix_map);
-
-    static std::shared_ptr<Interpolator::Interpolator> getInterpolatorForElement(const std::string& tableName, const Eigen::Matrix<double, Eigen::Dynamic, 2>& matrix);
-
-    Eigen::Matrix<double, Eigen::Dynamic, 2> getTableMatrix(const std::string& tableName, const std::string& dataColumnName, int element);
 };
 
 #endif //MCXRAYTRANSPORT_MATERIAL_DATA_H
@@ -105,20 +105,6 @@ namespace InteractionDataHelpers {
 
         return result;
     }
-
-    // convert material id to material name
-    inline std::string convertMaterialIdToName(int material_id, DataAccessObject &dao) {
-        // Add each element of the vector to a string if there are multiple elements
-        // (might be split into multiple lines)
-        std::string query = "SELECT Name FROM Materials WHERE MaterialID = " + std::to_string(material_id) + ";";
-        return dao.executeQuery(query)[0];
-    }
-
-    // convert material name to material id
-    inline uint8_t convertMaterialNameToId(const std::string& material_name, DataAccessObject& dao) {
-        std::string query = "SELECT MaterialID FROM Materials WHERE Name = '" + material_name + "';";
-        return castStringVector<int>(dao.executeQuery(query))[0];
-    }
 }
 
 #endif //MCXRAYTRANSPORT_MATERIAL_HELPERS_H
\ No newline at end of file
@@ -1,7 +1,8 @@
 #ifndef MCXRAYTRANSPORT_MATERIAL_PROPERTIES_H
 #define MCXRAYTRANSPORT_MATERIAL_PROPERTIES_H
 
-#include "data_access_object.h"
+#include "element_database.h"
+#include "table_cache.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -18,9 +19,26 @@ public:
      * @brief Constructor for the MaterialProperties class.
      *
      * @param name The name of the material.
-     * @param dao The DataAccessObject to use to query the database.
+     * @param database The snapshot of the database to read from.
      */
-    MaterialProperties(std::string  name, DataAccessObject& dao);
+    MaterialProperties(std::string  name, const ElementDatabase& database);
+
+    /**
+     * @brief Constructor for the MaterialProperties class which reads the properties from a cache payload instead of the database.
+     *
+     * @param name The name of the material.
+     * @param database The snapshot of the database the payload was derived from.
+     * @param reader The reader positioned at properties written by serialize.
+     * @throws std::runtime_error If the payload is inconsistent.
+     */
+    MaterialProperties(std::string  name, const ElementDatabase& database, TableCache::Reader& reader);
+
+    /**
+     * @brief Appends the properties to a cache payload.
+     *
+     * @param payload The payload to append to.
+     */
+    void serialize(std::string& payload) const;
 
     /**
      * @brief Returns the name of the material.
@@ -93,7 +111,7 @@ public:
     std::unordered_map<int, double> getElementalMassNumber() const { return elemental_mass_number_; }
 private:
     std::string name_;
-    DataAccessObject& dao_;
+    const ElementDatabase& database_;
     int material_id_;
     double mass_density_;
     double number_density_;
@@ -113,8 +131,7 @@ private:
 
 
 
-    void setElementalDataForTableAndColumn(const std::string &table_name, const std::string &column_name,
-                                           std::unordered_map<int, double> &map);
+    void setElementalData();
 
     void setMassDensity();
     void setNumberDensity();
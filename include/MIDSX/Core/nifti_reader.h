@@ -0,0 +1,105 @@
+#ifndef MCXRAYTRANSPORT_NIFTI_READER_H
+#define MCXRAYTRANSPORT_NIFTI_READER_H
+
+#include <string>
+#include <cstdint>
+#include <Eigen/Core>
+
+struct gzFile_s;
+
+/**
+ * @brief Class which reads single file NIfTI-1 images (.nii and .nii.gz).
+ *
+ * The header is read when the reader is constructed. The voxel data is decompressed through a fixed size buffer and
+ * converted to the requested type as it is read, so the image is never held in memory in its stored type. Voxels are
+ * returned with x varying fastest, then y, then z, which is the voxel order of VoxelGrid.
+ */
+class NIfTIReader {
+public:
+    /**
+     * @brief Constructor for the NIfTIReader class.
+     *
+     * @param filename The path of the NIfTI file. Compressed files are detected from their contents.
+     * @throws std::runtime_error If the file cannot be opened, is not a single file NIfTI-1 image, is not 3D, or has an unsupported data type or unit.
+     */
+    explicit NIfTIReader(std::string filename);
+
+    ~NIfTIReader();
+
+    NIfTIReader(const NIfTIReader&) = delete;
+    NIfTIReader& operator=(const NIfTIReader&) = delete;
+
+    /**
+     * @brief Gets the dimensions of the image in voxels.
+     *
+     * @return vector of the number of voxels in x, y and z
+     */
+    const Eigen::Vector3i& getDimVox() const { return dim_vox_; }
+
+    /**
+     * @brief Gets the size of the voxels in the spatial unit of the header.
+     *
+     * @return vector of the voxel size in x, y and z
+     */
+    const Eigen::Vector3d& getZooms() const { return zooms_; }
+
+    /**
+     * @brief Gets the spatial unit of the header in cm.
+     *
+     * Images with an unknown unit are taken to be in mm.
+     *
+     * @return length of the spatial unit (cm)
+     */
+    double getUnits() const { return units_; }
+
+    /**
+     * @brief Gets the number of voxels in the image.
+     *
+     * @return number of voxels in the image
+     */
+    int64_t getNumOfVoxels() const {
+        return static_cast<int64_t>(dim_vox_[0]) * dim_vox_[1] * dim_vox_[2];
+    }
+
+    /**
+     * @brief Reads the voxels as labels.
+     *
+     * The scaling of the header is applied before the labels are checked.
+     *
+     * @param labels Buffer of getNumOfVoxels() labels to read into.
+     * @throws std::runtime_error If the data was already read, the file is truncated, or a voxel is not an integer in [0, 255].
+     */
+    void readLabels(uint8_t* labels);
+
+    /**
+     * @brief Reads the voxels as values, with the scaling of the header applied.
+     *
+     * @param values Buffer of getNumOfVoxels() values to read into.
+     * @throws std::runtime_error If the data was already read or the file is truncated.
+     */
+    void readValues(double* values);
+
+private:
+    std::string filename_;
+    gzFile_s* file_ = nullptr;
+    Eigen::Vector3i dim_vox_;
+    Eigen::Vector3d zooms_;
+    double units_ = 1.0; // in cm
+    int datatype_ = 0;
+    bool swap_bytes_ = false;
+    double scl_slope_ = 1.0;
+    double scl_inter_ = 0.0;
+    bool data_read_ = false;
+
+    void readHeader();
+    void readBytes(char* buffer, size_t size);
+
+    // streams every voxel, converted to double and scaled, to output(index, value)
+    template <typename Output>
+    void readData(Output output);
+
+    template <typename Stored, typename Output>
+    void readDataAs(Output output);
+};
+
+#endif //MCXRAYTRANSPORT_NIFTI_READER_H
@@ -16,6 +16,20 @@ namespace ParticleHelpers{
      */
     Eigen::Vector3d rotateDirection(const Eigen::Vector3d& vector, const double& theta, const double& phi);
 
+    /**
+     * @brief Rotates a unit vector by the polar and azimuthal angles given by their cosines and sines.
+     *
+     * Uses the direction cosine update, so no trigonometric functions are evaluated. The result is renormalized
+     * if round-off has moved it away from unit length.
+     *
+     * @param vector The unit vector to be rotated.
+     * @param cos_theta The cosine of the polar angle.
+     * @param cos_phi The cosine of the azimuthal angle.
+     * @param sin_phi The sine of the azimuthal angle.
+     * @return The rotated unit vector.
+     */
+    Eigen::Vector3d rotateDirection(const Eigen::Vector3d& vector, double cos_theta, double cos_phi, double sin_phi);
+
 
     /**
      * @brief Returns a vector perpendicular to the given vector.
@@ -96,6 +110,19 @@ public:
         direction_ = ParticleHelpers::rotateDirection(direction_, theta, phi);
     }
 
+    /**
+     * @brief Rotates the particle by the polar and azimuthal angles given by their cosines and sines.
+     *
+     * Avoids all trigonometric function calls. Preferred when the scattering cosine is sampled directly.
+     *
+     * @param cos_theta The cosine of the polar angle.
+     * @param cos_phi The cosine of the azimuthal angle.
+     * @param sin_phi The sine of the azimuthal angle.
+     */
+    void rotate(double cos_theta, double cos_phi, double sin_phi) {
+        direction_ = ParticleHelpers::rotateDirection(direction_, cos_theta, cos_phi, sin_phi);
+    }
+
     /**
      * @brief Sets the energy of the particle.
      *
@@ -13,6 +13,26 @@ public:
     virtual double interact(Particle& particle, Material& material) = 0;
 protected:
     ProbabilityDist::Uniform uniform_dist_{0.0, 1.0};
+
+    /**
+     * @brief Samples a uniform azimuthal angle without trigonometric function calls.
+     *
+     * A point is rejection sampled in the unit disk; the cosine and sine of twice its polar angle are uniformly
+     * distributed on the unit circle. The acceptance probability is pi/4.
+     *
+     * @param cos_phi The cosine of the sampled azimuthal angle.
+     * @param sin_phi The sine of the sampled azimuthal angle.
+     */
+    void sampleAzimuth(double& cos_phi, double& sin_phi) {
+        double x, y, r_sq;
+        do {
+            x = 2*uniform_dist_.sample() - 1;
+            y = 2*uniform_dist_.sample() - 1;
+            r_sq = x*x + y*y;
+        } while (r_sq > 1 || r_sq == 0);
+        cos_phi = (x*x - y*y)/r_sq;
+        sin_phi = 2*x*y/r_sq;
+    }
 };
 
 #endif //MCXRAYTRANSPORT_PARTICLE_INTERACTION_BEHAVIOR_H
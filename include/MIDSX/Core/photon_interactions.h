@@ -56,9 +56,8 @@ public:
     /**
      * @brief Performs the incoherent scattering interaction.
      *
-     * Uses Kahn's algorithm to sample the Klein-Nishina distribution.
-     * Then performs an additional rejection sampling on the Scattering Function to get the scattering angle and new energy.
-     *
+     * Samples the scattering angle from the material's tabulated inverse CDF of the Klein-Nishina DCS
+     * times the incoherent scattering function (RITA algorithm), so no rejection is needed. The new energy follows from the Compton relation.
      *
      * @param photon The photon to interact.
      * @param material The material to interact with.
@@ -66,15 +65,8 @@ public:
      */
     double interact(Particle& photon, Material& material) override;
 private:
-    static bool isR1Accepted(double k, double random_number_1);
-    static double getChiIfR1Accepted(double k, double random_number_2);
-    static bool isR3AcceptedIfR1Accepted(double chi, double random_number_3);
-    static double getKPrime(double k, double chi);
-    static double getMu(double k, double k_prime);
-    bool isAcceptedByScatteringFunction(double mu, double k, Material& material);
-    double changeTrajectoryAndReturnEnergyForCoherentScattering(Particle& photon, double mu, double k, double k_prime);
-    static double getChiIfR1Rejected(double k, double random_number_2);
-    static bool isR3AcceptedIfR1Rejected(double k, double chi, double random_number_3);
+    static double getKPrime(double k, double mu);
+    double changeTrajectoryAndReturnEnergyForIncoherentScattering(Particle& photon, double mu, double k, double k_prime);
 };
 
 #endif //MCXRAYTRANSPORT_PHOTON_INTERACTIONS_H
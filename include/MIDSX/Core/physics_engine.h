@@ -63,6 +63,16 @@ public:
      */
     void setInteractionType(Photon& photon, Material& material, double total_cross_section);
 
+    /**
+     * @brief Sets the resolution at which the voxel grids of the computational domain are looked up.
+     *
+     * See ComputationalDomain::setResolutionLevel. Not thread safe, so must not be called while photons are transported.
+     *
+     * @param level 0 for the full resolution, or 1, 2 or 3 for the voxel grids downsampled by 2, 4 or 8 along each axis
+     * @throws std::out_of_range If the level is not between 0 and VoxelGrid::NUM_RESOLUTION_LEVELS - 1.
+     */
+    void setResolutionLevel(int level);
+
     /**
      * @brief Sets the volume tallies of the simulation.
      *
@@ -115,6 +125,8 @@ private:
     ComputationalDomain& comp_domain_;
     ProbabilityDist::Uniform uniform_dist_;
     InteractionData& interaction_data_;
+    std::vector<Material*> domain_materials_; // material of each material index of the computational domain
+    bool has_homogeneous_regions_ = false; // whether the computational domain has regions of one material to step through
     std::vector<std::vector<std::unique_ptr<VolumeTally>>> thread_local_volume_tallies_;
     std::vector<std::vector<std::unique_ptr<SurfaceTally>>> thread_local_surface_tallies_;
     std::vector<std::vector<TempVoxelData>> thread_local_voxel_data_;
@@ -0,0 +1,158 @@
+#ifndef MCXRAYTRANSPORT_PRIMITIVE_H
+#define MCXRAYTRANSPORT_PRIMITIVE_H
+
+#include "constants.h"
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <utility>
+
+/**
+ * @brief Virtual class which represents an analytic body of one material in the computational domain.
+ *
+ * Primitives are convex, so a line enters and exits each of them at most once. The material is uniform and at its
+ * nominal density.
+ */
+class Primitive {
+public:
+    virtual ~Primitive() = default;
+
+    /**
+     * @brief Checks if a position is within the primitive. Positions on the surface are within it.
+     *
+     * @param position The position to check.
+     * @return True if the position is within the primitive, false otherwise.
+     */
+    virtual bool contains(const Eigen::Vector3d& position) const = 0;
+
+    /**
+     * @brief Gets the lengths along a ray at which it enters and exits the primitive.
+     *
+     * The lengths are those of the whole line, so the entering length is negative if the position is within the primitive.
+     *
+     * @param position The origin of the ray.
+     * @param direction The unit direction of the ray.
+     * @return The entering and exiting lengths (cm). The entering length is greater than the exiting length if the line misses the primitive.
+     */
+    virtual std::pair<double, double> getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const = 0;
+
+    /**
+     * @brief Gets the axis aligned bounding box of the primitive.
+     *
+     * @return The bounding box, which is infinite along the axes the primitive is unbounded in.
+     */
+    virtual Eigen::AlignedBox3d getBoundingBox() const = 0;
+
+    /**
+     * @brief Gets the material of the primitive.
+     *
+     * @return The database material ID of the primitive.
+     */
+    int getMaterialId() const { return material_id_; }
+
+protected:
+    explicit Primitive(int material_id) : material_id_(material_id) {}
+
+    int material_id_;
+};
+
+/**
+ * @brief Class which represents an axis aligned box.
+ */
+class BoxPrimitive : public Primitive {
+public:
+    /**
+     * @brief Constructor for the BoxPrimitive class.
+     *
+     * @param min_corner The corner of the box with the smallest coordinates.
+     * @param max_corner The corner of the box with the largest coordinates.
+     * @param material_id The database material ID of the box.
+     * @throws std::runtime_error If a coordinate of min_corner is greater than that of max_corner.
+     */
+    BoxPrimitive(const Eigen::Vector3d& min_corner, const Eigen::Vector3d& max_corner, int material_id);
+
+    bool contains(const Eigen::Vector3d& position) const override;
+    std::pair<double, double> getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const override;
+    Eigen::AlignedBox3d getBoundingBox() const override;
+private:
+    Eigen::AlignedBox3d box_;
+};
+
+/**
+ * @brief Class which represents a sphere.
+ */
+class SpherePrimitive : public Primitive {
+public:
+    /**
+     * @brief Constructor for the SpherePrimitive class.
+     *
+     * @param center The center of the sphere.
+     * @param radius The radius of the sphere.
+     * @param material_id The database material ID of the sphere.
+     * @throws std::runtime_error If the radius is not positive.
+     */
+    SpherePrimitive(Eigen::Vector3d center, double radius, int material_id);
+
+    bool contains(const Eigen::Vector3d& position) const override;
+    std::pair<double, double> getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const override;
+    Eigen::AlignedBox3d getBoundingBox() const override;
+private:
+    Eigen::Vector3d center_;
+    double radius_;
+};
+
+/**
+ * @brief Class which represents a right circular cylinder of any orientation.
+ */
+class CylinderPrimitive : public Primitive {
+public:
+    /**
+     * @brief Constructor for the CylinderPrimitive class.
+     *
+     * @param center The center of the cylinder, halfway between its ends.
+     * @param axis The direction of the axis of the cylinder. Need not be normalized.
+     * @param radius The radius of the cylinder.
+     * @param height The distance between the ends of the cylinder.
+     * @param material_id The database material ID of the cylinder.
+     * @throws std::runtime_error If the axis is zero or the radius or height is not positive.
+     */
+    CylinderPrimitive(Eigen::Vector3d center, const Eigen::Vector3d& axis, double radius, double height, int material_id);
+
+    bool contains(const Eigen::Vector3d& position) const override;
+    std::pair<double, double> getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const override;
+    Eigen::AlignedBox3d getBoundingBox() const override;
+private:
+    Eigen::Vector3d center_;
+    Eigen::Vector3d axis_; // unit length
+    double radius_;
+    double half_height_;
+};
+
+/**
+ * @brief Class which represents a slab, the infinite region between two parallel planes.
+ *
+ * The slab is clipped by the boundary of the computational domain, so a slab with an axis aligned normal is a box
+ * spanning the domain in the other two axes.
+ */
+class SlabPrimitive : public Primitive {
+public:
+    /**
+     * @brief Constructor for the SlabPrimitive class.
+     *
+     * @param normal The normal of the planes. Need not be normalized.
+     * @param offset The distance of the first plane from the origin along the normal.
+     * @param thickness The distance between the planes. The second plane is at offset + thickness.
+     * @param material_id The database material ID of the slab.
+     * @throws std::runtime_error If the normal is zero or the thickness is not positive.
+     */
+    SlabPrimitive(const Eigen::Vector3d& normal, double offset, double thickness, int material_id);
+
+    bool contains(const Eigen::Vector3d& position) const override;
+    std::pair<double, double> getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const override;
+    Eigen::AlignedBox3d getBoundingBox() const override;
+private:
+    Eigen::Vector3d normal_; // unit length
+    double min_offset_;
+    double max_offset_;
+};
+
+#endif //MCXRAYTRANSPORT_PRIMITIVE_H
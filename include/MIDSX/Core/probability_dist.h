@@ -10,9 +10,23 @@
 #include <stdexcept>
 #include <Eigen/Core>
 #include <unsupported/Eigen/CXX11/Tensor>
+#include "table_cache.h"
+
+namespace ProbabilityDist {
+    struct IntervalData;
+}
 
 namespace ProbabilityDistHelpers {
     int findIndexOfNextSmallestValue(double x, const Eigen::VectorXd &vector);
+
+    // fraction of the interval's probability below x under RITA interpolation (PENELOPE 1.56)
+    double getRITAEta(double x, const ProbabilityDist::IntervalData &id);
+
+    // PDF implied by RITA interpolation of the CDF over the interval (PENELOPE 1.55)
+    double getRITAPDF(double x, const ProbabilityDist::IntervalData &id);
+
+    // RITA parameters a_i and b_i of an interval from the PDF at its ends
+    std::pair<double, double> getRITAParameters(double x_i, double x_i_1, double y_i, double y_i_1, double p_i, double p_i_1);
 }
 
 namespace ProbabilityDist {
@@ -55,10 +69,45 @@ namespace ProbabilityDist {
     };
 
 
+    /**
+     * @brief Enum class which represents the available algorithms for sampling a discrete distribution.
+     */
+    enum class DiscreteSamplingMethod {
+        Alias,
+        GuideTable
+    };
+
+    /**
+     * @brief Abstract base class for discrete distributions.
+     *
+     * This class is used to create a common interface for all discrete samplers.
+     */
+    class Discrete {
+    public:
+        virtual ~Discrete() = default;
+
+        /**
+         * @brief Returns a sample from the discrete distribution.
+         *
+         * @return A sample from the discrete distribution.
+         */
+        virtual double sample() const = 0;
+
+        /**
+         * @brief Returns the expectation value of the discrete distribution.
+         *
+         * @return The expectation value of the discrete distribution.
+         */
+        virtual double getExpectationValue() const = 0;
+    };
+
     /**
      * @brief Class which uses inversion sampling to sample from a discrete distribution.
+     *
+     * A guide table (Chen & Asau) over the CDF gives the starting index of the search, so the expected number
+     * of comparisons per sample is constant and no memory is allocated while sampling.
      */
-    class DiscreteInversion {
+    class DiscreteInversion : public Discrete {
     public:
         /**
          * @brief Constructor for the DiscreteInversion class.
@@ -72,18 +121,18 @@ namespace ProbabilityDist {
          *
          * @return A sample from the discrete distribution.
          */
-        double sample() const;
+        double sample() const override;
 
         /**
          * @brief Returns the expectation value of the discrete distribution.
          *
          * @return The expectation value of the discrete distribution.
          */
-        double getExpectationValue() const;
+        double getExpectationValue() const override;
     private:
         Eigen::Matrix<double, Eigen::Dynamic, 2> probabilities_matrix_;
         Eigen::Matrix<double, Eigen::Dynamic, 2> cdf_matrix_;
-        std::string sampling_algorithm_;
+        std::vector<int> guide_table_;
         ProbabilityDist::Uniform uniform_dist_;
 
         // Checks if discrete distribution is normalized. If not, normalizes it.
@@ -95,6 +144,49 @@ namespace ProbabilityDist {
         // generate cdf for sampling
         Eigen::Matrix<double, Eigen::Dynamic, 2> generateCDF() const;
 
+        // guide_table_[j] is the first index whose cdf value is >= j/size
+        void generateGuideTable();
+    };
+
+    /**
+     * @brief Class which uses Walker's alias method to sample from a discrete distribution.
+     *
+     * The alias table is built with Vose's algorithm. Each sample costs one random number, one table lookup
+     * and one comparison, independent of the number of values in the distribution.
+     */
+    class DiscreteAlias : public Discrete {
+    public:
+        /**
+         * @brief Constructor for the DiscreteAlias class.
+         *
+         * @param probabilities_matrix A 2 column matrix containing the values and probabilities of the discrete distribution.
+         */
+        explicit DiscreteAlias(const Eigen::Matrix<double, Eigen::Dynamic, 2> &probabilities_matrix);
+
+        /**
+         * @brief Returns a sample from the discrete distribution.
+         *
+         * @return A sample from the discrete distribution.
+         */
+        double sample() const override;
+
+        /**
+         * @brief Returns the expectation value of the discrete distribution.
+         *
+         * @return The expectation value of the discrete distribution.
+         */
+        double getExpectationValue() const override;
+    private:
+        Eigen::Matrix<double, Eigen::Dynamic, 2> probabilities_matrix_;
+        std::vector<double> cutoffs_;
+        std::vector<int> aliases_;
+        ProbabilityDist::Uniform uniform_dist_;
+
+        // Checks if discrete distribution is normalized. If not, normalizes it.
+        void normalize();
+
+        // fill cutoffs_ and aliases_ using Vose's algorithm
+        void generateAliasTable();
     };
 
     struct IntervalData {
@@ -106,8 +198,24 @@ namespace ProbabilityDist {
         double b_i;
     };
 
+    /**
+     * @brief Struct which represents a node of a RITA table.
+     *
+     * Stores the grid point, its CDF value and the interpolation parameters of the interval starting at the node.
+     */
+    struct RITANode {
+        double x;
+        double y;
+        double a;
+        double b;
+    };
+
     /**
      * @brief Class which uses PENELOPE's RITA inversion sampling algorithm to sample from a continuous distribution.
+     *
+     * The tables of all energies are stored in one contiguous buffer. Each table has a guide table with one bin
+     * per node on the CDF axis, so locating the interval of a random number takes constant expected time
+     * and sampling does not allocate memory.
      */
     class ContinuousInversion {
     public:
@@ -122,7 +230,23 @@ namespace ProbabilityDist {
          * @param x_max The maximum value of the distribution.
          * @param err_thresh The maximum error allowed for the between the interpolated PDF and the actual PDF.
          */
-        explicit ContinuousInversion(std::function<double(double, double)> &PDF, Eigen::VectorXd &energies, double x_min, double x_max, double err_thresh = 1E-4);
+        explicit ContinuousInversion(std::function<double(double, double)> &PDF, Eigen::VectorXd energies, double x_min, double x_max, double err_thresh = 1E-4);
+
+        /**
+         * @brief Constructor for the ContinuousInversion class which loads the tables from the on-disk cache when possible.
+         *
+         * The energies, range and err_thresh are added to the key, so it only needs to identify the PDF. On a cache miss
+         * the tables are built and stored.
+         *
+         * @param PDF The probability density function to sample from.
+         * @param energies The energies at which to generate the CDF.
+         * @param x_min The minimum value of the distribution.
+         * @param x_max The maximum value of the distribution.
+         * @param err_thresh The maximum error allowed for the between the interpolated PDF and the actual PDF.
+         * @param cache_key The key identifying the PDF.
+         */
+        ContinuousInversion(std::function<double(double, double)> &PDF, Eigen::VectorXd energies, double x_min, double x_max,
+                            double err_thresh, TableCache::Key cache_key);
 
         /**
          * @brief Returns a sample from the continuous distribution.
@@ -132,35 +256,136 @@ namespace ProbabilityDist {
          */
         double sample(double E) const;
 
+        /**
+         * @brief Appends the tables to a cache payload.
+         *
+         * @param payload The payload to append to.
+         */
+        void serialize(std::string &payload) const;
+
+        /**
+         * @brief Replaces the tables with ones read from a cache payload.
+         *
+         * @param reader The reader positioned at tables written by serialize.
+         * @return True if the tables were read and are consistent. On failure the object is unchanged.
+         */
+        bool deserialize(TableCache::Reader &reader);
+
     private:
         std::function<double(double, double)> PDF_;
-        std::function<double(double, double)> normalized_PDF_;
-        std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> CDF_;
         Eigen::VectorXd energies_;
-        std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> interp_parameters_;
+        Eigen::VectorXd log_energies_;
+        std::vector<RITANode> table_; // tables for all energies, back to back
+        std::vector<int> table_offsets_; // table of energy i is [table_offsets_[i], table_offsets_[i + 1])
+        std::vector<int> guide_table_; // shares table_offsets_ with table_
         double x_min_;
         double x_max_;
         double err_thresh_;
         ProbabilityDist::Uniform uniform_dist_;
 
-        void normalizePDF(double E);
+        // integral of the PDF over [x_min, x_max] at energy E. The PDF divided by it is the normalized PDF
+        double getPDFIntegral(double E) const;
 
         double getXFromY(int energy_index, double y) const;
 
         void initializeCDFAndInterpolationParameters();
 
+        // builds the tables of all energies as OpenMP tasks, which threads of an enclosing parallel region also pick up
+        void buildTablesAsTasks(std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> &CDFs,
+                                std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> &interp_parameters) const;
+
+        void appendTable(const Eigen::Array<double, Eigen::Dynamic, 2> &CDF_PER_ENERGY,
+                         const Eigen::Array<double, Eigen::Dynamic, 2> &interp_parameters_per_energy);
+
+        void addToCacheKey(TableCache::Key &cache_key) const;
+
         Eigen::Array<double, Eigen::Dynamic, 2> calculateInterpolationParametersPerEnergy(
-                double E, Eigen::Array<double, Eigen::Dynamic, 2> CDF_RITA_PER_ENERGY);
+                double E, double integral, const Eigen::Array<double, Eigen::Dynamic, 2> &CDF_RITA_PER_ENERGY) const;
+
+        Eigen::Array<double, Eigen::Dynamic, 2> getMinimizedErrorCDFPerEnergy(double E, double integral, double err_thresh) const;
+
+        Eigen::Array<double, Eigen::Dynamic, 2> generateCDFPerEnergy(double E, double integral, const Eigen::VectorXd &x_grid) const;
+
+        double getInterpErrorOverInterval(double E, double integral, IntervalData id) const;
+    };
+
+    /**
+     * @brief Class which samples a continuous distribution truncated to [x_min, x_max], where x_max is given per sample.
+     *
+     * A single RITA table of the cumulative distribution is built over a fixed grid. Sampling scales the random
+     * number by the cumulative at x_max and inverts it, so one table serves every truncation.
+     */
+    class TruncatedInversion {
+    public:
+        TruncatedInversion() = default;
 
-        Eigen::Array<double, Eigen::Dynamic, 2> getMinimizedErrorCDFPerEnergy(double E, double err_thresh);
+        /**
+         * @brief Constructor for the TruncatedInversion class.
+         *
+         * @param PDF The probability density function to sample from. Does not need to be normalized.
+         * @param x_grid The initial grid, in increasing order. Its ends are the range of the distribution, and intervals
+         * are bisected until the interpolation error is below err_thresh.
+         * @param err_thresh The maximum interpolation error of the PDF over an interval, relative to the probability of the interval.
+         */
+        TruncatedInversion(const std::function<double(double)> &PDF, const Eigen::VectorXd &x_grid, double err_thresh = 1E-4);
 
-        Eigen::Array<double, Eigen::Dynamic, 2> generateCDFPerEnergy(double E, Eigen::VectorXd x_grid);
+        /**
+         * @brief Returns a sample from the distribution truncated to [x_min, x_max].
+         *
+         * @param x_max The upper bound of the sample. Clamped to the range of the distribution.
+         * @return A sample from the truncated distribution.
+         */
+        double sample(double x_max) const;
 
-        double getInterpErrorOverInterval(double E, IntervalData id) const;
+        /**
+         * @brief Returns a sample from the distribution truncated where the cumulative distribution equals y_max.
+         *
+         * Equivalent to sample(x_max) with y_max = getCumulative(x_max), for repeated sampling at the same truncation.
+         *
+         * @param y_max The cumulative distribution at the upper bound of the sample, in [0, 1].
+         * @return A sample from the truncated distribution.
+         */
+        double sampleBelowCumulative(double y_max) const;
+
+        /**
+         * @brief Returns the cumulative distribution at x.
+         *
+         * @param x The value at which to evaluate the cumulative distribution.
+         * @return The probability of a sample being less than x, for the untruncated distribution.
+         */
+        double getCumulative(double x) const;
+
+        /**
+         * @brief Returns the number of nodes in the table.
+         *
+         * @return The number of nodes in the table.
+         */
+        int getNumNodes() const { return static_cast<int>(table_.size()); }
+
+        /**
+         * @brief Appends the table to a cache payload.
+         *
+         * @param payload The payload to append to.
+         */
+        void serialize(std::string &payload) const;
+
+        /**
+         * @brief Replaces the table with one read from a cache payload.
+         *
+         * @param reader The reader positioned at a table written by serialize.
+         * @return True if the table was read and is consistent. On failure the object is unchanged.
+         */
+        bool deserialize(TableCache::Reader &reader);
+
+    private:
+        std::vector<RITANode> table_;
+        std::vector<double> x_nodes_; // copy of the node x values for the search in getCumulative
+        std::vector<int> guide_table_;
+        ProbabilityDist::Uniform uniform_dist_{0.0, 1.0};
 
-        double getPDFFromCDFOverInterval(double E, double x, IntervalData id) const;
+        void buildTable(const std::function<double(double)> &PDF, const Eigen::VectorXd &x_grid, double err_thresh);
 
-        double getEta(double x, IntervalData id) const;
+        void generateGuideTable();
     };
 }
 #endif
@@ -3,32 +3,116 @@
 
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Class which represents a quantity by the moments of its values.
+ *
+ * Keeps the count, the sum (Kahan compensated) and the mean and sum of squared deviations from the mean (updated with
+ * Welford's algorithm, and merged with the pairwise update of Chan et al.), so it takes constant memory regardless of
+ * the number of values and its variance does not suffer from the cancellation of a sum of squares.
+ */
+class MomentValue {
+public:
+    // overloading the + operator
+    MomentValue operator+(const MomentValue& other) const;
+
+    void addValue(double value);
+
+    /**
+     * @brief Adds the moments of a set of values.
+     *
+     * @param count The number of values.
+     * @param mean The mean of the values.
+     * @param sum_of_squared_deviations The sum of the squared differences of the values from their mean.
+     */
+    void addMoments(uint64_t count, double mean, double sum_of_squared_deviations);
+    double getSum() const;
+    double getSumSTD() const;
+    double getMean() const;
+    double getMeanSTD() const;
+    double getCount() const;
+    double getCountSTD() const;
+    double getVariance() const;
+private:
+    uint64_t count_ = 0;
+    double sum_ = 0;
+    double sum_compensation_ = 0; // low order bits lost from sum_, which are subtracted from the next value added
+    double mean_ = 0;
+    double sum_of_squared_deviations_ = 0; // sum of the squared differences of the values from mean_
+
+    /**
+     * @brief Adds a value to the sum with Kahan summation.
+     *
+     * @param value The value to add.
+     */
+    void addToSum(double value);
+
+    /**
+     * @brief Merges the count, mean and sum of squared deviations of a set of values into those of this MomentValue.
+     *
+     * @param count The number of values.
+     * @param mean The mean of the values.
+     * @param sum_of_squared_deviations The sum of the squared differences of the values from their mean.
+     */
+    void mergeDeviations(uint64_t count, double mean, double sum_of_squared_deviations);
+};
 
 /**
  * @brief Class which represents a vector quantity. Used by the Tally classes to store simulation data.
+ *
+ * By default only the moments (see MomentValue), minimum and maximum of the values are kept, so the memory used does
+ * not grow with the number of photons. Every value is kept as well if retention is enabled, for quantities which are
+ * binned after the simulation (e.g. the incident energies used by DerivedQuantity).
  */
 class VectorValue {
 public:
-    // overloading the + operator
-    VectorValue operator+(VectorValue& other) const;
+    /**
+     * @brief Constructor for the VectorValue class.
+     *
+     * @param retain_values Whether every value is kept, so that it can be read with getVector.
+     */
+    explicit VectorValue(bool retain_values = false) : retain_values_(retain_values) {}
+
+    /**
+     * @brief Overloads the + operator for VectorValue.
+     *
+     * The values are only kept in the sum if both VectorValues keep them.
+     *
+     * @param other The VectorValue to add to this VectorValue.
+     * @return the VectorValue of the values of both
+     */
+    VectorValue operator+(const VectorValue& other) const;
 
     // pretty self-explanatory
     void addValue(double value);
     void addValues(const std::vector<double>& values);
-    std::vector<double>& getVector();
-    double getSum();
-    double getSumSTD();
-    double getMean();
-    double getMeanSTD();
-    double getCount();
-    double getCountSTD();
-    double getVariance();
+
+    /**
+     * @brief Gets every value added.
+     *
+     * @return vector of the values, in the order they were added
+     * @throws std::runtime_error If the values are not retained.
+     */
+    const std::vector<double>& getVector() const;
+    bool isRetainingValues() const;
+    const MomentValue& getMoments() const { return moments_; }
+    double getSum() const { return moments_.getSum(); }
+    double getSumSTD() const { return moments_.getSumSTD(); }
+    double getMean() const { return moments_.getMean(); }
+    double getMeanSTD() const { return moments_.getMeanSTD(); }
+    double getCount() const { return moments_.getCount(); }
+    double getCountSTD() const { return moments_.getCountSTD(); }
+    double getVariance() const { return moments_.getVariance(); }
+    double getMin() const;
+    double getMax() const;
 private:
+    bool retain_values_ = false;
     std::vector<double> values_ = {};
-    double sum_ = 0;
-    bool summed_ = false; // prevent multiple calls to getSum()
-    double var_ = 0;
-    bool var_calculated_ = false;
+    MomentValue moments_;
+    double min_ = std::numeric_limits<double>::infinity();
+    double max_ = -std::numeric_limits<double>::infinity();
 };
 
 /**
@@ -14,16 +14,26 @@
  *
  * Uses OpenMP to parallelize the simulation. Splits the number of photons among the threads.
  *
+ * A resolution level above 0 transports the photons through the voxel grids downsampled by 2, 4 or 8 along each axis
+ * (see VoxelGrid::setResolutionLevel), as a quick preview of the full simulation, e.g. to choose the number of photons
+ * of the full run from the uncertainties of the preview. Energy is scored in the dose grids at their full
+ * resolution, and surface and volume tallies do not depend on the voxels, so every result keeps its units and
+ * normalization. The energy deposited in each material is that of the downsampled voxel grids, but the energy of
+ * single voxels at material boundaries is not comparable with that of a full resolution run. The voxel grids are
+ * returned to their full resolution afterwards, also if the run throws.
+ *
  * @param source The photon source.
  * @param physics_engine The physics engine.
  * @param surface_tally_init A function which returns a vector of unique pointers to surface tallies.
  * @param volume_tally_init A function which returns a vector of unique pointers to volume tallies.
  * @param N_photons The number of photons to simulate.
  * @param run_time A reference to a double which stores the run time of the simulation in seconds.
+ * @param resolution_level The resolution level of the voxel grids to transport through, from 0 (full resolution) to 3.
+ * @throws std::out_of_range If the resolution level is not between 0 and VoxelGrid::NUM_RESOLUTION_LEVELS - 1.
  */
 void runSimulation(PhotonSource& source, PhysicsEngine& physics_engine,
                    std::function<std::vector<std::unique_ptr<SurfaceTally>>()> surface_tally_init,
                    std::function<std::vector<std::unique_ptr<VolumeTally>>()> volume_tally_init,
-                   int N_photons, double& run_time = *(new double));
+                   int N_photons, double& run_time = *(new double), int resolution_level = 0);
 
 #endif //HVL_RUN_SIMULATION_H
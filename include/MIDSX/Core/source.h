@@ -57,9 +57,13 @@ public:
     /**
      * @brief Constructor for the PolyenergeticSpectrum class.
      *
+     * The alias method is used by default, which samples in constant time regardless of the number of energy bins.
+     *
      * @param probabilities_matrix A matrix where the first column is the energy and the second column is the probability.
+     * @param sampling_method The algorithm used to sample the spectrum.
      */
-    explicit PolyenergeticSpectrum(const Eigen::Matrix<double, Eigen::Dynamic, 2> &probabilities_matrix);
+    explicit PolyenergeticSpectrum(const Eigen::Matrix<double, Eigen::Dynamic, 2> &probabilities_matrix,
+                                   ProbabilityDist::DiscreteSamplingMethod sampling_method = ProbabilityDist::DiscreteSamplingMethod::Alias);
 
     /**
      * @brief Returns a sample from the polyenergetic spectrum.
@@ -76,8 +80,7 @@ public:
     double getExpectationValue() const;
 
 private:
-    Eigen::Matrix<double, Eigen::Dynamic, 2> probabilities_matrix_;
-    ProbabilityDist::DiscreteInversion energy_dist_;
+    std::shared_ptr<ProbabilityDist::Discrete> energy_dist_;
 };
 
 /**
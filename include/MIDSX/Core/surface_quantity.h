@@ -51,8 +51,9 @@ public:
      * @brief Constructor for the VectorSurfaceQuantity class.
      *
      * @param type The type of the VectorSurfaceQuantity to be measured.
+     * @param retain_values Whether every value is kept, rather than only the statistics of the values. Needed to bin the values after the simulation, e.g. by DerivedQuantity.
      */
-    explicit VectorSurfaceQuantity(VectorSurfaceQuantityType type);
+    explicit VectorSurfaceQuantity(VectorSurfaceQuantityType type, bool retain_values = false);
 
     /**
      * @brief Overloads the + operator for VectorSurfaceQuantity.
@@ -82,7 +82,13 @@ private:
 };
 
 namespace SurfaceQuantityContainerFactory {
-    SurfaceQuantityContainer AllQuantities();
+    /**
+     * @brief Creates a container with every surface quantity.
+     *
+     * @param retain_values Whether the vector quantities keep every value rather than only their statistics.
+     * @return the container
+     */
+    SurfaceQuantityContainer AllQuantities(bool retain_values = false);
 }
 
 #endif //MIDSX_SURFACE_QUANTITY_CONTAINER_H
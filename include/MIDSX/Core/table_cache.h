@@ -0,0 +1,231 @@
+#ifndef MCXRAYTRANSPORT_TABLE_CACHE_H
+#define MCXRAYTRANSPORT_TABLE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <Eigen/Core>
+
+/**
+ * @brief On-disk cache for precomputed tables.
+ *
+ * Entries are stored as one binary file per key in the cache directory. Each file holds the full key, so hash
+ * collisions and stale entries are detected on load. Reading and writing are best effort: any failure is treated
+ * as a cache miss, and the caller falls back to computing the table.
+ */
+namespace TableCache {
+
+    /**
+     * @brief Class which identifies a cache entry by everything the cached table depends on.
+     */
+    class Key {
+    public:
+        /**
+         * @brief Constructor for the Key class.
+         *
+         * @param name The kind of table, used as the prefix of the file name.
+         */
+        explicit Key(std::string name);
+
+        Key& add(double value);
+        Key& add(int value);
+        Key& add(uint64_t value);
+        Key& add(const std::string& value);
+        Key& add(const Eigen::VectorXd& values);
+
+        /**
+         * @brief Returns the serialized key.
+         *
+         * @return The serialized key.
+         */
+        const std::string& getBytes() const { return bytes_; }
+
+        /**
+         * @brief Returns the file name of the entry, made from the name and a hash of the key.
+         *
+         * @return The file name of the entry.
+         */
+        std::string getFileName() const;
+
+    private:
+        std::string name_;
+        std::string bytes_;
+    };
+
+    // every value and array is padded to a multiple of 8 bytes, so arrays in a stored entry are aligned when the file is mapped
+    const size_t ALIGNMENT = 8;
+
+    inline size_t getPaddedSize(size_t size) {
+        return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    /**
+     * @brief Class which reads values written with appendValue, appendVector and appendMatrix from a payload.
+     *
+     * The reader shares ownership of the storage of the payload, which is either a string or a mapped cache file. Every
+     * read checks the bounds of the payload, so a truncated payload results in a failed read rather than a crash.
+     */
+    class Reader {
+    public:
+        explicit Reader(std::string payload) {
+            auto storage = std::make_shared<const std::string>(std::move(payload));
+            data_ = storage->data();
+            end_ = storage->data() + storage->size();
+            storage_ = std::move(storage);
+        }
+
+        /**
+         * @brief Constructor for the Reader class which reads a payload held by other storage, without copying it.
+         *
+         * @param storage The storage holding the payload, which is kept alive by the reader.
+         * @param data The start of the payload.
+         * @param size The size of the payload in bytes.
+         */
+        Reader(std::shared_ptr<const void> storage, const char* data, size_t size) :
+                storage_(std::move(storage)), data_(data), end_(data + size) {}
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        template <typename T>
+        bool read(T& value) {
+            static_assert(std::is_trivially_copyable<T>::value, "TableCache only stores trivially copyable types");
+            if (static_cast<size_t>(end_ - data_) < getPaddedSize(sizeof(T))) return false;
+            std::memcpy(&value, data_, sizeof(T));
+            data_ += getPaddedSize(sizeof(T));
+            return true;
+        }
+
+        template <typename T>
+        bool readVector(std::vector<T>& values) {
+            static_assert(std::is_trivially_copyable<T>::value, "TableCache only stores trivially copyable types");
+            uint64_t size;
+            if (!read(size) || size > static_cast<uint64_t>(end_ - data_) / sizeof(T)) return false;
+            size_t padded_size = getPaddedSize(size * sizeof(T));
+            if (static_cast<size_t>(end_ - data_) < padded_size) return false;
+            values.resize(size);
+            if (size > 0) std::memcpy(values.data(), data_, size * sizeof(T));
+            data_ += padded_size;
+            return true;
+        }
+
+        template <typename MatrixType>
+        bool readMatrix(MatrixType& matrix) {
+            int64_t rows, cols;
+            std::vector<typename MatrixType::Scalar> values;
+            if (!read(rows) || !read(cols) || !readVector(values) || rows < 0 || cols < 0 ||
+                static_cast<uint64_t>(rows * cols) != values.size()) return false;
+            if ((MatrixType::RowsAtCompileTime != Eigen::Dynamic && MatrixType::RowsAtCompileTime != rows) ||
+                (MatrixType::ColsAtCompileTime != Eigen::Dynamic && MatrixType::ColsAtCompileTime != cols)) return false;
+            matrix.resize(rows, cols);
+            matrix = Eigen::Map<const Eigen::Matrix<typename MatrixType::Scalar, Eigen::Dynamic, Eigen::Dynamic>>(values.data(), rows, cols);
+            return true;
+        }
+
+        /**
+         * @brief Reads a vector of bytes written with appendVector in place, without copying it.
+         *
+         * @param bytes Set to the start of the bytes within the payload.
+         * @param size Set to the number of bytes.
+         * @return True if the read succeeded.
+         */
+        bool readBytesInPlace(const char*& bytes, uint64_t& size) {
+            if (!read(size) || size > static_cast<uint64_t>(end_ - data_)) return false;
+            size_t padded_size = getPaddedSize(size);
+            if (static_cast<size_t>(end_ - data_) < padded_size) return false;
+            bytes = data_;
+            data_ += padded_size;
+            return true;
+        }
+
+        bool isAtEnd() const { return data_ == end_; }
+
+        const std::shared_ptr<const void>& getStorage() const { return storage_; }
+
+    private:
+        std::shared_ptr<const void> storage_;
+        const char* data_;
+        const char* end_;
+    };
+
+    template <typename T>
+    void appendValue(std::string& payload, const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "TableCache only stores trivially copyable types");
+        payload.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        payload.append(getPaddedSize(sizeof(T)) - sizeof(T), '\0');
+    }
+
+    template <typename T>
+    void appendVector(std::string& payload, const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "TableCache only stores trivially copyable types");
+        appendValue(payload, static_cast<uint64_t>(values.size()));
+        payload.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        payload.append(getPaddedSize(values.size() * sizeof(T)) - values.size() * sizeof(T), '\0');
+    }
+
+    // stored column major, as Eigen stores matrices by default
+    template <typename Derived>
+    void appendMatrix(std::string& payload, const Eigen::DenseBase<Derived>& matrix) {
+        Eigen::Matrix<typename Derived::Scalar, Eigen::Dynamic, Eigen::Dynamic> column_major = matrix;
+        appendValue(payload, static_cast<int64_t>(column_major.rows()));
+        appendValue(payload, static_cast<int64_t>(column_major.cols()));
+        appendVector(payload, std::vector<typename Derived::Scalar>(column_major.data(), column_major.data() + column_major.size()));
+    }
+
+    /**
+     * @brief Returns the 64 bit FNV-1a hash of a buffer.
+     *
+     * @param data The buffer to hash.
+     * @param size The size of the buffer in bytes.
+     * @param hash The hash to continue from, for hashing several buffers in sequence.
+     * @return The hash of the buffer.
+     */
+    uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL);
+
+    /**
+     * @brief Returns the cache directory.
+     *
+     * The directory is $MIDSX_CACHE_DIR if set, otherwise $XDG_CACHE_HOME/midsx or $HOME/.cache/midsx. Setting
+     * MIDSX_CACHE_DIR to an empty string disables the cache.
+     *
+     * @return The cache directory, or an empty string if caching is disabled.
+     */
+    std::string getCacheDirectory();
+
+    /**
+     * @brief Returns a hash of the contents of a file.
+     *
+     * The hash of each path is computed once per process.
+     *
+     * @param path The path of the file.
+     * @return The hash of the contents of the file.
+     * @throws std::runtime_error If the file cannot be read.
+     */
+    uint64_t hashFile(const std::string& path);
+
+    /**
+     * @brief Loads the payload of a cache entry.
+     *
+     * The entry is mapped into memory rather than read, and the returned reader reads the payload from the mapping, so
+     * the tables are copied once, from the page cache into the objects deserializing them.
+     *
+     * @param key The key of the entry.
+     * @return A reader of the payload if the entry exists, was written with the same key and format version, and its checksum matches, otherwise nullptr.
+     */
+    std::unique_ptr<Reader> load(const Key& key);
+
+    /**
+     * @brief Stores the payload of a cache entry.
+     *
+     * The file is written under a temporary name and renamed, so concurrent processes never read a partial entry.
+     *
+     * @param key The key of the entry.
+     * @param payload The payload to store.
+     */
+    void store(const Key& key, const std::string& payload);
+}
+
+#endif //MCXRAYTRANSPORT_TABLE_CACHE_H
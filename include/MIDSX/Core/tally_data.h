@@ -10,10 +10,10 @@
  * Solely exists for parallelizing photon transport.
  */
 struct TempVoxelData {
-    Voxel& voxel;
+    Voxel voxel;
     double energy_deposited = 0.0;
 
-    explicit TempVoxelData(Voxel& voxel) : voxel(voxel) {}
+    explicit TempVoxelData(const Voxel& voxel) : voxel(voxel) {}
 };
 
 /**
@@ -0,0 +1,215 @@
+#ifndef MCXRAYTRANSPORT_TETRAHEDRAL_MESH_H
+#define MCXRAYTRANSPORT_TETRAHEDRAL_MESH_H
+
+#include "voxel.h"
+#include "constants.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+/**
+ * @brief Class which represents a body made of tetrahedra, each of one material.
+ *
+ * Smooth anatomy is represented by the faces of its tetrahedra rather than by a staircase of voxels, so a mesh of a
+ * phantom needs far less memory than a voxelization fine enough to resolve the same boundaries.
+ *
+ * The mesh is read from a text file in which lines starting with # are comments, with lengths in cm:
+ *
+ *     vertices <number of vertices>
+ *     <x> <y> <z>                              (one line per vertex)
+ *     tetrahedra <number of tetrahedra>
+ *     <v0> <v1> <v2> <v3> <material ID>        (one line per tetrahedron)
+ *
+ * where v0 to v3 are indices of vertices, starting from 0, and the material ID is a database material ID. The mesh
+ * need not be convex or connected, but its tetrahedra must not overlap.
+ *
+ * Positions are located by walking from tetrahedron to tetrahedron, each time across the face opposite the vertex
+ * whose barycentric coordinate is most negative, starting from a tetrahedron near the position found in a uniform grid
+ * of cells over the mesh. The tetrahedra overlapping each cell are tested directly if the walk leaves the mesh (e.g.
+ * at a concavity). Each tetrahedron is a homogeneous region, so photons are transported to its faces with its own
+ * material as the majorant.
+ */
+class TetrahedralMesh {
+public:
+    TetrahedralMesh() = default;
+
+    /**
+     * @brief Constructor for the TetrahedralMesh class.
+     *
+     * @param filename The path to the mesh file.
+     * @throws std::runtime_error If the file cannot be read or the mesh is invalid.
+     */
+    explicit TetrahedralMesh(const std::string& filename);
+
+    /**
+     * @brief Constructor for the TetrahedralMesh class from its vertices and tetrahedra.
+     *
+     * @param vertices The positions of the vertices (cm).
+     * @param tetrahedra The indices of the four vertices of each tetrahedron.
+     * @param material_ids The database material ID of each tetrahedron.
+     * @throws std::runtime_error If a tetrahedron refers to a vertex which does not exist or has no volume, or the number of material IDs differs from the number of tetrahedra.
+     */
+    TetrahedralMesh(std::vector<Eigen::Vector3d> vertices, std::vector<std::array<int, 4>> tetrahedra,
+                    const std::vector<int>& material_ids);
+
+    /**
+     * @brief Finds the tetrahedron containing a position. Positions on a face are within it.
+     *
+     * Thread safe, as the walk keeps no state between calls.
+     *
+     * @param position The position relative to the origin of the mesh.
+     * @return the index of the tetrahedron, or -1 if the position is outside of the mesh
+     */
+    int findTetrahedron(const Eigen::Vector3d& position) const;
+
+    /**
+     * @brief Gets the voxel of a tetrahedron.
+     *
+     * @param tetrahedron The index of the tetrahedron.
+     * @return a voxel with the material index of the tetrahedron, at the nominal density of its material
+     */
+    Voxel getVoxel(int tetrahedron) const {
+        Voxel voxel;
+        voxel.materialID = material_indices_[tetrahedron];
+        return voxel;
+    }
+
+    /**
+     * @brief Gets the distance along a ray from a position within a tetrahedron to the face through which it exits.
+     *
+     * @param tetrahedron The index of the tetrahedron containing the position.
+     * @param position The position relative to the origin of the mesh.
+     * @param direction The unit direction of the ray.
+     * @return the distance to the exiting face (cm)
+     */
+    double getExitDistance(int tetrahedron, const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const;
+
+    /**
+     * @brief Gets the axis aligned bounding box of the mesh.
+     *
+     * @return the bounding box of the vertices, relative to the origin of the mesh
+     */
+    const Eigen::AlignedBox3d& getBoundingBox() const { return bounds_; }
+
+    /**
+     * @brief Gets the database material IDs of the mesh.
+     *
+     * Until remapMaterialIds is called, the materialID of a voxel is its index in this vector.
+     *
+     * @return vector of the database material IDs present in the mesh
+     */
+    const std::vector<int>& getMaterialIds() const { return material_ids_; }
+
+    /**
+     * @brief Sets the material index of every tetrahedron to its index in the given list of materials.
+     *
+     * Used by the computational domain so that all of its bodies share one dense material index.
+     *
+     * @param material_ids database material IDs, which must contain every material in the mesh
+     * @throws std::runtime_error If a material of the mesh is not in the list.
+     */
+    void remapMaterialIds(const std::vector<int>& material_ids);
+
+    /**
+     * @brief Gets the number of tetrahedra of the mesh.
+     *
+     * @return number of tetrahedra
+     */
+    int getNumOfTetrahedra() const { return static_cast<int>(material_indices_.size()); }
+
+    /**
+     * @brief Gets the number of vertices of the mesh.
+     *
+     * @return number of vertices
+     */
+    int getNumOfVertices() const { return static_cast<int>(vertices_.size()); }
+
+    /**
+     * @brief Gets the volume of the mesh.
+     *
+     * @return the sum of the volumes of the tetrahedra (cm^3)
+     */
+    double getVolume() const;
+
+    /**
+     * @brief Gets the memory used by the mesh and its point location structures.
+     *
+     * @return size of the vertices, tetrahedra, neighbours and lookup grid (bytes)
+     */
+    size_t getMemorySize() const;
+
+private:
+    std::vector<Eigen::Vector3d> vertices_;
+    // vertices of each tetrahedron, ordered so that it has a positive volume. Face f is opposite vertex f, and its
+    // plane is computed from the vertices when it is needed rather than stored, as it would take most of the memory
+    std::vector<std::array<int, 4>> tetrahedra_;
+    // tetrahedron sharing face f of each tetrahedron, or -1 if the face is on the surface of the mesh
+    std::vector<std::array<int, 4>> neighbors_;
+    std::vector<uint8_t> material_indices_; // index of the material of each tetrahedron in indexed_material_ids_
+    std::vector<int> material_ids_; // database material IDs present in the mesh
+    std::vector<int> indexed_material_ids_; // material_ids_ until remapped, then the list remapped to
+    Eigen::AlignedBox3d bounds_;
+
+    // uniform grid of cells over the bounding box. The tetrahedra whose bounding boxes overlap cell c are
+    // lookup_cell_tetrahedra_[lookup_cell_offsets_[c]] to lookup_cell_tetrahedra_[lookup_cell_offsets_[c + 1] - 1],
+    // the first of which is the one nearest the center of the cell, where walks through the cell start
+    Eigen::Vector3i lookup_dim_ = Eigen::Vector3i::Ones();
+    Eigen::Vector3d lookup_inv_cell_size_ = Eigen::Vector3d::Zero();
+    std::vector<int> lookup_cell_offsets_ = {0, 0};
+    std::vector<int> lookup_cell_tetrahedra_;
+
+    // steps after which a walk is abandoned, as it may cycle around a position which is on a face or edge
+    static const int MAX_WALK_STEPS = 64;
+
+    /**
+     * @brief Reads the vertices, tetrahedra and material IDs from a mesh file.
+     *
+     * @param filename The path to the mesh file.
+     * @param material_ids Set to the database material ID of each tetrahedron.
+     * @throws std::runtime_error If the file cannot be read or is not a mesh file.
+     */
+    void readMeshFile(const std::string& filename, std::vector<int>& material_ids);
+
+    /**
+     * @brief Checks the tetrahedra and builds their face planes, neighbours and lookup grid.
+     *
+     * @param material_ids The database material ID of each tetrahedron.
+     * @throws std::runtime_error If the mesh is invalid.
+     */
+    void initializeMesh(const std::vector<int>& material_ids);
+
+    /**
+     * @brief Finds the tetrahedron sharing each face of each tetrahedron.
+     *
+     * @throws std::runtime_error If a face is shared by more than two tetrahedra.
+     */
+    void setNeighbors();
+
+    /**
+     * @brief Builds the lookup grid, with the tetrahedron nearest the center of each cell first.
+     */
+    void setLookupGrid();
+
+    /**
+     * @brief Gets the face of a tetrahedron a position is furthest beyond, in the barycentric coordinates of the tetrahedron.
+     *
+     * @param tetrahedron The index of the tetrahedron.
+     * @param position The position relative to the origin of the mesh.
+     * @return the face, or -1 if the position is within the tetrahedron or within EPSILON of its faces
+     */
+    int getFaceOutside(int tetrahedron, const Eigen::Vector3d& position) const;
+
+    /**
+     * @brief Gets the index of the lookup cell containing a position, clamped to the lookup grid.
+     *
+     * @param position The position relative to the origin of the mesh.
+     * @return the (i, j, k) index of the cell
+     */
+    Eigen::Vector3i getLookupCellIndex(const Eigen::Vector3d& position) const;
+};
+
+#endif //MCXRAYTRANSPORT_TETRAHEDRAL_MESH_H
@@ -50,8 +50,9 @@ public:
      * @brief Constructor for the VectorVolumeQuantity class.
      *
      * @param type The type of the VectorVolumeQuantity to be measured.
+     * @param retain_values Whether every value is kept, rather than only the statistics of the values. Needed to bin the values after the simulation, e.g. by DerivedQuantity.
      */
-    explicit VectorVolumeQuantity(VectorVolumeQuantityType type);
+    explicit VectorVolumeQuantity(VectorVolumeQuantityType type, bool retain_values = false);
 
     /**
      * @brief Overloads the + operator for VectorVolumeQuantity.
@@ -83,7 +83,13 @@ private:
 };
 
 namespace VolumeQuantityContainerFactory {
-    VolumeQuantityContainer AllQuantities();
+    /**
+     * @brief Creates a container with every volume quantity.
+     *
+     * @param retain_values Whether the vector quantities keep every value rather than only their statistics.
+     * @return the container
+     */
+    VolumeQuantityContainer AllQuantities(bool retain_values = false);
     VolumeQuantityContainer EnergyDeposition();
 }
 
@@ -2,16 +2,23 @@
 #define VOXEL_H
 
 #include <string>
-#include "quantity.h"
+#include "dose_grid.h"
 
 /**
  * @brief Struct which represents a voxel.
  *
- * Stores the material ID and dose for a voxel.
+ * Stores the material ID, density scale factor and dose for a voxel. Voxel grids keep each property in its own array,
+ * and return a Voxel by value when one is looked up.
  */
 struct Voxel {
+    // dense index of the material in its voxel grid or computational domain, not the database ID. See VoxelGrid::getMaterialIds
     uint8_t materialID = 0;
-    VectorValue dose;
+    // ratio of the mass density of the voxel to the nominal density of its material. Cross sections scale linearly with it
+    float density_scale = 1.0f;
+    // dose grid of the voxel grid of the voxel. Null if the dose of the voxel is not scored (e.g. the background)
+    DoseGrid* dose_grid = nullptr;
+    // index of the voxel in its voxel grid
+    int voxel_number = 0;
 };
 
 #endif // VOXEL_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef MCXRAYTRANSPORT_VOXEL_FILE_H
+#define MCXRAYTRANSPORT_VOXEL_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <Eigen/Core>
+
+/**
+ * @brief Class which maps a MIDSX voxel file (.mvox) into memory.
+ *
+ * A voxel file is a page sized header followed by the material ID of each voxel as raw bytes, with x varying fastest,
+ * then y, then z. The header holds the dimensions, the voxel spacing in cm, the material IDs present in the file and a
+ * checksum of the voxels, all computed from the voxels when the file is written. The file is mapped read-only and the
+ * voxels are used in place, so opening a file only reads its header, the voxels are paged in as they are used rather
+ * than decompressed and copied, and every process simulating the same phantom on a node shares the same physical
+ * pages. The header is trusted on open, except in debug builds, which verify the voxels against it.
+ *
+ * Voxel files are written in the byte order of the machine and are not portable between byte orders.
+ */
+class VoxelFile {
+public:
+    /**
+     * @brief Offset of the voxels in the file. A multiple of the page size, so the voxels are page aligned when mapped.
+     */
+    static const uint64_t DATA_OFFSET = 4096;
+
+    /**
+     * @brief Constructor for the VoxelFile class. Maps the file into memory.
+     *
+     * @param filename The path of the voxel file.
+     * @throws std::runtime_error If the file cannot be mapped or is not a valid voxel file.
+     */
+    explicit VoxelFile(std::string filename);
+
+    ~VoxelFile();
+
+    VoxelFile(const VoxelFile&) = delete;
+    VoxelFile& operator=(const VoxelFile&) = delete;
+
+    /**
+     * @brief Gets the dimensions of the voxel grid in voxels.
+     *
+     * @return vector of the number of voxels in x, y and z
+     */
+    const Eigen::Vector3i& getDimVox() const { return dim_vox_; }
+
+    /**
+     * @brief Gets the size of the voxels.
+     *
+     * @return vector of the voxel size in x, y and z (cm)
+     */
+    const Eigen::Vector3d& getSpacing() const { return spacing_; }
+
+    /**
+     * @brief Gets the material IDs present in the voxel grid.
+     *
+     * @return vector of the database material IDs of the voxels, without duplicates
+     */
+    const std::vector<int>& getMaterialIds() const { return material_ids_; }
+
+    /**
+     * @brief Gets the material ID of each voxel.
+     *
+     * @return pointer to the mapped material IDs, valid for the lifetime of the VoxelFile
+     */
+    const uint8_t* getMaterials() const { return materials_; }
+
+    /**
+     * @brief Checks the voxels against the checksum and the material IDs of the header.
+     *
+     * Reads every voxel, so it touches every page of the mapping.
+     *
+     * @throws std::runtime_error If the checksum does not match, or a voxel has a material ID which is not in the header.
+     */
+    void verify() const;
+
+    /**
+     * @brief Writes a voxel file.
+     *
+     * The file is written under a temporary name and renamed, so processes mapping it never see a partial file.
+     *
+     * @param filename The path of the voxel file.
+     * @param dim_vox The dimensions of the voxel grid in voxels.
+     * @param spacing The size of the voxels (cm).
+     * @param materials The material ID of each voxel, with x varying fastest.
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    static void write(const std::string& filename, const Eigen::Vector3i& dim_vox, const Eigen::Vector3d& spacing,
+                      const uint8_t* materials);
+
+    /**
+     * @brief Converts a NIFTI file of material IDs to a voxel file.
+     *
+     * The spacing is read from the NIFTI header in the same way as when a VoxelGrid loads the NIFTI file directly.
+     *
+     * @param nifti_filename The path of the NIFTI file (.nii or .nii.gz).
+     * @param filename The path of the voxel file to write.
+     * @throws std::runtime_error If the NIFTI file cannot be read or the voxel file cannot be written.
+     */
+    static void convertNIfTI(const std::string& nifti_filename, const std::string& filename);
+
+    /**
+     * @brief Checks if the given file path is a voxel file.
+     *
+     * @param filename The file path to check.
+     * @return True if the file path has the .mvox extension, false otherwise.
+     */
+    static bool isVoxelFile(const std::string& filename);
+
+private:
+    std::string filename_;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    Eigen::Vector3i dim_vox_;
+    Eigen::Vector3d spacing_;
+    std::vector<int> material_ids_;
+    const uint8_t* materials_ = nullptr;
+    uint64_t num_voxels_ = 0;
+    uint64_t checksum_ = 0;
+
+    void readHeader();
+};
+
+#endif //MCXRAYTRANSPORT_VOXEL_FILE_H
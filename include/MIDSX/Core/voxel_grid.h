@@ -4,53 +4,126 @@
 #include <vector>
 #include "voxel.h"
 #include "interaction_data.h"
+#include "nifti_reader.h"
+#include "voxel_file.h"
+#include "voxel_octree.h"
 #include <Eigen/Dense>
-#include <pybind11/embed.h>
-#include <pybind11/numpy.h>
+#include <array>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <utility>
 
-namespace py = pybind11;
-
-namespace VoxelGridHelpers {
-    template <typename T, std::size_t N>
-    Eigen::Vector<T, N> pyTupleToEigenVector(const py::tuple &tuple);
-    double covertUnitNameToCm(const std::string& unitName);
-    int dimensionStringToIndex(const std::string& dimension);
-}
+/**
+ * @brief Order in which the per-voxel arrays of a voxel grid are stored.
+ */
+enum class VoxelLayout {
+    LINEAR, // x varies fastest, then y, then z
+    BRICKED // 8x8x8 bricks in Morton order, with the voxels of each brick in Morton order
+};
 
 /**
  * @brief Class which represents a voxel grid.
  *
- * Stores the voxels and the properties of the voxel grid.
+ * Stores the voxels and the properties of the voxel grid. The material of each voxel is stored as its database
+ * material ID in one contiguous byte array, which is either read from a NIFTI file or mapped in place from a MIDSX
+ * voxel file (see VoxelFile). The array is never written, and is translated to the dense material index of the
+ * computational domain through a 256 entry table when a voxel is looked up. The energy deposited in the voxels is only
+ * scored if enabled, in a separate DoseGrid.
+ *
+ * The byte array can be replaced by a VoxelOctree, which collapses blocks of one material and density. This saves memory
+ * for phantoms with large uniform regions, and lets transport step through the uniform blocks with the cross section
+ * of their material (see getHomogeneousDistance).
+ *
+ * The material IDs, density scale factors and dose grid are stored in the linear order of the file by default. With
+ * the bricked layout they are stored in 8x8x8 bricks, so voxels which are close in space are close in memory whichever
+ * direction a photon travels. A step along y or z then usually stays within the same cache lines, rather than jumping
+ * a row or a slice of the grid.
+ *
+ * Copies of the material IDs and density scale factors downsampled by 2, 4 and 8 along each axis can be built, by a
+ * majority vote of the voxels of each block, and transport switched to one of them (see setResolutionLevel) for a
+ * quick preview of a simulation before the full resolution run.
  */
 class VoxelGrid {
 public:
+    /**
+     * @brief Number of resolution levels, including the full resolution.
+     */
+    static const int NUM_RESOLUTION_LEVELS = 4;
+
     VoxelGrid() = default;
 
     /**
      * @brief Constructor for the VoxelGrid class.
      *
-     * @param dim_vox The dimensions of the voxel grid in voxels.
-     * @param is_python_environment Whether or not the VoxelGrid is being constructed in a Python environment. Only True for python wrapper only.
+     * @param filename NIFTI file (.nii or .nii.gz) or MIDSX voxel file (.mvox) with the material ID of each voxel.
+     * @param density_filename Optional NIFTI file with the mass density (g/cm^3) of each voxel. If empty, every voxel is at the nominal density of its material.
+     * @param layout The order in which the voxels are stored. A voxel file is copied rather than mapped if the layout is bricked.
+     * @throws std::runtime_error If a file cannot be read, the density file does not match the voxel grid or contains negative densities.
      */
-    explicit VoxelGrid(std::string  filename, bool is_python_environment = false);
+    explicit VoxelGrid(std::string  filename, std::string density_filename = "", VoxelLayout layout = VoxelLayout::LINEAR);
 
     /**
      * @brief Gets the voxel at (i, j, k).
      *
      * @param voxel_index
-     * @return
+     * @return the material index, density scale factor and dose grid of the voxel
+     * @throws std::out_of_range If the index is outside of the voxel grid.
      */
-    Voxel& getVoxel(const Eigen::Vector3i& voxel_index);
+    Voxel getVoxel(const Eigen::Vector3i& voxel_index);
 
     /**
-     * @brief Sets the voxel at (i, j, k) to specified voxel
+     * @brief Gets the number of the voxel at (i, j, k), which is its index in the dose grid.
+     *
      * @param voxel_index
-     * @param value
+     * @return the index of the voxel in the storage order of the layout
+     * @throws std::out_of_range If the index is outside of the voxel grid.
+     */
+    int getVoxelNumber(const Eigen::Vector3i& voxel_index) const;
+
+    /**
+     * @brief Gets the order in which the voxels are stored.
+     *
+     * @return the layout the voxel grid was loaded with
+     */
+    VoxelLayout getLayout() const {
+        return layout_;
+    }
+
+    /**
+     * @brief Gets the voxel at a spatial position, without checking that the position is within the voxel grid.
+     *
+     * Used by the computational domain, which has already found the voxel grid containing the position. Positions on
+     * the upper faces of the voxel grid belong to the last voxel along that axis.
+     *
+     * @param position spatial position relative to the origin of the voxel grid. Must be within the voxel grid
+     * @return the material index, density scale factor and dose grid of the voxel
      */
-    void setVoxel(const Eigen::Vector3i& voxel_index, Voxel& value);
+    Voxel getVoxelUnchecked(const Eigen::Vector3d& position) {
+        if (resolution_level_ > 0) {
+            Eigen::Vector3i downsampled_index;
+            return getDownsampledVoxel(position, downsampled_index);
+        }
+        return getVoxelAtIndex(getVoxelIndexUnchecked(position));
+    }
+
+    /**
+     * @brief Gets the voxel at a spatial position and the distance to the boundary of its homogeneous region.
+     *
+     * The homogeneous region of a voxel is the octree node containing it if the node has a single material and
+     * density. Voxels in blocks of mixed voxels, and every voxel of a voxel grid without an octree, have none. At a
+     * downsampled resolution level, the homogeneous region is the uniform octree node of the level containing the
+     * position, or the downsampled voxel if the node is a block of mixed voxels.
+     *
+     * @param position spatial position relative to the origin of the voxel grid. Must be within the voxel grid
+     * @param direction unit direction of travel
+     * @param voxel set to the voxel at the position
+     * @return distance along the direction to the boundary of the homogeneous region of the voxel (cm), or 0 if it has none
+     */
+    double getHomogeneousDistance(const Eigen::Vector3d& position, const Eigen::Vector3d& direction, Voxel& voxel);
 
     /**
      * @brief Gets the spatial position of the voxel at (i, j, k).
@@ -80,19 +153,100 @@ public:
      */
     std::vector<std::string> getMaterialNames() const;
 
+    /**
+     * @brief Gets the database material IDs of the voxel grid.
+     *
+     * Until remapMaterialIds is called, the materialID of a voxel is its index in this vector.
+     *
+     * @return vector of the database material IDs present in the voxel grid
+     */
+    const std::vector<int>& getMaterialIds() const {
+        return material_ids_;
+    }
+
+    /**
+     * @brief Sets the material index of every voxel to its index in the given list of materials.
+     *
+     * Used by the computational domain so that all voxel grids share one dense material index.
+     *
+     * @param material_ids database material IDs, which must contain every material in the voxel grid
+     * @throws std::runtime_error If a material of the voxel grid is not in the list.
+     */
+    void remapMaterialIds(const std::vector<int>& material_ids);
+
+    /**
+     * @brief Gets the largest density scale factor of each material in the voxel grid.
+     *
+     * @return unordered map of database material ID to the largest density scale factor of its voxels
+     */
+    std::unordered_map<int, double> getMaxDensityScales() const;
+
+    /**
+     * @brief Replaces the material ID array with an octree which collapses blocks of one material and density.
+     *
+     * The array is released, or unmapped if it was mapped from a voxel file. Must be called after the density file
+     * is read, as blocks are only collapsed if their densities match.
+     */
+    void enableOctree();
+
+    /**
+     * @brief Checks if the material IDs are stored in an octree.
+     *
+     * @return true if enableOctree was called, false otherwise
+     */
+    bool hasOctree() const {
+        return octree_ != nullptr;
+    }
+
+    /**
+     * @brief Gets the octree of the material IDs.
+     *
+     * @return the octree, or nullptr if the material IDs are stored in an array
+     */
+    const VoxelOctree* getOctree() const {
+        return octree_.get();
+    }
+
+    /**
+     * @brief Enables scoring of the energy deposited in each voxel.
+     *
+     * The dose is not scored by default, so voxel grids used only as geometry take one byte per voxel.
+     */
+    void enableDoseScoring();
+
+    /**
+     * @brief Checks if the energy deposited in each voxel is scored.
+     *
+     * @return true if the dose is scored, false otherwise
+     */
+    bool isDoseScored() const {
+        return dose_grid_.getNumOfVoxels() > 0;
+    }
+
+    /**
+     * @brief Gets the energy deposited in each voxel.
+     *
+     * @return the dose grid, which is empty if the dose is not scored
+     */
+    const DoseGrid& getDoseGrid() const {
+        return dose_grid_;
+    }
+
     /**
      * @brief Gets the total energy deposited in the voxel grid.
      *
      * @return total energy deposited in the voxel grid (eV)
+     * @throws std::runtime_error If the dose is not scored.
      */
-    double getTotalEnergyDeposited();
+    double getTotalEnergyDeposited() const;
 
     /**
      * @brief Gets the total energy deposited in the voxel grid by material.
      *
-     * @return unordered map of material name to total energy deposited in the voxel grid by material (eV)
+     * @return unordered map of database material ID to total energy deposited in the voxel grid by material (eV)
+     * @throws std::runtime_error If the dose is not scored.
      */
-    std::unordered_map<int, VectorValue> getEnergyDepositedInMaterials();
+    std::unordered_map<int, MomentValue> getEnergyDepositedInMaterials() const;
 
     /**
      * @brief Adds to the number of photons that have exited the voxel grid.
@@ -109,6 +263,50 @@ public:
         return numExits_;
     }
 
+    /**
+     * @brief Sets the resolution at which voxels are looked up by getVoxelUnchecked and getHomogeneousDistance.
+     *
+     * At level L, each voxel is the block of 2^L x 2^L x 2^L voxels of the full resolution containing it, with the
+     * material most of them have and the mean density scale factor of those of that material. The blocks at the upper
+     * faces are clipped to the voxel grid. Energy is still scored in the dose grid of the full resolution, so it keeps
+     * its dimensions and units at every level, in the voxel at the position of the interaction if it has the majority
+     * material of its block. Otherwise it is scored in the first voxel of the block which has, so the energy deposited
+     * in each material (see getEnergyDepositedInMaterials) is that of the downsampled voxel grid, but the energy of a
+     * single voxel at a material boundary is not comparable with that of the full resolution. Not thread safe, so must
+     * not be called while photons are transported.
+     *
+     * A level is built the first time it is set, with an octree of its voxels so that transport crosses uniform
+     * blocks of downsampled voxels in one step (see getHomogeneousDistance). It is not built on load, which would read
+     * every voxel of a mapped voxel file and add about 30% to the memory of its material IDs whether or not a
+     * preview is run. Each downsampled voxel stores its material ID and the offset within its block of the first voxel
+     * of that material, where its energy is scored (one byte at levels 1 and 2, and two at level 3), plus its density
+     * scale factor if the voxel grid has density scale factors. Without them, levels 1, 2 and 3 take about a quarter,
+     * a thirty-second and a hundred and seventieth of the memory of the material IDs of the full resolution, besides
+     * their octrees.
+     *
+     * @param level 0 for the full resolution, or 1, 2 or 3 for the voxel grid downsampled by 2, 4 or 8 along each axis
+     * @throws std::out_of_range If the level is not between 0 and NUM_RESOLUTION_LEVELS - 1.
+     */
+    void setResolutionLevel(int level);
+
+    /**
+     * @brief Gets the resolution at which voxels are looked up.
+     *
+     * @return the resolution level, which is 0 for the full resolution
+     */
+    int getResolutionLevel() const {
+        return resolution_level_;
+    }
+
+    /**
+     * @brief Gets the dimensions of the voxel grid at a resolution level.
+     *
+     * @param level The resolution level.
+     * @return the number of voxels along each axis at that level
+     * @throws std::out_of_range If the level is not between 0 and NUM_RESOLUTION_LEVELS - 1.
+     */
+    Eigen::Vector3i getDimVox(int level = 0) const;
+
     /**
      * @brief Gets the spatial dimensions of the voxel grid.
      * @return vector of spatial dimensions of the voxel grid
@@ -120,31 +318,188 @@ public:
 private:
     Eigen::Vector3i dim_vox_;
     Eigen::Vector3d spacing_; // in cm
+    Eigen::Vector3d inv_spacing_; // in 1/cm
     Eigen::Vector3d dim_space_; // in cm
     int numOfVoxels_ = 0;
+    int numOfStoredVoxels_ = 0; // including the padding of the bricks at the upper faces of a bricked voxel grid
     int numExits_ = 0;
-    std::vector<Voxel> voxels_;
+    std::shared_ptr<const uint8_t> materials_; // database material ID of each voxel. Owns the array or the mapping of the voxel file. Null if octree_ is set
+    std::shared_ptr<const VoxelOctree> octree_; // null unless the material IDs are stored in an octree
+    std::vector<float> density_scales_; // empty if every voxel is at the nominal density of its material
+    DoseGrid dose_grid_; // empty unless the dose is scored
+    std::vector<int> material_ids_; // database material IDs present in the voxel grid
+    std::array<uint8_t, 256> material_indices_{}; // material index of each database material ID
     std::string filename_;
+    std::string density_filename_;
     double units_ = 1.0; // in cm
-    bool is_python_environment_;
+    VoxelLayout layout_ = VoxelLayout::LINEAR;
+    Eigen::Vector3i dim_bricks_ = Eigen::Vector3i::Zero(); // dimensions of the voxel grid in bricks. Zero unless bricked
+    std::vector<int> brick_offsets_; // voxel number of the first voxel of each brick, with x varying fastest. Empty unless bricked
+
+    // a copy of the voxel grid downsampled by 2^L along each axis, in linear order
+    struct ResolutionLevel {
+        Eigen::Vector3i dim_vox;
+        Eigen::Vector3d inv_spacing; // in 1/cm
+        std::vector<uint8_t> materials; // database material ID of each voxel
+        std::vector<float> density_scales; // empty if every voxel is at the nominal density of its material
+        // offset from the origin of each block of its first voxel of the majority material, as i + j * 2^L + k * 4^L.
+        // In bytes at levels 1 and 2, whose blocks have at most 64 voxels, and otherwise in wide_block_offsets
+        std::vector<uint8_t> block_offsets;
+        std::vector<uint16_t> wide_block_offsets;
+        std::shared_ptr<const VoxelOctree> octree; // uniform blocks of the level. Null until the level is built
+    };
+    // levels 1 to NUM_RESOLUTION_LEVELS - 1, at index L - 1. Empty until a level is first set
+    std::vector<ResolutionLevel> resolution_levels_;
+    int resolution_level_ = 0;
+
+    static const int BRICK_SIZE = 8;
+    static const int BRICK_VOXELS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
 
-    // initialize voxels according to the nifti file
+    // initialize voxels according to the nifti or voxel file
     void initializeVoxels();
 
     // calculate the index of the voxel at (i, j, k)
-    int voxelNumber(const Eigen::Vector3i& voxel_index) const;
+    int voxelNumber(const Eigen::Vector3i& voxel_index) const {
+        if (layout_ == VoxelLayout::BRICKED) {
+            return brick_offsets_[brickNumber(voxel_index)] + brickVoxelNumber(voxel_index);
+        }
+        return voxel_index[0] + voxel_index[1]*dim_vox_[0] + voxel_index[2]*dim_vox_[0]*dim_vox_[1];
+    }
+
+    // index of the brick containing the voxel at (i, j, k), with x varying fastest
+    int brickNumber(const Eigen::Vector3i& voxel_index) const {
+        return voxel_index[0] / BRICK_SIZE + (voxel_index[1] / BRICK_SIZE) * dim_bricks_[0] +
+               (voxel_index[2] / BRICK_SIZE) * dim_bricks_[0] * dim_bricks_[1];
+    }
+
+    // Morton code of the voxel at (i, j, k) within its brick, interleaving the low three bits of each index
+    static int brickVoxelNumber(const Eigen::Vector3i& voxel_index) {
+        // spreads the three bits b2 b1 b0 to b2 0 0 b1 0 0 b0
+        static constexpr uint16_t SPREAD[BRICK_SIZE] = {0, 1, 8, 9, 64, 65, 72, 73};
+        return SPREAD[voxel_index[0] & (BRICK_SIZE - 1)] | (SPREAD[voxel_index[1] & (BRICK_SIZE - 1)] << 1) |
+               (SPREAD[voxel_index[2] & (BRICK_SIZE - 1)] << 2);
+    }
+
+    Eigen::Vector3i getVoxelIndexUnchecked(const Eigen::Vector3d& position) const {
+        return position.cwiseProduct(inv_spacing_).cast<int>().cwiseMin(dim_vox_ - Eigen::Vector3i::Ones());
+    }
+
+    // database material ID of the voxel at (i, j, k), whose index is voxel_number
+    uint8_t getMaterialIdAt(const Eigen::Vector3i& voxel_index, int voxel_number) const {
+        return octree_ ? octree_->getMaterialId(voxel_index) : materials_.get()[voxel_number];
+    }
+
+    // voxel of the current downsampled level at a position, whose index at that level is set to downsampled_index.
+    // Its voxel number is that of the voxel of the full resolution at the position if it has the material of the
+    // downsampled voxel, and otherwise that of a voxel of the block which does, so that energy deposited in a material
+    // is scored in a voxel of that material
+    Voxel getDownsampledVoxel(const Eigen::Vector3d& position, Eigen::Vector3i& downsampled_index) {
+        const ResolutionLevel& level = resolution_levels_[resolution_level_ - 1];
+        downsampled_index = position.cwiseProduct(level.inv_spacing).cast<int>().cwiseMin(level.dim_vox - Eigen::Vector3i::Ones());
+        const int downsampled_number = downsampled_index[0] + downsampled_index[1] * level.dim_vox[0] +
+                                       downsampled_index[2] * level.dim_vox[0] * level.dim_vox[1];
+        const uint8_t material_id = level.materials[downsampled_number];
+        const Eigen::Vector3i voxel_index = getVoxelIndexUnchecked(position);
+        int voxel_number = voxelNumber(voxel_index);
+        if (isDoseScored() && getMaterialIdAt(voxel_index, voxel_number) != material_id) {
+            voxel_number = getBlockVoxelNumber(level, downsampled_index, downsampled_number);
+        }
+        Voxel voxel = makeVoxel(voxel_number, material_id);
+        if (!level.density_scales.empty()) {
+            voxel.density_scale = level.density_scales[downsampled_number];
+        }
+        return voxel;
+    }
+
+    // voxel number of the first voxel of the majority material in the block of the downsampled voxel at
+    // downsampled_index of the current level, whose index at that level is downsampled_number
+    int getBlockVoxelNumber(const ResolutionLevel& level, const Eigen::Vector3i& downsampled_index, int downsampled_number) const {
+        const int factor = 1 << resolution_level_;
+        const int offset = level.block_offsets.empty() ? level.wide_block_offsets[downsampled_number]
+                                                       : level.block_offsets[downsampled_number];
+        const Eigen::Vector3i offset_index(offset & (factor - 1), (offset >> resolution_level_) & (factor - 1),
+                                           offset >> (2 * resolution_level_));
+        return voxelNumber(downsampled_index * factor + offset_index);
+    }
+
+    Voxel getVoxelAtIndex(const Eigen::Vector3i& voxel_index) {
+        const int voxel_number = voxelNumber(voxel_index);
+        return makeVoxel(voxel_number, getMaterialIdAt(voxel_index, voxel_number));
+    }
+
+    // voxel at voxel_number, whose database material ID is material_id
+    Voxel makeVoxel(int voxel_number, uint8_t material_id) {
+        Voxel voxel;
+        voxel.materialID = material_indices_[material_id];
+        if (!density_scales_.empty()) {
+            voxel.density_scale = density_scales_[voxel_number];
+        }
+        if (isDoseScored()) {
+            voxel.dose_grid = &dose_grid_;
+            voxel.voxel_number = voxel_number;
+        }
+        return voxel;
+    }
+
+    // calls f(voxel_number, material_id) for every voxel, with the database material ID
+    template <typename F>
+    void forEachVoxel(F f) const {
+        for (int k = 0; k < dim_vox_[2]; k++) {
+            for (int j = 0; j < dim_vox_[1]; j++) {
+                for (int i = 0; i < dim_vox_[0]; i++) {
+                    Eigen::Vector3i voxel_index(i, j, k);
+                    const int voxel_number = voxelNumber(voxel_index);
+                    f(voxel_number, getMaterialIdAt(voxel_index, voxel_number));
+                }
+            }
+        }
+    }
+
+    // copies of the given per-voxel array from the linear order of the file to the order of the layout, and back
+    template <typename T>
+    std::vector<T> toLayout(const T* linear_values, T padding_value) const {
+        std::vector<T> values(numOfStoredVoxels_, padding_value);
+        int linear_number = 0;
+        for (int k = 0; k < dim_vox_[2]; k++) {
+            for (int j = 0; j < dim_vox_[1]; j++) {
+                for (int i = 0; i < dim_vox_[0]; i++, linear_number++) {
+                    values[voxelNumber(Eigen::Vector3i(i, j, k))] = linear_values[linear_number];
+                }
+            }
+        }
+        return values;
+    }
+
+    template <typename T>
+    std::vector<T> toLinear(const T* values) const {
+        std::vector<T> linear_values(numOfVoxels_);
+        int linear_number = 0;
+        for (int k = 0; k < dim_vox_[2]; k++) {
+            for (int j = 0; j < dim_vox_[1]; j++) {
+                for (int i = 0; i < dim_vox_[0]; i++, linear_number++) {
+                    linear_values[linear_number] = values[voxelNumber(Eigen::Vector3i(i, j, k))];
+                }
+            }
+        }
+        return linear_values;
+    }
 
     void handleOutOfBounds(const Eigen::Vector3d& position) const;
 
-    void setVoxelProperties(const py::array_t<uint8_t>& array, const py::object &header);
+    void setVoxelProperties(const NIfTIReader& reader);
+    void setVoxelProperties(const VoxelFile& voxel_file);
 
-    static py::array_t<uint8_t> getNumPyArrayFromImg(const py::object& img);
-    void setDimVox(const py::array_t<uint8_t>& array);
-    void setUnits(const py::object& header);
-    void setSpacing(const py::object& header);
+    void setDimVox(const NIfTIReader& reader);
+    void setUnits(const NIfTIReader& reader);
+    void setSpacing(const NIfTIReader& reader);
     void setNumOfVoxels();
     void setDimSpace();
-    void setVoxelMaterialIDs(const py::array_t<uint8_t>& array);
+    void setVoxelMaterialIDs(NIfTIReader& reader);
+    void setVoxelMaterialIDs(const std::shared_ptr<const VoxelFile>& voxel_file);
+    void setVoxelDensityScales(NIfTIReader& reader);
+    void setLayout(VoxelLayout layout);
+    // builds the material IDs, density scale factors and octree of a downsampled level
+    void setResolutionLevelData(int level_number);
 };
 
 #endif // VOXELGRID_H
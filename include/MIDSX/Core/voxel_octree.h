@@ -0,0 +1,142 @@
+#ifndef MCXRAYTRANSPORT_VOXEL_OCTREE_H
+#define MCXRAYTRANSPORT_VOXEL_OCTREE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <Eigen/Core>
+
+/**
+ * @brief Struct which represents a leaf of a VoxelOctree.
+ */
+struct VoxelOctreeNode {
+    // database material ID of the voxel the node was looked up with
+    uint8_t material_id = 0;
+    // true if every voxel of the node has the same material and density, false if the node is a brick of mixed voxels
+    bool is_homogeneous = false;
+    // voxel index range of the node, clipped to the voxel grid. The upper bound is exclusive
+    Eigen::Vector3i min_index = Eigen::Vector3i::Zero();
+    Eigen::Vector3i max_index = Eigen::Vector3i::Zero();
+};
+
+/**
+ * @brief Class which stores the material IDs of a voxel grid in an octree that collapses homogeneous blocks.
+ *
+ * The leaves of the octree are blocks of 8x8x8 voxels. A block whose voxels all have the same material (and density, if
+ * the voxel grid has a density file) is stored as a single node, and eight sibling nodes of the same material and
+ * density are merged into their parent. Only blocks of mixed voxels keep their material IDs, at one byte per voxel, so
+ * the memory of phantoms with large uniform regions scales with the area of the boundaries between materials rather
+ * than with the volume.
+ *
+ * Each homogeneous node is an axis aligned box of one material and density, through which photons can be transported
+ * with the cross section of that material as the majorant (see ComputationalDomain::getHomogeneousDistance).
+ */
+class VoxelOctree {
+public:
+    /**
+     * @brief Edge length of the leaf blocks in voxels.
+     */
+    static const int BRICK_SIZE = 8;
+
+    VoxelOctree() = default;
+
+    /**
+     * @brief Constructor for the VoxelOctree class.
+     *
+     * @param dim_vox The dimensions of the voxel grid in voxels.
+     * @param materials The database material ID of each voxel, with x varying fastest.
+     * @param density_scales The density scale factor of each voxel, or nullptr if every voxel is at the nominal density of its material.
+     */
+    VoxelOctree(const Eigen::Vector3i& dim_vox, const uint8_t* materials, const float* density_scales);
+
+    /**
+     * @brief Gets the material ID of a voxel.
+     *
+     * @param voxel_index The (i, j, k) index of the voxel. Must be within the voxel grid.
+     * @return the database material ID of the voxel
+     */
+    uint8_t getMaterialId(const Eigen::Vector3i& voxel_index) const {
+        uint32_t node = root_;
+        int size = root_size_;
+        while ((node >> TYPE_SHIFT) == INTERIOR) {
+            size >>= 1;
+            node = nodes_[(node & INDEX_MASK) + childNumber(voxel_index, size)];
+        }
+        if ((node >> TYPE_SHIFT) == HOMOGENEOUS) {
+            return static_cast<uint8_t>(node);
+        }
+        return bricks_[static_cast<size_t>(node & INDEX_MASK) * BRICK_VOXELS + brickVoxelNumber(voxel_index)];
+    }
+
+    /**
+     * @brief Gets the leaf of the octree containing a voxel.
+     *
+     * @param voxel_index The (i, j, k) index of the voxel. Must be within the voxel grid.
+     * @return the material ID of the voxel, and whether the leaf is homogeneous with its voxel index range
+     */
+    VoxelOctreeNode getNode(const Eigen::Vector3i& voxel_index) const;
+
+    /**
+     * @brief Gets the number of nodes of the octree.
+     *
+     * @return number of nodes, including the root
+     */
+    size_t getNumOfNodes() const { return nodes_.size() + 1; }
+
+    /**
+     * @brief Gets the number of blocks of mixed voxels.
+     *
+     * @return number of leaf blocks which store the material ID of each voxel
+     */
+    size_t getNumOfBricks() const { return bricks_.size() / BRICK_VOXELS; }
+
+    /**
+     * @brief Gets the memory used by the octree.
+     *
+     * @return size of the nodes and blocks (bytes)
+     */
+    size_t getMemorySize() const { return nodes_.size() * sizeof(uint32_t) + bricks_.size(); }
+
+private:
+    // a node is a 2 bit type followed by the material ID of a homogeneous node, the index of the first of the eight
+    // children of an interior node, or the index of the block of a mixed node
+    enum NodeType : uint32_t {
+        HOMOGENEOUS = 0,
+        INTERIOR = 1,
+        BRICK = 2,
+    };
+    static const int TYPE_SHIFT = 30;
+    static const uint32_t INDEX_MASK = (1u << TYPE_SHIFT) - 1;
+    static const int BRICK_VOXELS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+    Eigen::Vector3i dim_vox_ = Eigen::Vector3i::Zero();
+    uint32_t root_ = HOMOGENEOUS;
+    int root_size_ = BRICK_SIZE; // edge length of the root in voxels, a power of two
+    std::vector<uint32_t> nodes_; // children of the interior nodes, in groups of eight
+    std::vector<uint8_t> bricks_; // material IDs of the mixed blocks, BRICK_VOXELS per block
+
+    // summary of the voxels of a node while the octree is built
+    struct BlockSummary {
+        enum State : uint8_t { EMPTY, UNIFORM, MIXED } state = EMPTY; // empty if outside of the voxel grid
+        uint8_t material_id = 0;
+        float density_scale = 1.0f;
+    };
+
+    // position of a child in the group of eight children of its parent, where size is the edge length of the child
+    static int childNumber(const Eigen::Vector3i& voxel_index, int size) {
+        return ((voxel_index[0] & size) ? 1 : 0) | ((voxel_index[1] & size) ? 2 : 0) | ((voxel_index[2] & size) ? 4 : 0);
+    }
+
+    static int brickVoxelNumber(const Eigen::Vector3i& voxel_index) {
+        return (voxel_index[0] & (BRICK_SIZE - 1)) + (voxel_index[1] & (BRICK_SIZE - 1)) * BRICK_SIZE +
+               (voxel_index[2] & (BRICK_SIZE - 1)) * BRICK_SIZE * BRICK_SIZE;
+    }
+
+    static BlockSummary mergeSummaries(const BlockSummary& first, const BlockSummary& second);
+
+    // writes the subtree of the node at (i, j, k) of the given level of the summaries, and returns the node
+    uint32_t buildNode(const std::vector<std::vector<BlockSummary>>& levels, const std::vector<Eigen::Vector3i>& level_dims,
+                       int level, const Eigen::Vector3i& block_index, const uint8_t* materials);
+};
+
+#endif //MCXRAYTRANSPORT_VOXEL_OCTREE_H
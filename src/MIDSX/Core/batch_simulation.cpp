@@ -0,0 +1,59 @@
+#include "Core/batch_simulation.h"
+#include <future>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+    // runs on the loading thread. The element database is shared with the transport, and is safe to read from both
+    BatchCase loadBatchCase(const std::string& json_file_path) {
+        double start_time = omp_get_wtime();
+        BatchCase batch_case;
+        batch_case.json_file_path = json_file_path;
+        try {
+            batch_case.comp_domain = std::make_unique<ComputationalDomain>(json_file_path);
+            batch_case.interaction_data = std::make_unique<InteractionData>(batch_case.comp_domain->getInteractionData());
+        }
+        catch (const std::exception& e) {
+            throw std::runtime_error("Could not load " + json_file_path + ": " + e.what());
+        }
+        batch_case.load_time = omp_get_wtime() - start_time;
+        return batch_case;
+    }
+}
+
+BatchTimings runBatchSimulation(const std::vector<std::string>& json_file_paths, PhotonSource& source,
+                                const std::function<std::vector<std::unique_ptr<SurfaceTally>>()>& surface_tally_init,
+                                const std::function<std::vector<std::unique_ptr<VolumeTally>>()>& volume_tally_init,
+                                int N_photons, const std::function<void(BatchCase&, PhysicsEngine&)>& process_results) {
+    BatchTimings timings;
+    double start_time = omp_get_wtime();
+    std::future<BatchCase> next_case;
+    if (!json_file_paths.empty()) {
+        next_case = std::async(std::launch::async, loadBatchCase, json_file_paths[0]);
+    }
+    for (size_t i = 0; i < json_file_paths.size(); i++) {
+        double wait_start_time = omp_get_wtime();
+        BatchCase batch_case = next_case.get(); // rethrows any error of the loading thread
+        batch_case.wait_time = omp_get_wtime() - wait_start_time;
+        if (i + 1 < json_file_paths.size()) {
+            next_case = std::async(std::launch::async, loadBatchCase, json_file_paths[i + 1]);
+        }
+
+        PhysicsEngine physics_engine(*batch_case.comp_domain, *batch_case.interaction_data);
+        runSimulation(source, physics_engine, surface_tally_init, volume_tally_init, N_photons, batch_case.run_time);
+        process_results(batch_case, physics_engine);
+
+        std::ostringstream summary; // formatted apart from std::cout, so its formatting flags are left as they were
+        summary << "Case " << i + 1 << "/" << json_file_paths.size() << " (" << batch_case.json_file_path << "): "
+                << std::fixed << std::setprecision(2) << "loaded in " << batch_case.load_time << " s, waited "
+                << batch_case.wait_time << " s, transported in " << batch_case.run_time << " s";
+        std::cout << summary.str() << std::endl;
+        timings.total_load_time += batch_case.load_time;
+        timings.total_wait_time += batch_case.wait_time;
+        timings.total_run_time += batch_case.run_time;
+    }
+    timings.wall_time = omp_get_wtime() - start_time;
+    return timings;
+}
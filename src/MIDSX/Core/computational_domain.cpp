@@ -2,15 +2,58 @@
 
 using json = nlohmann::json;
 
-ComputationalDomain::ComputationalDomain(const std::string &json_file_path,
-                                         bool is_python_environment):
-                                         is_python_environment_(is_python_environment) {
+namespace {
+    // lengths along a ray at which it enters and exits a box, with the entering length greater than the exiting
+    // length if the ray misses it
+    std::pair<double, double> getEnteringAndExitingLengths(const Eigen::AlignedBox3d &box, const Eigen::Vector3d &position,
+                                                           const Eigen::Vector3d &direction) {
+        double entering_length = -INF;
+        double exiting_length = INF;
+        for (int i = 0; i < 3; i++) {
+            if (std::abs(direction[i]) < EPSILON) {
+                // parallel to the faces along this axis, so either always or never between them
+                if (position[i] < box.min()[i] || position[i] > box.max()[i]) {
+                    return {INF, -INF};
+                }
+                continue;
+            }
+            double t1 = (box.min()[i] - position[i]) / direction[i];
+            double t2 = (box.max()[i] - position[i]) / direction[i];
+            entering_length = std::max(entering_length, std::min(t1, t2));
+            exiting_length = std::min(exiting_length, std::max(t1, t2));
+        }
+        return {entering_length, exiting_length};
+    }
+}
+
+ComputationalDomain::ComputationalDomain(const std::string &json_file_path) {
     initializeCompDomain(json_file_path);
 }
 
 InteractionData ComputationalDomain::getInteractionData() const {
     std::vector<std::string> material_names = getMaterialNames();
-    return InteractionData(material_names);
+    return InteractionData(material_names, getMaxDensityScales());
+}
+
+std::unordered_map<int, double> ComputationalDomain::getMaxDensityScales() const {
+    std::unordered_map<int, double> max_density_scales = {{material_ids_[background_voxel.materialID], background_voxel.density_scale}};
+    for (auto& primitive : primitives_) {
+        double& max_density_scale = max_density_scales[primitive->getMaterialId()];
+        max_density_scale = std::max(max_density_scale, 1.0); // primitives are at the nominal density of their material
+    }
+    for (auto& tetrahedral_mesh : tetrahedral_meshes_) {
+        for (int material_id : tetrahedral_mesh.first.getMaterialIds()) {
+            double& max_density_scale = max_density_scales[material_id];
+            max_density_scale = std::max(max_density_scale, 1.0); // as are the tetrahedra of meshes
+        }
+    }
+    for (auto& voxel_grid : voxel_grids_) {
+        for (auto& material_density_scale : voxel_grid.first.getMaxDensityScales()) {
+            double& max_density_scale = max_density_scales[material_density_scale.first];
+            max_density_scale = std::max(max_density_scale, material_density_scale.second);
+        }
+    }
+    return max_density_scales;
 }
 
 bool ComputationalDomain::isInComputationalDomain(const Eigen::Vector3d &position) const {
@@ -20,16 +63,146 @@ bool ComputationalDomain::isInComputationalDomain(const Eigen::Vector3d &positio
 
 }
 
-Voxel& ComputationalDomain::getVoxel(const Eigen::Vector3d &position) {
-    for (auto &voxel_grid : voxel_grids_) {
-        Eigen::Vector3d position_in_voxel_grid = position - voxel_grid.second;
-        if (voxel_grid.first.withinGrid(position_in_voxel_grid)) {
-            return voxel_grid.first.getVoxel(voxel_grid.first.getVoxelIndex(position_in_voxel_grid));
+Voxel ComputationalDomain::getVoxel(const Eigen::Vector3d &position) {
+    const int num_voxel_grids = static_cast<int>(voxel_grids_.size());
+    const int num_tetrahedral_meshes = static_cast<int>(tetrahedral_meshes_.size());
+    int cell = getLookupCell(position);
+    for (int i = lookup_cell_offsets_[cell]; i < lookup_cell_offsets_[cell + 1]; i++) {
+        int body = lookup_cell_bodies_[i];
+        const Eigen::AlignedBox3d& bounds = body_bounds_[body];
+        if (!bounds.contains(position)) {
+            continue;
+        }
+        if (body < num_voxel_grids) {
+            VoxelGrid& voxel_grid = voxel_grids_[body].first;
+            if (!voxel_grid_is_rotated_[body]) {
+                return voxel_grid.getVoxelUnchecked(position - bounds.min());
+            }
+            // the bounds of a rotated voxel grid enclose it, so the position may still be outside of it
+            Eigen::Vector3d voxel_grid_position = toVoxelGridPosition(body, position);
+            if (voxel_grid.withinGrid(voxel_grid_position)) {
+                return voxel_grid.getVoxelUnchecked(voxel_grid_position);
+            }
+            continue;
+        }
+        if (body < num_voxel_grids + num_tetrahedral_meshes) {
+            const TetrahedralMesh& tetrahedral_mesh = tetrahedral_meshes_[body - num_voxel_grids].first;
+            int tetrahedron = tetrahedral_mesh.findTetrahedron(position - tetrahedral_meshes_[body - num_voxel_grids].second);
+            if (tetrahedron >= 0) {
+                return tetrahedral_mesh.getVoxel(tetrahedron);
+            }
+            continue;
+        }
+        if (primitives_[body - num_voxel_grids - num_tetrahedral_meshes]->contains(position)) {
+            return primitive_voxels_[body - num_voxel_grids - num_tetrahedral_meshes];
         }
     }
     return background_voxel;
 }
 
+double ComputationalDomain::getHomogeneousDistance(const Eigen::Vector3d &position, const Eigen::Vector3d &direction, Voxel &voxel) {
+    const int num_voxel_grids = static_cast<int>(voxel_grids_.size());
+    const int num_tetrahedral_meshes = static_cast<int>(tetrahedral_meshes_.size());
+    int cell = getLookupCell(position);
+    for (int i = lookup_cell_offsets_[cell]; i < lookup_cell_offsets_[cell + 1]; i++) {
+        int body = lookup_cell_bodies_[i];
+        const Eigen::AlignedBox3d& bounds = body_bounds_[body];
+        if (!bounds.contains(position)) {
+            continue;
+        }
+        if (body < num_voxel_grids) {
+            VoxelGrid& voxel_grid = voxel_grids_[body].first;
+            Eigen::Vector3d voxel_grid_position = position - bounds.min();
+            Eigen::Vector3d voxel_grid_direction = direction;
+            if (voxel_grid_is_rotated_[body]) {
+                voxel_grid_position = toVoxelGridPosition(body, position);
+                if (!voxel_grid.withinGrid(voxel_grid_position)) {
+                    continue;
+                }
+                voxel_grid_direction = voxel_grid_inverse_rotations_[body] * direction; // rotations preserve distances
+            }
+            if (body_is_overlapped_[body]) {
+                // a region of the voxel grid may extend into an earlier voxel grid
+                voxel = voxel_grid.getVoxelUnchecked(voxel_grid_position);
+                return 0.0;
+            }
+            return voxel_grid.getHomogeneousDistance(voxel_grid_position, voxel_grid_direction, voxel);
+        }
+        if (body < num_voxel_grids + num_tetrahedral_meshes) {
+            const TetrahedralMesh& tetrahedral_mesh = tetrahedral_meshes_[body - num_voxel_grids].first;
+            Eigen::Vector3d mesh_position = position - tetrahedral_meshes_[body - num_voxel_grids].second;
+            int tetrahedron = tetrahedral_mesh.findTetrahedron(mesh_position);
+            if (tetrahedron < 0) {
+                continue;
+            }
+            voxel = tetrahedral_mesh.getVoxel(tetrahedron);
+            if (body_is_overlapped_[body]) {
+                return 0.0;
+            }
+            // each tetrahedron is a region of one material, so the majorant is local to it
+            return tetrahedral_mesh.getExitDistance(tetrahedron, mesh_position, direction);
+        }
+        const Primitive& primitive = *primitives_[body - num_voxel_grids - num_tetrahedral_meshes];
+        if (primitive.contains(position)) {
+            voxel = primitive_voxels_[body - num_voxel_grids - num_tetrahedral_meshes];
+            if (body_is_overlapped_[body]) {
+                return 0.0;
+            }
+            // the primitive is clipped by the computational domain, where the photon is terminated anyway
+            return std::max(primitive.getEnteringAndExitingLengths(position, direction).second, 0.0);
+        }
+    }
+    voxel = background_voxel;
+    return getBackgroundDistance(position, direction);
+}
+
+double ComputationalDomain::getBackgroundDistance(const Eigen::Vector3d &position, const Eigen::Vector3d &direction) const {
+    int cell = getLookupCell(position);
+    for (int i = lookup_cell_offsets_[cell]; i < lookup_cell_offsets_[cell + 1]; i++) {
+        if (body_bounds_[lookup_cell_bodies_[i]].contains(position)) {
+            return 0.0;
+        }
+    }
+    // the photon is terminated where it leaves the computational domain, so the background ends there too
+    double distance = getEnteringAndExitingLengths(Eigen::AlignedBox3d(Eigen::Vector3d::Zero(), dim_space_), position, direction).second;
+
+    // walk the lookup grid along the ray, crossing the block of empty cells around an empty cell in one go. The bodies
+    // are inclusive in the cells they overlap, so a body is entered within a cell it is listed in, and the walk can stop
+    // once it has passed the nearest entry found so far
+    const Eigen::Vector3d cell_size = dim_space_.cwiseQuotient(lookup_dim_.cast<double>());
+    const double nudge = 1e-9; // moves the lookup position off the face the walk stopped at (cm)
+    double walked = 0.0;
+    while (walked < distance) {
+        Eigen::Vector3i cell_index = getLookupCellIndex(position + (walked + nudge) * direction);
+        cell = cell_index[0] + cell_index[1] * lookup_dim_[0] + cell_index[2] * lookup_dim_[0] * lookup_dim_[1];
+        for (int i = lookup_cell_offsets_[cell]; i < lookup_cell_offsets_[cell + 1]; i++) {
+            std::pair<double, double> lengths = getEnteringAndExitingLengths(body_bounds_[lookup_cell_bodies_[i]], position, direction);
+            if (lengths.first <= lengths.second && lengths.second >= 0) {
+                distance = std::min(distance, lengths.first);
+            }
+        }
+        Eigen::Vector3d clearance = Eigen::Vector3d::Constant(std::max(lookup_cell_clearances_[cell], 0));
+        Eigen::AlignedBox3d block((cell_index.cast<double>() - clearance).cwiseProduct(cell_size),
+                                  (cell_index.cast<double>() + clearance + Eigen::Vector3d::Ones()).cwiseProduct(cell_size));
+        walked = std::max(getEnteringAndExitingLengths(block, position, direction).second, walked + nudge);
+    }
+    return std::max(distance, 0.0);
+}
+
+bool ComputationalDomain::hasHomogeneousRegions() const {
+    return !primitives_.empty() || !tetrahedral_meshes_.empty() ||
+           std::any_of(voxel_grids_.begin(), voxel_grids_.end(), [](const std::pair<VoxelGrid, Eigen::Vector3d>& voxel_grid) {
+               return voxel_grid.first.hasOctree() || voxel_grid.first.getResolutionLevel() > 0;
+           });
+}
+
+void ComputationalDomain::setResolutionLevel(int level) {
+    for (auto& voxel_grid : voxel_grids_) {
+        voxel_grid.first.setResolutionLevel(level);
+    }
+    resolution_level_ = level;
+}
+
 VoxelGrid& ComputationalDomain::getVoxelGridN(int N) {
     return voxel_grids_[N].first;
 }
@@ -38,6 +211,15 @@ Eigen::Vector3d ComputationalDomain::getVoxelGridOriginN(int N) {
     return voxel_grids_[N].second;
 }
 
+Eigen::Matrix3d ComputationalDomain::getVoxelGridRotationN(int N) const {
+    return voxel_grid_rotations_[N];
+}
+
+void ComputationalDomain::setVoxelGridRotationN(int N, const Eigen::Matrix3d& rotation) {
+    setVoxelGridRotation(N, rotation);
+    setVoxelGridLookup(); // the bounds of the voxel grid have changed
+}
+
 Eigen::Vector3d ComputationalDomain::getVoxelGridDimSpaceN(int N) {
     return voxel_grids_[N].first.getDimSpace();
 }
@@ -46,6 +228,26 @@ int ComputationalDomain::getNumVoxelGrids() const {
     return voxel_grids_.size();
 }
 
+const Primitive& ComputationalDomain::getPrimitiveN(int N) const {
+    return *primitives_[N];
+}
+
+int ComputationalDomain::getNumPrimitives() const {
+    return primitives_.size();
+}
+
+const TetrahedralMesh& ComputationalDomain::getTetrahedralMeshN(int N) const {
+    return tetrahedral_meshes_[N].first;
+}
+
+Eigen::Vector3d ComputationalDomain::getTetrahedralMeshOriginN(int N) const {
+    return tetrahedral_meshes_[N].second;
+}
+
+int ComputationalDomain::getNumTetrahedralMeshes() const {
+    return tetrahedral_meshes_.size();
+}
+
 
 void ComputationalDomain::initializeCompDomain(const std::string &json_file_path) {
     // Check if the file is a JSON
@@ -76,6 +278,10 @@ void ComputationalDomain::initializeCompDomain(const std::string &json_file_path
     std::string json_directory_path = json_absolute_path.parent_path().string();
     setCompProperties(json_object);
     setVoxelGrids(json_object, json_directory_path);
+    setTetrahedralMeshes(json_object, json_directory_path);
+    setPrimitives(json_object);
+    setMaterialIds();
+    setVoxelGridLookup();
 }
 bool ComputationalDomain::isJSON(const std::string &file_path) {
     return file_path.find(".json") != std::string::npos;
@@ -85,48 +291,264 @@ void ComputationalDomain::setCompProperties(const json &json_object) {
     std::array<double, 3> dim_space = json_object["dim_space"];
     dim_space_ = Eigen::Map<Eigen::Vector3d>(dim_space.data());
     // set background voxel
-    // initialize dummy interaction data object to use helper function
-    InteractionData interaction_data({});
-    background_voxel.materialID = interaction_data.getAnyMaterialIdFromName(json_object["background_material_name"]);
+    background_voxel.materialID = ElementDatabase::getInstance().getMaterialId(json_object["background_material_name"]);
 }
 
 void ComputationalDomain::setVoxelGrids(const json &json_object, const std::string &json_directory_path) {
     std::vector<std::string> nifti_file_paths;
+    std::vector<std::string> density_file_paths;
     std::vector<Eigen::Vector3d> origins;
+    std::vector<Eigen::Matrix3d> rotations;
+    std::vector<bool> score_doses;
+    std::vector<bool> octrees;
+    std::vector<VoxelLayout> layouts;
+    if (!json_object.contains("voxel_grids")) {
+        return; // optional, as the domain may be made of primitives only
+    }
     for (auto &voxel_grid_json: json_object["voxel_grids"]) {
         getNIFTIFilePaths(voxel_grid_json, json_directory_path, nifti_file_paths);
+        getDensityFilePaths(voxel_grid_json, json_directory_path, density_file_paths);
         getOrigins(voxel_grid_json, origins);
+        getRotations(voxel_grid_json, rotations);
+        getLayouts(voxel_grid_json, layouts);
+        score_doses.push_back(voxel_grid_json.value("score_dose", false)); // optional. Dose is not scored by default
+        octrees.push_back(voxel_grid_json.value("octree", false)); // optional. Material IDs are stored in an array by default
     }
-    std::unique_ptr<py::scoped_interpreter> guard;
-    if (!is_python_environment_) {
-        guard = std::make_unique<py::scoped_interpreter>(); // start python interpreter only if not already started
+    for (int i = 0; i < static_cast<int>(nifti_file_paths.size()); i++) {
+        voxel_grids_.emplace_back(VoxelGrid(nifti_file_paths[i], density_file_paths[i], layouts[i]), origins[i]);
+        if (score_doses[i]) {
+            voxel_grids_.back().first.enableDoseScoring();
+        }
+        if (octrees[i]) {
+            voxel_grids_.back().first.enableOctree();
+        }
+        voxel_grid_rotations_.push_back(Eigen::Matrix3d::Identity());
+        voxel_grid_inverse_rotations_.push_back(Eigen::Matrix3d::Identity());
+        voxel_grid_is_rotated_.push_back(false);
     }
-    for (int i = 0; i < nifti_file_paths.size(); i++) {
-        voxel_grids_.emplace_back(VoxelGrid(nifti_file_paths[i], is_python_environment_), origins[i]);
+    for (int i = 0; i < static_cast<int>(nifti_file_paths.size()); i++) {
+        setVoxelGridRotation(i, rotations[i]);
     }
 }
 
-std::vector<std::string> ComputationalDomain::getMaterialNames() const {
-    std::vector<std::string> material_names;
-    // get background material name
-    material_names.push_back(getBackgroundMaterialName());
-    // get unique material names from voxel grids
+void ComputationalDomain::setTetrahedralMeshes(const json &json_object, const std::string &json_directory_path) {
+    if (!json_object.contains("tetrahedral_meshes")) {
+        return; // optional
+    }
+    for (auto &tetrahedral_mesh_json: json_object["tetrahedral_meshes"]) {
+        std::string file_path = tetrahedral_mesh_json["file_path"];
+        if (!std::filesystem::path(file_path).is_absolute()) {
+            file_path = json_directory_path + "/" + file_path;
+        }
+        std::vector<Eigen::Vector3d> origins;
+        getOrigins(tetrahedral_mesh_json, origins);
+        tetrahedral_meshes_.emplace_back(TetrahedralMesh(file_path), origins[0]);
+    }
+}
+
+void ComputationalDomain::setPrimitives(const json &json_object) {
+    if (!json_object.contains("primitives")) {
+        return; // optional
+    }
+    for (auto &primitive_json: json_object["primitives"]) {
+        primitives_.push_back(createPrimitive(primitive_json));
+    }
+}
+
+void ComputationalDomain::setVoxelGridRotation(int N, const Eigen::Matrix3d &rotation) {
+    if (!(rotation.transpose() * rotation).isIdentity(1e-6) || std::abs(rotation.determinant() - 1.0) > 1e-6) {
+        throw std::runtime_error("The rotation of voxel grid " + std::to_string(N) + " is not a rotation matrix.");
+    }
+    voxel_grid_rotations_[N] = rotation;
+    voxel_grid_inverse_rotations_[N] = rotation.transpose();
+    // unrotated voxel grids take the faster lookup without a rotation
+    voxel_grid_is_rotated_[N] = !rotation.isIdentity(0.0);
+}
+
+void ComputationalDomain::setMaterialIds() {
+    // background material first, then the unique materials of the voxel grids, meshes and primitives
+    material_ids_ = {background_voxel.materialID};
+    auto addMaterialId = [this](int material_id) {
+        if (std::find(material_ids_.begin(), material_ids_.end(), material_id) == material_ids_.end()) {
+            material_ids_.push_back(material_id);
+        }
+    };
+    for (auto& voxel_grid : voxel_grids_) {
+        for (int material_id : voxel_grid.first.getMaterialIds()) {
+            addMaterialId(material_id);
+        }
+    }
+    for (auto& tetrahedral_mesh : tetrahedral_meshes_) {
+        for (int material_id : tetrahedral_mesh.first.getMaterialIds()) {
+            addMaterialId(material_id);
+        }
+    }
+    for (auto& primitive : primitives_) {
+        addMaterialId(primitive->getMaterialId());
+    }
+    if (material_ids_.size() > 256) {
+        throw std::runtime_error("The computational domain contains more than 256 materials.");
+    }
+    background_voxel.materialID = 0;
     for (auto& voxel_grid : voxel_grids_) {
-        std::vector<std::string> voxel_grid_material_names = voxel_grid.first.getMaterialNames();
-        for (auto& material_name : voxel_grid_material_names) {
-            if (std::find(material_names.begin(), material_names.end(), material_name) == material_names.end()) {
-                material_names.push_back(material_name);
+        voxel_grid.first.remapMaterialIds(material_ids_);
+    }
+    for (auto& tetrahedral_mesh : tetrahedral_meshes_) {
+        tetrahedral_mesh.first.remapMaterialIds(material_ids_);
+    }
+    primitive_voxels_.clear();
+    for (auto& primitive : primitives_) {
+        Voxel voxel;
+        voxel.materialID = static_cast<uint8_t>(std::find(material_ids_.begin(), material_ids_.end(), primitive->getMaterialId()) - material_ids_.begin());
+        primitive_voxels_.push_back(voxel);
+    }
+}
+
+void ComputationalDomain::setVoxelGridLookup() {
+    body_bounds_.clear();
+    for (int i = 0; i < static_cast<int>(voxel_grids_.size()); i++) {
+        Eigen::AlignedBox3d bounds(voxel_grids_[i].second, voxel_grids_[i].second + voxel_grids_[i].first.getDimSpace());
+        if (voxel_grid_is_rotated_[i]) {
+            // box enclosing the corners of the rotated voxel grid
+            Eigen::AlignedBox3d rotated_bounds;
+            for (int corner = 0; corner < 8; corner++) {
+                Eigen::Vector3d corner_offset = bounds.corner(static_cast<Eigen::AlignedBox3d::CornerType>(corner)) - bounds.center();
+                rotated_bounds.extend(bounds.center() + voxel_grid_rotations_[i] * corner_offset);
+            }
+            bounds = rotated_bounds;
+        }
+        body_bounds_.push_back(bounds);
+    }
+    for (auto& tetrahedral_mesh : tetrahedral_meshes_) {
+        const Eigen::AlignedBox3d& mesh_bounds = tetrahedral_mesh.first.getBoundingBox();
+        body_bounds_.emplace_back(mesh_bounds.min() + tetrahedral_mesh.second, mesh_bounds.max() + tetrahedral_mesh.second);
+    }
+    // primitives may be unbounded (e.g. slabs), so their bounds are clipped to the computational domain
+    const Eigen::AlignedBox3d domain_bounds(Eigen::Vector3d::Zero(), dim_space_);
+    for (auto& primitive : primitives_) {
+        body_bounds_.push_back(primitive->getBoundingBox().intersection(domain_bounds));
+    }
+    // bodies which only touch share no volume, so they do not overlap
+    body_is_overlapped_.assign(body_bounds_.size(), false);
+    for (size_t i = 0; i < body_bounds_.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            if ((body_bounds_[i].intersection(body_bounds_[j]).sizes().array() > 0).all()) {
+                body_is_overlapped_[i] = true;
+            }
+        }
+    }
+
+    // about 8 cells per body, so a cell overlaps few bodies while the table stays small
+    double num_cells = std::min(8.0 * std::max<size_t>(body_bounds_.size(), 1), 262144.0);
+    double cell_size = std::cbrt(dim_space_.prod() / num_cells);
+    for (int i = 0; i < 3; i++) {
+        if (cell_size > 0 && std::isfinite(cell_size) && dim_space_[i] > 0) {
+            lookup_dim_[i] = std::max(1, std::min(static_cast<int>(std::ceil(dim_space_[i] / cell_size)), 1024));
+            lookup_inv_cell_size_[i] = lookup_dim_[i] / dim_space_[i];
+        }
+        else {
+            lookup_dim_[i] = 1;
+            lookup_inv_cell_size_[i] = 0;
+        }
+    }
+
+    // cells overlapped by each body, with the bounds inclusive as in AlignedBox3d::contains. Bodies outside of the
+    // computational domain have empty bounds and overlap no cells
+    std::vector<std::pair<Eigen::Vector3i, Eigen::Vector3i>> cell_ranges;
+    for (auto& bounds : body_bounds_) {
+        if (bounds.isEmpty()) {
+            cell_ranges.emplace_back(Eigen::Vector3i::Zero(), -Eigen::Vector3i::Ones());
+            continue;
+        }
+        Eigen::Vector3i min_cell = getLookupCellIndex(bounds.min());
+        Eigen::Vector3i max_cell = getLookupCellIndex(bounds.max());
+        cell_ranges.emplace_back(min_cell, max_cell);
+    }
+    const int total_cells = lookup_dim_.prod();
+    std::vector<std::vector<int>> cell_bodies(total_cells);
+    for (int body = 0; body < static_cast<int>(cell_ranges.size()); body++) {
+        const auto& range = cell_ranges[body];
+        for (int k = range.first[2]; k <= range.second[2]; k++) {
+            for (int j = range.first[1]; j <= range.second[1]; j++) {
+                for (int i = range.first[0]; i <= range.second[0]; i++) {
+                    cell_bodies[i + j * lookup_dim_[0] + k * lookup_dim_[0] * lookup_dim_[1]].push_back(body);
+                }
+            }
+        }
+    }
+    lookup_cell_offsets_.assign(1, 0);
+    lookup_cell_bodies_.clear();
+    for (auto& bodies : cell_bodies) {
+        lookup_cell_bodies_.insert(lookup_cell_bodies_.end(), bodies.begin(), bodies.end());
+        lookup_cell_offsets_.push_back(static_cast<int>(lookup_cell_bodies_.size()));
+    }
+    setLookupCellClearances();
+}
+
+void ComputationalDomain::setLookupCellClearances() {
+    // breadth first search from the cells with bodies over the 26 neighbours of each cell, which gives the Chebyshev
+    // distance in cells to the nearest cell with a body
+    const int total_cells = lookup_dim_.prod();
+    const int max_clearance = lookup_dim_.maxCoeff(); // covers the whole grid, e.g. if there are no bodies
+    lookup_cell_clearances_.assign(total_cells, max_clearance);
+    std::vector<int> frontier;
+    for (int cell = 0; cell < total_cells; cell++) {
+        if (lookup_cell_offsets_[cell] != lookup_cell_offsets_[cell + 1]) {
+            lookup_cell_clearances_[cell] = -1;
+            frontier.push_back(cell);
+        }
+    }
+    std::vector<int> next_frontier;
+    for (int clearance = 0; !frontier.empty(); clearance++) {
+        next_frontier.clear();
+        for (int cell : frontier) {
+            Eigen::Vector3i index(cell % lookup_dim_[0], (cell / lookup_dim_[0]) % lookup_dim_[1], cell / (lookup_dim_[0] * lookup_dim_[1]));
+            Eigen::Vector3i min_index = (index - Eigen::Vector3i::Ones()).cwiseMax(0);
+            Eigen::Vector3i max_index = (index + Eigen::Vector3i::Ones()).cwiseMin(lookup_dim_ - Eigen::Vector3i::Ones());
+            for (int k = min_index[2]; k <= max_index[2]; k++) {
+                for (int j = min_index[1]; j <= max_index[1]; j++) {
+                    for (int i = min_index[0]; i <= max_index[0]; i++) {
+                        int neighbor = i + j * lookup_dim_[0] + k * lookup_dim_[0] * lookup_dim_[1];
+                        if (lookup_cell_clearances_[neighbor] > clearance) {
+                            lookup_cell_clearances_[neighbor] = clearance;
+                            next_frontier.push_back(neighbor);
+                        }
+                    }
+                }
             }
         }
+        std::swap(frontier, next_frontier);
+    }
+}
+
+Eigen::Vector3d ComputationalDomain::toVoxelGridPosition(int N, const Eigen::Vector3d &position) const {
+    Eigen::Vector3d half_dim_space = voxel_grids_[N].first.getDimSpace() / 2;
+    Eigen::Vector3d center = voxel_grids_[N].second + half_dim_space;
+    return voxel_grid_inverse_rotations_[N] * (position - center) + half_dim_space;
+}
+
+Eigen::Vector3i ComputationalDomain::getLookupCellIndex(const Eigen::Vector3d &position) const {
+    // clamped before the cast, so positions outside of the computational domain map to the nearest cell
+    Eigen::Vector3d cell = position.cwiseProduct(lookup_inv_cell_size_).cwiseMax(0.0).cwiseMin((lookup_dim_ - Eigen::Vector3i::Ones()).cast<double>());
+    return cell.cast<int>();
+}
+
+int ComputationalDomain::getLookupCell(const Eigen::Vector3d &position) const {
+    Eigen::Vector3i cell = getLookupCellIndex(position);
+    return cell[0] + cell[1] * lookup_dim_[0] + cell[2] * lookup_dim_[0] * lookup_dim_[1];
+}
+
+std::vector<std::string> ComputationalDomain::getMaterialNames() const {
+    std::vector<std::string> material_names;
+    for (int material_id : material_ids_) {
+        material_names.push_back(ElementDatabase::getInstance().getMaterialName(material_id));
     }
     return material_names;
 }
 
 std::string ComputationalDomain::getBackgroundMaterialName() const {
-    // create dummy interaction data object to use helper function
-    InteractionData interaction_data({});
-    int background_material_id = background_voxel.materialID;
-    return interaction_data.getAnyMaterialNameFromId(background_material_id);
+    int background_material_id = material_ids_[background_voxel.materialID];
+    return ElementDatabase::getInstance().getMaterialName(background_material_id);
 }
 
 
@@ -134,7 +556,7 @@ void ComputationalDomain::getNIFTIFilePaths(const json& voxel_grid_json, const s
                                             std::vector<std::string> &nifti_file_paths) {
     std::string file_path = voxel_grid_json["file_path"];
     std::filesystem::path path = file_path;
-    if (isNIFTI(file_path)) {
+    if (isNIFTI(file_path) || VoxelFile::isVoxelFile(file_path)) {
         if (path.is_absolute()) {
             nifti_file_paths.push_back(file_path);
         }
@@ -143,7 +565,26 @@ void ComputationalDomain::getNIFTIFilePaths(const json& voxel_grid_json, const s
         }
     }
     else {
-        throw std::runtime_error("The file provided is not a NIFTI file.");
+        throw std::runtime_error("The file provided is not a NIFTI or MIDSX voxel file.");
+    }
+}
+
+void ComputationalDomain::getDensityFilePaths(const json& voxel_grid_json, const std::string &json_directory_path,
+                                              std::vector<std::string> &density_file_paths) {
+    // optional. Voxels are at the nominal density of their material if no density file is given
+    if (!voxel_grid_json.contains("density_file_path")) {
+        density_file_paths.emplace_back();
+        return;
+    }
+    std::string file_path = voxel_grid_json["density_file_path"];
+    if (!isNIFTI(file_path)) {
+        throw std::runtime_error("The density file provided is not a NIFTI file.");
+    }
+    if (std::filesystem::path(file_path).is_absolute()) {
+        density_file_paths.push_back(file_path);
+    }
+    else {
+        density_file_paths.push_back(json_directory_path + "/" + file_path);
     }
 }
 
@@ -154,6 +595,70 @@ void ComputationalDomain::getOrigins(const json &voxel_grid_json, std::vector<Ei
 }
 
 
+std::shared_ptr<const Primitive> ComputationalDomain::createPrimitive(const json &primitive_json) {
+    auto toVector = [](const json &vector_json) {
+        std::array<double, 3> vector = vector_json;
+        return Eigen::Vector3d(vector[0], vector[1], vector[2]);
+    };
+    std::string type = primitive_json["type"];
+    int material_id = ElementDatabase::getInstance().getMaterialId(primitive_json["material_name"]);
+    if (type == "box") {
+        return std::make_shared<const BoxPrimitive>(toVector(primitive_json["min"]), toVector(primitive_json["max"]), material_id);
+    }
+    else if (type == "sphere") {
+        return std::make_shared<const SpherePrimitive>(toVector(primitive_json["center"]), primitive_json["radius"].get<double>(), material_id);
+    }
+    else if (type == "cylinder") {
+        return std::make_shared<const CylinderPrimitive>(toVector(primitive_json["center"]), toVector(primitive_json["axis"]),
+                                                         primitive_json["radius"].get<double>(), primitive_json["height"].get<double>(), material_id);
+    }
+    else if (type == "slab") {
+        return std::make_shared<const SlabPrimitive>(toVector(primitive_json["normal"]), primitive_json["offset"].get<double>(),
+                                                     primitive_json["thickness"].get<double>(), material_id);
+    }
+    throw std::runtime_error("Unknown primitive type " + type + ". Expected box, sphere, cylinder or slab.");
+}
+
+void ComputationalDomain::getRotations(const json &voxel_grid_json, std::vector<Eigen::Matrix3d> &rotations) {
+    // optional. Either {"axis": [x, y, z], "angle": degrees} or the rows of a rotation matrix
+    if (!voxel_grid_json.contains("rotation")) {
+        rotations.push_back(Eigen::Matrix3d::Identity());
+        return;
+    }
+    const json &rotation_json = voxel_grid_json["rotation"];
+    if (rotation_json.is_object()) {
+        std::array<double, 3> axis = rotation_json["axis"];
+        Eigen::Vector3d axis_vector = Eigen::Map<Eigen::Vector3d>(axis.data());
+        if (!(axis_vector.norm() > 0)) {
+            throw std::runtime_error("The rotation axis of a voxel grid must be nonzero.");
+        }
+        double angle = rotation_json["angle"].get<double>() * PI / 180.0;
+        rotations.push_back(Eigen::AngleAxisd(angle, axis_vector.normalized()).toRotationMatrix());
+        return;
+    }
+    std::array<std::array<double, 3>, 3> matrix = rotation_json;
+    Eigen::Matrix3d rotation;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            rotation(i, j) = matrix[i][j];
+        }
+    }
+    rotations.push_back(rotation);
+}
+
+void ComputationalDomain::getLayouts(const json &voxel_grid_json, std::vector<VoxelLayout> &layouts) {
+    std::string layout = voxel_grid_json.value("layout", "linear"); // optional. Voxels are stored in the order of the file by default
+    if (layout == "linear") {
+        layouts.push_back(VoxelLayout::LINEAR);
+    }
+    else if (layout == "bricked") {
+        layouts.push_back(VoxelLayout::BRICKED);
+    }
+    else {
+        throw std::runtime_error("Unknown voxel grid layout " + layout + ". Expected linear or bricked.");
+    }
+}
+
 bool ComputationalDomain::isNIFTI(const std::string &file_path) {
     return file_path.find(".nii") != std::string::npos;
 }
@@ -1,24 +1,87 @@
 #include "Core/data_access_object.h"
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+    bool isValidIdentifier(const std::string& name) {
+        if (name.empty()) return false;
+        for (char c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+        }
+        return true;
+    }
+
+    // resets the statement when leaving scope, so it can be reused even if reading the results throws
+    struct StatementResetter {
+        sqlite3_stmt* statement;
+        ~StatementResetter() {
+            sqlite3_reset(statement);
+            sqlite3_clear_bindings(statement);
+        }
+    };
+}
 
 DatabaseException::DatabaseException(std::string  message) : msg_(std::move(message)) {}
 
 const char* DatabaseException::what() const noexcept { return msg_.c_str(); }
 
-DataAccessObject::DataAccessObject(const std::string& db_name) {
-    int rc = sqlite3_open(db_name.c_str(), &db);
-    if(rc) {
-        std::cout << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
+struct DataAccessObject::Connection {
+    sqlite3* db = nullptr;
+    std::unordered_map<std::string, sqlite3_stmt*> statements;
+
+    explicit Connection(const std::string& db_path) {
+        // each connection is only used by its own thread, so SQLite's internal locking is not needed
+        int rc = sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
+        if (rc != SQLITE_OK) {
+            std::string message = "Can't open database " + db_path + ": " + (db ? sqlite3_errmsg(db) : "out of memory");
+            sqlite3_close(db);
+            throw DatabaseException(message);
+        }
     }
-}
 
-DataAccessObject::~DataAccessObject() {
-    sqlite3_close(db);
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    ~Connection() {
+        for (auto& statement : statements) {
+            sqlite3_finalize(statement.second);
+        }
+        sqlite3_close(db);
+    }
+};
+
+class DataAccessObject::ConnectionPool {
+public:
+    explicit ConnectionPool(std::string db_path) : db_path_(std::move(db_path)) {}
+
+    Connection& getConnection() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& connection = connections_[std::this_thread::get_id()];
+        if (!connection) {
+            connection = std::make_unique<Connection>(db_path_);
+        }
+        return *connection;
+    }
+
+private:
+    std::string db_path_;
+    std::mutex mutex_;
+    std::unordered_map<std::thread::id, std::unique_ptr<Connection>> connections_;
+};
+
+DataAccessObject::DataAccessObject(const std::string& db_name) : db_path_(db_name),
+                                                                 pool_(std::make_shared<ConnectionPool>(db_name)) {
+    // open the connection of this thread now, so a bad path is reported here rather than at the first query
+    pool_->getConnection();
 }
 
 std::vector<std::string> DataAccessObject::executeQuery(const std::string& query) {
     char* zErrMsg = nullptr;
     std::vector<std::string> results;
-    int rc = sqlite3_exec(db, query.c_str(), callback, &results, &zErrMsg);
+    int rc = sqlite3_exec(pool_->getConnection().db, query.c_str(), callback, &results, &zErrMsg);
     if(rc != SQLITE_OK) {
         std::string errMsg;
         if (zErrMsg) {
@@ -33,6 +96,108 @@ std::vector<std::string> DataAccessObject::executeQuery(const std::string& query
     return results;
 }
 
+Eigen::MatrixXd DataAccessObject::queryMatrix(const std::string& query, const std::vector<Parameter>& parameters) {
+    sqlite3_stmt* statement = prepareStatement(query, parameters);
+    StatementResetter resetter{statement};
+
+    const int num_columns = sqlite3_column_count(statement);
+    std::vector<double> values;
+    int rc;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        for (int i = 0; i < num_columns; ++i) {
+            values.push_back(sqlite3_column_type(statement, i) == SQLITE_NULL ? std::numeric_limits<double>::quiet_NaN()
+                                                                              : sqlite3_column_double(statement, i));
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        throw DatabaseException(sqlite3_errmsg(sqlite3_db_handle(statement)));
+    }
+
+    const Eigen::Index num_rows = num_columns > 0 ? static_cast<Eigen::Index>(values.size()) / num_columns : 0;
+    return Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(values.data(), num_rows, num_columns);
+}
+
+std::vector<std::string> DataAccessObject::queryStrings(const std::string& query, const std::vector<Parameter>& parameters) {
+    sqlite3_stmt* statement = prepareStatement(query, parameters);
+    StatementResetter resetter{statement};
+
+    const int num_columns = sqlite3_column_count(statement);
+    std::vector<std::string> results;
+    int rc;
+    while ((rc = sqlite3_step(statement)) == SQLITE_ROW) {
+        for (int i = 0; i < num_columns; ++i) {
+            const unsigned char* text = sqlite3_column_text(statement, i);
+            results.emplace_back(text ? reinterpret_cast<const char*>(text) : "");
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        throw DatabaseException(sqlite3_errmsg(sqlite3_db_handle(statement)));
+    }
+    return results;
+}
+
+std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> DataAccessObject::queryElementTables(const std::string& table_name,
+                                                                                                      const std::string& column_name,
+                                                                                                      const std::vector<int>& element_ids) {
+    // identifiers cannot be bound as parameters, so they are validated instead
+    if (!isValidIdentifier(table_name) || !isValidIdentifier(column_name)) {
+        throw DatabaseException("Invalid table or column name: " + table_name + "." + column_name);
+    }
+    std::string placeholders;
+    std::vector<Parameter> parameters;
+    for (int element_id : element_ids) {
+        placeholders += placeholders.empty() ? "?" : ", ?";
+        parameters.emplace_back(element_id);
+    }
+    std::string query = "SELECT ElementID, Energy, " + column_name + " FROM " + table_name +
+                        (element_ids.empty() ? "" : " WHERE ElementID IN (" + placeholders + ")") +
+                        " ORDER BY ElementID, rowid;";
+    Eigen::MatrixXd rows = queryMatrix(query, parameters);
+
+    std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> tables;
+
+    // rows are grouped by element, so each element is one contiguous block
+    Eigen::Index start = 0;
+    while (start < rows.rows()) {
+        Eigen::Index end = start;
+        while (end < rows.rows() && rows(end, 0) == rows(start, 0)) {
+            ++end;
+        }
+        tables[static_cast<int>(rows(start, 0))] = rows.block(start, 1, end - start, 2);
+        start = end;
+    }
+    return tables;
+}
+
+sqlite3_stmt* DataAccessObject::prepareStatement(const std::string& query, const std::vector<Parameter>& parameters) {
+    Connection& connection = pool_->getConnection();
+    sqlite3_stmt*& statement = connection.statements[query];
+    if (!statement) {
+        if (sqlite3_prepare_v2(connection.db, query.c_str(), -1, &statement, nullptr) != SQLITE_OK) {
+            std::string message = sqlite3_errmsg(connection.db);
+            connection.statements.erase(query);
+            throw DatabaseException(message);
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>(parameters.size()); ++i) {
+        int rc;
+        if (const auto* int_value = std::get_if<int>(&parameters[i])) {
+            rc = sqlite3_bind_int(statement, i + 1, *int_value);
+        } else if (const auto* double_value = std::get_if<double>(&parameters[i])) {
+            rc = sqlite3_bind_double(statement, i + 1, *double_value);
+        } else {
+            const auto& string_value = std::get<std::string>(parameters[i]);
+            rc = sqlite3_bind_text(statement, i + 1, string_value.c_str(), static_cast<int>(string_value.size()), SQLITE_TRANSIENT);
+        }
+        if (rc != SQLITE_OK) {
+            sqlite3_clear_bindings(statement);
+            throw DatabaseException(sqlite3_errmsg(connection.db));
+        }
+    }
+    return statement;
+}
+
 int DataAccessObject::callback(void* data, int argc, char** argv, char** azColName) {
     auto* results = static_cast<std::vector<std::string>*>(data);
     for(int i = 0; i < argc; i++){
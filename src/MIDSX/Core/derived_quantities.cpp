@@ -11,9 +11,12 @@ double DerivedQuantity::getPrimaryFluence(SurfaceQuantityContainer &surface_quan
     }
 
     VectorValue& incident_energies = surface_quantity_container.getVectorQuantities().at(VectorSurfaceQuantityType::IncidentEnergy).getPrimaryValues();
+    if (!incident_energies.isRetainingValues()) {
+        throw std::runtime_error("SurfaceQuantityContainer does not retain the incident energies required for fluence calculation. Create it with SurfaceQuantityContainerFactory::AllQuantities(true)");
+    }
 
     // get vector
-    std::vector<double>& incident_energies_vector = incident_energies.getVector();
+    const std::vector<double>& incident_energies_vector = incident_energies.getVector();
 
     if (is_cosine_weighted) {
         // sum of entrance cosine
@@ -26,7 +29,7 @@ double DerivedQuantity::getPrimaryFluence(SurfaceQuantityContainer &surface_quan
         VectorValue& entrance_cosines = surface_quantity_container.getVectorQuantities().at(VectorSurfaceQuantityType::EntranceCosine).getPrimaryValues();
 
         // get vectors
-        std::vector<double>& entrance_cosines_vector = entrance_cosines.getVector();
+        const std::vector<double>& entrance_cosines_vector = entrance_cosines.getVector();
 
         for (int i = 0; i < incident_energies_vector.size(); i++) {
             if (incident_energies_vector[i] >= energy - energy_width/2 && incident_energies_vector[i] <= energy + energy_width/2) {
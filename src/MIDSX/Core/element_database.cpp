@@ -0,0 +1,169 @@
+#include "Core/element_database.h"
+#include <stdexcept>
+
+const ElementDatabase& ElementDatabase::getInstance() {
+    // initialization of a function-local static is thread-safe, so concurrent first calls open the database once
+    static const ElementDatabase instance(MIDSX_DB_PATH);
+    return instance;
+}
+
+ElementDatabase::ElementDatabase(const std::string& db_path) : dao_(db_path) {
+    loadMaterials();
+    loadElements();
+}
+
+int ElementDatabase::getMaterialId(const std::string& name) const {
+    auto it = material_ids_.find(name);
+    if (it == material_ids_.end()) {
+        throw std::runtime_error("Material " + name + " not found in the database");
+    }
+    return it->second;
+}
+
+const std::string& ElementDatabase::getMaterialName(int id) const {
+    auto it = material_names_.find(id);
+    if (it == material_names_.end()) {
+        throw std::runtime_error("Material ID " + std::to_string(id) + " not found in the database");
+    }
+    return it->second;
+}
+
+double ElementDatabase::getMaterialDensity(int id) const {
+    auto it = material_densities_.find(id);
+    if (it == material_densities_.end()) {
+        throw std::runtime_error("Material ID " + std::to_string(id) + " not found in the database");
+    }
+    return it->second;
+}
+
+const std::unordered_map<int, double>& ElementDatabase::getMaterialComposition(int id) const {
+    auto it = material_compositions_.find(id);
+    if (it == material_compositions_.end()) {
+        throw std::runtime_error("Material ID " + std::to_string(id) + " has no composition in the database");
+    }
+    return it->second;
+}
+
+const ElementDatabase::Element& ElementDatabase::getElement(int id) const {
+    auto it = elements_.find(id);
+    if (it == elements_.end()) {
+        throw std::runtime_error("Element ID " + std::to_string(id) + " not found in the database");
+    }
+    return it->second;
+}
+
+std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> ElementDatabase::getElementTables(const std::string& table_name,
+                                                                                                   const std::string& column_name,
+                                                                                                   const std::vector<int>& element_ids) const {
+    std::shared_ptr<const Table> table = getTable(table_name, column_name);
+    std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> matrices_map;
+    for (int element_id : element_ids) {
+        matrices_map[element_id] = getElementMatrix(*table, table_name, element_id);
+    }
+    return matrices_map;
+}
+
+std::unordered_map<int, std::shared_ptr<const Interpolator::Interpolator>> ElementDatabase::getElementInterpolators(const std::string& table_name,
+                                                                                                                   const std::string& column_name,
+                                                                                                                   const std::vector<int>& element_ids) const {
+    const std::string key = table_name + "." + column_name;
+    std::unordered_map<int, std::shared_ptr<const Interpolator::Interpolator>> interpolators_map;
+    std::vector<int> missing_element_ids;
+    {
+        std::lock_guard<std::mutex> lock(interpolators_mutex_);
+        auto& interpolators = interpolators_[key];
+        for (int element_id : element_ids) {
+            auto it = interpolators.find(element_id);
+            if (it != interpolators.end()) {
+                interpolators_map[element_id] = it->second;
+            } else {
+                missing_element_ids.push_back(element_id);
+            }
+        }
+    }
+    if (missing_element_ids.empty()) {
+        return interpolators_map;
+    }
+
+    // spline fits are built without holding the lock, so materials loaded in parallel are not serialized. If two threads
+    // build the same interpolator, the first one stored is kept
+    std::shared_ptr<const Table> table = getTable(table_name, column_name);
+    std::vector<std::shared_ptr<const Interpolator::Interpolator>> built_interpolators;
+    for (int element_id : missing_element_ids) {
+        built_interpolators.push_back(createInterpolator(table_name, getElementMatrix(*table, table_name, element_id)));
+    }
+    std::lock_guard<std::mutex> lock(interpolators_mutex_);
+    auto& interpolators = interpolators_[key];
+    for (size_t i = 0; i < missing_element_ids.size(); ++i) {
+        interpolators_map[missing_element_ids[i]] = interpolators.emplace(missing_element_ids[i], built_interpolators[i]).first->second;
+    }
+    return interpolators_map;
+}
+
+void ElementDatabase::loadMaterials() {
+    std::vector<std::string> names = dao_.queryStrings("SELECT MaterialID, Name FROM Materials;");
+    for (size_t i = 0; i + 1 < names.size(); i += 2) {
+        int id = std::stoi(names[i]);
+        material_ids_.emplace(names[i + 1], id);
+        material_names_.emplace(id, names[i + 1]);
+    }
+    Eigen::MatrixXd densities = dao_.queryMatrix("SELECT MaterialID, Density FROM Materials;");
+    for (int i = 0; i < densities.rows(); ++i) {
+        material_densities_[static_cast<int>(densities(i, 0))] = densities(i, 1);
+    }
+    Eigen::MatrixXd compositions = dao_.queryMatrix("SELECT MaterialID, ElementID, WeightFraction FROM MaterialCompositions;");
+    for (int i = 0; i < compositions.rows(); ++i) {
+        material_compositions_[static_cast<int>(compositions(i, 0))][static_cast<int>(compositions(i, 1))] = compositions(i, 2);
+    }
+}
+
+void ElementDatabase::loadElements() {
+    Eigen::MatrixXd elements = dao_.queryMatrix("SELECT ID, AtomicNumber, Mass, Density, MassNumber FROM Elements;");
+    for (int i = 0; i < elements.rows(); ++i) {
+        elements_[static_cast<int>(elements(i, 0))] = {static_cast<int>(elements(i, 1)), elements(i, 2),
+                                                       elements(i, 3), elements(i, 4)};
+    }
+}
+
+std::shared_ptr<const ElementDatabase::Table> ElementDatabase::getTable(const std::string& table_name, const std::string& column_name) const {
+    // held while loading, so each table is read once even if materials are built in parallel
+    std::lock_guard<std::mutex> lock(tables_mutex_);
+    auto& table = tables_[table_name + "." + column_name];
+    if (!table) {
+        auto loaded_table = std::make_shared<Table>();
+        for (auto& element_matrix : dao_.queryElementTables(table_name, column_name)) {
+            (*loaded_table)[element_matrix.first] = {element_matrix.second.col(0), element_matrix.second.col(1)};
+        }
+        table = std::move(loaded_table);
+    }
+    return table;
+}
+
+Eigen::Matrix<double, Eigen::Dynamic, 2> ElementDatabase::getElementMatrix(const Table& table, const std::string& table_name, int element_id) {
+    auto it = table.find(element_id);
+    if (it == table.end()) {
+        throw std::runtime_error("Element ID " + std::to_string(element_id) + " not found in " + table_name);
+    }
+    Eigen::Matrix<double, Eigen::Dynamic, 2> matrix(it->second.energies.size(), 2);
+    matrix << it->second.energies, it->second.values;
+    return matrix;
+}
+
+std::shared_ptr<const Interpolator::Interpolator> ElementDatabase::createInterpolator(const std::string& table_name,
+                                                                                     const Eigen::Matrix<double, Eigen::Dynamic, 2>& matrix) {
+    if (table_name == "IncoherentScatteringFunctions") {
+        return std::make_shared<Interpolator::LogLogLinear>(matrix);
+    } else if (table_name == "CoherentScatteringFormFactors") {
+        return std::make_shared<Interpolator::LogLogLinear>(matrix);
+    } else if (table_name == "IncoherentScatteringCrossSections") {
+        return std::make_shared<Interpolator::LogLogSpline>(matrix);
+    } else if (table_name == "CoherentScatteringCrossSections") {
+        return std::make_shared<Interpolator::LogLogSpline>(matrix);
+    } else if (table_name == "TotalPhotoIonizationCrossSections") {
+        return std::make_shared<Interpolator::LogLogLinear>(matrix);
+    } else if (table_name == "MassEnergyAbsorptionCoefficients") {
+        return std::make_shared<Interpolator::LogLogLinear>(matrix);
+    } else {
+        throw std::runtime_error("Invalid table");
+    }
+}
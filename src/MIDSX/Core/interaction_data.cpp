@@ -1,41 +1,47 @@
 #include "Core/interaction_data.h"
 
-InteractionData::InteractionData(const std::vector<std::string>& material_names) :
-        dao_(DataAccessObject(MIDSX_DB_PATH)), material_names_(material_names) {
+InteractionData::InteractionData(const std::vector<std::string>& material_names,
+                                 std::unordered_map<int, double> max_density_scales) :
+        database_(ElementDatabase::getInstance()), material_names_(material_names),
+        max_density_scales_(std::move(max_density_scales)) {
     initializeData();
 }
 
+double InteractionData::getMaxDensityScale(int id) const {
+    auto it = max_density_scales_.find(id);
+    return it == max_density_scales_.end() ? 1.0 : it->second;
+}
+
 std::string InteractionData::getAnyMaterialNameFromId(int id) {
-    std::string material_name = InteractionDataHelpers::convertMaterialIdToName(id, dao_);
-    return material_name;
+    return database_.getMaterialName(id);
 }
 
 uint8_t InteractionData::getAnyMaterialIdFromName(std::string name) {
-    uint8_t material_id = InteractionDataHelpers::convertMaterialNameToId(name, dao_);
-    return material_id;
+    return static_cast<uint8_t>(database_.getMaterialId(name));
 }
 
 void InteractionData::initializeData() {
-    setMaterialMap();
+    setMaterials();
     setMaxTotalCrossSectionsAndInterpolator();
 }
 
-void InteractionData::setMaterialMap() {
-#pragma omp parallel default(none) shared(material_map_, material_names_, dao_)
-    {
-        std::vector<Material> temp_materials;
-#pragma omp for
-        for (const auto &material_name: material_names_) {
-            Material temp_material(material_name, dao_);
-            temp_materials.emplace_back(temp_material);
-        }
-#pragma omp critical
-        {
-            for (auto &material: temp_materials) {
-                material_map_.emplace(material.getProperties().getMaterialId(), material);
-            }
+void InteractionData::setMaterials() {
+    std::vector<std::string> unique_material_names;
+    for (const auto &material_name: material_names_) {
+        int material_id = database_.getMaterialId(material_name);
+        if (material_indices_.emplace(material_id, static_cast<int>(unique_material_names.size())).second) {
+            unique_material_names.push_back(material_name);
         }
     }
+    std::vector<std::unique_ptr<Material>> loaded_materials(unique_material_names.size());
+#pragma omp parallel for default(none) shared(loaded_materials, unique_material_names, database_)
+    for (int i = 0; i < static_cast<int>(unique_material_names.size()); ++i) {
+        loaded_materials[i] = std::make_unique<Material>(unique_material_names[i], database_);
+    }
+    materials_.reserve(loaded_materials.size());
+    for (auto &material: loaded_materials) {
+        materials_.push_back(std::move(*material));
+    }
 }
 
 
@@ -47,8 +53,8 @@ void InteractionData::setMaxTotalCrossSectionsAndInterpolator() {
 Eigen::Matrix<double, Eigen::Dynamic, 2> InteractionData::getTotalMaxCrossSectionsMatrixFromInteractionData() {
     // create a vector of all energy matrices for each element
     std::vector<Eigen::MatrixXd> all_energies;
-    for (auto& material : material_map_) {
-        all_energies.emplace_back(material.second.getData().getTotalCrossSectionMatrix().col(0));
+    for (auto& material : materials_) {
+        all_energies.emplace_back(material.getData().getTotalCrossSectionMatrix().col(0));
     }
     // merge the energy column vectors into a single matrix
     Eigen::MatrixXd merged_energy_matrix = InteractionDataHelpers::mergeMatrices(all_energies);
@@ -63,8 +69,9 @@ void InteractionData::fillTotalMaxCrossSectionsMatrix(Eigen::MatrixXd& total_max
     for (int i = 0; i < merged_energy_matrix.rows(); ++i) {
         double energy = merged_energy_matrix(i, 0);
         std::vector<double> total_cross_section_for_each_element;
-        for (auto& material : material_map_) {
-            total_cross_section_for_each_element.emplace_back(material.second.getData().interpolateTotalCrossSection(energy));
+        for (auto& material : materials_) {
+            total_cross_section_for_each_element.emplace_back(getMaxDensityScale(material.getProperties().getMaterialId()) *
+                                                              material.getData().interpolateTotalCrossSection(energy));
         }
         double max_cross_section = *std::max_element(total_cross_section_for_each_element.begin(), total_cross_section_for_each_element.end());
         total_max_cross_sections_matrix(i, 0) = energy;
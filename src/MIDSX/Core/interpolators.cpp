@@ -11,6 +11,12 @@ Interpolator::Spline::Spline(const Eigen::MatrixXd &data) :
                 scaledValues(x_vec_)))
 { }
 
+Interpolator::Spline::Spline(double x_min, double x_max, const Eigen::RowVectorXd &knots, const Eigen::RowVectorXd &control_points) :
+        x_min_(x_min),
+        x_max_(x_max),
+        spline_(knots, control_points)
+{ }
+
 double Interpolator::Spline::operator()(double x) const {
     return spline_(scaledValue(x))(0);
 }
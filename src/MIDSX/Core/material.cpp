@@ -1,7 +1,55 @@
 #include "Core/material.h"
 
+namespace {
+    // an entry which passes its checksum can still fail to deserialize, e.g. after a change of layout without a bump of
+    // the format version. Such an entry is treated as a miss: cached is reset, so the material is built from the
+    // database and the entry is overwritten
+    MaterialProperties readProperties(const std::string& name, const ElementDatabase& database,
+                                      std::unique_ptr<TableCache::Reader>& cached) {
+        if (cached) {
+            try {
+                return MaterialProperties(name, database, *cached);
+            }
+            catch (const std::runtime_error&) {
+                cached.reset();
+            }
+        }
+        return MaterialProperties(name, database);
+    }
 
-Material::Material(std::string  name, DataAccessObject& dao) : name_(std::move(name)), dao_(dao),
-                                                                     properties_(name_, dao_), data_(properties_, dao_) {
-//    initializeMaterial();
-}
\ No newline at end of file
+    MaterialData readData(MaterialProperties& properties, const ElementDatabase& database,
+                          std::unique_ptr<TableCache::Reader>& cached) {
+        if (cached) {
+            try {
+                return MaterialData(properties, database, *cached);
+            }
+            catch (const std::runtime_error&) {
+                cached.reset();
+            }
+        }
+        return MaterialData(properties, database);
+    }
+}
+
+Material::Material(std::string name, const ElementDatabase& database) :
+        Material(name, database, TableCache::load(getCacheKey(name, database))) {}
+
+Material::Material(std::string name, const ElementDatabase& database, std::unique_ptr<TableCache::Reader> cached) :
+        name_(std::move(name)), database_(database),
+        properties_(readProperties(name_, database_, cached)),
+        data_(readData(properties_, database_, cached)) {
+    if (cached) {
+        return;
+    }
+    std::string payload;
+    properties_.serialize(payload);
+    data_.serialize(payload);
+    TableCache::store(getCacheKey(name_, database_), payload);
+}
+
+TableCache::Key Material::getCacheKey(const std::string& name, const ElementDatabase& database) {
+    // the composition and every table are determined by the name and the database contents
+    TableCache::Key key("Material");
+    key.add(name).add(TableCache::hashFile(database.getPath()));
+    return key;
+}
@@ -1,11 +1,66 @@
 #include "Core/material_data.h"
 
 
-MaterialData::MaterialData(MaterialProperties& properties, DataAccessObject& dao) :
-        properties_(properties), dao_(dao) {
+MaterialData::MaterialData(MaterialProperties& properties, const ElementDatabase& database) :
+        properties_(properties), database_(database) {
     initializeData();
 }
 
+MaterialData::MaterialData(MaterialProperties& properties, const ElementDatabase& database, TableCache::Reader& reader) :
+        properties_(properties), database_(database) {
+    // the splines are stored fitted, so only the cheap linear interpolators are rebuilt
+    auto readSpline = [&reader](Interpolator::LogLogSpline& spline) {
+        double log_x_min, log_x_max;
+        Eigen::RowVectorXd knots, control_points;
+        if (!reader.read(log_x_min) || !reader.read(log_x_max) || !reader.readMatrix(knots) || !reader.readMatrix(control_points)) {
+            return false;
+        }
+        spline = Interpolator::LogLogSpline(log_x_min, log_x_max, knots, control_points);
+        return true;
+    };
+    bool read = reader.readMatrix(incoherent_cs_matrix_) && readSpline(incoherent_cs_interpolator_) &&
+                reader.readMatrix(coherent_cs_matrix_) && readSpline(coherent_cs_interpolator_) &&
+                reader.readMatrix(photoelectric_cs_matrix_) &&
+                reader.readMatrix(total_cs_matrix_) &&
+                reader.readMatrix(incoherent_scattering_function_matrix_) &&
+                reader.readMatrix(coherent_form_factor_matrix_) &&
+                reader.readMatrix(mass_energy_absorption_coefficient_matrix_) &&
+                coherent_squared_form_factor_dist_.deserialize(reader) &&
+                incoherent_scattering_dcs_dist_.deserialize(reader);
+    if (!read) {
+        throw std::runtime_error("Inconsistent cached data for material " + properties_.getName());
+    }
+    setLinearInterpolators();
+}
+
+void MaterialData::serialize(std::string& payload) const {
+    auto appendSpline = [&payload](const Interpolator::LogLogSpline& spline) {
+        TableCache::appendValue(payload, spline.getXMin());
+        TableCache::appendValue(payload, spline.getXMax());
+        TableCache::appendMatrix(payload, spline.getKnots());
+        TableCache::appendMatrix(payload, spline.getControlPoints());
+    };
+    TableCache::appendMatrix(payload, incoherent_cs_matrix_);
+    appendSpline(incoherent_cs_interpolator_);
+    TableCache::appendMatrix(payload, coherent_cs_matrix_);
+    appendSpline(coherent_cs_interpolator_);
+    TableCache::appendMatrix(payload, photoelectric_cs_matrix_);
+    TableCache::appendMatrix(payload, total_cs_matrix_);
+    TableCache::appendMatrix(payload, incoherent_scattering_function_matrix_);
+    TableCache::appendMatrix(payload, coherent_form_factor_matrix_);
+    TableCache::appendMatrix(payload, mass_energy_absorption_coefficient_matrix_);
+    coherent_squared_form_factor_dist_.serialize(payload);
+    incoherent_scattering_dcs_dist_.serialize(payload);
+}
+
+void MaterialData::setLinearInterpolators() {
+    photoelectric_cs_interpolator_ = Interpolator::LogLogLinear(photoelectric_cs_matrix_);
+    total_cs_interpolator_ = Interpolator::LogLogLinear(total_cs_matrix_);
+    incoherent_scattering_function_interpolator_ = Interpolator::LogLogLinear(incoherent_scattering_function_matrix_);
+    coherent_form_factor_interpolator_ = Interpolator::LogLogLinear(coherent_form_factor_matrix_);
+    mass_energy_absorption_coefficient_interpolator_ = Interpolator::LogLogLinear(mass_energy_absorption_coefficient_matrix_);
+}
+
 void MaterialData::initializeData() {
     setInteractionCrossSectionsAndInterpolators();
     setTotalCrossSectionsAndInterpolator();
@@ -13,6 +68,7 @@ void MaterialData::initializeData() {
     setCoherentScatteringFormFactorAndInterpolator();
     setMassEnergyAbsorptionCoefficientsAndInterpolator();
     setCoherentScatteringDCSDistribution();
+    setIncoherentScatteringDCSDistribution();
 }
 
 void MaterialData::setInteractionCrossSectionsAndInterpolators() {
@@ -60,16 +116,66 @@ void MaterialData::setPhotoelectricCrossSectionAndInterpolator() {
 }
 
 void MaterialData::setCoherentScatteringDCSDistribution() {
-    // define PDF lambda
+    // F^2 as a function of x^2. Grid nodes at the squared form factor nodes, where the interpolant has kinks
+    auto PDF = [this](double x_sq) {
+        return pow(interpolateCoherentFormFactor(sqrt(x_sq)), 2);
+    };
+    std::vector<double> x_sq_grid = {0};
+    for (int i = 0; i < coherent_form_factor_matrix_.rows(); ++i) {
+        double x_sq = coherent_form_factor_matrix_(i, 0)*coherent_form_factor_matrix_(i, 0);
+        if (x_sq > x_sq_grid.back()) {
+            x_sq_grid.push_back(x_sq);
+        }
+    }
+    Eigen::VectorXd x_sq_values = Eigen::Map<Eigen::VectorXd>(x_sq_grid.data(), static_cast<Eigen::Index>(x_sq_grid.size()));
+    coherent_squared_form_factor_dist_ = ProbabilityDist::TruncatedInversion(PDF, x_sq_values, 1E-4);
+}
+
+double MaterialData::sampleCoherentScatteringDCS(double energy) const {
+    // x^2 = (ALPHA*k)^2*(1 - mu), so x^2 ranges up to 2*(ALPHA*k)^2 at mu = -1
+    double alpha_k = ALPHA*energy/ELECTRON_REST_MASS;
+    double alpha_k_sq = alpha_k*alpha_k;
+    double max_cumulative = coherent_squared_form_factor_dist_.getCumulative(2*alpha_k_sq);
+    while (true) {
+        double x_sq = coherent_squared_form_factor_dist_.sampleBelowCumulative(max_cumulative);
+        // round-off can put x^2 marginally above its maximum
+        double mu = std::max(-1.0, 1 - x_sq/alpha_k_sq);
+        // Thomson DCS rejection
+        if (2*uniform_dist_.sample() <= 1 + mu*mu) {
+            return mu;
+        }
+    }
+}
+
+void MaterialData::setIncoherentScatteringDCSDistribution() {
+    // define PDF lambda. Klein-Nishina DCS times the incoherent scattering function
     auto PDF = [this](double mu, double E) {
         double k = E/ELECTRON_REST_MASS;
+        double k_ratio = 1/(1 + k*(1 - mu)); // k'/k
         double x = ALPHA*k*sqrt(1 - mu);
-        return (1 + mu*mu)*pow(interpolateCoherentFormFactor(x), 2);
+        return k_ratio*k_ratio*(k_ratio + 1/k_ratio - (1 - mu*mu))*interpolateIncoherentScatteringFunction(x);
     };
     // get energy array
     Eigen::VectorXd energy_values = getIncoherentScatteringCrossSectionMatrix().col(0);
     std::function<double(double, double)> PDF_function = PDF;
-    coherent_scattering_dcs_dist_ = ProbabilityDist::ContinuousInversion(PDF_function, energy_values, -1, 1, 1E-4);
+    incoherent_scattering_dcs_dist_ = ProbabilityDist::ContinuousInversion(PDF_function, std::move(energy_values), -1, 1, 1E-4,
+                                                                            getCompositionCacheKey("IncoherentScatteringDCS"));
+}
+
+TableCache::Key MaterialData::getCompositionCacheKey(const std::string& table_name) const {
+    // sorted, since the composition is stored in an unordered map
+    auto composition = properties_.getElementalComposition();
+    std::vector<std::pair<int, double>> sorted_composition(composition.begin(), composition.end());
+    std::sort(sorted_composition.begin(), sorted_composition.end());
+
+    // the tables are built from the element data of the database, so its contents are part of the key
+    TableCache::Key key(table_name);
+    key.add(TableCache::hashFile(database_.getPath()));
+    key.add(static_cast<int>(sorted_composition.size()));
+    for (const auto& element : sorted_composition) {
+        key.add(element.first).add(element.second);
+    }
+    return key;
 }
 
 Eigen::Matrix<double, Eigen::Dynamic, 2> MaterialData::getTotalCrossSectionsMatrixFromInteractionData() {
@@ -93,7 +199,9 @@ Eigen::Matrix<double, Eigen::Dynamic, 2> MaterialData::calculateWeightedAverageO
     }
     Eigen::MatrixXd merged_energy_matrix = InteractionDataHelpers::mergeMatrices(all_energies);
     Eigen::MatrixXd weighted_average_matrix = Eigen::MatrixXd::Zero(merged_energy_matrix.rows(), 2);
-    std::unordered_map<int, std::shared_ptr<Interpolator::Interpolator>> interpolators_map = getInterpolatorsForAllElements(tableName, matrices_map);
+    std::vector<int> element_ids = MaterialHelpers::mapKeysToVector(matrices_map);
+    std::unordered_map<int, std::shared_ptr<const Interpolator::Interpolator>> interpolators_map =
+            database_.getElementInterpolators(tableName, dataColumnName, element_ids);
     std::unordered_map<int, double> elemental_composition = properties_.getElementalComposition();
     std::unordered_map<int, double> elemental_number_density = properties_.getElementalNumberDensity();
     for (int i = 0; i < merged_energy_matrix.rows(); ++i) {
@@ -115,11 +223,7 @@ Eigen::Matrix<double, Eigen::Dynamic, 2> MaterialData::calculateWeightedAverageO
 
 std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> MaterialData::getTableMatrixForAllElements(const std::string &tableName, const std::string &dataColumnName) {
     std::vector<int> element_ids = MaterialHelpers::mapKeysToVector(properties_.getElementalComposition());
-    std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>> matrices_map;
-    for (int element : element_ids) {
-        matrices_map[element] = getTableMatrix(tableName, dataColumnName, element);
-    }
-    return matrices_map;
+    return database_.getElementTables(tableName, dataColumnName, element_ids);
 }
 
 void MaterialData::fillTotalCrossSectionsMatrix(Eigen::MatrixXd& total_cross_sections_matrix, const Eigen::MatrixXd& merged_energy_matrix) {
@@ -132,39 +236,3 @@ void MaterialData::fillTotalCrossSectionsMatrix(Eigen::MatrixXd& total_cross_sec
         total_cross_sections_matrix(i, 1) = incoherent_cross_section + coherent_cross_section + photo_cross_section;
     }
 }
-
-std::unordered_map<int, std::shared_ptr<Interpolator::Interpolator>> MaterialData::getInterpolatorsForAllElements(const std::string &tableName,
-        const std::unordered_map<int, Eigen::Matrix<double, Eigen::Dynamic, 2>>& table_matrix_map) {
-    std::unordered_map<int, std::shared_ptr<Interpolator::Interpolator>> interpolators_map;
-    for (const auto& element_matrix : table_matrix_map) {
-        interpolators_map[element_matrix.first] = getInterpolatorForElement(tableName, element_matrix.second);
-    }
-    return interpolators_map;
-}
-
-Eigen::Matrix<double, Eigen::Dynamic, 2> MaterialData::getTableMatrix(const std::string &tableName,
-                                                                      const std::string &dataColumnName, int element) {
-    std::string query = "SELECT Energy, " + dataColumnName + " FROM " + tableName + " WHERE ElementID = " + std::to_string(element);
-    std::vector<double> res = InteractionDataHelpers::castStringVector<double>(dao_.executeQuery(query));
-    auto res_distributed = InteractionDataHelpers::distributeNTimes(res, 2);
-
-    return InteractionDataHelpers::convertNVectorsToEigenMatrix(res_distributed);
-}
-
-std::shared_ptr<Interpolator::Interpolator> MaterialData::getInterpolatorForElement(const std::string& tableName, const Eigen::Matrix<double, Eigen::Dynamic, 2>& matrix) {
-    if (tableName == "IncoherentScatteringFunctions") {
-        return std::make_shared<Interpolator::LogLogLinear>(matrix);
-    } else if (tableName == "CoherentScatteringFormFactors") {
-        return std::make_shared<Interpolator::LogLogLinear>(matrix);
-    } else if (tableName == "IncoherentScatteringCrossSections") {
-        return std::make_shared<Interpolator::LogLogSpline>(matrix);
-    } else if (tableName == "CoherentScatteringCrossSections") {
-        return std::make_shared<Interpolator::LogLogSpline>(matrix);
-    } else if (tableName == "TotalPhotoIonizationCrossSections") {
-        return std::make_shared<Interpolator::LogLogLinear>(matrix);
-    } else if (tableName == "MassEnergyAbsorptionCoefficients") {
-        return std::make_shared<Interpolator::LogLogLinear>(matrix);
-    } else {
-        throw std::runtime_error("Invalid table");
-    }
-}
\ No newline at end of file
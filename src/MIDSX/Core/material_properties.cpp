@@ -2,15 +2,43 @@
 
 #include <utility>
 
-#include "Core/data_access_object.h"
+#include "Core/element_database.h"
 #include "Core/constants.h"
 #include "Core/interaction_data.h"
 
 
-MaterialProperties::MaterialProperties(std::string name, DataAccessObject& dao) : name_(std::move(name)), dao_(dao) {
+MaterialProperties::MaterialProperties(std::string name, const ElementDatabase& database) : name_(std::move(name)), database_(database) {
     initializeProperties();
 }
 
+MaterialProperties::MaterialProperties(std::string name, const ElementDatabase& database, TableCache::Reader& reader) : name_(std::move(name)), database_(database) {
+    bool read = reader.read(material_id_) && reader.read(mass_density_) && reader.read(number_density_) && reader.read(atomic_weight_);
+    for (auto* map : {&elemental_composition_, &elemental_mass_density_, &elemental_number_density_,
+                      &elemental_atomic_weight_, &elemental_mass_number_}) {
+        std::vector<int> keys;
+        std::vector<double> values;
+        read = read && reader.readVector(keys) && reader.readVector(values) && keys.size() == values.size();
+        for (size_t i = 0; read && i < keys.size(); ++i) {
+            (*map)[keys[i]] = values[i];
+        }
+    }
+    if (!read) {
+        throw std::runtime_error("Inconsistent cached properties for material " + name_);
+    }
+}
+
+void MaterialProperties::serialize(std::string& payload) const {
+    TableCache::appendValue(payload, material_id_);
+    TableCache::appendValue(payload, mass_density_);
+    TableCache::appendValue(payload, number_density_);
+    TableCache::appendValue(payload, atomic_weight_);
+    for (const auto* map : {&elemental_composition_, &elemental_mass_density_, &elemental_number_density_,
+                            &elemental_atomic_weight_, &elemental_mass_number_}) {
+        TableCache::appendVector(payload, MaterialHelpers::mapKeysToVector(*map));
+        TableCache::appendVector(payload, MaterialHelpers::mapElementsToVector(*map));
+    }
+}
+
 void MaterialProperties::initializeProperties() {
     setMaterialId();
     setElementalComposition();
@@ -18,49 +46,31 @@ void MaterialProperties::initializeProperties() {
 }
 
 void MaterialProperties::setMaterialId() {
-    material_id_ = InteractionDataHelpers::convertMaterialNameToId(name_, dao_);
+    material_id_ = database_.getMaterialId(name_);
 }
 
 void MaterialProperties::setElementalComposition() {
-    std::string query = "SELECT MaterialCompositions.ElementID, MaterialCompositions.WeightFraction "
-                        "FROM Materials "
-                        "INNER JOIN MaterialCompositions ON Materials.MaterialID = MaterialCompositions.MaterialID "
-                        "WHERE Materials.Name = '" + name_ + "';";
-    auto output = InteractionDataHelpers::castStringVector<double>(dao_.executeQuery(query));
-    auto output_distributed = InteractionDataHelpers::distributeNTimes(output, 2);
-    for (int i = 0; i < output_distributed[0].size(); ++i) {
-        elemental_composition_[static_cast<int>(output_distributed[0][i])] = output_distributed[1][i];
-    }
+    elemental_composition_ = database_.getMaterialComposition(material_id_);
 }
 
 void MaterialProperties::initializeMaterialProperties() {
-    setElementalDataForTableAndColumn("Elements", "Mass", elemental_atomic_weight_);
-    setElementalDataForTableAndColumn("Elements", "Density", elemental_mass_density_);
-    setElementalDataForTableAndColumn("Elements", "MassNumber", elemental_mass_number_);
+    setElementalData();
     setMassDensity();
     setAtomicWeight();
     setNumberDensity();
 }
 
-void MaterialProperties::setElementalDataForTableAndColumn(const std::string& table_name, const std::string& column_name, std::unordered_map<int, double>& map) {
-    std::vector<int> element_ids = MaterialHelpers::mapKeysToVector(elemental_composition_);
-    std::string element_ids_str = MaterialHelpers::mapKeysToString(elemental_composition_);
-    std::string query = "SELECT AtomicNumber, " + column_name + " "
-                        "FROM " + table_name + " "
-                        "WHERE ID IN (" + element_ids_str + ");";
-    auto output = InteractionDataHelpers::castStringVector<double>(dao_.executeQuery(query));
-    auto output_distributed = InteractionDataHelpers::distributeNTimes(output, 2);
-    for (int i = 0; i < output_distributed[0].size(); ++i) {
-        map[static_cast<int>(output_distributed[0][i])] = output_distributed[1][i];
+void MaterialProperties::setElementalData() {
+    for (const auto& element_fraction : elemental_composition_) {
+        const ElementDatabase::Element& element = database_.getElement(element_fraction.first);
+        elemental_atomic_weight_[element.atomic_number] = element.mass;
+        elemental_mass_density_[element.atomic_number] = element.density;
+        elemental_mass_number_[element.atomic_number] = element.mass_number;
     }
 }
 
 void MaterialProperties::setMassDensity() {
-    std::string query = "SELECT Density "
-                        "FROM Materials "
-                        "WHERE Name = '" + name_ + "';";
-    auto output = InteractionDataHelpers::castStringVector<double>(dao_.executeQuery(query));
-    mass_density_ = static_cast<double>(output[0]);
+    mass_density_ = database_.getMaterialDensity(material_id_);
 }
 
 void MaterialProperties::setNumberDensity() {
@@ -0,0 +1,201 @@
+#include "Core/nifti_reader.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // layout of the NIfTI-1 header
+    const int HEADER_SIZE = 348;
+    const size_t DIM_OFFSET = 40;
+    const size_t DATATYPE_OFFSET = 70;
+    const size_t PIXDIM_OFFSET = 76;
+    const size_t VOX_OFFSET_OFFSET = 108;
+    const size_t SCL_SLOPE_OFFSET = 112;
+    const size_t SCL_INTER_OFFSET = 116;
+    const size_t XYZT_UNITS_OFFSET = 123;
+    const size_t MAGIC_OFFSET = 344;
+
+    enum DataType {
+        DT_UINT8 = 2,
+        DT_INT16 = 4,
+        DT_INT32 = 8,
+        DT_FLOAT32 = 16,
+        DT_FLOAT64 = 64,
+        DT_INT8 = 256,
+        DT_UINT16 = 512,
+        DT_UINT32 = 768,
+        DT_INT64 = 1024,
+        DT_UINT64 = 1280,
+    };
+
+    // number of voxels decompressed and converted at a time
+    const size_t CHUNK_SIZE = 1 << 16;
+
+    template <typename T>
+    T swapBytes(T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        std::reverse(bytes, bytes + sizeof(T));
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    T getField(const char* header, size_t offset, bool swap_bytes) {
+        T value;
+        std::memcpy(&value, header + offset, sizeof(T));
+        return swap_bytes ? swapBytes(value) : value;
+    }
+
+    // converts the NIFTI_UNITS_* code of the spatial unit to cm
+    double spatialUnitToCm(int xyzt_units) {
+        switch (xyzt_units & 0x07) {
+            case 0: return 0.1; // unknown. Taken as mm, the unit of most scanners and segmentation tools
+            case 1: return 100.0; // m
+            case 2: return 0.1; // mm
+            case 3: return 1e-4; // um
+            default: throw std::runtime_error("Invalid spatial unit code " + std::to_string(xyzt_units & 0x07));
+        }
+    }
+}
+
+NIfTIReader::NIfTIReader(std::string filename) : filename_(std::move(filename)) {
+    // gzopen reads uncompressed files as they are, so .nii and .nii.gz take the same path
+    file_ = gzopen(filename_.c_str(), "rb");
+    if (!file_) {
+        throw std::runtime_error("Can't open NIfTI file " + filename_);
+    }
+    gzbuffer(file_, 1 << 20);
+    try {
+        readHeader();
+    } catch (...) {
+        gzclose(file_);
+        throw;
+    }
+}
+
+NIfTIReader::~NIfTIReader() {
+    gzclose(file_);
+}
+
+void NIfTIReader::readLabels(uint8_t* labels) {
+    readData([this, labels](int64_t index, double value) {
+        if (!(value >= 0 && value <= 255 && value == std::floor(value))) {
+            throw std::runtime_error("NIfTI file " + filename_ + " contains the label " + std::to_string(value) +
+                                     ", which is not an integer in [0, 255]");
+        }
+        labels[index] = static_cast<uint8_t>(value);
+    });
+}
+
+void NIfTIReader::readValues(double* values) {
+    readData([values](int64_t index, double value) {
+        values[index] = value;
+    });
+}
+
+void NIfTIReader::readHeader() {
+    char header[HEADER_SIZE];
+    readBytes(header, HEADER_SIZE);
+
+    // the header size doubles as the byte order mark
+    int32_t sizeof_hdr = getField<int32_t>(header, 0, false);
+    if (sizeof_hdr != HEADER_SIZE) {
+        swap_bytes_ = true;
+        if (swapBytes(sizeof_hdr) != HEADER_SIZE) {
+            throw std::runtime_error(filename_ + " is not a NIfTI-1 file");
+        }
+    }
+    if (std::memcmp(header + MAGIC_OFFSET, "n+1\0", 4) != 0) {
+        throw std::runtime_error(filename_ + " is not a single file NIfTI-1 image");
+    }
+
+    int16_t num_dims = getField<int16_t>(header, DIM_OFFSET, swap_bytes_);
+    if (num_dims < 3 || num_dims > 7) {
+        throw std::runtime_error("NIfTI file " + filename_ + " is not a 3D image");
+    }
+    for (int i = 0; i < 3; i++) {
+        dim_vox_[i] = getField<int16_t>(header, DIM_OFFSET + 2 * (i + 1), swap_bytes_);
+        zooms_[i] = std::abs(getField<float>(header, PIXDIM_OFFSET + 4 * (i + 1), swap_bytes_));
+        if (dim_vox_[i] <= 0) {
+            throw std::runtime_error("NIfTI file " + filename_ + " has an empty dimension");
+        }
+    }
+    for (int i = 4; i <= num_dims; i++) {
+        if (getField<int16_t>(header, DIM_OFFSET + 2 * i, swap_bytes_) > 1) {
+            throw std::runtime_error("NIfTI file " + filename_ + " is not a 3D image");
+        }
+    }
+
+    datatype_ = getField<int16_t>(header, DATATYPE_OFFSET, swap_bytes_);
+    units_ = spatialUnitToCm(static_cast<unsigned char>(header[XYZT_UNITS_OFFSET]));
+
+    // as in nibabel, a slope of 0 or NaN means the data is not scaled
+    double scl_slope = getField<float>(header, SCL_SLOPE_OFFSET, swap_bytes_);
+    double scl_inter = getField<float>(header, SCL_INTER_OFFSET, swap_bytes_);
+    if (std::isfinite(scl_slope) && scl_slope != 0) {
+        scl_slope_ = scl_slope;
+        scl_inter_ = std::isfinite(scl_inter) ? scl_inter : 0.0;
+    }
+
+    // skip the extensions
+    auto vox_offset = static_cast<int64_t>(getField<float>(header, VOX_OFFSET_OFFSET, swap_bytes_));
+    if (vox_offset < HEADER_SIZE) {
+        throw std::runtime_error("NIfTI file " + filename_ + " has an invalid data offset");
+    }
+    std::vector<char> extensions(vox_offset - HEADER_SIZE);
+    readBytes(extensions.data(), extensions.size());
+}
+
+void NIfTIReader::readBytes(char* buffer, size_t size) {
+    while (size > 0) {
+        auto request = static_cast<unsigned>(std::min<size_t>(size, 1u << 30));
+        int num_read = gzread(file_, buffer, request);
+        if (num_read <= 0) {
+            int error;
+            const char* message = gzerror(file_, &error);
+            throw std::runtime_error("Can't read NIfTI file " + filename_ + ": " +
+                                     (error != Z_OK && error != Z_BUF_ERROR ? message : "unexpected end of file"));
+        }
+        buffer += num_read;
+        size -= num_read;
+    }
+}
+
+template <typename Output>
+void NIfTIReader::readData(Output output) {
+    if (data_read_) {
+        throw std::runtime_error("The data of NIfTI file " + filename_ + " was already read");
+    }
+    data_read_ = true;
+    switch (datatype_) {
+        case DT_UINT8: readDataAs<uint8_t>(output); break;
+        case DT_INT8: readDataAs<int8_t>(output); break;
+        case DT_INT16: readDataAs<int16_t>(output); break;
+        case DT_UINT16: readDataAs<uint16_t>(output); break;
+        case DT_INT32: readDataAs<int32_t>(output); break;
+        case DT_UINT32: readDataAs<uint32_t>(output); break;
+        case DT_INT64: readDataAs<int64_t>(output); break;
+        case DT_UINT64: readDataAs<uint64_t>(output); break;
+        case DT_FLOAT32: readDataAs<float>(output); break;
+        case DT_FLOAT64: readDataAs<double>(output); break;
+        default: throw std::runtime_error("NIfTI file " + filename_ + " has the unsupported data type " + std::to_string(datatype_));
+    }
+}
+
+template <typename Stored, typename Output>
+void NIfTIReader::readDataAs(Output output) {
+    const int64_t num_voxels = getNumOfVoxels();
+    std::vector<Stored> chunk(std::min<int64_t>(CHUNK_SIZE, num_voxels));
+    for (int64_t start = 0; start < num_voxels; start += static_cast<int64_t>(chunk.size())) {
+        const size_t count = std::min<int64_t>(chunk.size(), num_voxels - start);
+        readBytes(reinterpret_cast<char*>(chunk.data()), count * sizeof(Stored));
+        for (size_t i = 0; i < count; i++) {
+            Stored value = swap_bytes_ ? swapBytes(chunk[i]) : chunk[i];
+            output(start + static_cast<int64_t>(i), static_cast<double>(value) * scl_slope_ + scl_inter_);
+        }
+    }
+}
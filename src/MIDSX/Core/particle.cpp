@@ -2,31 +2,40 @@
 
 namespace {
     const double EPSILON = 1E-9;
+    const double NORM_TOLERANCE = 1E-14;
 }
 
 Eigen::Vector3d ParticleHelpers::rotateDirection(const Eigen::Vector3d &vector, const double &theta, const double &phi) {
-    // First find a perpendicular vector to the given vector.
-    // Must be normalized for use with quaternion rotation
-    Eigen::Vector3d perp_vector = getPerpendicularVector(vector).normalized();
-
-    // Using quaternion rotation, rotate the vector about the perpendicular vector by theta (polar angle)
-    // Eigen has some nice helper functions for this
-//    auto rotation = Eigen::AngleAxisd(theta, perp_vector);
-//    Eigen::Vector3d rotated_vector = rotation * perp_vector;
-//
-//    // Now rotate about the direction vector by phi (azimuthal angle)
-//    rotation = Eigen::AngleAxisd(phi, vector);
-//    rotated_vector = rotation * rotated_vector;
-
-    Eigen::Quaterniond q_theta(cos(theta/2), perp_vector.x()*sin(theta/2), perp_vector.y()*sin(theta/2), perp_vector.z()*sin(theta/2));
-    Eigen::Quaterniond q_phi(cos(phi/2), vector.x()*sin(phi/2), vector.y()*sin(phi/2), vector.z()*sin(phi/2));
-    Eigen::Quaterniond q = q_phi * q_theta;
-    Eigen::Quaterniond v(0, vector.x(), vector.y(), vector.z());
-
-    Eigen::Quaterniond rotated_vector = q * v * q.inverse();
+    return rotateDirection(vector, cos(theta), cos(phi), sin(phi));
+}
 
+Eigen::Vector3d ParticleHelpers::rotateDirection(const Eigen::Vector3d &vector, double cos_theta, double cos_phi, double sin_phi) {
+    // direction cosine update (e.g. PENELOPE's DIRECT subroutine)
+    double u = vector.x();
+    double v = vector.y();
+    double w = vector.z();
+    double sin_theta = sqrt(std::max(0.0, 1 - cos_theta*cos_theta));
+    // u^2 + v^2 rather than 1 - w^2 to avoid cancellation near the poles
+    double s_sq = u*u + v*v;
+
+    Eigen::Vector3d rotated_vector;
+    if (s_sq < EPSILON*EPSILON) {
+        // vector is (anti)parallel to the z axis, so the general formula is ill-conditioned
+        rotated_vector << sin_theta*cos_phi, sin_theta*sin_phi, (w > 0 ? cos_theta : -cos_theta);
+    } else {
+        double s = sqrt(s_sq);
+        double sin_theta_over_s = sin_theta/s;
+        rotated_vector << u*cos_theta + sin_theta_over_s*(u*w*cos_phi - v*sin_phi),
+                          v*cos_theta + sin_theta_over_s*(v*w*cos_phi + u*sin_phi),
+                          w*cos_theta - s*sin_theta*cos_phi;
+    }
 
-    return {rotated_vector.x(), rotated_vector.y(), rotated_vector.z()};
+    // keep round-off from accumulating over long histories
+    double norm_sq = rotated_vector.squaredNorm();
+    if (std::abs(norm_sq - 1) > NORM_TOLERANCE) {
+        rotated_vector /= sqrt(norm_sq);
+    }
+    return rotated_vector;
 }
 
 Eigen::Vector3d ParticleHelpers::getPerpendicularVector(const Eigen::Vector3d &vector) {
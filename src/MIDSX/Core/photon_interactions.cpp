@@ -51,90 +51,30 @@ double CoherentScattering::interact(Particle& photon, Material& material) {
 
     double mu = material.getData().sampleCoherentScatteringDCS(photon.getEnergy());
 
-    double theta = acos(mu);
     // sample phi (0, 2pi)
-    double phi = 2*PI*uniform_dist_.sample();
+    double cos_phi, sin_phi;
+    sampleAzimuth(cos_phi, sin_phi);
     // rotate photon direction
-    photon.rotate(theta, phi);
+    photon.rotate(mu, cos_phi, sin_phi);
     return 0;
 }
 
 double IncoherentScattering::interact(Particle& photon, Material& material) {
-    // Kahn's rejection method
     double k = photon.getEnergy() / ELECTRON_REST_MASS; // unitless
-    double chi, mu, k_prime;
-
-    while (true) {
-        double random_number_1 = uniform_dist_.sample();
-        double random_number_2 = uniform_dist_.sample();
-        double random_number_3 = uniform_dist_.sample();
-
-        if (isR1Accepted(k, random_number_1)) {
-            chi = getChiIfR1Accepted(k, random_number_2);
-            if (!isR3AcceptedIfR1Accepted(chi, random_number_3)) continue;
-        } else {
-            chi = getChiIfR1Rejected(k, random_number_2);
-            if (!isR3AcceptedIfR1Rejected(k, chi, random_number_3)) continue;
-        }
-
-        // accept/reject with scattering function
-
-        k_prime = getKPrime(k, chi);
-        mu = getMu(k, k_prime);
-        if (isAcceptedByScatteringFunction(mu, k, material)) {
-            return changeTrajectoryAndReturnEnergyForCoherentScattering(photon, mu, k, k_prime);
-        }
-    }
+    double mu = material.getData().sampleIncoherentScatteringDCS(photon.getEnergy());
+    double k_prime = getKPrime(k, mu);
+    return changeTrajectoryAndReturnEnergyForIncoherentScattering(photon, mu, k, k_prime);
 }
 
-bool IncoherentScattering::isR1Accepted(double k, double random_number_1) {
-    double R1_acceptance_prob = (1 + 2*k)/(9 + 2*k);
-    return random_number_1 <= R1_acceptance_prob;
-}
-
-double IncoherentScattering::getChiIfR1Accepted(double k, double random_number_2) {
-    double chi = 1 + 2*k*random_number_2;
-    return chi;
-}
-
-bool IncoherentScattering::isR3AcceptedIfR1Accepted(double chi, double random_number_3) {
-    double R3_acceptance_prob = 4 * (1/chi - 1/(chi*chi));
-    return random_number_3 <= R3_acceptance_prob;
-}
-
-double IncoherentScattering::getKPrime(double k, double chi) {
-    double k_prime = k/chi;
+double IncoherentScattering::getKPrime(double k, double mu) {
+    double k_prime = k/(1 + k*(1 - mu));
     return k_prime;
 }
 
-double IncoherentScattering::getMu(double k, double k_prime) {
-    double mu = 1 + 1/k - 1/k_prime;
-    return mu;
-}
-
-bool IncoherentScattering::isAcceptedByScatteringFunction(double mu, double k, Material& material) {
-    double x = ALPHA*k*sqrt(1-mu);
-    double max_x = ALPHA*k*sqrt(2);
-    // S(x, Z)/S(max_x, Z)
-    double accept_prob =  material.getData().interpolateIncoherentScatteringFunction(x)/material.getData().interpolateIncoherentScatteringFunction(max_x);
-    double random_number = uniform_dist_.sample();
-    return random_number <= accept_prob;
-}
-
-double IncoherentScattering::getChiIfR1Rejected(double k, double random_number_2) {
-    double chi = (1 + 2*k)/(1 + 2*k*random_number_2);
-    return chi;
-}
-
-bool IncoherentScattering::isR3AcceptedIfR1Rejected(double k, double chi, double random_number_3) {
-    double R3_acceptance_prob = pow(1/k - chi/k + 1, 2) + 1/chi;
-    return 2*random_number_3 <= R3_acceptance_prob;
-}
-
-double IncoherentScattering::changeTrajectoryAndReturnEnergyForCoherentScattering(Particle& photon, double mu, double k, double k_prime) {
-    double theta = acos(mu);
-    double phi = 2*PI*uniform_dist_.sample();
-    photon.rotate(theta, phi);
+double IncoherentScattering::changeTrajectoryAndReturnEnergyForIncoherentScattering(Particle& photon, double mu, double k, double k_prime) {
+    double cos_phi, sin_phi;
+    sampleAzimuth(cos_phi, sin_phi);
+    photon.rotate(mu, cos_phi, sin_phi);
 
     photon.setEnergy(k_prime*ELECTRON_REST_MASS);
     return ELECTRON_REST_MASS * (k - k_prime);
@@ -12,7 +12,13 @@ PhysicsEngine::PhysicsEngine(ComputationalDomain& comp_domain, InteractionData&
                              comp_domain_(comp_domain), interaction_data_(interaction_data),
                              uniform_dist_(0.0, 1.0), photoelectric_effect_(std::make_shared<PhotoelectricEffect>()),
                              coherent_scattering_(std::make_shared<CoherentScattering>()),
-                             incoherent_scattering_(std::make_shared<IncoherentScattering>()) {}
+                             incoherent_scattering_(std::make_shared<IncoherentScattering>()) {
+    // voxels store dense material indices, so the material of a voxel is a single indexed load
+    for (int material_id : comp_domain_.getMaterialIds()) {
+        domain_materials_.push_back(&interaction_data_.getMaterialFromId(material_id));
+    }
+    has_homogeneous_regions_ = comp_domain_.hasHomogeneousRegions();
+}
 
 void PhysicsEngine::transportPhoton(Photon& photon) {
     std::vector<TempSurfaceTallyData> temp_surface_tally_data_per_photon;
@@ -37,9 +43,36 @@ void PhysicsEngine::transportPhotonOneStep(Photon& photon, std::vector<TempSurfa
     double photon_energy = photon.getEnergy();
     double max_cross_section = interaction_data_.interpolateMaxTotalCrossSection(photon_energy);
 
+    // within a region of one material and density, the cross section of the region is the majorant up to its boundary.
+    // Only worth it if delta tracking would take more than about one step to cross the region. The background is
+    // always such a region, and is found from the bounding boxes alone if the bodies have no regions of their own
+    double region_distance = std::numeric_limits<double>::infinity();
+    Voxel region_voxel = comp_domain_.background_voxel;
+    double homogeneous_distance = has_homogeneous_regions_ ?
+                                  comp_domain_.getHomogeneousDistance(photon.getPosition(), photon.getDirection(), region_voxel) :
+                                  comp_domain_.getBackgroundDistance(photon.getPosition(), photon.getDirection());
+    if (homogeneous_distance > EPSILON && homogeneous_distance * max_cross_section > 1.0) {
+        region_distance = homogeneous_distance;
+        max_cross_section = region_voxel.density_scale *
+                            domain_materials_[region_voxel.materialID]->getData().interpolateTotalCrossSection(photon_energy);
+    }
+
     // move photon to distance of free path length
     Eigen::Vector3d initial_position = photon.getPosition();
     double free_path_length = getFreePath(max_cross_section);
+    if (free_path_length >= region_distance) {
+        // no interaction within the region. The photon continues from just past its boundary, so that a surface tally
+        // on the boundary is crossed by this step only rather than also by the next one starting on it
+        temp_surface_tally_data.free_path = temp_volume_tally_data.free_path = region_distance + EPSILON;
+        photon.move(region_distance + EPSILON);
+        updateTempTallyPerPhoton(temp_surface_tally_data_per_photon, temp_volume_tally_data_per_photon,
+                                 temp_surface_tally_data, temp_volume_tally_data);
+        // a region which ends at the boundary of the computational domain leaves the photon just outside of it
+        if (!comp_domain_.isInComputationalDomain(photon.getPosition())) {
+            processPhotonOutsideVoxelGrid(photon);
+        }
+        return;
+    }
     temp_surface_tally_data.free_path = temp_volume_tally_data.free_path = free_path_length;
     photon.move(free_path_length);
 
@@ -52,15 +85,15 @@ void PhysicsEngine::transportPhotonOneStep(Photon& photon, std::vector<TempSurfa
     }
 
     // get material of new voxel
-    Voxel& current_voxel = comp_domain_.getVoxel(photon.getPosition());
-    int current_material_id = current_voxel.materialID;
+    Voxel current_voxel = comp_domain_.getVoxel(photon.getPosition());
 
     // get total cross section for current material
-    Material& current_material = interaction_data_.getMaterialFromId(current_material_id);
+    Material& current_material = *domain_materials_[current_voxel.materialID];
     double total_cross_section = (current_material.getData().interpolateTotalCrossSection(photon_energy));
 
-    // sample delta scattering
-    bool delta_scattering = isDeltaScatter(total_cross_section, max_cross_section);
+    // sample delta scattering. Only the total cross section scales with the density of the voxel; the interaction
+    // type probabilities are ratios of cross sections of the same material, so they do not
+    bool delta_scattering = isDeltaScatter(current_voxel.density_scale * total_cross_section, max_cross_section);
     if (!delta_scattering) {
         temp_surface_tally_data.isInteract = temp_volume_tally_data.isInteract = true;
         setInteractionType(photon, current_material, total_cross_section);
@@ -72,7 +105,9 @@ void PhysicsEngine::transportPhotonOneStep(Photon& photon, std::vector<TempSurfa
         temp_volume_tally_data.energy_deposited = energy_deposited;
         temp_volume_tally_data.final_photon = photon;
 
-        temp_voxel_data_per_photon.push_back(temp_voxel_data); // not in updateTempTallyPerPhoton because of out of bounds case
+        if (current_voxel.dose_grid) {
+            temp_voxel_data_per_photon.push_back(temp_voxel_data); // not in updateTempTallyPerPhoton because of out of bounds case
+        }
     }
     updateTempTallyPerPhoton(temp_surface_tally_data_per_photon, temp_volume_tally_data_per_photon,
                              temp_surface_tally_data, temp_volume_tally_data);
@@ -108,6 +143,12 @@ void PhysicsEngine::setInteractionType(Photon& photon, Material& material, doubl
     }
 }
 
+void PhysicsEngine::setResolutionLevel(int level) {
+    comp_domain_.setResolutionLevel(level);
+    // downsampled voxels are homogeneous regions, which are only looked up if the domain has any
+    has_homogeneous_regions_ = comp_domain_.hasHomogeneousRegions();
+}
+
 void PhysicsEngine::addVolumeTallies(std::vector<std::unique_ptr<VolumeTally>>&& volume_tallies) {
     thread_local_volume_tallies_.push_back(std::move(volume_tallies));
 }
@@ -160,7 +201,7 @@ std::vector<SurfaceQuantityContainer> PhysicsEngine::getSurfaceQuantityContainer
 void PhysicsEngine::addVoxelDataToComputationalDomain() {
     for (auto &thread_local_voxel_data: thread_local_voxel_data_) {
         for (auto &temp_voxel_data: thread_local_voxel_data) {
-            temp_voxel_data.voxel.dose.addValue(temp_voxel_data.energy_deposited);
+            temp_voxel_data.voxel.dose_grid->addValue(temp_voxel_data.voxel.voxel_number, temp_voxel_data.energy_deposited);
         }
         // after adding all the dose values, clear the thread local voxel data to save memory
         thread_local_voxel_data.clear();
@@ -0,0 +1,152 @@
+#include "Core/primitive.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // entering and exiting lengths of a line with no intersection
+    const std::pair<double, double> MISS = {INF, -INF};
+
+    // lengths along a line at which position + t * direction satisfies min_value <= normal . (position + t * direction) <= max_value
+    std::pair<double, double> getLengthsBetweenPlanes(double position_offset, double direction_cosine, double min_value, double max_value) {
+        if (std::abs(direction_cosine) < EPSILON) {
+            // parallel to the planes, so either always or never between them
+            return (position_offset >= min_value && position_offset <= max_value) ? std::make_pair(-INF, INF) : MISS;
+        }
+        double t1 = (min_value - position_offset) / direction_cosine;
+        double t2 = (max_value - position_offset) / direction_cosine;
+        return {std::min(t1, t2), std::max(t1, t2)};
+    }
+
+    // solves a * t^2 + 2 * half_b * t + c = 0 for the interval where it is <= 0, given a > 0
+    std::pair<double, double> getLengthsWithinQuadric(double a, double half_b, double c) {
+        double discriminant = half_b * half_b - a * c;
+        if (discriminant < 0) {
+            return MISS;
+        }
+        double root = std::sqrt(discriminant);
+        // avoids cancellation between half_b and root
+        double q = -(half_b + std::copysign(root, half_b));
+        if (q == 0) {
+            return {0.0, 0.0};
+        }
+        double t1 = q / a;
+        double t2 = c / q;
+        return {std::min(t1, t2), std::max(t1, t2)};
+    }
+
+    std::pair<double, double> intersectIntervals(const std::pair<double, double>& first, const std::pair<double, double>& second) {
+        return {std::max(first.first, second.first), std::min(first.second, second.second)};
+    }
+}
+
+BoxPrimitive::BoxPrimitive(const Eigen::Vector3d& min_corner, const Eigen::Vector3d& max_corner, int material_id) :
+        Primitive(material_id), box_(min_corner, max_corner) {
+    if ((min_corner.array() > max_corner.array()).any()) {
+        throw std::runtime_error("The minimum corner of a box must not be greater than its maximum corner.");
+    }
+}
+
+bool BoxPrimitive::contains(const Eigen::Vector3d& position) const {
+    return box_.contains(position);
+}
+
+std::pair<double, double> BoxPrimitive::getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const {
+    std::pair<double, double> lengths = {-INF, INF};
+    for (int i = 0; i < 3; i++) {
+        lengths = intersectIntervals(lengths, getLengthsBetweenPlanes(position[i], direction[i], box_.min()[i], box_.max()[i]));
+    }
+    return lengths;
+}
+
+Eigen::AlignedBox3d BoxPrimitive::getBoundingBox() const {
+    return box_;
+}
+
+SpherePrimitive::SpherePrimitive(Eigen::Vector3d center, double radius, int material_id) :
+        Primitive(material_id), center_(std::move(center)), radius_(radius) {
+    if (!(radius_ > 0)) {
+        throw std::runtime_error("The radius of a sphere must be positive.");
+    }
+}
+
+bool SpherePrimitive::contains(const Eigen::Vector3d& position) const {
+    return (position - center_).squaredNorm() <= radius_ * radius_;
+}
+
+std::pair<double, double> SpherePrimitive::getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const {
+    Eigen::Vector3d relative_position = position - center_;
+    return getLengthsWithinQuadric(direction.squaredNorm(), relative_position.dot(direction),
+                                   relative_position.squaredNorm() - radius_ * radius_);
+}
+
+Eigen::AlignedBox3d SpherePrimitive::getBoundingBox() const {
+    return {center_.array() - radius_, center_.array() + radius_};
+}
+
+CylinderPrimitive::CylinderPrimitive(Eigen::Vector3d center, const Eigen::Vector3d& axis, double radius, double height,
+                                     int material_id) :
+        Primitive(material_id), center_(std::move(center)), axis_(axis.normalized()), radius_(radius), half_height_(height / 2) {
+    if (!(axis.norm() > 0) || !(radius_ > 0) || !(half_height_ > 0)) {
+        throw std::runtime_error("A cylinder must have a nonzero axis and a positive radius and height.");
+    }
+}
+
+bool CylinderPrimitive::contains(const Eigen::Vector3d& position) const {
+    Eigen::Vector3d relative_position = position - center_;
+    double axial_offset = relative_position.dot(axis_);
+    return std::abs(axial_offset) <= half_height_ &&
+           (relative_position - axial_offset * axis_).squaredNorm() <= radius_ * radius_;
+}
+
+std::pair<double, double> CylinderPrimitive::getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const {
+    Eigen::Vector3d relative_position = position - center_;
+    double axial_offset = relative_position.dot(axis_);
+    double axial_cosine = direction.dot(axis_);
+    std::pair<double, double> lengths = getLengthsBetweenPlanes(axial_offset, axial_cosine, -half_height_, half_height_);
+
+    // components perpendicular to the axis
+    Eigen::Vector3d radial_position = relative_position - axial_offset * axis_;
+    Eigen::Vector3d radial_direction = direction - axial_cosine * axis_;
+    double a = radial_direction.squaredNorm();
+    double c = radial_position.squaredNorm() - radius_ * radius_;
+    if (a < EPSILON * EPSILON) {
+        // parallel to the axis, so either always or never within the radius
+        return c <= 0 ? lengths : MISS;
+    }
+    return intersectIntervals(lengths, getLengthsWithinQuadric(a, radial_position.dot(radial_direction), c));
+}
+
+Eigen::AlignedBox3d CylinderPrimitive::getBoundingBox() const {
+    // extent of the two end discs along each axis
+    Eigen::Vector3d disc_extent = radius_ * (Eigen::Vector3d::Ones() - axis_.cwiseAbs2()).cwiseMax(0.0).cwiseSqrt();
+    Eigen::Vector3d extent = half_height_ * axis_.cwiseAbs() + disc_extent;
+    return {center_ - extent, center_ + extent};
+}
+
+SlabPrimitive::SlabPrimitive(const Eigen::Vector3d& normal, double offset, double thickness, int material_id) :
+        Primitive(material_id), normal_(normal.normalized()), min_offset_(offset), max_offset_(offset + thickness) {
+    if (!(normal.norm() > 0) || !(thickness > 0)) {
+        throw std::runtime_error("A slab must have a nonzero normal and a positive thickness.");
+    }
+}
+
+bool SlabPrimitive::contains(const Eigen::Vector3d& position) const {
+    double offset = normal_.dot(position);
+    return offset >= min_offset_ && offset <= max_offset_;
+}
+
+std::pair<double, double> SlabPrimitive::getEnteringAndExitingLengths(const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const {
+    return getLengthsBetweenPlanes(normal_.dot(position), normal_.dot(direction), min_offset_, max_offset_);
+}
+
+Eigen::AlignedBox3d SlabPrimitive::getBoundingBox() const {
+    Eigen::AlignedBox3d box(Eigen::Vector3d::Constant(-INF), Eigen::Vector3d::Constant(INF));
+    // only bounded along the normal if the normal is along an axis
+    for (int i = 0; i < 3; i++) {
+        if (std::abs(std::abs(normal_[i]) - 1.0) < EPSILON) {
+            box.min()[i] = normal_[i] > 0 ? min_offset_ : -max_offset_;
+            box.max()[i] = normal_[i] > 0 ? max_offset_ : -min_offset_;
+        }
+    }
+    return box;
+}
@@ -1,4 +1,5 @@
 #include "Core/probability_dist.h"
+#include <omp.h>
 
 // ensures rng is thread safe
 thread_local std::mt19937 ProbabilityDist::Uniform::generator_(std::random_device{}());
@@ -8,22 +9,57 @@ int ProbabilityDistHelpers::findIndexOfNextSmallestValue(double x, const Eigen::
     return lower_bound_it - vector.data() - 1;
 }
 
+double ProbabilityDistHelpers::getRITAEta(double x, const ProbabilityDist::IntervalData &id) {
+    // PENELOPE 1.56
+    double tau = (x - id.x_i) / (id.x_i_1 - id.x_i);
+    if (tau == 0) {
+        return 0;
+    }
+    if (id.b_i == 0) {
+        // limit of 1.56 as b_i -> 0
+        return tau / (1 + id.a_i - id.a_i * tau);
+    }
+    double eta = (1 + id.a_i + id.b_i - id.a_i * tau) / (2 * id.b_i * tau) * (1 - sqrt(1 - 4 * id.b_i * tau * tau / pow(1 + id.a_i + id.b_i - id.a_i * tau, 2)));
+    return eta;
+}
+
+double ProbabilityDistHelpers::getRITAPDF(double x, const ProbabilityDist::IntervalData &id) {
+    // PENELOPE 1.55
+    double eta = getRITAEta(x, id);
+    double p_num = pow(1 + id.a_i * eta + id.b_i * eta * eta, 2) / ((1 + id.a_i + id.b_i) * (1 - id.b_i * eta * eta)) * (id.y_i_1 - id.y_i) / (id.x_i_1 - id.x_i);
+    return p_num;
+}
+
+std::pair<double, double> ProbabilityDistHelpers::getRITAParameters(double x_i, double x_i_1, double y_i, double y_i_1, double p_i, double p_i_1) {
+    // if the PDF vanishes at either end of the interval, fall back to linear interpolation (a_i = b_i = 0)
+    if (p_i <= 0 || p_i_1 <= 0) {
+        return {0.0, 0.0};
+    }
+    double b_i = 1 - pow((y_i_1 - y_i) / (x_i_1 - x_i), 2) * (1 / (p_i * p_i_1));
+    double a_i = (y_i_1 - y_i) / (x_i_1 - x_i) * (1 / p_i) - b_i - 1;
+    return {a_i, b_i};
+}
+
 ProbabilityDist::DiscreteInversion::DiscreteInversion(const Eigen::Matrix<double, Eigen::Dynamic, 2> &probabilities_matrix)
         : probabilities_matrix_(probabilities_matrix),
         uniform_dist_(Uniform(0.0, 1.0)) {
     normalize(); // normalize probabilities if necessary
     cdf_matrix_ = generateCDF();
+    generateGuideTable();
 }
 
 double ProbabilityDist::DiscreteInversion::sample() const {
     double sample = uniform_dist_.sample();
-    Eigen::VectorXd cdf = cdf_matrix_.col(1);
-    int index = ProbabilityDistHelpers::findIndexOfNextSmallestValue(sample, cdf) + 1;
-    if (index == 0) {
-        // sample is less than min cdf
-        return cdf_matrix_(0, 0);
+    const double* cdf = cdf_matrix_.col(1).data(); // columns are contiguous, so no copy is needed
+    const int last_index = static_cast<int>(cdf_matrix_.rows()) - 1;
+
+    // the guide table gives the first index that can satisfy cdf >= sample, then search linearly. The bin is clamped,
+    // as a sample of 1.0 (which uniform_real_distribution can return through rounding) would be one past the end
+    const int guide_size = static_cast<int>(guide_table_.size());
+    int index = guide_table_[std::min(static_cast<int>(sample * guide_size), guide_size - 1)];
+    while (index < last_index && cdf[index] < sample) {
+        ++index;
     }
-
     return cdf_matrix_(index, 0);
 }
 
@@ -49,6 +85,19 @@ Eigen::Matrix<double, Eigen::Dynamic, 2> ProbabilityDist::DiscreteInversion::gen
     return cdf_matrix;
 }
 
+void ProbabilityDist::DiscreteInversion::generateGuideTable() {
+    const int size = static_cast<int>(cdf_matrix_.rows());
+    guide_table_.resize(size);
+    int index = 0;
+    for (int j = 0; j < size; ++j) {
+        double y = static_cast<double>(j) / size;
+        while (index < size - 1 && cdf_matrix_(index, 1) < y) {
+            ++index;
+        }
+        guide_table_[j] = index;
+    }
+}
+
 Eigen::VectorXd ProbabilityDist::DiscreteInversion::cumsum(const Eigen::VectorXd &vector) {
     Eigen::VectorXd cumsum_vector(vector.rows());
     cumsum_vector(0) = vector(0);
@@ -59,7 +108,78 @@ Eigen::VectorXd ProbabilityDist::DiscreteInversion::cumsum(const Eigen::VectorXd
     return cumsum_vector;
 }
 
-ProbabilityDist::ContinuousInversion::ContinuousInversion(std::function<double(double, double)> &PDF, Eigen::VectorXd& energies,
+ProbabilityDist::DiscreteAlias::DiscreteAlias(const Eigen::Matrix<double, Eigen::Dynamic, 2> &probabilities_matrix)
+        : probabilities_matrix_(probabilities_matrix),
+        uniform_dist_(Uniform(0.0, 1.0)) {
+    normalize(); // normalize probabilities if necessary
+    generateAliasTable();
+}
+
+double ProbabilityDist::DiscreteAlias::sample() const {
+    // a single random number picks the column and is then reused for the cutoff comparison
+    double scaled_sample = uniform_dist_.sample() * static_cast<double>(cutoffs_.size());
+    int column = std::min(static_cast<int>(scaled_sample), static_cast<int>(cutoffs_.size()) - 1);
+    double fraction = scaled_sample - column;
+    int index = fraction < cutoffs_[column] ? column : aliases_[column];
+    return probabilities_matrix_(index, 0);
+}
+
+double ProbabilityDist::DiscreteAlias::getExpectationValue() const {
+    return probabilities_matrix_.col(0).dot(probabilities_matrix_.col(1));
+}
+
+void ProbabilityDist::DiscreteAlias::normalize() {
+    double sum = probabilities_matrix_.col(1).sum();
+    if (sum != 1.0) {
+        probabilities_matrix_.col(1) /= sum;
+    }
+}
+
+void ProbabilityDist::DiscreteAlias::generateAliasTable() {
+    // Vose's algorithm. Each column is split between its own value (cutoff) and one alias
+    const int size = static_cast<int>(probabilities_matrix_.rows());
+    cutoffs_.resize(size);
+    aliases_.resize(size);
+
+    std::vector<double> scaled_probabilities(size);
+    std::vector<int> small;
+    std::vector<int> large;
+    for (int i = 0; i < size; ++i) {
+        scaled_probabilities[i] = probabilities_matrix_(i, 1) * size;
+        aliases_[i] = i;
+        if (scaled_probabilities[i] < 1.0) {
+            small.push_back(i);
+        } else {
+            large.push_back(i);
+        }
+    }
+
+    while (!small.empty() && !large.empty()) {
+        int less = small.back();
+        small.pop_back();
+        int more = large.back();
+        large.pop_back();
+
+        cutoffs_[less] = scaled_probabilities[less];
+        aliases_[less] = more;
+        scaled_probabilities[more] = (scaled_probabilities[more] + scaled_probabilities[less]) - 1.0;
+        if (scaled_probabilities[more] < 1.0) {
+            small.push_back(more);
+        } else {
+            large.push_back(more);
+        }
+    }
+
+    // whatever is left is 1 up to round-off
+    for (int i : large) {
+        cutoffs_[i] = 1.0;
+    }
+    for (int i : small) {
+        cutoffs_[i] = 1.0;
+    }
+}
+
+ProbabilityDist::ContinuousInversion::ContinuousInversion(std::function<double(double, double)> &PDF, Eigen::VectorXd energies,
                                                           double x_min, double x_max, double err_thresh) :
         PDF_(PDF),
         energies_(std::move(energies)),
@@ -70,10 +190,30 @@ ProbabilityDist::ContinuousInversion::ContinuousInversion(std::function<double(d
     initializeCDFAndInterpolationParameters();
 }
 
+ProbabilityDist::ContinuousInversion::ContinuousInversion(std::function<double(double, double)> &PDF, Eigen::VectorXd energies,
+                                                          double x_min, double x_max, double err_thresh, TableCache::Key cache_key) :
+        PDF_(PDF),
+        energies_(std::move(energies)),
+        x_min_(x_min),
+        x_max_(x_max),
+        err_thresh_(err_thresh),
+        uniform_dist_(Uniform(0.0, 1.0)) {
+    addToCacheKey(cache_key);
+    if (auto reader = TableCache::load(cache_key)) {
+        if (deserialize(*reader) && reader->isAtEnd()) {
+            return;
+        }
+    }
+    initializeCDFAndInterpolationParameters();
+    std::string payload;
+    serialize(payload);
+    TableCache::store(cache_key, payload);
+}
+
 double ProbabilityDist::ContinuousInversion::sample(double E) const {
-    // get CDF and interpolation parameters for E
-    // wil cause issues if E is not in energies_
+    // get the tables bracketing E, clamping to the ends of the energy grid
     int lower_index = ProbabilityDistHelpers::findIndexOfNextSmallestValue(E, energies_);
+    lower_index = std::max(0, std::min(lower_index, static_cast<int>(energies_.size()) - 2));
     int upper_index = lower_index + 1;
 
     // get x for each E
@@ -83,18 +223,24 @@ double ProbabilityDist::ContinuousInversion::sample(double E) const {
     double x_upper = getXFromY(upper_index, y);
 
     // log-log interpolate x accounting for the fact that x ranges [-1, 1], so add 1 to x
-    double x = exp(log(x_lower + 1) + (log(x_upper + 1) - log(x_lower + 1)) * (log(E) - log(energies_(lower_index))) / (log(energies_(upper_index)) - log(energies_(lower_index)))) - 1.0;
+    double log_x_lower = log(x_lower + 1);
+    double weight = (log(E) - log_energies_(lower_index)) / (log_energies_(upper_index) - log_energies_(lower_index));
+    double x = exp(log_x_lower + (log(x_upper + 1) - log_x_lower) * weight) - 1.0;
     return x;
 }
 
 double ProbabilityDist::ContinuousInversion::getXFromY(int energy_index, double y) const {
-    // get lower index of y
-    Eigen::Array<double, Eigen::Dynamic, 2> CDF_PER_ENERGY = CDF_[energy_index];
-    Eigen::Array<double, Eigen::Dynamic, 2> interp_parameters_per_energy = interp_parameters_[energy_index];
-
-    int y_i_index = ProbabilityDistHelpers::findIndexOfNextSmallestValue(y, CDF_PER_ENERGY.col(1));
+    const RITANode* table = table_.data() + table_offsets_[energy_index];
+    const int* guide_table = guide_table_.data() + table_offsets_[energy_index];
+    const int num_nodes = table_offsets_[energy_index + 1] - table_offsets_[energy_index];
+
+    // find the interval with y_i < y <= y_i_1, starting from the guide table. The bin is clamped for y = 1
+    int y_i_index = guide_table[std::min(static_cast<int>(y * num_nodes), num_nodes - 1)];
+    while (y_i_index < num_nodes - 1 && table[y_i_index + 1].y < y) {
+        ++y_i_index;
+    }
 
-    if (y_i_index == CDF_PER_ENERGY.rows() - 1) {
+    if (y_i_index == num_nodes - 1) {
         // y is greater than max y
         return x_max_;
     }
@@ -103,48 +249,142 @@ double ProbabilityDist::ContinuousInversion::getXFromY(int energy_index, double
         return x_min_;
     }
     else {
-        double y_i = CDF_PER_ENERGY(y_i_index, 1);
-        double y_i_1 = CDF_PER_ENERGY(y_i_index + 1, 1);
-        double x_i = CDF_PER_ENERGY(y_i_index, 0);
-        double x_i_1 = CDF_PER_ENERGY(y_i_index + 1, 0);
-        double a_i = interp_parameters_per_energy(y_i_index, 0);
-        double b_i = interp_parameters_per_energy(y_i_index, 1);
+        const RITANode& node = table[y_i_index];
+        const RITANode& next_node = table[y_i_index + 1];
 
-        double nu = y - y_i;
-        double delta_i = y_i_1 - y_i;
+        double nu = y - node.y;
+        double delta_i = next_node.y - node.y;
 
-        double x = x_i + (1 + a_i + b_i) * delta_i * nu / (delta_i * delta_i + a_i * delta_i * nu + b_i * nu * nu) * (x_i_1 - x_i);
+        double x = node.x + (1 + node.a + node.b) * delta_i * nu / (delta_i * delta_i + node.a * delta_i * nu + node.b * nu * nu) * (next_node.x - node.x);
         return x;
     }
 }
 
 void ProbabilityDist::ContinuousInversion::initializeCDFAndInterpolationParameters() {
+    log_energies_ = energies_.array().log();
+    // a cache entry which was rejected after being deserialized leaves its tables behind
+    table_.clear();
+    table_offsets_.assign(1, 0);
+    guide_table_.clear();
+
+    std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> CDFs(energies_.size());
+    std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> interp_parameters(energies_.size());
+    if (omp_in_parallel()) {
+        // e.g. materials being built in parallel. Idle threads of that region pick up the tasks
+        buildTablesAsTasks(CDFs, interp_parameters);
+    } else {
+#pragma omp parallel default(none) shared(CDFs, interp_parameters)
+#pragma omp single
+        buildTablesAsTasks(CDFs, interp_parameters);
+    }
 
     for (int i = 0; i < energies_.size(); ++i) {
+        appendTable(CDFs[i], interp_parameters[i]);
+    }
+    table_.shrink_to_fit();
+    guide_table_.shrink_to_fit();
+}
+
+void ProbabilityDist::ContinuousInversion::buildTablesAsTasks(std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> &CDFs,
+                                                              std::vector<Eigen::Array<double, Eigen::Dynamic, 2>> &interp_parameters) const {
+    const int num_energies = static_cast<int>(energies_.size());
+#pragma omp taskloop default(none) shared(CDFs, interp_parameters, num_energies) grainsize(1)
+    for (int i = 0; i < num_energies; ++i) {
         // normalize PDF for each energy
-        normalizePDF(energies_(i));
+        double integral = getPDFIntegral(energies_(i));
         // generate CDF for each energy
-        Eigen::Array<double, Eigen::Dynamic, 2> CDF_PER_ENERGY = getMinimizedErrorCDFPerEnergy(energies_(i), err_thresh_);
-
+        CDFs[i] = getMinimizedErrorCDFPerEnergy(energies_(i), integral, err_thresh_);
         // calculate interpolation parameters for each energy
-        Eigen::Array<double, Eigen::Dynamic, 2> interp_parameters_per_energy = calculateInterpolationParametersPerEnergy(
-                energies_(i), CDF_PER_ENERGY);
+        interp_parameters[i] = calculateInterpolationParametersPerEnergy(energies_(i), integral, CDFs[i]);
+    }
+}
+
+void ProbabilityDist::ContinuousInversion::appendTable(const Eigen::Array<double, Eigen::Dynamic, 2> &CDF_PER_ENERGY,
+                                                       const Eigen::Array<double, Eigen::Dynamic, 2> &interp_parameters_per_energy) {
+    const int num_nodes = static_cast<int>(CDF_PER_ENERGY.rows());
+    const int offset = static_cast<int>(table_.size());
+
+    for (int i = 0; i < num_nodes; ++i) {
+        // the last node only closes the final interval, so it has no interpolation parameters
+        double a_i = i < num_nodes - 1 ? interp_parameters_per_energy(i, 0) : 0.0;
+        double b_i = i < num_nodes - 1 ? interp_parameters_per_energy(i, 1) : 0.0;
+        table_.push_back({CDF_PER_ENERGY(i, 0), CDF_PER_ENERGY(i, 1), a_i, b_i});
+    }
+
+    // guide bin j holds the interval containing y = j/num_nodes, which is a lower bound for any y in the bin
+    int y_i_index = -1;
+    for (int j = 0; j < num_nodes; ++j) {
+        double y = static_cast<double>(j) / num_nodes;
+        while (y_i_index < num_nodes - 1 && table_[offset + y_i_index + 1].y < y) {
+            ++y_i_index;
+        }
+        guide_table_.push_back(y_i_index);
+    }
+    table_offsets_.push_back(offset + num_nodes);
+}
 
-        CDF_.push_back(CDF_PER_ENERGY);
-        interp_parameters_.push_back(interp_parameters_per_energy);
+void ProbabilityDist::ContinuousInversion::addToCacheKey(TableCache::Key &cache_key) const {
+    cache_key.add(energies_).add(x_min_).add(x_max_).add(err_thresh_);
+}
+
+void ProbabilityDist::ContinuousInversion::serialize(std::string &payload) const {
+    TableCache::appendMatrix(payload, energies_);
+    TableCache::appendValue(payload, x_min_);
+    TableCache::appendValue(payload, x_max_);
+    TableCache::appendValue(payload, err_thresh_);
+    TableCache::appendVector(payload, table_);
+    TableCache::appendVector(payload, table_offsets_);
+    TableCache::appendVector(payload, guide_table_);
+}
+
+bool ProbabilityDist::ContinuousInversion::deserialize(TableCache::Reader &reader) {
+    Eigen::VectorXd energies;
+    double x_min, x_max, err_thresh;
+    std::vector<RITANode> table;
+    std::vector<int> table_offsets;
+    std::vector<int> guide_table;
+    if (!reader.readMatrix(energies) || !reader.read(x_min) || !reader.read(x_max) || !reader.read(err_thresh) ||
+        !reader.readVector(table) || !reader.readVector(table_offsets) || !reader.readVector(guide_table)) {
+        return false;
+    }
+    // the tables are only used if they are consistent with each other and with the energy grid
+    if (energies.size() < 2 || table_offsets.size() != static_cast<size_t>(energies.size()) + 1 || table_offsets.front() != 0 ||
+        table_offsets.back() != static_cast<int>(table.size()) || guide_table.size() != table.size()) {
+        return false;
     }
+    // a corrupt entry can still pass its checksum, and sampling indexes the table with the guide table unchecked
+    for (size_t i = 0; i + 1 < table_offsets.size(); ++i) {
+        const int num_nodes = table_offsets[i + 1] - table_offsets[i];
+        if (num_nodes < 2) {
+            return false;
+        }
+        for (int j = table_offsets[i]; j < table_offsets[i + 1]; ++j) {
+            if (guide_table[j] < -1 || guide_table[j] > num_nodes - 1) {
+                return false;
+            }
+        }
+    }
+    energies_ = std::move(energies);
+    log_energies_ = energies_.array().log();
+    x_min_ = x_min;
+    x_max_ = x_max;
+    err_thresh_ = err_thresh;
+    table_ = std::move(table);
+    table_offsets_ = std::move(table_offsets);
+    guide_table_ = std::move(guide_table);
+    return true;
 }
 
-Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::getMinimizedErrorCDFPerEnergy(double E, double err_thresh) {
+Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::getMinimizedErrorCDFPerEnergy(double E, double integral, double err_thresh) const {
     // get initial CDF with 10 grid points
     Eigen::VectorXd x_grid = Eigen::VectorXd::LinSpaced(10, x_min_, x_max_);
 
     bool threshold_met = false;
 
     while (!threshold_met) {
-        Eigen::Array<double, Eigen::Dynamic, 2> CDF_RITA_PER_ENERGY = generateCDFPerEnergy(E, x_grid);
+        Eigen::Array<double, Eigen::Dynamic, 2> CDF_RITA_PER_ENERGY = generateCDFPerEnergy(E, integral, x_grid);
         Eigen::Array<double, Eigen::Dynamic, 2> interp_parameters_per_energy_RITA = calculateInterpolationParametersPerEnergy(
-                E, CDF_RITA_PER_ENERGY);
+                E, integral, CDF_RITA_PER_ENERGY);
         std::vector<double> new_x_grid;
 
         threshold_met = true;
@@ -158,7 +398,7 @@ Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::ge
             id.y_i_1 = CDF_RITA_PER_ENERGY(i + 1, 1);
             id.a_i = interp_parameters_per_energy_RITA(i, 0);
             id.b_i = interp_parameters_per_energy_RITA(i, 1);
-            double eps_i = getInterpErrorOverInterval(E, id);
+            double eps_i = getInterpErrorOverInterval(E, integral, id);
             if (eps_i > err_thresh) {
                 // add new grid points at midpoint if error is too large
                 double x_new = (id.x_i + id.x_i_1) / 2;
@@ -170,11 +410,11 @@ Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::ge
         x_grid = Eigen::Map<Eigen::VectorXd, Eigen::Unaligned>(new_x_grid.data(), new_x_grid.size()); // move new grid points to x_grid
     }
 
-    Eigen::Array<double, Eigen::Dynamic, 2> CDF_RITA_PER_ENERGY = generateCDFPerEnergy(E, x_grid);
+    Eigen::Array<double, Eigen::Dynamic, 2> CDF_RITA_PER_ENERGY = generateCDFPerEnergy(E, integral, x_grid);
     return CDF_RITA_PER_ENERGY;
 }
 
-double ProbabilityDist::ContinuousInversion::getInterpErrorOverInterval(double E, IntervalData id) const {
+double ProbabilityDist::ContinuousInversion::getInterpErrorOverInterval(double E, double integral, IntervalData id) const {
     // PENELOPE 1.57
     // calculate eps_i = integral from x_i to x_i_1 of abs(p(x) - p_num(x)) dx using trapezoidal rule N=51
     const int N = 51;
@@ -182,34 +422,17 @@ double ProbabilityDist::ContinuousInversion::getInterpErrorOverInterval(double E
     double sum = 0;
     for (int i = 1; i < N; ++i) {
         double x_k = id.x_i + i * delta_x;
-        double p = normalized_PDF_(x_k, E);
-        double p_num = getPDFFromCDFOverInterval(E, x_k, id);
+        double p = PDF_(x_k, E) / integral;
+        double p_num = ProbabilityDistHelpers::getRITAPDF(x_k, id);
         sum += abs(p - p_num);
     }
-    double eps_i = delta_x * (sum + (abs(normalized_PDF_(id.x_i_1, E) - getPDFFromCDFOverInterval(E, id.x_i_1, id))
-            + abs(normalized_PDF_(id.x_i, E) - getPDFFromCDFOverInterval(E, id.x_i, id))) / 2);
+    double eps_i = delta_x * (sum + (abs(PDF_(id.x_i_1, E) / integral - ProbabilityDistHelpers::getRITAPDF(id.x_i_1, id))
+            + abs(PDF_(id.x_i, E) / integral - ProbabilityDistHelpers::getRITAPDF(id.x_i, id))) / 2);
     return eps_i;
 }
 
-double ProbabilityDist::ContinuousInversion::getPDFFromCDFOverInterval(double E, double x, IntervalData id) const {
-    // PENELOPE 1.55
-    double eta = getEta(x, id);
-    double p_num = pow(1 + id.a_i * eta + id.b_i * eta * eta, 2) / ((1 + id.a_i + id.b_i) * (1 - id.b_i * eta * eta)) * (id.y_i_1 - id.y_i) / (id.x_i_1 - id.x_i);
-    return p_num;
-}
-
-double ProbabilityDist::ContinuousInversion::getEta(double x, IntervalData id) const {
-    // PENELOPE 1.56
-    double tau = (x - id.x_i) / (id.x_i_1 - id.x_i);
-    if (tau == 0) {
-        return 0;
-    }
-    double eta = (1 + id.a_i + id.b_i - id.a_i * tau) / (2 * id.b_i * tau) * (1 - sqrt(1 - 4 * id.b_i * tau * tau / pow(1 + id.a_i + id.b_i - id.a_i * tau, 2)));
-    return eta;
-}
-
 Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::calculateInterpolationParametersPerEnergy(
-        double E, Eigen::Array<double, Eigen::Dynamic, 2> CDF_RITA_PER_ENERGY) {
+        double E, double integral, const Eigen::Array<double, Eigen::Dynamic, 2> &CDF_RITA_PER_ENERGY) const {
     // calculate a_i and b_i for E
 
     const int CDF_RITA_SIZE = CDF_RITA_PER_ENERGY.rows();
@@ -220,16 +443,17 @@ Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::ca
         double x_i_1 = CDF_RITA_PER_ENERGY(i + 1, 0);
         double y_i = CDF_RITA_PER_ENERGY(i, 1);
         double y_i_1 = CDF_RITA_PER_ENERGY(i + 1, 1);
-        double b_i = 1 - pow((y_i_1 - y_i) / (x_i_1 - x_i), 2) * (1 / (normalized_PDF_(x_i, E) * normalized_PDF_(x_i_1, E)));
-        double a_i = (y_i_1 - y_i) / (x_i_1 - x_i) * (1 / normalized_PDF_(x_i, E)) - b_i - 1;
-        interp_parameters_per_energy_RITA(i, 0) = a_i;
-        interp_parameters_per_energy_RITA(i, 1) = b_i;
+        double p_i = PDF_(x_i, E) / integral;
+        double p_i_1 = PDF_(x_i_1, E) / integral;
+        auto parameters = ProbabilityDistHelpers::getRITAParameters(x_i, x_i_1, y_i, y_i_1, p_i, p_i_1);
+        interp_parameters_per_energy_RITA(i, 0) = parameters.first;
+        interp_parameters_per_energy_RITA(i, 1) = parameters.second;
     }
 
     return interp_parameters_per_energy_RITA;
 }
 
-Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::generateCDFPerEnergy(double E, Eigen::VectorXd x_grid) {
+Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::generateCDFPerEnergy(double E, double integral, const Eigen::VectorXd &x_grid) const {
 
     int NUM_GRID_POINTS = x_grid.size();
 
@@ -249,7 +473,7 @@ Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::ge
         double sum = 0;
         for (int k = 0; k < NUM_POINTS; ++k) {
             double x_k = x + k * h;
-            double f = normalized_PDF_(x_k, E);
+            double f = PDF_(x_k, E) / integral;
             if (k == 0 || k == NUM_POINTS - 1) {
                 sum += f;
             } else if (k % 2 == 0) {
@@ -264,8 +488,8 @@ Eigen::Array<double, Eigen::Dynamic, 2> ProbabilityDist::ContinuousInversion::ge
     return CDF_RITA_PER_ENERGY;
 }
 
-void ProbabilityDist::ContinuousInversion::normalizePDF(double E) {
-    // normalize PDF using simpson's rule
+double ProbabilityDist::ContinuousInversion::getPDFIntegral(double E) const {
+    // integrate PDF using simpson's rule
     const int NUM_POINTS = 1001;
     double h = (x_max_ - x_min_) / (NUM_POINTS - 1);
     double sum = 0;
@@ -280,12 +504,170 @@ void ProbabilityDist::ContinuousInversion::normalizePDF(double E) {
             sum += 4 * f;
         }
     }
-    double integral = h / 3 * sum;
-    normalized_PDF_ = [this, integral](double x, double E) {
-        return PDF_(x, E) / integral;
-    };
+    return h / 3 * sum;
+}
+
+ProbabilityDist::TruncatedInversion::TruncatedInversion(const std::function<double(double)> &PDF, const Eigen::VectorXd &x_grid,
+                                                        double err_thresh) {
+    if (x_grid.size() < 2) {
+        throw std::invalid_argument("TruncatedInversion requires at least two grid points");
+    }
+    buildTable(PDF, x_grid, err_thresh);
+    generateGuideTable();
+}
+
+double ProbabilityDist::TruncatedInversion::sample(double x_max) const {
+    return sampleBelowCumulative(getCumulative(x_max));
+}
+
+double ProbabilityDist::TruncatedInversion::sampleBelowCumulative(double y_max) const {
+    const int num_nodes = static_cast<int>(table_.size());
+    double y = uniform_dist_.sample() * y_max;
+
+    // find the interval with y_i <= y <= y_i_1, starting from the guide table. The bin is clamped for y = 1
+    int y_i_index = guide_table_[std::min(static_cast<int>(y * num_nodes), num_nodes - 1)];
+    while (y_i_index < num_nodes - 2 && table_[y_i_index + 1].y < y) {
+        ++y_i_index;
+    }
+
+    const RITANode& node = table_[y_i_index];
+    const RITANode& next_node = table_[y_i_index + 1];
+    double delta_i = next_node.y - node.y;
+    if (delta_i <= 0) {
+        return node.x;
+    }
+    double nu = y - node.y;
+    return node.x + (1 + node.a + node.b) * delta_i * nu / (delta_i * delta_i + node.a * delta_i * nu + node.b * nu * nu) * (next_node.x - node.x);
+}
+
+double ProbabilityDist::TruncatedInversion::getCumulative(double x) const {
+    if (x <= x_nodes_.front()) {
+        return 0;
+    }
+    if (x >= x_nodes_.back()) {
+        return 1;
+    }
+    int index = static_cast<int>(std::upper_bound(x_nodes_.begin(), x_nodes_.end(), x) - x_nodes_.begin()) - 1;
+    const RITANode& node = table_[index];
+    const RITANode& next_node = table_[index + 1];
+    IntervalData id{node.x, next_node.x, node.y, next_node.y, node.a, node.b};
+    return node.y + ProbabilityDistHelpers::getRITAEta(x, id) * (next_node.y - node.y);
 }
 
+void ProbabilityDist::TruncatedInversion::buildTable(const std::function<double(double)> &PDF, const Eigen::VectorXd &x_grid,
+                                                     double err_thresh) {
+    // integrates the PDF over [x, x_1] using extended Simpson's rule with 51 equally spaced points
+    auto integrate = [&PDF](double x, double x_1) {
+        const int NUM_POINTS = 51;
+        double h = (x_1 - x) / (NUM_POINTS - 1);
+        double sum = 0;
+        for (int k = 0; k < NUM_POINTS; ++k) {
+            double f = PDF(x + k * h);
+            if (k == 0 || k == NUM_POINTS - 1) {
+                sum += f;
+            } else if (k % 2 == 0) {
+                sum += 2 * f;
+            } else {
+                sum += 4 * f;
+            }
+        }
+        return h / 3 * sum;
+    };
+
+    // bisection stops regardless of the error after this many passes, so noisy PDFs cannot refine forever
+    const int MAX_REFINEMENTS = 20;
+
+    std::vector<double> x_nodes(x_grid.data(), x_grid.data() + x_grid.size());
+    for (int refinement = 0; refinement <= MAX_REFINEMENTS; ++refinement) {
+        const int num_nodes = static_cast<int>(x_nodes.size());
 
+        std::vector<double> cumulative(num_nodes, 0.0);
+        for (int i = 0; i < num_nodes - 1; ++i) {
+            cumulative[i + 1] = cumulative[i] + integrate(x_nodes[i], x_nodes[i + 1]);
+        }
+        double total = cumulative.back();
+        if (total <= 0) {
+            throw std::runtime_error("TruncatedInversion PDF integrates to zero over the grid");
+        }
 
+        table_.clear();
+        for (int i = 0; i < num_nodes; ++i) {
+            table_.push_back({x_nodes[i], cumulative[i] / total, 0.0, 0.0});
+        }
+        for (int i = 0; i < num_nodes - 1; ++i) {
+            auto parameters = ProbabilityDistHelpers::getRITAParameters(table_[i].x, table_[i + 1].x, table_[i].y, table_[i + 1].y,
+                                                                        PDF(table_[i].x) / total, PDF(table_[i + 1].x) / total);
+            table_[i].a = parameters.first;
+            table_[i].b = parameters.second;
+        }
+        if (refinement == MAX_REFINEMENTS) {
+            break;
+        }
 
+        // PENELOPE 1.57, relative to the probability of the interval so that truncated samples are as accurate as full ones.
+        // Intervals with less than err_thresh of the probability are held to an absolute error of err_thresh^2 instead,
+        // since the differences of cumulative values close to 1 are dominated by round-off
+        std::vector<double> new_x_nodes;
+        bool threshold_met = true;
+        for (int i = 0; i < num_nodes - 1; ++i) {
+            new_x_nodes.push_back(x_nodes[i]);
+            IntervalData id{table_[i].x, table_[i + 1].x, table_[i].y, table_[i + 1].y, table_[i].a, table_[i].b};
+            double probability = id.y_i_1 - id.y_i;
+            if (probability <= 0) {
+                continue;
+            }
+            const int N = 51;
+            double delta_x = (id.x_i_1 - id.x_i) / N;
+            double sum = 0;
+            for (int k = 0; k <= N; ++k) {
+                double x_k = id.x_i + k * delta_x;
+                double error = std::abs(PDF(x_k) / total - ProbabilityDistHelpers::getRITAPDF(x_k, id));
+                sum += (k == 0 || k == N) ? error / 2 : error;
+            }
+            if (delta_x * sum > err_thresh * std::max(probability, err_thresh)) {
+                new_x_nodes.push_back((id.x_i + id.x_i_1) / 2);
+                threshold_met = false;
+            }
+        }
+        new_x_nodes.push_back(x_nodes.back());
+        if (threshold_met) {
+            break;
+        }
+        x_nodes = std::move(new_x_nodes);
+    }
+
+    x_nodes_ = std::move(x_nodes);
+    table_.shrink_to_fit();
+}
+
+void ProbabilityDist::TruncatedInversion::serialize(std::string &payload) const {
+    TableCache::appendVector(payload, table_);
+}
+
+bool ProbabilityDist::TruncatedInversion::deserialize(TableCache::Reader &reader) {
+    std::vector<RITANode> table;
+    if (!reader.readVector(table) || table.size() < 2) {
+        return false;
+    }
+    table_ = std::move(table);
+    x_nodes_.clear();
+    for (const auto &node : table_) {
+        x_nodes_.push_back(node.x);
+    }
+    generateGuideTable();
+    return true;
+}
+
+void ProbabilityDist::TruncatedInversion::generateGuideTable() {
+    // guide bin j holds the interval containing y = j/num_nodes, which is a lower bound for any y in the bin
+    const int num_nodes = static_cast<int>(table_.size());
+    guide_table_.resize(num_nodes);
+    int y_i_index = 0;
+    for (int j = 0; j < num_nodes; ++j) {
+        double y = static_cast<double>(j) / num_nodes;
+        while (y_i_index < num_nodes - 2 && table_[y_i_index + 1].y < y) {
+            ++y_i_index;
+        }
+        guide_table_[j] = y_i_index;
+    }
+}
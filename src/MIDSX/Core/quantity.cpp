@@ -1,96 +1,124 @@
 #include "Core/quantity.h"
-
-VectorValue VectorValue::operator+(VectorValue& other) const {
-    // combine two vectors
-    VectorValue sum = *this;
-    sum.addValues(other.getVector());
-    // reset sum and var
-    sum.summed_ = false;
-    sum.var_calculated_ = false;
-    sum.sum_ = 0;
-    sum.var_ = 0;
+#include <algorithm>
+#include <stdexcept>
+
+MomentValue MomentValue::operator+(const MomentValue& other) const {
+    MomentValue sum = *this;
+    sum.mergeDeviations(other.count_, other.mean_, other.sum_of_squared_deviations_);
+    sum.addToSum(other.sum_);
+    sum.addToSum(-other.sum_compensation_);
     return sum;
 }
 
-void VectorValue::addValue(double value) {
-    values_.push_back(value);
+void MomentValue::addValue(double value) {
+    // Welford's update
+    count_++;
+    addToSum(value);
+    double delta = value - mean_;
+    mean_ += delta / count_;
+    sum_of_squared_deviations_ += delta * (value - mean_);
 }
 
-void VectorValue::addValues(const std::vector<double>& values) {
-    values_.insert(values_.end(), values.begin(), values.end());
+void MomentValue::addMoments(uint64_t count, double mean, double sum_of_squared_deviations) {
+    mergeDeviations(count, mean, sum_of_squared_deviations);
+    addToSum(count * mean);
 }
 
-std::vector<double>& VectorValue::getVector() {
-    return values_;
+void MomentValue::addToSum(double value) {
+    double compensated_value = value - sum_compensation_;
+    double sum = sum_ + compensated_value;
+    sum_compensation_ = (sum - sum_) - compensated_value;
+    sum_ = sum;
 }
 
-double VectorValue::getSum() {
-    double sum = 0;
-    for (auto& value : values_) {
-        sum += value;
+void MomentValue::mergeDeviations(uint64_t count, double mean, double sum_of_squared_deviations) {
+    // pairwise update of Chan et al.
+    if (count == 0) {
+        return;
     }
-    sum_ = sum;
-    summed_ = true;
-    return sum;
+    uint64_t total_count = count_ + count;
+    double delta = mean - mean_;
+    mean_ += delta * (static_cast<double>(count) / total_count);
+    sum_of_squared_deviations_ += sum_of_squared_deviations + delta * delta * (static_cast<double>(count_) * count / total_count);
+    count_ = total_count;
 }
 
-double VectorValue::getSumSTD() {
-    double var = 0;
-    if (!var_calculated_) {
-        var = getVariance();
-    } else {
-        var = var_;
-    }
-    return sqrt(values_.size() * var);
+double MomentValue::getSum() const {
+    return sum_;
 }
 
-double VectorValue::getMean() {
-    double sum = 0;
-    if (!summed_) {
-        sum = getSum();
-    } else {
-        sum = sum_;
-    }
-    double mean = sum / values_.size();
-    return mean;
+double MomentValue::getSumSTD() const {
+    return sqrt(count_ * getVariance());
+}
+
+double MomentValue::getMean() const {
+    return sum_ / count_;
 }
 
-double VectorValue::getMeanSTD() {
+double MomentValue::getMeanSTD() const {
     // sample standard deviation
-    double var = 0;
-    if (!var_calculated_) {
-        var = getVariance();
-    } else {
-        var = var_;
-    }
-    return sqrt(var / values_.size());
+    return sqrt(getVariance() / count_);
 }
 
-double VectorValue::getCount() {
-    return values_.size();
+double MomentValue::getCount() const {
+    return count_;
 }
 
-double VectorValue::getCountSTD() {
-    return sqrt(values_.size());
+double MomentValue::getCountSTD() const {
+    return sqrt(count_);
 }
 
-double VectorValue::getVariance() {
+double MomentValue::getVariance() const {
     // sample variance
-    double sum = 0;
-    if (!summed_) {
-        sum = getSum();
+    return sum_of_squared_deviations_ / (count_ - 1.0);
+}
+
+VectorValue VectorValue::operator+(const VectorValue& other) const {
+    VectorValue sum = *this;
+    sum.moments_ = moments_ + other.moments_;
+    sum.min_ = std::min(min_, other.min_);
+    sum.max_ = std::max(max_, other.max_);
+    if (retain_values_ && other.retain_values_) {
+        sum.values_.insert(sum.values_.end(), other.values_.begin(), other.values_.end());
     } else {
-        sum = sum_;
+        sum.retain_values_ = false;
+        sum.values_ = {};
+    }
+    return sum;
+}
+
+void VectorValue::addValue(double value) {
+    moments_.addValue(value);
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    if (retain_values_) {
+        values_.push_back(value);
+    }
+}
+
+void VectorValue::addValues(const std::vector<double>& values) {
+    for (double value : values) {
+        addValue(value);
     }
-    double mean = sum / values_.size();
-    double var = 0;
-    for (auto& value : values_) {
-        var += (value - mean) * (value - mean);
+}
+
+const std::vector<double>& VectorValue::getVector() const {
+    if (!retain_values_) {
+        throw std::runtime_error("VectorValue does not retain its values. Enable retention when constructing the quantity to read them");
     }
-    var /= (values_.size() - 1);
-    var_ = var;
-    var_calculated_ = true;
-    return var;
+    return values_;
+}
+
+bool VectorValue::isRetainingValues() const {
+    return retain_values_;
+}
+
+double VectorValue::getMin() const {
+    return min_;
+}
+
+double VectorValue::getMax() const {
+    return max_;
 }
 
 CountValue CountValue::operator+(const CountValue& other) const {
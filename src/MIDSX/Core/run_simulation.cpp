@@ -3,10 +3,34 @@
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "openmp-use-default-none"
 
+namespace {
+    // transports through the voxel grids at a resolution level for its lifetime, so that they are returned to their
+    // full resolution however the run ends
+    class ResolutionLevelGuard {
+    public:
+        ResolutionLevelGuard(PhysicsEngine& physics_engine, int resolution_level) : physics_engine_(physics_engine) {
+            try {
+                physics_engine_.setResolutionLevel(resolution_level);
+            } catch (...) {
+                physics_engine_.setResolutionLevel(0); // the voxel grids set before the failure
+                throw;
+            }
+        }
+        ~ResolutionLevelGuard() {
+            physics_engine_.setResolutionLevel(0);
+        }
+        ResolutionLevelGuard(const ResolutionLevelGuard&) = delete;
+        ResolutionLevelGuard& operator=(const ResolutionLevelGuard&) = delete;
+    private:
+        PhysicsEngine& physics_engine_;
+    };
+}
+
 void runSimulation(PhotonSource& source, PhysicsEngine& physics_engine,
                    std::function<std::vector<std::unique_ptr<SurfaceTally>>()> surface_tally_init,
                      std::function<std::vector<std::unique_ptr<VolumeTally>>()> volume_tally_init,
-                   int N_photons, double& run_time) {
+                   int N_photons, double& run_time, int resolution_level) {
+    ResolutionLevelGuard resolution_level_guard(physics_engine, resolution_level);
     int j = 0;
     // timer
     double start_time = omp_get_wtime();
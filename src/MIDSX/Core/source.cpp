@@ -47,16 +47,24 @@ double MonoenergeticSpectrum::sampleEnergy() {
     return energy_;
 }
 
-PolyenergeticSpectrum::PolyenergeticSpectrum(const Eigen::Matrix<double, Eigen::Dynamic, 2> &probabilities_matrix)
-: energy_dist_(probabilities_matrix) {}
+PolyenergeticSpectrum::PolyenergeticSpectrum(const Eigen::Matrix<double, Eigen::Dynamic, 2> &probabilities_matrix,
+                                             ProbabilityDist::DiscreteSamplingMethod sampling_method) {
+    if (sampling_method == ProbabilityDist::DiscreteSamplingMethod::Alias) {
+        energy_dist_ = std::make_shared<ProbabilityDist::DiscreteAlias>(probabilities_matrix);
+    } else if (sampling_method == ProbabilityDist::DiscreteSamplingMethod::GuideTable) {
+        energy_dist_ = std::make_shared<ProbabilityDist::DiscreteInversion>(probabilities_matrix);
+    } else {
+        throw std::invalid_argument("Unknown DiscreteSamplingMethod");
+    }
+}
 
 double PolyenergeticSpectrum::sampleEnergy() {
-    double energy = energy_dist_.sample();
+    double energy = energy_dist_->sample();
     return energy;
 }
 
 double PolyenergeticSpectrum::getExpectationValue() const {
-    return energy_dist_.getExpectationValue();
+    return energy_dist_->getExpectationValue();
 }
 
 IsotropicDirectionality::IsotropicDirectionality() : uniform_dist_(0, 2*PI) {}
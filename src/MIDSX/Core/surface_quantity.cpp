@@ -19,7 +19,9 @@ std::string CountSurfaceQuantityHelper::toString(CountSurfaceQuantityType type)
     return countTypeToString[type];
 }
 
-VectorSurfaceQuantity::VectorSurfaceQuantity(VectorSurfaceQuantityType type) {
+VectorSurfaceQuantity::VectorSurfaceQuantity(VectorSurfaceQuantityType type, bool retain_values)
+        : primary_values_(retain_values), single_incoherent_scatter_values_(retain_values),
+          single_coherent_scatter_values_(retain_values), multiple_scatter_values_(retain_values) {
     type_ = type;
     if (type == VectorSurfaceQuantityType::IncidentEnergy) {
         valueExtractor_ = [](const TempSurfaceTallyData& temp_surface_tally_data) {
@@ -68,10 +70,9 @@ VectorSurfaceQuantityType VectorSurfaceQuantity::getType() const {
 
 VectorValue& VectorSurfaceQuantity::getTotalValues() {
     if (!totaled_) {
-        total_values_.addValues(primary_values_.getVector());
-        total_values_.addValues(single_incoherent_scatter_values_.getVector());
-        total_values_.addValues(single_coherent_scatter_values_.getVector());
-        total_values_.addValues(multiple_scatter_values_.getVector());
+        // merges the moments of the categories rather than their values, which are only kept in the total if retained
+        total_values_ = primary_values_ + single_incoherent_scatter_values_ + single_coherent_scatter_values_ +
+                        multiple_scatter_values_;
         totaled_ = true;
     }
     return total_values_;
@@ -74,10 +74,10 @@ double SurfaceQuantityContainer::getArea() const {
     return area_;
 }
 
-SurfaceQuantityContainer SurfaceQuantityContainerFactory::AllQuantities() {
+SurfaceQuantityContainer SurfaceQuantityContainerFactory::AllQuantities(bool retain_values) {
     auto container = SurfaceQuantityContainer();
-    container.addVectorQuantity(VectorSurfaceQuantity(VectorSurfaceQuantityType::IncidentEnergy));
-    container.addVectorQuantity(VectorSurfaceQuantity(VectorSurfaceQuantityType::EntranceCosine));
+    container.addVectorQuantity(VectorSurfaceQuantity(VectorSurfaceQuantityType::IncidentEnergy, retain_values));
+    container.addVectorQuantity(VectorSurfaceQuantity(VectorSurfaceQuantityType::EntranceCosine, retain_values));
     container.addCountQuantity(CountSurfaceQuantity(CountSurfaceQuantityType::NumberOfPhotons));
     return container;
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "Core/table_cache.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    struct Magic {
+        char bytes[8];
+    };
+    const Magic MAGIC = {{'M', 'I', 'D', 'S', 'X', 'T', 'B', 'L'}};
+    // bump whenever the layout or the computation of any cached table changes
+    const uint32_t FORMAT_VERSION = 2;
+}
+
+TableCache::Key::Key(std::string name) : name_(std::move(name)) {
+    add(name_);
+}
+
+TableCache::Key& TableCache::Key::add(double value) {
+    appendValue(bytes_, value);
+    return *this;
+}
+
+TableCache::Key& TableCache::Key::add(int value) {
+    appendValue(bytes_, static_cast<int64_t>(value));
+    return *this;
+}
+
+TableCache::Key& TableCache::Key::add(uint64_t value) {
+    appendValue(bytes_, value);
+    return *this;
+}
+
+TableCache::Key& TableCache::Key::add(const std::string& value) {
+    appendValue(bytes_, static_cast<uint64_t>(value.size()));
+    bytes_.append(value);
+    return *this;
+}
+
+TableCache::Key& TableCache::Key::add(const Eigen::VectorXd& values) {
+    appendValue(bytes_, static_cast<uint64_t>(values.size()));
+    bytes_.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    return *this;
+}
+
+std::string TableCache::Key::getFileName() const {
+    std::stringstream ss;
+    ss << name_ << "_" << std::hex << std::setw(16) << std::setfill('0') << hashBytes(bytes_.data(), bytes_.size()) << ".bin";
+    return ss.str();
+}
+
+uint64_t TableCache::hashBytes(const void* data, size_t size, uint64_t hash) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string TableCache::getCacheDirectory() {
+    if (const char* cache_dir = std::getenv("MIDSX_CACHE_DIR")) {
+        return cache_dir;
+    }
+    if (const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME")) {
+        if (*xdg_cache_home) return std::string(xdg_cache_home) + "/midsx";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        if (*home) return std::string(home) + "/.cache/midsx";
+    }
+    return "";
+}
+
+uint64_t TableCache::hashFile(const std::string& path) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, uint64_t> hashes;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = hashes.find(path);
+    if (it != hashes.end()) {
+        return it->second;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open " + path + " for hashing");
+    }
+    // FNV-1a over 8 byte words rather than bytes, which is several times faster on large files
+    const size_t CHUNK_SIZE = 1 << 20;
+    std::vector<uint64_t> chunk(CHUNK_SIZE / sizeof(uint64_t));
+    uint64_t hash = 14695981039346656037ULL;
+    while (file) {
+        file.read(reinterpret_cast<char*>(chunk.data()), CHUNK_SIZE);
+        auto bytes_read = static_cast<size_t>(file.gcount());
+        size_t num_words = bytes_read / sizeof(uint64_t);
+        for (size_t i = 0; i < num_words; ++i) {
+            hash ^= chunk[i];
+            hash *= 1099511628211ULL;
+        }
+        hash = hashBytes(reinterpret_cast<const char*>(chunk.data()) + num_words * sizeof(uint64_t),
+                         bytes_read - num_words * sizeof(uint64_t), hash);
+    }
+    hashes[path] = hash;
+    return hash;
+}
+
+std::unique_ptr<TableCache::Reader> TableCache::load(const Key& key) {
+    std::string cache_dir = getCacheDirectory();
+    if (cache_dir.empty()) {
+        return nullptr;
+    }
+    int fd = open((cache_dir + "/" + key.getFileName()).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    auto size = static_cast<size_t>(file_stat.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    // unmapped once the last reader of the entry is destroyed
+    std::shared_ptr<const void> storage(mapping, [size](const void* data) { munmap(const_cast<void*>(data), size); });
+    Reader reader(storage, static_cast<const char*>(mapping), size);
+
+    Magic magic{};
+    uint32_t version;
+    uint64_t checksum;
+    std::vector<char> stored_key_bytes;
+    const char* payload_bytes;
+    uint64_t payload_size;
+    if (!reader.read(magic) || std::memcmp(magic.bytes, MAGIC.bytes, sizeof(MAGIC.bytes)) != 0 || !reader.read(version) || version != FORMAT_VERSION) {
+        return nullptr;
+    }
+    if (!reader.readVector(stored_key_bytes) || !reader.read(checksum) || !reader.readBytesInPlace(payload_bytes, payload_size) || !reader.isAtEnd()) {
+        return nullptr;
+    }
+    if (std::string(stored_key_bytes.begin(), stored_key_bytes.end()) != key.getBytes() ||
+        hashBytes(payload_bytes, payload_size) != checksum) {
+        return nullptr;
+    }
+    return std::make_unique<Reader>(std::move(storage), payload_bytes, payload_size);
+}
+
+void TableCache::store(const Key& key, const std::string& payload) {
+    std::string cache_dir = getCacheDirectory();
+    if (cache_dir.empty()) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(cache_dir, error);
+    if (error) {
+        return;
+    }
+
+    std::string contents;
+    appendValue(contents, MAGIC);
+    appendValue(contents, FORMAT_VERSION);
+    appendVector(contents, std::vector<char>(key.getBytes().begin(), key.getBytes().end()));
+    appendValue(contents, hashBytes(payload.data(), payload.size()));
+    appendVector(contents, std::vector<char>(payload.begin(), payload.end()));
+
+    std::string path = cache_dir + "/" + key.getFileName();
+    std::stringstream temp_path;
+    // unique across processes sharing the cache directory, and across threads of a process
+    temp_path << path << ".tmp" << getpid() << "_" << std::hash<std::thread::id>{}(std::this_thread::get_id()) << "_"
+              << std::chrono::steady_clock::now().time_since_epoch().count();
+    {
+        std::ofstream file(temp_path.str(), std::ios::binary);
+        if (!file.write(contents.data(), static_cast<std::streamsize>(contents.size()))) {
+            file.close();
+            std::filesystem::remove(temp_path.str(), error);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path.str(), path, error);
+    if (error) {
+        std::filesystem::remove(temp_path.str(), error);
+    }
+}
@@ -0,0 +1,306 @@
+#include "Core/tetrahedral_mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // vertices of face f, opposite vertex f, ordered so that their normal points out of a tetrahedron of positive volume
+    const int FACE_VERTICES[4][3] = {{1, 2, 3}, {0, 3, 2}, {0, 1, 3}, {0, 2, 1}};
+
+    double getSignedVolume(const Eigen::Vector3d& v0, const Eigen::Vector3d& v1, const Eigen::Vector3d& v2,
+                           const Eigen::Vector3d& v3) {
+        return (v1 - v0).dot((v2 - v0).cross(v3 - v0)) / 6.0;
+    }
+}
+
+TetrahedralMesh::TetrahedralMesh(const std::string& filename) {
+    std::vector<int> material_ids;
+    readMeshFile(filename, material_ids);
+    initializeMesh(material_ids);
+}
+
+TetrahedralMesh::TetrahedralMesh(std::vector<Eigen::Vector3d> vertices, std::vector<std::array<int, 4>> tetrahedra,
+                                 const std::vector<int>& material_ids) :
+        vertices_(std::move(vertices)), tetrahedra_(std::move(tetrahedra)) {
+    initializeMesh(material_ids);
+}
+
+int TetrahedralMesh::findTetrahedron(const Eigen::Vector3d& position) const {
+    if (!bounds_.contains(position)) {
+        return -1;
+    }
+    Eigen::Vector3i cell_index = getLookupCellIndex(position);
+    int cell = cell_index[0] + cell_index[1] * lookup_dim_[0] + cell_index[2] * lookup_dim_[0] * lookup_dim_[1];
+    int begin = lookup_cell_offsets_[cell];
+    int end = lookup_cell_offsets_[cell + 1];
+    if (begin == end) {
+        return -1; // no tetrahedron comes near the cell
+    }
+
+    int tetrahedron = lookup_cell_tetrahedra_[begin];
+    for (int step = 0; step < MAX_WALK_STEPS; step++) {
+        int face = getFaceOutside(tetrahedron, position);
+        if (face < 0) {
+            return tetrahedron;
+        }
+        tetrahedron = neighbors_[tetrahedron][face];
+        if (tetrahedron < 0) {
+            break; // left the mesh, which the position may be outside of or may reach around a concavity
+        }
+    }
+    // the tetrahedra overlapping the cell include every one which can contain the position
+    for (int i = begin; i < end; i++) {
+        if (getFaceOutside(lookup_cell_tetrahedra_[i], position) < 0) {
+            return lookup_cell_tetrahedra_[i];
+        }
+    }
+    return -1;
+}
+
+double TetrahedralMesh::getExitDistance(int tetrahedron, const Eigen::Vector3d& position, const Eigen::Vector3d& direction) const {
+    const std::array<int, 4>& vertices = tetrahedra_[tetrahedron];
+    double distance = INF;
+    for (const auto& face_vertices : FACE_VERTICES) {
+        const Eigen::Vector3d& a = vertices_[vertices[face_vertices[0]]];
+        Eigen::Vector3d normal = (vertices_[vertices[face_vertices[1]]] - a).cross(vertices_[vertices[face_vertices[2]]] - a);
+        double cosine = normal.dot(direction);
+        if (cosine > 0) {
+            // the normal need not be normalized, as its length cancels
+            distance = std::min(distance, normal.dot(a - position) / cosine);
+        }
+    }
+    return std::isfinite(distance) ? std::max(distance, 0.0) : 0.0;
+}
+
+void TetrahedralMesh::remapMaterialIds(const std::vector<int>& material_ids) {
+    // the material IDs of the mesh are kept, and only the indices of its tetrahedra move to the new list
+    std::array<uint8_t, 256> new_indices{};
+    for (int material_id : material_ids_) {
+        auto it = std::find(material_ids.begin(), material_ids.end(), material_id);
+        if (it == material_ids.end()) {
+            throw std::runtime_error("Material " + std::to_string(material_id) + " of the mesh is not in the list of materials.");
+        }
+        auto old_it = std::find(indexed_material_ids_.begin(), indexed_material_ids_.end(), material_id);
+        new_indices[old_it - indexed_material_ids_.begin()] = static_cast<uint8_t>(it - material_ids.begin());
+    }
+    for (uint8_t& material_index : material_indices_) {
+        material_index = new_indices[material_index];
+    }
+    indexed_material_ids_ = material_ids;
+}
+
+double TetrahedralMesh::getVolume() const {
+    double volume = 0.0;
+    for (const auto& vertices : tetrahedra_) {
+        volume += getSignedVolume(vertices_[vertices[0]], vertices_[vertices[1]], vertices_[vertices[2]], vertices_[vertices[3]]);
+    }
+    return volume;
+}
+
+size_t TetrahedralMesh::getMemorySize() const {
+    return vertices_.size() * sizeof(Eigen::Vector3d) + tetrahedra_.size() * sizeof(std::array<int, 4>) +
+           neighbors_.size() * sizeof(std::array<int, 4>) + material_indices_.size() +
+           (lookup_cell_offsets_.size() + lookup_cell_tetrahedra_.size()) * sizeof(int);
+}
+
+void TetrahedralMesh::readMeshFile(const std::string& filename, std::vector<int>& material_ids) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Can't open mesh file " + filename);
+    }
+    // comments are removed so the rest can be read as a stream of numbers
+    std::stringstream contents;
+    std::string line;
+    while (std::getline(file, line)) {
+        contents << line.substr(0, line.find('#')) << '\n';
+    }
+
+    std::string keyword;
+    long long num_vertices = -1;
+    if (!(contents >> keyword >> num_vertices) || keyword != "vertices" || num_vertices < 0) {
+        throw std::runtime_error(filename + " is not a mesh file, as it does not start with the number of vertices");
+    }
+    vertices_.resize(num_vertices);
+    for (auto& vertex : vertices_) {
+        if (!(contents >> vertex[0] >> vertex[1] >> vertex[2])) {
+            throw std::runtime_error("Mesh file " + filename + " has fewer vertices than it declares");
+        }
+    }
+    long long num_tetrahedra = -1;
+    if (!(contents >> keyword >> num_tetrahedra) || keyword != "tetrahedra" || num_tetrahedra < 0) {
+        throw std::runtime_error("Mesh file " + filename + " does not give the number of tetrahedra after its vertices");
+    }
+    tetrahedra_.resize(num_tetrahedra);
+    material_ids.resize(num_tetrahedra);
+    for (long long i = 0; i < num_tetrahedra; i++) {
+        std::array<int, 4>& vertices = tetrahedra_[i];
+        if (!(contents >> vertices[0] >> vertices[1] >> vertices[2] >> vertices[3] >> material_ids[i])) {
+            throw std::runtime_error("Mesh file " + filename + " has fewer tetrahedra than it declares");
+        }
+    }
+}
+
+void TetrahedralMesh::initializeMesh(const std::vector<int>& material_ids) {
+    if (material_ids.size() != tetrahedra_.size()) {
+        throw std::runtime_error("A mesh needs one material ID per tetrahedron.");
+    }
+    bounds_.setEmpty();
+    for (size_t i = 0; i < tetrahedra_.size(); i++) {
+        std::array<int, 4>& vertices = tetrahedra_[i];
+        for (int vertex : vertices) {
+            if (vertex < 0 || vertex >= static_cast<int>(vertices_.size())) {
+                throw std::runtime_error("Tetrahedron " + std::to_string(i) + " of the mesh refers to vertex " +
+                                         std::to_string(vertex) + ", which does not exist.");
+            }
+            bounds_.extend(vertices_[vertex]);
+        }
+        double volume = getSignedVolume(vertices_[vertices[0]], vertices_[vertices[1]], vertices_[vertices[2]], vertices_[vertices[3]]);
+        double edge_length = (vertices_[vertices[1]] - vertices_[vertices[0]]).norm();
+        if (!(std::abs(volume) > EPSILON * edge_length * edge_length * edge_length)) {
+            throw std::runtime_error("Tetrahedron " + std::to_string(i) + " of the mesh has no volume.");
+        }
+        if (volume < 0) {
+            std::swap(vertices[2], vertices[3]);
+        }
+    }
+
+    material_ids_.clear();
+    material_indices_.clear();
+    material_indices_.reserve(material_ids.size());
+    for (int material_id : material_ids) {
+        auto it = std::find(material_ids_.begin(), material_ids_.end(), material_id);
+        if (it == material_ids_.end()) {
+            if (material_ids_.size() == 256) {
+                throw std::runtime_error("A mesh can contain at most 256 materials.");
+            }
+            material_ids_.push_back(material_id);
+            it = material_ids_.end() - 1;
+        }
+        material_indices_.push_back(static_cast<uint8_t>(it - material_ids_.begin()));
+    }
+    indexed_material_ids_ = material_ids_;
+
+    setNeighbors();
+    setLookupGrid();
+}
+
+void TetrahedralMesh::setNeighbors() {
+    // faces are matched by sorting them by their vertices, which needs no hash table as large as the mesh
+    struct Face {
+        std::array<int, 3> vertices;
+        int tetrahedron;
+        int face;
+    };
+    std::vector<Face> faces;
+    faces.reserve(tetrahedra_.size() * 4);
+    for (int i = 0; i < static_cast<int>(tetrahedra_.size()); i++) {
+        for (int f = 0; f < 4; f++) {
+            Face face = {{tetrahedra_[i][FACE_VERTICES[f][0]], tetrahedra_[i][FACE_VERTICES[f][1]], tetrahedra_[i][FACE_VERTICES[f][2]]}, i, f};
+            std::sort(face.vertices.begin(), face.vertices.end());
+            faces.push_back(face);
+        }
+    }
+    std::sort(faces.begin(), faces.end(), [](const Face& a, const Face& b) { return a.vertices < b.vertices; });
+
+    neighbors_.assign(tetrahedra_.size(), {-1, -1, -1, -1});
+    for (size_t i = 0; i + 1 < faces.size(); i++) {
+        if (faces[i].vertices != faces[i + 1].vertices) {
+            continue;
+        }
+        if (i + 2 < faces.size() && faces[i + 2].vertices == faces[i].vertices) {
+            throw std::runtime_error("A face of the mesh is shared by more than two tetrahedra.");
+        }
+        neighbors_[faces[i].tetrahedron][faces[i].face] = faces[i + 1].tetrahedron;
+        neighbors_[faces[i + 1].tetrahedron][faces[i + 1].face] = faces[i].tetrahedron;
+        i++;
+    }
+}
+
+void TetrahedralMesh::setLookupGrid() {
+    lookup_dim_ = Eigen::Vector3i::Ones();
+    lookup_inv_cell_size_ = Eigen::Vector3d::Zero();
+    lookup_cell_offsets_ = {0, 0};
+    lookup_cell_tetrahedra_.clear();
+    if (tetrahedra_.empty()) {
+        return;
+    }
+
+    // about one cell per two tetrahedra, so walks are a few steps long and a cell overlaps few tetrahedra
+    const Eigen::Vector3d dim_space = bounds_.sizes();
+    double num_cells = std::min(std::max(tetrahedra_.size() / 2.0, 1.0), 4194304.0);
+    double cell_size = std::cbrt(dim_space.prod() / num_cells);
+    for (int i = 0; i < 3; i++) {
+        if (cell_size > 0 && std::isfinite(cell_size) && dim_space[i] > 0) {
+            lookup_dim_[i] = std::max(1, std::min(static_cast<int>(std::ceil(dim_space[i] / cell_size)), 1024));
+            lookup_inv_cell_size_[i] = lookup_dim_[i] / dim_space[i];
+        }
+    }
+
+    const int total_cells = lookup_dim_.prod();
+    std::vector<std::vector<int>> cell_tetrahedra(total_cells);
+    for (int t = 0; t < static_cast<int>(tetrahedra_.size()); t++) {
+        Eigen::AlignedBox3d tetrahedron_bounds;
+        for (int vertex : tetrahedra_[t]) {
+            tetrahedron_bounds.extend(vertices_[vertex]);
+        }
+        Eigen::Vector3i min_cell = getLookupCellIndex(tetrahedron_bounds.min());
+        Eigen::Vector3i max_cell = getLookupCellIndex(tetrahedron_bounds.max());
+        for (int k = min_cell[2]; k <= max_cell[2]; k++) {
+            for (int j = min_cell[1]; j <= max_cell[1]; j++) {
+                for (int i = min_cell[0]; i <= max_cell[0]; i++) {
+                    cell_tetrahedra[i + j * lookup_dim_[0] + k * lookup_dim_[0] * lookup_dim_[1]].push_back(t);
+                }
+            }
+        }
+    }
+
+    lookup_cell_offsets_.assign(1, 0);
+    const Eigen::Vector3d cell_size_vector = dim_space.cwiseQuotient(lookup_dim_.cast<double>());
+    for (int cell = 0; cell < total_cells; cell++) {
+        std::vector<int>& tetrahedra = cell_tetrahedra[cell];
+        if (!tetrahedra.empty()) {
+            Eigen::Vector3i cell_index(cell % lookup_dim_[0], (cell / lookup_dim_[0]) % lookup_dim_[1], cell / (lookup_dim_[0] * lookup_dim_[1]));
+            Eigen::Vector3d cell_center = bounds_.min() + (cell_index.cast<double>().array() + 0.5).matrix().cwiseProduct(cell_size_vector);
+            auto centroid_distance = [&](int t) {
+                Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+                for (int vertex : tetrahedra_[t]) {
+                    centroid += vertices_[vertex] / 4.0;
+                }
+                return (centroid - cell_center).squaredNorm();
+            };
+            auto nearest = std::min_element(tetrahedra.begin(), tetrahedra.end(), [&](int a, int b) {
+                return centroid_distance(a) < centroid_distance(b);
+            });
+            std::iter_swap(tetrahedra.begin(), nearest);
+        }
+        lookup_cell_tetrahedra_.insert(lookup_cell_tetrahedra_.end(), tetrahedra.begin(), tetrahedra.end());
+        lookup_cell_offsets_.push_back(static_cast<int>(lookup_cell_tetrahedra_.size()));
+        std::vector<int>().swap(tetrahedra); // releases the cell, so the lists are not held twice
+    }
+}
+
+int TetrahedralMesh::getFaceOutside(int tetrahedron, const Eigen::Vector3d& position) const {
+    const std::array<int, 4>& vertices = tetrahedra_[tetrahedron];
+    int face = -1;
+    double max_offset = 0.0;
+    for (int f = 0; f < 4; f++) {
+        const Eigen::Vector3d& a = vertices_[vertices[FACE_VERTICES[f][0]]];
+        Eigen::Vector3d normal = (vertices_[vertices[FACE_VERTICES[f][1]]] - a).cross(vertices_[vertices[FACE_VERTICES[f][2]]] - a);
+        // the offset is six times the volume of the tetrahedron times the barycentric coordinate of vertex f, negated.
+        // Positions within EPSILON of the face are on it, which is compared squared to avoid normalizing the normal
+        double offset = normal.dot(position - a);
+        if (offset > max_offset && offset * offset > EPSILON * EPSILON * normal.squaredNorm()) {
+            max_offset = offset;
+            face = f;
+        }
+    }
+    return face;
+}
+
+Eigen::Vector3i TetrahedralMesh::getLookupCellIndex(const Eigen::Vector3d& position) const {
+    // clamped before the cast, so positions on the far faces of the bounding box map to the last cell
+    Eigen::Vector3d cell = (position - bounds_.min()).cwiseProduct(lookup_inv_cell_size_).cwiseMax(0.0).cwiseMin((lookup_dim_ - Eigen::Vector3i::Ones()).cast<double>());
+    return cell.cast<int>();
+}
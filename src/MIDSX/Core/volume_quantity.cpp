@@ -20,7 +20,9 @@ std::string CountVolumeQuantityHelper::toString(CountVolumeQuantityType type) {
     return countTypeToString[type];
 }
 
-VectorVolumeQuantity::VectorVolumeQuantity(VectorVolumeQuantityType type) {
+VectorVolumeQuantity::VectorVolumeQuantity(VectorVolumeQuantityType type, bool retain_values)
+        : primary_values_(retain_values), single_incoherent_scatter_values_(retain_values),
+          single_coherent_scatter_values_(retain_values), multiple_scatter_values_(retain_values) {
     type_ = type;
     if (type == VectorVolumeQuantityType::EnergyDeposition) {
         valueExtractor_ = [](const TempVolumeTallyData& temp_volume_tally_data) {
@@ -72,10 +74,9 @@ VectorVolumeQuantityType VectorVolumeQuantity::getType() const {
 
 VectorValue& VectorVolumeQuantity::getTotalValues() {
     if (!totaled_) {
-        total_values_.addValues(primary_values_.getVector());
-        total_values_.addValues(single_incoherent_scatter_values_.getVector());
-        total_values_.addValues(single_coherent_scatter_values_.getVector());
-        total_values_.addValues(multiple_scatter_values_.getVector());
+        // merges the moments of the categories rather than their values, which are only kept in the total if retained
+        total_values_ = primary_values_ + single_incoherent_scatter_values_ + single_coherent_scatter_values_ +
+                        multiple_scatter_values_;
         totaled_ = true;
     }
     return total_values_;
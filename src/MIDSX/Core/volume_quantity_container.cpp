@@ -74,10 +74,10 @@ double VolumeQuantityContainer::getVolume() const {
     return volume_;
 }
 
-VolumeQuantityContainer VolumeQuantityContainerFactory::AllQuantities() {
+VolumeQuantityContainer VolumeQuantityContainerFactory::AllQuantities(bool retain_values) {
     auto container = VolumeQuantityContainer();
-    container.addVectorQuantity(VectorVolumeQuantity(VectorVolumeQuantityType::EnergyDeposition));
-    container.addVectorQuantity(VectorVolumeQuantity(VectorVolumeQuantityType::IncidentEnergy));
+    container.addVectorQuantity(VectorVolumeQuantity(VectorVolumeQuantityType::EnergyDeposition, retain_values));
+    container.addVectorQuantity(VectorVolumeQuantity(VectorVolumeQuantityType::IncidentEnergy, retain_values));
     container.addCountQuantity(CountVolumeQuantity(CountVolumeQuantityType::NumberOfPhotons));
     container.addCountQuantity(CountVolumeQuantity(CountVolumeQuantityType::NumberOfInteractions));
 
@@ -0,0 +1,179 @@
+#include "Core/voxel_file.h"
+#include "Core/nifti_reader.h"
+#include "Core/table_cache.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    const char MAGIC[8] = {'M', 'I', 'D', 'S', 'X', 'V', 'O', 'X'};
+    // bump whenever the layout of the header changes
+    const uint32_t FORMAT_VERSION = 1;
+
+    // layout of the header. The rest of the header up to the voxels is zero
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t num_materials;
+        int32_t dim_vox[3];
+        uint32_t reserved;
+        double spacing[3]; // in cm
+        uint64_t data_offset;
+        uint64_t data_size;
+        uint64_t checksum; // FNV-1a hash of the voxels
+        uint8_t material_ids[256];
+    };
+    static_assert(sizeof(Header) <= VoxelFile::DATA_OFFSET, "The header of a voxel file must fit before the voxels");
+}
+
+VoxelFile::VoxelFile(std::string filename) : filename_(std::move(filename)) {
+    int fd = open(filename_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open voxel file " + filename_);
+    }
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || static_cast<uint64_t>(file_stat.st_size) < DATA_OFFSET) {
+        close(fd);
+        throw std::runtime_error(filename_ + " is not a voxel file");
+    }
+    mapping_size_ = file_stat.st_size;
+    // shared, so the page cache backs the mapping and concurrent processes share the pages
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw std::runtime_error("Can't map voxel file " + filename_);
+    }
+    try {
+        readHeader();
+#ifndef NDEBUG
+        verify();
+#endif
+    } catch (...) {
+        munmap(mapping_, mapping_size_);
+        throw;
+    }
+}
+
+VoxelFile::~VoxelFile() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+}
+
+void VoxelFile::write(const std::string& filename, const Eigen::Vector3i& dim_vox, const Eigen::Vector3d& spacing,
+                      const uint8_t* materials) {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.data_offset = DATA_OFFSET;
+    header.data_size = static_cast<uint64_t>(dim_vox[0]) * dim_vox[1] * dim_vox[2];
+    header.checksum = TableCache::hashBytes(materials, header.data_size);
+    bool is_present[256] = {};
+    for (uint64_t i = 0; i < header.data_size; i++) {
+        is_present[materials[i]] = true;
+    }
+    for (int i = 0; i < 256; i++) {
+        if (is_present[i]) {
+            header.material_ids[header.num_materials++] = static_cast<uint8_t>(i);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        header.dim_vox[i] = dim_vox[i];
+        header.spacing[i] = spacing[i];
+    }
+
+    std::vector<char> header_bytes(DATA_OFFSET, '\0');
+    std::memcpy(header_bytes.data(), &header, sizeof(Header));
+    std::stringstream temp_filename;
+    temp_filename << filename << ".tmp" << getpid() << "_" << std::hash<std::thread::id>{}(std::this_thread::get_id()) << "_"
+                  << std::chrono::steady_clock::now().time_since_epoch().count();
+    std::error_code error;
+    {
+        std::ofstream file(temp_filename.str(), std::ios::binary);
+        if (!file.write(header_bytes.data(), static_cast<std::streamsize>(header_bytes.size())) ||
+            !file.write(reinterpret_cast<const char*>(materials), static_cast<std::streamsize>(header.data_size))) {
+            file.close();
+            std::filesystem::remove(temp_filename.str(), error);
+            throw std::runtime_error("Can't write voxel file " + filename);
+        }
+    }
+    std::filesystem::rename(temp_filename.str(), filename, error);
+    if (error) {
+        std::filesystem::remove(temp_filename.str(), error);
+        throw std::runtime_error("Can't write voxel file " + filename);
+    }
+}
+
+void VoxelFile::convertNIfTI(const std::string& nifti_filename, const std::string& filename) {
+    NIfTIReader reader(nifti_filename);
+    std::vector<uint8_t> materials(reader.getNumOfVoxels());
+    reader.readLabels(materials.data());
+    write(filename, reader.getDimVox(), reader.getZooms() * reader.getUnits(), materials.data());
+}
+
+bool VoxelFile::isVoxelFile(const std::string& filename) {
+    return std::filesystem::path(filename).extension() == ".mvox";
+}
+
+void VoxelFile::readHeader() {
+    Header header{};
+    std::memcpy(&header, mapping_, sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(filename_ + " is not a voxel file");
+    }
+    if (header.version != FORMAT_VERSION) {
+        throw std::runtime_error("Voxel file " + filename_ + " has format version " + std::to_string(header.version) +
+                                 " (expected " + std::to_string(FORMAT_VERSION) + "). It may have been written on a machine of a different byte order");
+    }
+    for (int i = 0; i < 3; i++) {
+        dim_vox_[i] = header.dim_vox[i];
+        spacing_[i] = header.spacing[i];
+        if (dim_vox_[i] <= 0 || !(spacing_[i] > 0)) {
+            throw std::runtime_error("Voxel file " + filename_ + " has invalid dimensions");
+        }
+    }
+    uint64_t num_voxels = static_cast<uint64_t>(dim_vox_[0]) * dim_vox_[1] * dim_vox_[2];
+    if (header.data_offset != DATA_OFFSET || header.data_size != num_voxels ||
+        mapping_size_ < header.data_offset + header.data_size || header.num_materials > 256) {
+        throw std::runtime_error("Voxel file " + filename_ + " is truncated or corrupt");
+    }
+    material_ids_.assign(header.material_ids, header.material_ids + header.num_materials);
+    if (material_ids_.empty() || !std::is_sorted(material_ids_.begin(), material_ids_.end(), std::less_equal<>())) {
+        throw std::runtime_error("Voxel file " + filename_ + " has invalid material IDs");
+    }
+    materials_ = static_cast<const uint8_t*>(mapping_) + header.data_offset;
+    num_voxels_ = num_voxels;
+    checksum_ = header.checksum;
+}
+
+void VoxelFile::verify() const {
+    if (TableCache::hashBytes(materials_, num_voxels_) != checksum_) {
+        throw std::runtime_error("Voxel file " + filename_ + " is corrupt: the checksum of its voxels does not match its header");
+    }
+    // a voxel whose ID is not in the header would otherwise be looked up as whichever material has index 0
+    bool is_listed[256] = {};
+    for (int material_id : material_ids_) {
+        is_listed[material_id] = true;
+    }
+    bool is_present[256] = {};
+    for (uint64_t i = 0; i < num_voxels_; i++) {
+        is_present[materials_[i]] = true;
+    }
+    for (int i = 0; i < 256; i++) {
+        if (is_present[i] && !is_listed[i]) {
+            throw std::runtime_error("Voxel file " + filename_ + " has voxels of material ID " + std::to_string(i) +
+                                     ", which is not in its header");
+        }
+    }
+}
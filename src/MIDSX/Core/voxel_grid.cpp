@@ -1,51 +1,78 @@
 #include "Core/voxel_grid.h"
 
-template <typename T, std::size_t N>
-Eigen::Vector<T, N> VoxelGridHelpers::pyTupleToEigenVector(const py::tuple &tuple) {
-    Eigen::Vector<T, N> vector;
-    for (std::size_t i = 0; i < N; i++) {
-        vector[i] = tuple[i].cast<T>();
-    }
-    return vector;
-}
-
-double VoxelGridHelpers::covertUnitNameToCm(const std::string& unitName) {
-    std::unordered_map<std::string, double> unitMap = {
-            {"nm", 1e-7},
-            {"um", 1e-4},
-            {"mm", 0.1},
-            {"cm", 1.0},
-            {"m", 100.0},
-            {"km", 1e5},
-    }; // converts to cm
-    return unitMap[unitName];
-}
-
-int VoxelGridHelpers::dimensionStringToIndex(const std::string& dimension) {
-    std::unordered_map<std::string, int> dimensionMap = {
-            {"x", 0},
-            {"y", 1},
-            {"z", 2},
-    };
-    return dimensionMap[dimension];
-}
-
-
 VoxelGrid::VoxelGrid(std::string  nii_filename,
-                     bool is_python_environment):
+                     std::string density_filename,
+                     VoxelLayout layout):
                      filename_(std::move(nii_filename)),
-                        is_python_environment_(is_python_environment) {
+                        density_filename_(std::move(density_filename)) {
     initializeVoxels();
+    // the files are read in linear order, so they are reordered once every array is read
+    setLayout(layout);
 };
 // initialize voxels to default values
 
 // get voxel value at (i, j, k)
-Voxel& VoxelGrid::getVoxel(const Eigen::Vector3i& voxel_index) {
-    return voxels_.at(voxelNumber(voxel_index));
+Voxel VoxelGrid::getVoxel(const Eigen::Vector3i& voxel_index) {
+    if ((voxel_index.array() < 0).any() || (voxel_index.array() >= dim_vox_.array()).any()) {
+        throw std::out_of_range("VoxelGrid::getVoxel: voxel index out of range");
+    }
+    return getVoxelAtIndex(voxel_index);
 }
 
-void VoxelGrid::setVoxel(const Eigen::Vector3i& voxel_index, Voxel &value) {
-    voxels_.at(voxelNumber(voxel_index)) = value;
+int VoxelGrid::getVoxelNumber(const Eigen::Vector3i& voxel_index) const {
+    if ((voxel_index.array() < 0).any() || (voxel_index.array() >= dim_vox_.array()).any()) {
+        throw std::out_of_range("VoxelGrid::getVoxelNumber: voxel index out of range");
+    }
+    return voxelNumber(voxel_index);
+}
+
+double VoxelGrid::getHomogeneousDistance(const Eigen::Vector3d& position, const Eigen::Vector3d& direction, Voxel& voxel) {
+    if (resolution_level_ > 0) {
+        // a downsampled voxel has one material and density, so it is a homogeneous region even within a mixed block
+        Eigen::Vector3i downsampled_index;
+        voxel = getDownsampledVoxel(position, downsampled_index);
+        Eigen::Vector3i min_index = downsampled_index;
+        Eigen::Vector3i max_index = downsampled_index + Eigen::Vector3i::Ones();
+        VoxelOctreeNode node = resolution_levels_[resolution_level_ - 1].octree->getNode(downsampled_index);
+        if (node.is_homogeneous) {
+            min_index = node.min_index;
+            max_index = node.max_index;
+        }
+        const Eigen::Vector3d downsampled_spacing = spacing_ * (1 << resolution_level_);
+        double distance = std::numeric_limits<double>::infinity();
+        for (int i = 0; i < 3; i++) {
+            // the blocks at the upper faces are clipped to the voxel grid
+            if (direction[i] > 0) {
+                double max_face = std::min(max_index[i] * downsampled_spacing[i], dim_space_[i]);
+                distance = std::min(distance, (max_face - position[i]) / direction[i]);
+            }
+            else if (direction[i] < 0) {
+                distance = std::min(distance, (min_index[i] * downsampled_spacing[i] - position[i]) / direction[i]);
+            }
+        }
+        return std::max(distance, 0.0);
+    }
+    Eigen::Vector3i voxel_index = getVoxelIndexUnchecked(position);
+    if (!octree_) {
+        voxel = getVoxelAtIndex(voxel_index);
+        return 0.0;
+    }
+    VoxelOctreeNode node = octree_->getNode(voxel_index);
+    voxel = makeVoxel(voxelNumber(voxel_index), node.material_id);
+    if (!node.is_homogeneous) {
+        return 0.0;
+    }
+    // distance to the nearest of the exit planes of the node along each axis
+    double distance = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < 3; i++) {
+        if (direction[i] > 0) {
+            distance = std::min(distance, (node.max_index[i] * spacing_[i] - position[i]) / direction[i]);
+        }
+        else if (direction[i] < 0) {
+            distance = std::min(distance, (node.min_index[i] * spacing_[i] - position[i]) / direction[i]);
+        }
+    }
+    return std::max(distance, 0.0);
 }
 
 Eigen::Vector3d VoxelGrid::getVoxelPosition(const Eigen::Vector3i& voxel_index) {
@@ -59,46 +86,101 @@ Eigen::Vector3i VoxelGrid::getVoxelIndex(const Eigen::Vector3d& position) const
 }
 
 std::vector<std::string> VoxelGrid::getMaterialNames() const {
-    InteractionData interaction_data({});
-    std::unordered_set<uint8_t> material_ids_set;
-#pragma omp parallel default(none) shared(material_ids_set, interaction_data)
-    {
-        // use unordered_set to avoid duplicates
-        std::unordered_set<uint8_t> material_ids_set_private;
-#pragma omp for
-        for (auto &voxel: voxels_) {
-            material_ids_set_private.insert(voxel.materialID);
+    std::vector<std::string> material_names;
+    for (int material_id: material_ids_) {
+        material_names.push_back(ElementDatabase::getInstance().getMaterialName(material_id));
+    }
+    return material_names;
+}
+
+void VoxelGrid::remapMaterialIds(const std::vector<int>& material_ids) {
+    // only the lookup table changes, as the material array may be a read-only mapping
+    for (int material_id : material_ids_) {
+        auto it = std::find(material_ids.begin(), material_ids.end(), material_id);
+        if (it == material_ids.end()) {
+            throw std::runtime_error("Material ID " + std::to_string(material_id) + " of " + filename_ + " is not in the material list");
         }
-#pragma omp critical
-        {
-            material_ids_set.insert(material_ids_set_private.begin(), material_ids_set_private.end());
+        material_indices_[material_id] = static_cast<uint8_t>(it - material_ids.begin());
+    }
+}
+
+std::unordered_map<int, double> VoxelGrid::getMaxDensityScales() const {
+    std::unordered_map<int, double> max_density_scales;
+    if (density_scales_.empty()) {
+        for (int material_id : material_ids_) {
+            max_density_scales[material_id] = 1.0;
         }
+        return max_density_scales;
+    }
+    forEachVoxel([&](int voxel_number, uint8_t material_id) {
+        double& max_density_scale = max_density_scales[material_id]; // 0 if not yet present
+        max_density_scale = std::max(max_density_scale, static_cast<double>(density_scales_[voxel_number]));
+    });
+    return max_density_scales;
+}
 
+void VoxelGrid::enableOctree() {
+    if (octree_) {
+        return;
     }
-    std::vector<std::string> material_names;
-    for (auto &material_id: material_ids_set) {
-        material_names.push_back(interaction_data.getAnyMaterialNameFromId(material_id));
+    if (layout_ == VoxelLayout::BRICKED) {
+        // the octree is built from the arrays in linear order
+        std::vector<uint8_t> materials = toLinear(materials_.get());
+        std::vector<float> density_scales = density_scales_.empty() ? std::vector<float>() : toLinear(density_scales_.data());
+        octree_ = std::make_shared<const VoxelOctree>(dim_vox_, materials.data(), density_scales.empty() ? nullptr : density_scales.data());
     }
-    return material_names;
+    else {
+        octree_ = std::make_shared<const VoxelOctree>(dim_vox_, materials_.get(), density_scales_.empty() ? nullptr : density_scales_.data());
+    }
+    materials_.reset();
+}
+
+void VoxelGrid::setResolutionLevel(int level) {
+    if (level < 0 || level >= NUM_RESOLUTION_LEVELS) {
+        throw std::out_of_range("VoxelGrid::setResolutionLevel: resolution level out of range");
+    }
+    if (resolution_levels_.empty()) {
+        resolution_levels_.resize(NUM_RESOLUTION_LEVELS - 1);
+    }
+    if (level > 0 && !resolution_levels_[level - 1].octree) {
+        setResolutionLevelData(level);
+    }
+    resolution_level_ = level;
+}
+
+Eigen::Vector3i VoxelGrid::getDimVox(int level) const {
+    if (level < 0 || level >= NUM_RESOLUTION_LEVELS) {
+        throw std::out_of_range("VoxelGrid::getDimVox: resolution level out of range");
+    }
+    return (dim_vox_.array() + (1 << level) - 1) / (1 << level);
 }
 
+void VoxelGrid::enableDoseScoring() {
+    if (!isDoseScored()) {
+        dose_grid_ = DoseGrid(numOfStoredVoxels_);
+    }
+}
 
-double VoxelGrid::getTotalEnergyDeposited() {
+double VoxelGrid::getTotalEnergyDeposited() const {
     double totalDose = 0.0;
-    for (auto& voxel : voxels_) {
-        totalDose += voxel.dose.getSum();
+    for (auto& energy_deposited : getEnergyDepositedInMaterials()) {
+        totalDose += energy_deposited.second.getSum();
     }
     return totalDose;
 }
 
-std::unordered_map<int, VectorValue> VoxelGrid::getEnergyDepositedInMaterials() {
-    std::unordered_map<int, VectorValue> energyDepositedInMaterials;
-
-    for (auto& voxel : voxels_) {
-        int materialID = voxel.materialID;
-        std::vector<double>& voxel_dose = voxel.dose.getVector();
-        energyDepositedInMaterials[materialID].addValues(voxel_dose);
+std::unordered_map<int, MomentValue> VoxelGrid::getEnergyDepositedInMaterials() const {
+    if (!isDoseScored()) {
+        throw std::runtime_error("The dose of " + filename_ + " is not scored");
     }
+    std::unordered_map<int, MomentValue> energyDepositedInMaterials;
+    for (int material_id : material_ids_) {
+        energyDepositedInMaterials[material_id]; // every material is reported, including those without deposits
+    }
+
+    forEachVoxel([&](int voxel_number, uint8_t material_id) {
+        dose_grid_.addTo(voxel_number, energyDepositedInMaterials[material_id]);
+    });
 
     return energyDepositedInMaterials;
 }
@@ -107,17 +189,24 @@ std::unordered_map<int, VectorValue> VoxelGrid::getEnergyDepositedInMaterials()
 
 
 void VoxelGrid::initializeVoxels() {
-    py::module   nibabel = py::module::import("nibabel");
-    py::object img = nibabel.attr("load")(filename_); // load the nifti file into img
-    py::object data = img.attr("get_fdata")(); // get the data from img
-    py::object header = img.attr("header");
-    auto numpy_array = getNumPyArrayFromImg(img);
-    setVoxelProperties(numpy_array, header);
-    setVoxelMaterialIDs(numpy_array);
-}
-
-int VoxelGrid::voxelNumber(const Eigen::Vector3i& voxel_index) const {
-    return voxel_index[0] + voxel_index[1]*dim_vox_[0] + voxel_index[2]*dim_vox_[0]*dim_vox_[1];
+    if (VoxelFile::isVoxelFile(filename_)) {
+        auto voxel_file = std::make_shared<const VoxelFile>(filename_);
+        setVoxelProperties(*voxel_file);
+        setVoxelMaterialIDs(voxel_file);
+    }
+    else {
+        NIfTIReader reader(filename_);
+        setVoxelProperties(reader);
+        setVoxelMaterialIDs(reader);
+    }
+    // until the voxel grid is added to a computational domain, the material index is the position in material_ids_
+    for (size_t i = 0; i < material_ids_.size(); i++) {
+        material_indices_[material_ids_[i]] = static_cast<uint8_t>(i);
+    }
+    if (!density_filename_.empty()) {
+        NIfTIReader density_reader(density_filename_);
+        setVoxelDensityScales(density_reader);
+    }
 }
 
 bool VoxelGrid::withinGrid(const Eigen::Vector3d& position) const {
@@ -134,49 +223,209 @@ void VoxelGrid::handleOutOfBounds(const Eigen::Vector3d& position) const {
     }
 }
 
-void VoxelGrid::setVoxelProperties(const py::array_t<uint8_t> &array, const py::object &header) {
-    setDimVox(array);
-    setUnits(header);
+void VoxelGrid::setVoxelProperties(const NIfTIReader& reader) {
+    setDimVox(reader);
+    setUnits(reader);
     setNumOfVoxels();
-    setSpacing(header);
+    setSpacing(reader);
     setDimSpace();
 }
 
-py::array_t<uint8_t> VoxelGrid::getNumPyArrayFromImg(const py::object &img) {
-    py::object data = img.attr("get_fdata")(); // get the data from img
-    return py::cast<py::array_t<uint8_t>>(data);
+void VoxelGrid::setVoxelProperties(const VoxelFile& voxel_file) {
+    dim_vox_ = voxel_file.getDimVox();
+    units_ = 1.0; // voxel files store the spacing in cm
+    setNumOfVoxels();
+    spacing_ = voxel_file.getSpacing();
+    setDimSpace();
 }
 
-void VoxelGrid::setDimVox(const py::array_t<uint8_t>& array) {
-    py::tuple shape = array.attr("shape");
-    dim_vox_ = VoxelGridHelpers::pyTupleToEigenVector<int, 3>(shape);
+void VoxelGrid::setDimVox(const NIfTIReader& reader) {
+    dim_vox_ = reader.getDimVox();
 }
 
-void VoxelGrid::setUnits(const py::object &header) {
-    py::object units = header.attr("get_xyzt_units")();
-    py::tuple unitTuple = py::cast<py::tuple>(units);
-    std::string unitName = py::cast<std::string>(unitTuple[0]);
-    units_ = VoxelGridHelpers::covertUnitNameToCm(unitName);
+void VoxelGrid::setUnits(const NIfTIReader& reader) {
+    units_ = reader.getUnits();
 }
 
-void VoxelGrid::setSpacing(const py::object& header) {
-    py::tuple zooms = header.attr("get_zooms")();
-    spacing_ = VoxelGridHelpers::pyTupleToEigenVector<double, 3>(zooms) * units_;
+void VoxelGrid::setSpacing(const NIfTIReader& reader) {
+    spacing_ = reader.getZooms() * units_;
 }
 
 void VoxelGrid::setNumOfVoxels() {
     numOfVoxels_ = dim_vox_[0]*dim_vox_[1]*dim_vox_[2];
+    numOfStoredVoxels_ = numOfVoxels_;
 }
 
 void VoxelGrid::setDimSpace() {
     dim_space_ = dim_vox_.cast<double>().cwiseProduct(spacing_);
+    inv_spacing_ = spacing_.cwiseInverse();
 }
 
-void VoxelGrid::setVoxelMaterialIDs(const py::array_t<uint8_t> &array) {
-    uint8_t* data_ptr = (uint8_t *) array.request().ptr;
+void VoxelGrid::setVoxelMaterialIDs(NIfTIReader& reader) {
+    auto materials = std::make_shared<std::vector<uint8_t>>(numOfVoxels_);
+    reader.readLabels(materials->data());
+    bool is_present[256] = {};
+    for (uint8_t material_id : *materials) {
+        is_present[material_id] = true;
+    }
+    for (int i = 0; i < 256; i++) {
+        if (is_present[i]) {
+            material_ids_.push_back(i);
+        }
+    }
+    materials_ = std::shared_ptr<const uint8_t>(materials, materials->data());
+}
+
+void VoxelGrid::setVoxelMaterialIDs(const std::shared_ptr<const VoxelFile>& voxel_file) {
+    material_ids_ = voxel_file->getMaterialIds();
+    // the voxels are used in place, and the mapping lives as long as the voxel grid and its copies
+    materials_ = std::shared_ptr<const uint8_t>(voxel_file, voxel_file->getMaterials());
+}
+
+void VoxelGrid::setVoxelDensityScales(NIfTIReader& reader) {
+    if (reader.getDimVox() != dim_vox_) {
+        throw std::runtime_error("Density file " + density_filename_ + " does not match the dimensions of " + filename_);
+    }
+    std::vector<double> densities(numOfVoxels_);
+    reader.readValues(densities.data());
+    // scale factors relative to the nominal density of each material, so the mass cross sections of one material serve any density
+    std::array<double, 256> nominal_densities{};
+    for (int material_id : material_ids_) {
+        nominal_densities[material_id] = ElementDatabase::getInstance().getMaterialDensity(material_id);
+        if (!(nominal_densities[material_id] > 0)) {
+            throw std::runtime_error("Material " + std::to_string(material_id) + " of " + filename_ +
+                                     " has no positive nominal density to scale the densities of " + density_filename_ + " by");
+        }
+    }
+    const uint8_t* materials = materials_.get();
+    density_scales_.resize(numOfVoxels_);
     for (int i = 0; i < numOfVoxels_; i++) {
-        Voxel voxel;
-        voxel.materialID = data_ptr[i];
-        voxels_.push_back(voxel);
+        // also rejects NaN
+        if (!(densities[i] >= 0)) {
+            throw std::runtime_error("Density file " + density_filename_ + " has an invalid density (" +
+                                     std::to_string(densities[i]) + ") at voxel " + std::to_string(i));
+        }
+        density_scales_[i] = static_cast<float>(densities[i] / nominal_densities[materials[i]]);
+    }
+}
+
+void VoxelGrid::setResolutionLevelData(int level_number) {
+    const int factor = 1 << level_number;
+    ResolutionLevel& level = resolution_levels_[level_number - 1];
+    level.dim_vox = getDimVox(level_number);
+    level.inv_spacing = inv_spacing_ / factor;
+    level.materials.resize(level.dim_vox.prod());
+    const bool wide_block_offsets = factor * factor * factor > 256;
+    if (wide_block_offsets) {
+        level.wide_block_offsets.resize(level.dim_vox.prod());
+    }
+    else {
+        level.block_offsets.resize(level.dim_vox.prod());
+    }
+    if (!density_scales_.empty()) {
+        level.density_scales.resize(level.dim_vox.prod());
+    }
+
+    // voted from the full resolution rather than the level before, as a majority of majorities need not be the
+    // majority of the block. The voxels are read through the layout and octree, whichever the voxel grid has
+    std::array<int, 256> counts{};
+    std::array<double, 256> density_scale_sums{};
+    std::array<int, 256> first_block_offsets{};
+    std::vector<uint8_t> block_materials; // materials counted in the block, so only they are reset
+    int downsampled_number = 0;
+    for (int kc = 0; kc < level.dim_vox[2]; kc++) {
+        for (int jc = 0; jc < level.dim_vox[1]; jc++) {
+            for (int ic = 0; ic < level.dim_vox[0]; ic++, downsampled_number++) {
+                const Eigen::Vector3i min_index = Eigen::Vector3i(ic, jc, kc) * factor;
+                const Eigen::Vector3i max_index = (min_index.array() + factor).min(dim_vox_.array());
+                for (int k = min_index[2]; k < max_index[2]; k++) {
+                    for (int j = min_index[1]; j < max_index[1]; j++) {
+                        for (int i = min_index[0]; i < max_index[0]; i++) {
+                            Eigen::Vector3i voxel_index(i, j, k);
+                            const int voxel_number = voxelNumber(voxel_index);
+                            uint8_t material_id = getMaterialIdAt(voxel_index, voxel_number);
+                            if (counts[material_id]++ == 0) {
+                                block_materials.push_back(material_id);
+                                first_block_offsets[material_id] = (i - min_index[0]) + ((j - min_index[1]) << level_number) +
+                                                                   ((k - min_index[2]) << (2 * level_number));
+                            }
+                            if (!density_scales_.empty()) {
+                                density_scale_sums[material_id] += density_scales_[voxel_number];
+                            }
+                        }
+                    }
+                }
+                // ties go to the lowest material ID, so the vote does not depend on the order of the voxels
+                uint8_t majority_material_id = block_materials[0];
+                for (uint8_t material_id : block_materials) {
+                    if (counts[material_id] > counts[majority_material_id] ||
+                        (counts[material_id] == counts[majority_material_id] && material_id < majority_material_id)) {
+                        majority_material_id = material_id;
+                    }
+                }
+                level.materials[downsampled_number] = majority_material_id;
+                if (wide_block_offsets) {
+                    level.wide_block_offsets[downsampled_number] = static_cast<uint16_t>(first_block_offsets[majority_material_id]);
+                }
+                else {
+                    level.block_offsets[downsampled_number] = static_cast<uint8_t>(first_block_offsets[majority_material_id]);
+                }
+                if (!density_scales_.empty()) {
+                    level.density_scales[downsampled_number] = static_cast<float>(
+                            density_scale_sums[majority_material_id] / counts[majority_material_id]);
+                }
+                for (uint8_t material_id : block_materials) {
+                    counts[material_id] = 0;
+                    density_scale_sums[material_id] = 0.0;
+                }
+                block_materials.clear();
+            }
+        }
+    }
+    level.octree = std::make_shared<const VoxelOctree>(level.dim_vox, level.materials.data(),
+                                                       level.density_scales.empty() ? nullptr : level.density_scales.data());
+}
+
+void VoxelGrid::setLayout(VoxelLayout layout) {
+    if (layout == VoxelLayout::LINEAR) {
+        return;
+    }
+    dim_bricks_ = (dim_vox_.array() + BRICK_SIZE - 1) / BRICK_SIZE;
+    // rank of each brick in Morton order of the brick indices, so that the bricks are stored without gaps for grids
+    // whose dimensions in bricks are not equal powers of two
+    auto morton_code = [](const Eigen::Vector3i& brick_index) {
+        uint64_t code = 0;
+        for (int bit = 0; bit < 21; bit++) {
+            for (int i = 0; i < 3; i++) {
+                code |= static_cast<uint64_t>((brick_index[i] >> bit) & 1) << (3 * bit + i);
+            }
+        }
+        return code;
+    };
+    std::vector<std::pair<uint64_t, int>> bricks;
+    bricks.reserve(dim_bricks_.prod());
+    for (int k = 0; k < dim_bricks_[2]; k++) {
+        for (int j = 0; j < dim_bricks_[1]; j++) {
+            for (int i = 0; i < dim_bricks_[0]; i++) {
+                bricks.emplace_back(morton_code(Eigen::Vector3i(i, j, k)), static_cast<int>(bricks.size()));
+            }
+        }
+    }
+    std::sort(bricks.begin(), bricks.end());
+    if (bricks.size() * BRICK_VOXELS > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        throw std::runtime_error("Voxel grid " + filename_ + " is too large for the bricked layout");
+    }
+    brick_offsets_.resize(bricks.size());
+    for (size_t rank = 0; rank < bricks.size(); rank++) {
+        brick_offsets_[bricks[rank].second] = static_cast<int>(rank) * BRICK_VOXELS;
     }
-}
\ No newline at end of file
+    numOfStoredVoxels_ = static_cast<int>(bricks.size()) * BRICK_VOXELS;
+    layout_ = VoxelLayout::BRICKED;
+
+    // the padding voxels of the bricks at the upper faces are never looked up
+    auto materials = std::make_shared<std::vector<uint8_t>>(toLayout(materials_.get(), static_cast<uint8_t>(0)));
+    materials_ = std::shared_ptr<const uint8_t>(materials, materials->data());
+    if (!density_scales_.empty()) {
+        density_scales_ = toLayout(density_scales_.data(), 1.0f);
+    }
+}
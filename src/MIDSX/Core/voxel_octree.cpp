@@ -0,0 +1,118 @@
+#include "Core/voxel_octree.h"
+#include <algorithm>
+
+VoxelOctree::VoxelOctree(const Eigen::Vector3i& dim_vox, const uint8_t* materials, const float* density_scales) :
+        dim_vox_(dim_vox) {
+    // summaries of the blocks, then of each coarser level up to a single node
+    std::vector<Eigen::Vector3i> level_dims = {(dim_vox_.array() + BRICK_SIZE - 1) / BRICK_SIZE};
+    std::vector<std::vector<BlockSummary>> levels(1, std::vector<BlockSummary>(level_dims[0].prod()));
+    int voxel_number = 0;
+    for (int k = 0; k < dim_vox_[2]; k++) {
+        for (int j = 0; j < dim_vox_[1]; j++) {
+            const int row_offset = (j / BRICK_SIZE) * level_dims[0][0] + (k / BRICK_SIZE) * level_dims[0][0] * level_dims[0][1];
+            for (int i = 0; i < dim_vox_[0]; i++, voxel_number++) {
+                BlockSummary voxel;
+                voxel.state = BlockSummary::UNIFORM;
+                voxel.material_id = materials[voxel_number];
+                voxel.density_scale = density_scales ? density_scales[voxel_number] : 1.0f;
+                BlockSummary& block = levels[0][row_offset + i / BRICK_SIZE];
+                block = mergeSummaries(block, voxel);
+            }
+        }
+    }
+    while ((level_dims.back().array() > 1).any()) {
+        const Eigen::Vector3i& fine_dims = level_dims.back();
+        Eigen::Vector3i coarse_dims = (fine_dims.array() + 1) / 2;
+        std::vector<BlockSummary> coarse(coarse_dims.prod());
+        const std::vector<BlockSummary>& fine = levels.back();
+        for (int k = 0; k < fine_dims[2]; k++) {
+            for (int j = 0; j < fine_dims[1]; j++) {
+                for (int i = 0; i < fine_dims[0]; i++) {
+                    BlockSummary& parent = coarse[i / 2 + (j / 2) * coarse_dims[0] + (k / 2) * coarse_dims[0] * coarse_dims[1]];
+                    parent = mergeSummaries(parent, fine[i + j * fine_dims[0] + k * fine_dims[0] * fine_dims[1]]);
+                }
+            }
+        }
+        level_dims.push_back(coarse_dims);
+        levels.push_back(std::move(coarse));
+    }
+
+    root_size_ = BRICK_SIZE << (levels.size() - 1);
+    root_ = buildNode(levels, level_dims, static_cast<int>(levels.size()) - 1, Eigen::Vector3i::Zero(), materials);
+    nodes_.shrink_to_fit();
+    bricks_.shrink_to_fit();
+}
+
+VoxelOctreeNode VoxelOctree::getNode(const Eigen::Vector3i& voxel_index) const {
+    uint32_t node = root_;
+    int size = root_size_;
+    while ((node >> TYPE_SHIFT) == INTERIOR) {
+        size >>= 1;
+        node = nodes_[(node & INDEX_MASK) + childNumber(voxel_index, size)];
+    }
+    VoxelOctreeNode leaf;
+    leaf.min_index = voxel_index.unaryExpr([size](int index) { return index & ~(size - 1); });
+    leaf.max_index = (leaf.min_index.array() + size).min(dim_vox_.array());
+    if ((node >> TYPE_SHIFT) == HOMOGENEOUS) {
+        leaf.material_id = static_cast<uint8_t>(node);
+        leaf.is_homogeneous = true;
+    }
+    else {
+        leaf.material_id = bricks_[static_cast<size_t>(node & INDEX_MASK) * BRICK_VOXELS + brickVoxelNumber(voxel_index)];
+    }
+    return leaf;
+}
+
+VoxelOctree::BlockSummary VoxelOctree::mergeSummaries(const BlockSummary& first, const BlockSummary& second) {
+    if (first.state == BlockSummary::EMPTY) {
+        return second;
+    }
+    if (second.state == BlockSummary::EMPTY) {
+        return first;
+    }
+    BlockSummary merged = first;
+    if (first.state == BlockSummary::MIXED || second.state == BlockSummary::MIXED ||
+        first.material_id != second.material_id || first.density_scale != second.density_scale) {
+        merged.state = BlockSummary::MIXED;
+    }
+    return merged;
+}
+
+uint32_t VoxelOctree::buildNode(const std::vector<std::vector<BlockSummary>>& levels, const std::vector<Eigen::Vector3i>& level_dims,
+                                int level, const Eigen::Vector3i& block_index, const uint8_t* materials) {
+    const Eigen::Vector3i& dims = level_dims[level];
+    if ((block_index.array() >= dims.array()).any()) {
+        return HOMOGENEOUS; // outside of the voxel grid, so never looked up
+    }
+    const BlockSummary& summary = levels[level][block_index[0] + block_index[1] * dims[0] + block_index[2] * dims[0] * dims[1]];
+    if (summary.state != BlockSummary::MIXED) {
+        return (static_cast<uint32_t>(HOMOGENEOUS) << TYPE_SHIFT) | summary.material_id;
+    }
+
+    if (level == 0) {
+        // copy the voxels of the block. Voxels outside of the voxel grid are left at 0 and never looked up
+        const auto brick = static_cast<uint32_t>(bricks_.size() / BRICK_VOXELS);
+        bricks_.resize(bricks_.size() + BRICK_VOXELS, 0);
+        uint8_t* brick_materials = bricks_.data() + static_cast<size_t>(brick) * BRICK_VOXELS;
+        Eigen::Vector3i first_voxel = block_index * BRICK_SIZE;
+        Eigen::Vector3i end_voxel = (first_voxel.array() + BRICK_SIZE).min(dim_vox_.array());
+        for (int k = first_voxel[2]; k < end_voxel[2]; k++) {
+            for (int j = first_voxel[1]; j < end_voxel[1]; j++) {
+                const size_t row = first_voxel[0] + static_cast<size_t>(j) * dim_vox_[0] + static_cast<size_t>(k) * dim_vox_[0] * dim_vox_[1];
+                std::copy(materials + row, materials + row + (end_voxel[0] - first_voxel[0]),
+                          brick_materials + (j - first_voxel[1]) * BRICK_SIZE + (k - first_voxel[2]) * BRICK_SIZE * BRICK_SIZE);
+            }
+        }
+        return (static_cast<uint32_t>(BRICK) << TYPE_SHIFT) | brick;
+    }
+
+    // the children are written after the groups of their ancestors, so a group of eight is reserved before recursing
+    const auto first_child = static_cast<uint32_t>(nodes_.size());
+    nodes_.resize(nodes_.size() + 8);
+    for (int child = 0; child < 8; child++) {
+        Eigen::Vector3i child_index = 2 * block_index + Eigen::Vector3i(child & 1, (child >> 1) & 1, (child >> 2) & 1);
+        uint32_t child_node = buildNode(levels, level_dims, level - 1, child_index, materials);
+        nodes_[first_child + child] = child_node;
+    }
+    return (static_cast<uint32_t>(INTERIOR) << TYPE_SHIFT) | first_child;
+}
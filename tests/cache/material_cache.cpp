@@ -0,0 +1,81 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <sys/stat.h>
+
+// Builds materials from copies of the database through the on-disk cache, and checks that a second build is a hit
+// which gives the same cross sections, that a database with other contents is a miss even though its materials have
+// the same names, and that a corrupt entry is rebuilt and overwritten.
+
+const TestUtils::TestDirectory TEST_DIR("material_cache");
+const std::string MATERIAL_NAME = "Al";
+const std::vector<double> ENERGIES = {1.5E3, 15E3, 33.17E3, 88E3, 150E3};
+
+// a rewritten entry is written under a temporary name and renamed over the old one, so it has a new inode
+ino_t getInode(const std::string& path) {
+    struct stat file_stat{};
+    return stat(path.c_str(), &file_stat) == 0 ? file_stat.st_ino : 0;
+}
+
+// the material entries only; the tables a material builds on a miss, such as IncoherentScatteringDCS, have their own keys
+std::vector<std::string> getEntries() {
+    std::vector<std::string> entries;
+    for (const auto& entry : std::filesystem::directory_iterator(TEST_DIR.file("cache"))) {
+        if (entry.path().filename().string().rfind("Material_", 0) == 0) {
+            entries.push_back(entry.path().string());
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+}
+
+std::vector<double> getTotalCrossSections(const ElementDatabase& database) {
+    Material material(MATERIAL_NAME, database);
+    std::vector<double> cross_sections;
+    for (double energy : ENERGIES) {
+        cross_sections.push_back(material.getData().interpolateTotalCrossSection(energy));
+    }
+    return cross_sections;
+}
+
+int main() {
+    setenv("MIDSX_CACHE_DIR", TEST_DIR.file("cache").c_str(), 1);
+    std::string db_path = TEST_DIR.file("midsx.db");
+    std::filesystem::copy_file(MIDSX_DB_PATH, db_path);
+    ElementDatabase database(db_path);
+    bool passed = true;
+
+    std::cout << "Hits and misses" << std::endl;
+    std::vector<double> cross_sections = getTotalCrossSections(database);
+    std::vector<std::string> entries = getEntries();
+    passed = TestUtils::report("miss stores an entry", entries.size() == 1) && passed;
+    ino_t inode = getInode(entries.front());
+    passed = TestUtils::report("hit gives the same cross sections", getTotalCrossSections(database) == cross_sections) && passed;
+    passed = TestUtils::report("hit leaves the entry", getEntries() == entries && getInode(entries.front()) == inode) && passed;
+
+    // the user_version field of the SQLite header, which changes the contents but not the data of the database
+    std::string other_db_path = TEST_DIR.file("other_midsx.db");
+    std::filesystem::copy_file(db_path, other_db_path);
+    {
+        std::fstream file(other_db_path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(60);
+        file.put(1);
+    }
+    ElementDatabase other_database(other_db_path);
+    passed = TestUtils::report("other database misses", getTotalCrossSections(other_database) == cross_sections &&
+                               getEntries().size() == 2 && getInode(entries.front()) == inode) && passed;
+
+    std::cout << "Invalid entries" << std::endl;
+    {
+        std::fstream file(entries.front(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.put('\x7f');
+    }
+    passed = TestUtils::report("corrupt entry rebuilt and overwritten", getTotalCrossSections(database) == cross_sections &&
+                               getInode(entries.front()) != inode) && passed;
+    inode = getInode(entries.front());
+    passed = TestUtils::report("overwritten entry hits", getTotalCrossSections(database) == cross_sections &&
+                               getInode(entries.front()) == inode && getEntries().size() == 2) && passed;
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
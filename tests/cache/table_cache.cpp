@@ -0,0 +1,113 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <set>
+
+// Builds a ContinuousInversion through the on-disk cache, and checks that a second build with the same key is a hit,
+// that changing anything in the key is a miss, and that an entry which is corrupt, or which passes its checksum but
+// has guide table entries outside its tables, is rebuilt and overwritten rather than used.
+
+const TestUtils::TestDirectory TEST_DIR("table_cache");
+const double X_MIN = 0.0;
+const double X_MAX = 1.0;
+const double ERR_THRESH = 1E-4;
+
+// PDF which counts its evaluations, so a build from the cache is one which never evaluates it
+struct CountingPDF {
+    int evaluations = 0;
+    std::function<double(double, double)> pdf = [this](double x, double E) {
+        ++evaluations;
+        return 1 + x * E / 1E5 + std::sin(10 * x) / 2;
+    };
+};
+
+Eigen::VectorXd getEnergies() {
+    Eigen::VectorXd energies(3);
+    energies << 1E4, 2E4, 5E4;
+    return energies;
+}
+
+std::string getPayload(const ProbabilityDist::ContinuousInversion& dist) {
+    std::string payload;
+    dist.serialize(payload);
+    return payload;
+}
+
+ProbabilityDist::ContinuousInversion build(CountingPDF& counting_pdf, double err_thresh = ERR_THRESH) {
+    Eigen::VectorXd energies = getEnergies();
+    return ProbabilityDist::ContinuousInversion(counting_pdf.pdf, energies, X_MIN, X_MAX, err_thresh, TableCache::Key("table_cache_test"));
+}
+
+// the path of the only entry of the cache directory other than the given ones
+std::string findNewEntry(const std::set<std::string>& known) {
+    std::string found;
+    for (const auto& entry : std::filesystem::directory_iterator(TEST_DIR.file(""))) {
+        if (!known.count(entry.path().string())) {
+            found = entry.path().string();
+        }
+    }
+    return found;
+}
+
+int main() {
+    setenv("MIDSX_CACHE_DIR", TEST_DIR.file("").c_str(), 1);
+    bool passed = true;
+
+    std::cout << "Hits and misses" << std::endl;
+    CountingPDF first_pdf;
+    std::string payload = getPayload(build(first_pdf));
+    std::string entry = findNewEntry({});
+    passed = TestUtils::report("miss builds and stores the tables", first_pdf.evaluations > 0 && !entry.empty()) && passed;
+    CountingPDF hit_pdf;
+    passed = TestUtils::report("hit loads the same tables", getPayload(build(hit_pdf)) == payload && hit_pdf.evaluations == 0) && passed;
+    CountingPDF other_key_pdf;
+    build(other_key_pdf, ERR_THRESH / 2);
+    passed = TestUtils::report("changed key misses", other_key_pdf.evaluations > 0 && !findNewEntry({entry}).empty()) && passed;
+
+    std::cout << "Invalid entries" << std::endl;
+    {
+        std::fstream file(entry, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-1, std::ios::end);
+        file.put('\x7f');
+    }
+    CountingPDF corrupt_pdf;
+    passed = TestUtils::report("corrupt entry rebuilt", getPayload(build(corrupt_pdf)) == payload && corrupt_pdf.evaluations > 0) && passed;
+    CountingPDF rewritten_pdf;
+    build(rewritten_pdf);
+    passed = TestUtils::report("corrupt entry overwritten", rewritten_pdf.evaluations == 0) && passed;
+
+    // an entry with a guide table entry past the end of its table, stored with a valid checksum
+    TableCache::Reader reader(payload);
+    Eigen::VectorXd energies;
+    double x_min, x_max, err_thresh;
+    std::vector<ProbabilityDist::RITANode> table;
+    std::vector<int> table_offsets, guide_table;
+    reader.readMatrix(energies);
+    reader.read(x_min);
+    reader.read(x_max);
+    reader.read(err_thresh);
+    reader.readVector(table);
+    reader.readVector(table_offsets);
+    reader.readVector(guide_table);
+    guide_table[table_offsets[1] - 1] = static_cast<int>(table.size());
+    std::string bad_guide_payload;
+    TableCache::appendMatrix(bad_guide_payload, energies);
+    TableCache::appendValue(bad_guide_payload, x_min);
+    TableCache::appendValue(bad_guide_payload, x_max);
+    TableCache::appendValue(bad_guide_payload, err_thresh);
+    TableCache::appendVector(bad_guide_payload, table);
+    TableCache::appendVector(bad_guide_payload, table_offsets);
+    TableCache::appendVector(bad_guide_payload, guide_table);
+    ProbabilityDist::ContinuousInversion bad_guide_dist;
+    TableCache::Reader bad_guide_reader(bad_guide_payload);
+    passed = TestUtils::report("guide table entry past its table rejected", !bad_guide_dist.deserialize(bad_guide_reader)) && passed;
+
+    TableCache::Key key("table_cache_test");
+    key.add(getEnergies()).add(X_MIN).add(X_MAX).add(ERR_THRESH);
+    passed = TestUtils::report("key of the entry", std::filesystem::path(entry).filename() == key.getFileName()) && passed;
+    TableCache::store(key, bad_guide_payload);
+    CountingPDF bad_guide_pdf;
+    passed = TestUtils::report("entry with a bad guide table rebuilt", getPayload(build(bad_guide_pdf)) == payload && bad_guide_pdf.evaluations > 0) && passed;
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
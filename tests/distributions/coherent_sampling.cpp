@@ -0,0 +1,83 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <chrono>
+
+// Benchmarks sampling of the coherent scattering DCS for a few materials and energies, and compares the sampled
+// cosine histograms with the DCS (1 + mu^2)*F^2(x, Z) integrated over each bin using a chi-square test.
+
+const int N_SAMPLES = 10000000;
+const int N_BINS = 100;
+
+int muToBin(double mu) {
+    return std::min(N_BINS - 1, std::max(0, static_cast<int>((mu + 1) / 2 * N_BINS)));
+}
+
+// Probability of each bin under the DCS, using Simpson's rule within each bin
+std::vector<double> getExpectedBinProbabilities(const MaterialData& material_data, double energy) {
+    const int NUM_POINTS = 101;
+    double k = energy/ELECTRON_REST_MASS;
+    auto DCS = [&](double mu) {
+        double x = ALPHA*k*sqrt(1 - mu);
+        return (1 + mu*mu)*pow(material_data.interpolateCoherentFormFactor(x), 2);
+    };
+    std::vector<double> probabilities(N_BINS);
+    double total = 0;
+    for (int i = 0; i < N_BINS; ++i) {
+        double mu_low = -1 + 2.0 * i / N_BINS;
+        double h = 2.0 / N_BINS / (NUM_POINTS - 1);
+        double sum = 0;
+        for (int j = 0; j < NUM_POINTS; ++j) {
+            double weight = (j == 0 || j == NUM_POINTS - 1) ? 1 : (j % 2 == 0 ? 2 : 4);
+            sum += weight * DCS(mu_low + j * h);
+        }
+        probabilities[i] = h / 3 * sum;
+        total += probabilities[i];
+    }
+    for (double& probability : probabilities) {
+        probability /= total;
+    }
+    return probabilities;
+}
+
+int main() {
+    std::vector<std::string> material_names = {"Water, Liquid", "Al", "Pb"};
+    std::vector<double> energies = {20E3, 60E3, 100E3};
+
+    auto start = std::chrono::high_resolution_clock::now();
+    InteractionData interaction_data(material_names);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "InteractionData construction: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+
+    bool passed = true;
+    for (auto& material_name : material_names) {
+        int material_id = interaction_data.getAnyMaterialIdFromName(material_name);
+        auto& material_data = interaction_data.getMaterialFromId(material_id).getData();
+        for (double energy : energies) {
+            double mean_mu = 0;
+            std::vector<long> histogram(N_BINS, 0);
+            start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < N_SAMPLES; ++i) {
+                double mu = material_data.sampleCoherentScatteringDCS(energy);
+                mean_mu += mu;
+                histogram[muToBin(mu)]++;
+            }
+            end = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+            std::vector<double> expected = getExpectedBinProbabilities(material_data, energy);
+            std::vector<double> observed(histogram.begin(), histogram.end());
+            for (double& count : expected) {
+                count *= N_SAMPLES;
+            }
+            TestUtils::ChiSquareResult result = TestUtils::chiSquareTest(expected, observed);
+            passed = passed && result.passed();
+
+            std::cout << material_name << " at " << energy / 1E3 << " keV: "
+                      << static_cast<double>(duration) / N_SAMPLES << " ns per sample, <mu> = "
+                      << mean_mu / N_SAMPLES << std::endl;
+            std::cout << "  " << result << std::endl;
+        }
+    }
+    return passed ? 0 : 1;
+}
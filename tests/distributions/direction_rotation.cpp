@@ -0,0 +1,105 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <chrono>
+
+// Compares the quaternion direction rotation previously used by Particle::rotate against the direction cosine
+// update with a rejection sampled azimuth. Both are timed, and a long chain of rotations is checked to stay unit
+// norm and to reproduce the sampled polar cosine between consecutive directions. The azimuths are sampled by
+// ParticleInteractionBehavior::sampleAzimuth, which is also checked to be uniform on the unit circle.
+
+const int N_BENCHMARK = 10000000;
+const long N_HISTORY = 100000000;
+const double NORM_TOLERANCE = 1E-12;
+const double COS_THETA_TOLERANCE = 1E-9;
+const int N_AZIMUTH_SAMPLES = 1000000;
+const int N_AZIMUTH_BINS = 100;
+
+// Reference implementation: quaternion rotation about a perpendicular vector, then about the direction itself
+Eigen::Vector3d rotateDirectionQuaternion(const Eigen::Vector3d& vector, double theta, double phi) {
+    Eigen::Vector3d perp_vector = ParticleHelpers::getPerpendicularVector(vector).normalized();
+    Eigen::Quaterniond q_theta(cos(theta/2), perp_vector.x()*sin(theta/2), perp_vector.y()*sin(theta/2), perp_vector.z()*sin(theta/2));
+    Eigen::Quaterniond q_phi(cos(phi/2), vector.x()*sin(phi/2), vector.y()*sin(phi/2), vector.z()*sin(phi/2));
+    Eigen::Quaterniond q = q_phi * q_theta;
+    Eigen::Quaterniond v(0, vector.x(), vector.y(), vector.z());
+    Eigen::Quaterniond rotated_vector = q * v * q.inverse();
+    return {rotated_vector.x(), rotated_vector.y(), rotated_vector.z()};
+}
+
+// Exposes the azimuth sampling shared by the interaction behaviors
+class AzimuthSampler : public ParticleInteractionBehavior {
+public:
+    double interact(Particle&, Material&) override { return 0; }
+    using ParticleInteractionBehavior::sampleAzimuth;
+};
+
+bool checkAzimuthDistribution(AzimuthSampler& sampler) {
+    std::vector<double> observed(N_AZIMUTH_BINS, 0);
+    double max_norm_error = 0;
+    for (int i = 0; i < N_AZIMUTH_SAMPLES; ++i) {
+        double cos_phi, sin_phi;
+        sampler.sampleAzimuth(cos_phi, sin_phi);
+        max_norm_error = std::max(max_norm_error, std::abs(cos_phi*cos_phi + sin_phi*sin_phi - 1));
+        double phi = std::atan2(sin_phi, cos_phi) + PI; // in [0, 2 pi]
+        observed[std::min(static_cast<int>(phi / (2*PI) * N_AZIMUTH_BINS), N_AZIMUTH_BINS - 1)]++;
+    }
+    std::vector<double> expected(N_AZIMUTH_BINS, static_cast<double>(N_AZIMUTH_SAMPLES) / N_AZIMUTH_BINS);
+    TestUtils::ChiSquareResult result = TestUtils::chiSquareTest(expected, observed);
+    std::cout << "Azimuth distribution" << std::endl;
+    std::cout << "  Max |cos^2 + sin^2 - 1|: " << max_norm_error << std::endl;
+    std::cout << "  " << result << std::endl;
+    return result.passed() && max_norm_error < NORM_TOLERANCE;
+}
+
+int main() {
+    ProbabilityDist::Uniform uniform_dist(0.0, 1.0);
+    AzimuthSampler sampler;
+    Eigen::Vector3d direction(0, 0, 1);
+
+    // benchmark, including the sampling of the polar cosine and the azimuth
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < N_BENCHMARK; ++i) {
+        double mu = 2*uniform_dist.sample() - 1;
+        double phi = 2*PI*uniform_dist.sample();
+        direction = rotateDirectionQuaternion(direction, acos(mu), phi).normalized();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto quaternion_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << "Quaternion (final z = " << direction.z() << "): "
+              << static_cast<double>(quaternion_duration) / N_BENCHMARK << " ns per rotation" << std::endl;
+
+    direction << 0, 0, 1;
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < N_BENCHMARK; ++i) {
+        double mu = 2*uniform_dist.sample() - 1;
+        double cos_phi, sin_phi;
+        sampler.sampleAzimuth(cos_phi, sin_phi);
+        direction = ParticleHelpers::rotateDirection(direction, mu, cos_phi, sin_phi);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto direction_cosine_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << "Direction cosines (final z = " << direction.z() << "): "
+              << static_cast<double>(direction_cosine_duration) / N_BENCHMARK << " ns per rotation" << std::endl;
+
+    // long history, unnormalized between steps other than by rotateDirection itself
+    direction << 0, 0, 1;
+    double max_norm_error = 0;
+    double max_cos_theta_error = 0;
+    for (long i = 0; i < N_HISTORY; ++i) {
+        // bias towards forward scattering and the poles, where round-off is worst
+        double mu = (i % 3 == 0) ? 1 - 1E-6*uniform_dist.sample() : 2*uniform_dist.sample() - 1;
+        double cos_phi, sin_phi;
+        sampler.sampleAzimuth(cos_phi, sin_phi);
+        Eigen::Vector3d new_direction = ParticleHelpers::rotateDirection(direction, mu, cos_phi, sin_phi);
+        max_norm_error = std::max(max_norm_error, std::abs(new_direction.norm() - 1));
+        max_cos_theta_error = std::max(max_cos_theta_error, std::abs(new_direction.dot(direction) - mu));
+        direction = new_direction;
+    }
+    bool passed = max_norm_error < NORM_TOLERANCE && max_cos_theta_error < COS_THETA_TOLERANCE;
+
+    std::cout << "History of " << N_HISTORY << " rotations" << std::endl;
+    std::cout << "  Max |norm - 1|: " << max_norm_error << std::endl;
+    std::cout << "  Max |cos(theta) error|: " << max_cos_theta_error << std::endl;
+    passed = checkAzimuthDistribution(sampler) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
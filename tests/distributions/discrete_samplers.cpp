@@ -0,0 +1,57 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <chrono>
+#include <map>
+
+// Compares the alias and guide table samplers for a polyenergetic spectrum.
+// Each sampler is timed and its histogram is checked against the input probabilities with a chi-square test.
+
+const int N_SAMPLES = 10000000;
+
+Eigen::MatrixXd processEnergySpectrum() {
+    Eigen::MatrixXd energy_spectrum = SourceHelpers::readCSV("../../data/source_distributions/RQR8_W_AL_100kVp_E_spectrum.csv");
+    energy_spectrum.col(0) = energy_spectrum.col(0).array() * 1000;  // Convert from keV to eV
+    return energy_spectrum;
+}
+
+bool runSampler(const std::string& name, PolyenergeticSpectrum& spectrum, const Eigen::MatrixXd& energy_spectrum) {
+    std::map<double, long> histogram;
+    std::vector<double> samples(N_SAMPLES);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < N_SAMPLES; ++i) {
+        samples[i] = spectrum.sampleEnergy();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    for (double sample : samples) {
+        histogram[sample]++;
+    }
+
+    double total_probability = energy_spectrum.col(1).sum();
+    std::vector<double> expected(energy_spectrum.rows());
+    std::vector<double> observed(energy_spectrum.rows());
+    for (int i = 0; i < energy_spectrum.rows(); ++i) {
+        expected[i] = N_SAMPLES * energy_spectrum(i, 1) / total_probability;
+        observed[i] = static_cast<double>(histogram[energy_spectrum(i, 0)]);
+    }
+    TestUtils::ChiSquareResult result = TestUtils::chiSquareTest(expected, observed);
+
+    std::cout << name << std::endl;
+    std::cout << "  Duration per sample: " << static_cast<double>(duration) / N_SAMPLES << " ns" << std::endl;
+    std::cout << "  " << result << std::endl;
+    return result.passed();
+}
+
+int main() {
+    Eigen::MatrixXd energy_spectrum = processEnergySpectrum();
+
+    PolyenergeticSpectrum alias_spectrum(energy_spectrum, ProbabilityDist::DiscreteSamplingMethod::Alias);
+    PolyenergeticSpectrum guide_table_spectrum(energy_spectrum, ProbabilityDist::DiscreteSamplingMethod::GuideTable);
+
+    bool passed = runSampler("Alias", alias_spectrum, energy_spectrum);
+    passed = runSampler("Guide table", guide_table_spectrum, energy_spectrum) && passed;
+
+    return passed ? 0 : 1;
+}
@@ -15,8 +15,7 @@ Eigen::VectorXd energy_values = Eigen::ArrayXd::LinSpaced(100, 0, 100).matrix();
 
 
 int main() {
-    auto data_service = DataAccessObject("data/data_sources/EPDL/EPDL.db");
-    auto interaction_data = InteractionData({"Al"}, data_service);
+    auto interaction_data = InteractionData({"Al"});
 
     const int N_PHOTONS = 10000000;
     const double ENERGY = 60E3;
@@ -24,7 +23,7 @@ int main() {
     Eigen::Vector3d direction(0, 0, 1);
     CoherentScattering scattering;
 
-    auto material = interaction_data.getMaterial(61);
+    Material& material = interaction_data.getMaterialFromId(interaction_data.getAnyMaterialIdFromName("Al"));
 
     const double ALPHA = ELECTRON_REST_MASS/(sqrt(2)*PLANCK_CONSTANT*SPEED_OF_LIGHT*1E8);
     double k = ENERGY/ELECTRON_REST_MASS;
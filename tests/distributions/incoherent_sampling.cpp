@@ -0,0 +1,91 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <chrono>
+
+// Compares the tabulated incoherent scattering sampler against Kahn's rejection method followed by
+// rejection on the incoherent scattering function. Both samplers are timed, and the sampled cosine
+// histograms are compared with a two-sample chi-square test.
+
+const int N_SAMPLES = 5000000;
+const int N_BINS = 100;
+
+// Reference sampler: Kahn's rejection method for Klein-Nishina, then rejection with S(x, Z)/S(x_max, Z)
+double sampleMuKahn(double k, const MaterialData& material_data, ProbabilityDist::Uniform& uniform_dist) {
+    double max_x = ALPHA*k*sqrt(2);
+    double max_S = material_data.interpolateIncoherentScatteringFunction(max_x);
+    while (true) {
+        double random_number_1 = uniform_dist.sample();
+        double random_number_2 = uniform_dist.sample();
+        double random_number_3 = uniform_dist.sample();
+        double chi;
+        if (random_number_1 <= (1 + 2*k)/(9 + 2*k)) {
+            chi = 1 + 2*k*random_number_2;
+            if (random_number_3 > 4 * (1/chi - 1/(chi*chi))) continue;
+        } else {
+            chi = (1 + 2*k)/(1 + 2*k*random_number_2);
+            if (2*random_number_3 > pow(1/k - chi/k + 1, 2) + 1/chi) continue;
+        }
+        double k_prime = k/chi;
+        double mu = 1 + 1/k - 1/k_prime;
+        double x = ALPHA*k*sqrt(1 - mu);
+        if (uniform_dist.sample() <= material_data.interpolateIncoherentScatteringFunction(x)/max_S) {
+            return mu;
+        }
+    }
+}
+
+int muToBin(double mu) {
+    return std::min(N_BINS - 1, std::max(0, static_cast<int>((mu + 1) / 2 * N_BINS)));
+}
+
+int main() {
+    std::vector<std::string> material_names = {"Water, Liquid", "Al", "Pb"};
+    std::vector<double> energies = {10E3, 30E3, 60E3, 100E3};
+
+    InteractionData interaction_data(material_names);
+    ProbabilityDist::Uniform uniform_dist(0.0, 1.0);
+    bool passed = true;
+
+    for (auto& material_name : material_names) {
+        int material_id = interaction_data.getAnyMaterialIdFromName(material_name);
+        auto& material_data = interaction_data.getMaterialFromId(material_id).getData();
+        for (double energy : energies) {
+            double k = energy/ELECTRON_REST_MASS;
+            std::vector<long> kahn_histogram(N_BINS, 0);
+            std::vector<long> tabulated_histogram(N_BINS, 0);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < N_SAMPLES; ++i) {
+                kahn_histogram[muToBin(sampleMuKahn(k, material_data, uniform_dist))]++;
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            auto kahn_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+            start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < N_SAMPLES; ++i) {
+                tabulated_histogram[muToBin(material_data.sampleIncoherentScatteringDCS(energy))]++;
+            }
+            end = std::chrono::high_resolution_clock::now();
+            auto tabulated_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+            // two-sample chi-square with equal sample sizes
+            double chi_square = 0;
+            int dof = -1;
+            for (int i = 0; i < N_BINS; ++i) {
+                double total = static_cast<double>(kahn_histogram[i] + tabulated_histogram[i]);
+                if (total == 0) continue;
+                double difference = static_cast<double>(kahn_histogram[i] - tabulated_histogram[i]);
+                chi_square += difference * difference / total;
+                dof++;
+            }
+            TestUtils::ChiSquareResult result = {chi_square, dof, TestUtils::chiSquareZScore(chi_square, dof)};
+            passed = passed && result.passed();
+
+            std::cout << material_name << " at " << energy / 1E3 << " keV" << std::endl;
+            std::cout << "  Kahn + rejection: " << static_cast<double>(kahn_duration) / N_SAMPLES << " ns per sample" << std::endl;
+            std::cout << "  Tabulated: " << static_cast<double>(tabulated_duration) / N_SAMPLES << " ns per sample" << std::endl;
+            std::cout << "  " << result << std::endl;
+        }
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <random>
+
+// Builds a computational domain of overlapping voxel grids, a tetrahedral mesh and random primitives, and checks the
+// lookup grid against a brute-force search of every body at random positions: the voxel must be that of the first
+// voxel grid, then mesh, then primitive containing the position. Along random rays, the voxel must not change within
+// the distance returned by getHomogeneousDistance, and the background distance must be the distance to the nearest
+// bounding box of a body, or to the boundary of the computational domain.
+
+const TestUtils::TestDirectory TEST_DIR("domain_lookup");
+const int N_POSITIONS = 20000;
+const int N_PRIMITIVES = 40;
+const int N_SAMPLES = 16; // positions checked along each homogeneous distance
+const double DISTANCE_TOLERANCE = 1E-9; // cm
+const double DIM_SPACE = 20; // cm
+const std::string BACKGROUND_MATERIAL_NAME = "Air, Dry (near sea level)";
+const std::vector<std::string> MATERIAL_NAMES = {"Water, Liquid", "Al", "Pb", "Tissue, Soft"};
+
+// blocks of 8x8x8 voxels of materials 1, 2 and 5, half of them with scattered voxels of material 5, so the octree has
+// uniform nodes as well as mixed ones
+void writeVoxelGrid(const std::string& filename, const Eigen::Vector3i& dim_vox, std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    const std::vector<uint8_t> material_choices = {1, 2, 5};
+    const Eigen::Vector3i dim_blocks = (dim_vox.array() + 7) / 8;
+    std::vector<uint8_t> block_materials(dim_blocks.prod());
+    std::vector<bool> block_is_noisy(dim_blocks.prod());
+    for (size_t block = 0; block < block_materials.size(); ++block) {
+        block_materials[block] = material_choices[static_cast<int>(uniform_dist(generator) * 3)];
+        block_is_noisy[block] = uniform_dist(generator) < 0.5;
+    }
+    TestUtils::writeVoxelFile(filename, dim_vox, Eigen::Vector3d::Constant(0.25), [&](const Eigen::Vector3i& voxel_index) {
+        int block = TestUtils::linearNumber(voxel_index / 8, dim_blocks);
+        bool noise = block_is_noisy[block] && uniform_dist(generator) < 0.02;
+        return noise ? uint8_t(5) : block_materials[block];
+    });
+}
+
+std::string vectorJSON(const Eigen::Vector3d& vector) {
+    std::ostringstream stream;
+    stream << "[" << vector[0] << ", " << vector[1] << ", " << vector[2] << "]";
+    return stream.str();
+}
+
+// random boxes, spheres and cylinders, which overlap each other and the other bodies
+std::string primitivesJSON(std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    std::ostringstream primitives;
+    for (int i = 0; i < N_PRIMITIVES; ++i) {
+        Eigen::Vector3d center = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator) * DIM_SPACE; });
+        Eigen::Vector3d half_sizes = Eigen::Vector3d::NullaryExpr([&]() { return 0.2 + uniform_dist(generator) * 2; });
+        std::string material_name = MATERIAL_NAMES[i % MATERIAL_NAMES.size()];
+        primitives << (i > 0 ? ", " : "");
+        if (i % 3 == 0) {
+            primitives << R"json({"type": "box", "min": )json" << vectorJSON(center - half_sizes) << R"json(, "max": )json"
+                       << vectorJSON(center + half_sizes);
+        }
+        else if (i % 3 == 1) {
+            primitives << R"json({"type": "sphere", "center": )json" << vectorJSON(center) << R"json(, "radius": )json" << half_sizes[0];
+        }
+        else {
+            Eigen::Vector3d axis = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator) - 0.5; });
+            primitives << R"json({"type": "cylinder", "center": )json" << vectorJSON(center) << R"json(, "axis": )json"
+                       << vectorJSON(axis) << R"json(, "radius": )json" << half_sizes[0] << R"json(, "height": )json" << 2 * half_sizes[1];
+        }
+        primitives << R"json(, "material_name": ")json" << material_name << R"json("})json";
+    }
+    return primitives.str();
+}
+
+// the bounding boxes of every body, in the order of precedence, as the computational domain clips them
+std::vector<Eigen::AlignedBox3d> getBodyBounds(ComputationalDomain& comp_domain) {
+    const Eigen::AlignedBox3d domain_bounds(Eigen::Vector3d::Zero(), Eigen::Vector3d::Constant(DIM_SPACE));
+    std::vector<Eigen::AlignedBox3d> body_bounds;
+    for (int i = 0; i < comp_domain.getNumVoxelGrids(); ++i) {
+        body_bounds.emplace_back(comp_domain.getVoxelGridOriginN(i), comp_domain.getVoxelGridOriginN(i) + comp_domain.getVoxelGridDimSpaceN(i));
+    }
+    for (int i = 0; i < comp_domain.getNumTetrahedralMeshes(); ++i) {
+        const Eigen::AlignedBox3d& mesh_bounds = comp_domain.getTetrahedralMeshN(i).getBoundingBox();
+        body_bounds.emplace_back(mesh_bounds.min() + comp_domain.getTetrahedralMeshOriginN(i), mesh_bounds.max() + comp_domain.getTetrahedralMeshOriginN(i));
+    }
+    for (int i = 0; i < comp_domain.getNumPrimitives(); ++i) {
+        body_bounds.push_back(comp_domain.getPrimitiveN(i).getBoundingBox().intersection(domain_bounds));
+    }
+    return body_bounds;
+}
+
+// the voxel of the first body containing the position, searching every body
+Voxel findVoxel(ComputationalDomain& comp_domain, const Eigen::Vector3d& position) {
+    for (int i = 0; i < comp_domain.getNumVoxelGrids(); ++i) {
+        Eigen::Vector3d voxel_grid_position = position - comp_domain.getVoxelGridOriginN(i);
+        if ((voxel_grid_position.array() >= 0).all() && (voxel_grid_position.array() <= comp_domain.getVoxelGridDimSpaceN(i).array()).all()) {
+            return comp_domain.getVoxelGridN(i).getVoxelUnchecked(voxel_grid_position);
+        }
+    }
+    for (int i = 0; i < comp_domain.getNumTetrahedralMeshes(); ++i) {
+        const TetrahedralMesh& tetrahedral_mesh = comp_domain.getTetrahedralMeshN(i);
+        int tetrahedron = tetrahedral_mesh.findTetrahedron(position - comp_domain.getTetrahedralMeshOriginN(i));
+        if (tetrahedron >= 0) {
+            return tetrahedral_mesh.getVoxel(tetrahedron);
+        }
+    }
+    const std::vector<int>& material_ids = comp_domain.getMaterialIds();
+    for (int i = 0; i < comp_domain.getNumPrimitives(); ++i) {
+        const Primitive& primitive = comp_domain.getPrimitiveN(i);
+        if (primitive.contains(position)) {
+            Voxel voxel;
+            voxel.materialID = static_cast<uint8_t>(std::find(material_ids.begin(), material_ids.end(), primitive.getMaterialId()) - material_ids.begin());
+            return voxel;
+        }
+    }
+    return comp_domain.background_voxel;
+}
+
+int main() {
+    std::mt19937_64 generator(20240428);
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    std::normal_distribution<double> normal_dist(0.0, 1.0);
+
+    // the second voxel grid overlaps the first, so neither is a homogeneous region where they overlap
+    writeVoxelGrid(TEST_DIR.file("first.mvox"), Eigen::Vector3i(24, 20, 16), generator);
+    writeVoxelGrid(TEST_DIR.file("second.mvox"), Eigen::Vector3i(16, 16, 16), generator);
+    TestUtils::writeCubeMesh(TEST_DIR.file("cube.mesh"), 3, 2); // Al
+    std::string json_file_path = TestUtils::writeFile(TEST_DIR.file("domain.json"),
+            R"json({"dim_space": [20, 20, 20], "background_material_name": ")json" + BACKGROUND_MATERIAL_NAME +
+            R"json(", "voxel_grids": [{"file_path": "first.mvox", "origin": [1, 2, 3], "octree": true},
+                {"file_path": "second.mvox", "origin": [5, 5, 5], "octree": true},
+                {"file_path": "second.mvox", "origin": [14, 14, 0]}],
+            "tetrahedral_meshes": [{"file_path": "cube.mesh", "origin": [12, 2, 12]}],
+            "primitives": [)json" + primitivesJSON(generator) + "]}");
+    ComputationalDomain comp_domain(json_file_path);
+    const std::vector<Eigen::AlignedBox3d> body_bounds = getBodyBounds(comp_domain);
+    const Eigen::AlignedBox3d domain_bounds(Eigen::Vector3d::Zero(), Eigen::Vector3d::Constant(DIM_SPACE));
+
+    bool voxels_passed = true;
+    bool homogeneous_passed = true;
+    bool background_passed = true;
+    int num_body = 0;
+    int num_homogeneous = 0;
+    int num_background = 0;
+    for (int n = 0; n < N_POSITIONS; ++n) {
+        // half of the positions within the bounding box of a random body, as most of the domain is background
+        Eigen::AlignedBox3d sampled_bounds = domain_bounds;
+        if (n % 2 == 1) {
+            sampled_bounds = body_bounds[static_cast<size_t>(uniform_dist(generator) * body_bounds.size())];
+        }
+        Eigen::Vector3d position = sampled_bounds.min() + Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); })
+                                                                  .cwiseProduct(sampled_bounds.sizes());
+        Eigen::Vector3d direction = Eigen::Vector3d::NullaryExpr([&]() { return normal_dist(generator); }).normalized();
+        Voxel voxel = comp_domain.getVoxel(position);
+        Voxel expected_voxel = findVoxel(comp_domain, position);
+        num_body += TestUtils::sameRegion(expected_voxel, comp_domain.background_voxel) ? 0 : 1;
+        voxels_passed = voxels_passed && TestUtils::sameRegion(voxel, expected_voxel) && voxel.voxel_number == expected_voxel.voxel_number;
+
+        // photons are terminated where they leave the computational domain, so the region is only checked within it
+        const double domain_exit = TestUtils::getRayBoxLengths(domain_bounds, position, direction).second;
+        Voxel homogeneous_voxel;
+        double homogeneous_distance = comp_domain.getHomogeneousDistance(position, direction, homogeneous_voxel);
+        homogeneous_passed = homogeneous_passed && TestUtils::sameRegion(homogeneous_voxel, expected_voxel) && homogeneous_distance >= 0;
+        double checked_distance = std::min(homogeneous_distance, domain_exit);
+        num_homogeneous += checked_distance > 0 ? 1 : 0;
+        for (int s = 0; s < N_SAMPLES && checked_distance > 0; ++s) {
+            double length = checked_distance * (s + uniform_dist(generator)) / N_SAMPLES;
+            homogeneous_passed = homogeneous_passed && TestUtils::sameRegion(findVoxel(comp_domain, position + length * direction), expected_voxel);
+        }
+
+        // the nearest bounding box the ray enters, or the boundary of the computational domain
+        double expected_background_distance = domain_exit;
+        for (const auto& bounds : body_bounds) {
+            std::pair<double, double> lengths = TestUtils::getRayBoxLengths(bounds, position, direction);
+            if (bounds.contains(position)) {
+                expected_background_distance = 0;
+            }
+            else if (lengths.first <= lengths.second && lengths.second >= 0) {
+                expected_background_distance = std::min(expected_background_distance, lengths.first);
+            }
+        }
+        double background_distance = comp_domain.getBackgroundDistance(position, direction);
+        num_background += background_distance > 0 ? 1 : 0;
+        background_passed = background_passed && std::abs(background_distance - expected_background_distance) < DISTANCE_TOLERANCE &&
+                            (background_distance == 0 || TestUtils::sameRegion(expected_voxel, comp_domain.background_voxel));
+    }
+    std::cout << "Lookup grid (" << num_body << " positions in bodies, " << num_homogeneous << " homogeneous and " << num_background << " background distances of "
+              << N_POSITIONS << ")" << std::endl;
+    bool passed = TestUtils::report("voxels match a search of every body", voxels_passed);
+    passed = TestUtils::report("voxel unchanged within the homogeneous distance", homogeneous_passed) && passed;
+    passed = TestUtils::report("background distance to the nearest bounding box", background_passed) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <map>
+#include <random>
+
+// Stores a voxel grid of nested spheres, with scattered voxels and a region of varying density, in an octree, and
+// checks it against the arrays it was built from: every voxel must have its own material, every node must be one
+// material and density if it is uniform, and every block of 8x8x8 voxels of one material and density must be a
+// uniform node. Along random rays, the voxel must not change within the distance returned by getHomogeneousDistance,
+// which must end at the boundary of the uniform node, or be 0 in a block of mixed voxels.
+
+const TestUtils::TestDirectory TEST_DIR("octree_regions");
+const Eigen::Vector3i DIM_VOX(45, 30, 21); // not multiples of the block size
+const Eigen::Vector3d SPACING(0.1, 0.1, 0.2); // cm
+const int BRICK_SIZE = VoxelOctree::BRICK_SIZE;
+const int N_RAYS = 20000;
+const int N_SAMPLES = 16; // positions checked along each homogeneous distance
+const double DISTANCE_TOLERANCE = 1E-9; // cm
+
+// true if every voxel in [min_index, max_index) has the material and density scale factor of the first
+bool isUniform(const Eigen::Vector3i& min_index, const Eigen::Vector3i& max_index, const std::vector<uint8_t>& materials,
+               const std::vector<double>& density_scales) {
+    const int first = TestUtils::linearNumber(min_index, DIM_VOX);
+    for (int k = min_index[2]; k < max_index[2]; ++k) {
+        for (int j = min_index[1]; j < max_index[1]; ++j) {
+            for (int i = min_index[0]; i < max_index[0]; ++i) {
+                int voxel_number = TestUtils::linearNumber(Eigen::Vector3i(i, j, k), DIM_VOX);
+                if (materials[voxel_number] != materials[first] || density_scales[voxel_number] != density_scales[first]) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool checkNodes(const VoxelOctree& octree, const std::vector<uint8_t>& materials, const std::vector<double>& density_scales) {
+    bool materials_passed = true;
+    bool nodes_passed = true;
+    std::map<std::array<int, 3>, bool> uniform_nodes; // whether each node found so far is uniform, by its lower corner
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        VoxelOctreeNode node = octree.getNode(voxel_index);
+        uint8_t material = materials[TestUtils::linearNumber(voxel_index, DIM_VOX)];
+        materials_passed = materials_passed && octree.getMaterialId(voxel_index) == material && node.material_id == material;
+        bool aligned = (node.min_index.array() <= voxel_index.array()).all() && (voxel_index.array() < node.max_index.array()).all() &&
+                       (node.max_index.array() <= DIM_VOX.array()).all() &&
+                       (node.min_index.unaryExpr([](int index) { return index % BRICK_SIZE; }).array() == 0).all();
+        // a mixed node is a single block, clipped to the voxel grid
+        bool mixed_is_block = node.is_homogeneous ||
+                              node.max_index == (node.min_index.array() + BRICK_SIZE).min(DIM_VOX.array()).matrix();
+        std::array<int, 3> key = {node.min_index[0], node.min_index[1], node.min_index[2]};
+        auto uniform_node = uniform_nodes.find(key);
+        if (uniform_node == uniform_nodes.end()) {
+            uniform_node = uniform_nodes.emplace(key, isUniform(node.min_index, node.max_index, materials, density_scales)).first;
+        }
+        nodes_passed = nodes_passed && aligned && mixed_is_block && (!node.is_homogeneous || uniform_node->second);
+    });
+
+    // every uniform block is collapsed, so only the blocks of mixed voxels are stored
+    size_t num_mixed_blocks = 0;
+    bool blocks_passed = true;
+    for (int k = 0; k < DIM_VOX[2]; k += BRICK_SIZE) {
+        for (int j = 0; j < DIM_VOX[1]; j += BRICK_SIZE) {
+            for (int i = 0; i < DIM_VOX[0]; i += BRICK_SIZE) {
+                Eigen::Vector3i min_index(i, j, k);
+                Eigen::Vector3i max_index = (min_index.array() + BRICK_SIZE).min(DIM_VOX.array());
+                bool uniform = isUniform(min_index, max_index, materials, density_scales);
+                num_mixed_blocks += uniform ? 0 : 1;
+                blocks_passed = blocks_passed && octree.getNode(min_index).is_homogeneous == uniform;
+            }
+        }
+    }
+    std::cout << "  " << octree.getNumOfNodes() << " nodes, " << octree.getNumOfBricks() << " blocks of mixed voxels" << std::endl;
+    bool passed = TestUtils::report("material of every voxel", materials_passed);
+    passed = TestUtils::report("nodes contain their voxel and uniform nodes are one material and density", nodes_passed) && passed;
+    return TestUtils::report("uniform blocks collapsed", blocks_passed && octree.getNumOfBricks() == num_mixed_blocks) && passed;
+}
+
+bool checkHomogeneousDistances(VoxelGrid& voxel_grid, std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    std::normal_distribution<double> normal_dist(0.0, 1.0);
+    const Eigen::Vector3d dim_space = DIM_VOX.cast<double>().cwiseProduct(SPACING);
+    const Eigen::AlignedBox3d grid_bounds(Eigen::Vector3d::Zero(), dim_space);
+    bool voxels_passed = true;
+    bool regions_passed = true;
+    bool boundaries_passed = true;
+    int num_homogeneous = 0;
+    for (int n = 0; n < N_RAYS; ++n) {
+        Eigen::Vector3d position = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); }).cwiseProduct(dim_space);
+        Eigen::Vector3d direction = Eigen::Vector3d::NullaryExpr([&]() { return normal_dist(generator); }).normalized();
+        Voxel voxel;
+        double distance = voxel_grid.getHomogeneousDistance(position, direction, voxel);
+        Voxel expected_voxel = voxel_grid.getVoxelUnchecked(position);
+        voxels_passed = voxels_passed && TestUtils::sameRegion(voxel, expected_voxel) && voxel.voxel_number == expected_voxel.voxel_number;
+
+        // the region is the uniform node containing the position, so the distance ends at the boundary of the node
+        Eigen::Vector3i voxel_index = position.cwiseQuotient(SPACING).cast<int>().cwiseMin(DIM_VOX - Eigen::Vector3i::Ones());
+        VoxelOctreeNode node = voxel_grid.getOctree()->getNode(voxel_index);
+        double expected_distance = 0;
+        if (node.is_homogeneous) {
+            Eigen::AlignedBox3d node_bounds(node.min_index.cast<double>().cwiseProduct(SPACING), node.max_index.cast<double>().cwiseProduct(SPACING));
+            expected_distance = TestUtils::getRayBoxLengths(node_bounds, position, direction).second;
+        }
+        boundaries_passed = boundaries_passed && std::abs(distance - expected_distance) < DISTANCE_TOLERANCE;
+
+        double checked_distance = std::min(distance, TestUtils::getRayBoxLengths(grid_bounds, position, direction).second);
+        num_homogeneous += checked_distance > 0 ? 1 : 0;
+        for (int s = 0; s < N_SAMPLES && checked_distance > 0; ++s) {
+            double length = checked_distance * (s + uniform_dist(generator)) / N_SAMPLES;
+            regions_passed = regions_passed && TestUtils::sameRegion(voxel_grid.getVoxelUnchecked(position + length * direction), expected_voxel);
+        }
+    }
+    std::cout << "  " << num_homogeneous << " of " << N_RAYS << " rays start in a uniform node" << std::endl;
+    bool passed = TestUtils::report("voxel at the position", voxels_passed);
+    passed = TestUtils::report("voxel unchanged within the homogeneous distance", regions_passed) && passed;
+    return TestUtils::report("homogeneous distance to the boundary of the node", boundaries_passed) && passed;
+}
+
+int main() {
+    // nested spheres of materials 2 and 5 in material 1, with scattered voxels of material 5, and densities which vary
+    // along z in a slab, where the blocks are mixed even though they are one material
+    std::mt19937_64 generator(20240428);
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    std::vector<uint8_t> materials(DIM_VOX.prod());
+    std::vector<float> densities(DIM_VOX.prod());
+    const std::unordered_map<int, float> nominal_densities = {{1, 1.0f}, {2, 2.699f}, {5, 1.06f}};
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        int voxel_number = TestUtils::linearNumber(voxel_index, DIM_VOX);
+        Eigen::Vector3d offset = (voxel_index - Eigen::Vector3i(26, 15, 10)).cast<double>();
+        double r_sq = offset[0] * offset[0] + offset[1] * offset[1] + 4.0 * offset[2] * offset[2];
+        materials[voxel_number] = r_sq < 36 || uniform_dist(generator) < 0.001 ? 5 : r_sq < 144 ? 2 : 1;
+        float density_factor = voxel_index[0] < 8 ? 0.9f + 0.01f * static_cast<float>(voxel_index[2]) : 1.0f;
+        densities[voxel_number] = nominal_densities.at(materials[voxel_number]) * density_factor;
+    });
+    std::string filename = TEST_DIR.file("phantom.mvox");
+    VoxelFile::write(filename, DIM_VOX, SPACING, materials.data());
+    std::string density_filename = TestUtils::writeNIfTI(TEST_DIR.file("densities.nii.gz"), DIM_VOX, SPACING, densities);
+
+    VoxelGrid voxel_grid(filename, density_filename);
+    std::vector<double> density_scales(DIM_VOX.prod());
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        density_scales[TestUtils::linearNumber(voxel_index, DIM_VOX)] = voxel_grid.getVoxel(voxel_index).density_scale;
+    });
+    Voxel voxel;
+    bool passed = TestUtils::report("no homogeneous regions without an octree",
+                                    voxel_grid.getHomogeneousDistance(Eigen::Vector3d(4.0, 1.5, 2.0), Eigen::Vector3d(1, 0, 0), voxel) == 0);
+    voxel_grid.enableOctree();
+    std::cout << "Octree" << std::endl;
+    passed = checkNodes(*voxel_grid.getOctree(), materials, density_scales) && passed;
+    std::cout << "Homogeneous regions" << std::endl;
+    passed = checkHomogeneousDistances(voxel_grid, generator) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
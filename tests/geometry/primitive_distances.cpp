@@ -0,0 +1,101 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <random>
+
+// Checks the entering and exiting lengths of each primitive against a brute-force walk along random lines: every
+// position between the lengths must be within the primitive, and every position outside of them must not be, and
+// every position within the primitive must be within its bounding box. Lines parallel to the faces, to the axis of a
+// cylinder and to the planes of a slab are checked as well, as are primitives with invalid dimensions.
+
+const int N_LINES = 2000;
+const int N_SAMPLES = 4000; // positions checked along each line
+const double MAX_LENGTH = 8; // cm, the half length of the checked part of each line
+const double BOUNDARY_TOLERANCE = 1E-9; // cm, within which of a length a position may be on either side
+const int MATERIAL_ID = 2;
+
+// true if the positions along the line are within the primitive exactly between the entering and exiting lengths
+bool checkLine(const Primitive& primitive, const Eigen::Vector3d& position, const Eigen::Vector3d& direction) {
+    const std::pair<double, double> lengths = primitive.getEnteringAndExitingLengths(position, direction);
+    const Eigen::AlignedBox3d bounds = primitive.getBoundingBox();
+    for (int s = 0; s <= N_SAMPLES; ++s) {
+        double length = MAX_LENGTH * (2.0 * s / N_SAMPLES - 1);
+        if (std::abs(length - lengths.first) < BOUNDARY_TOLERANCE || std::abs(length - lengths.second) < BOUNDARY_TOLERANCE) {
+            continue;
+        }
+        Eigen::Vector3d sample = position + length * direction;
+        bool contained = primitive.contains(sample);
+        if (contained != (length >= lengths.first && length <= lengths.second) || (contained && !bounds.contains(sample))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkPrimitive(const std::string& name, const Primitive& primitive, std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(-3.0, 3.0);
+    std::normal_distribution<double> normal_dist(0.0, 1.0);
+    bool passed = primitive.getMaterialId() == MATERIAL_ID;
+    int num_hits = 0;
+    for (int n = 0; n < N_LINES; ++n) {
+        Eigen::Vector3d position = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); });
+        Eigen::Vector3d direction = Eigen::Vector3d::NullaryExpr([&]() { return normal_dist(generator); }).normalized();
+        if (n % 2 == 1) {
+            // half of the lines through a position near the center of the primitives, so most of them hit
+            Eigen::Vector3d target = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator) / 6; });
+            direction = (target - position).normalized();
+        }
+        passed = passed && checkLine(primitive, position, direction);
+        std::pair<double, double> lengths = primitive.getEnteringAndExitingLengths(position, direction);
+        num_hits += lengths.first <= lengths.second ? 1 : 0;
+    }
+    std::cout << "  " << name << " hit by " << num_hits << " of " << N_LINES << " lines" << std::endl;
+    return TestUtils::report(name + " lengths match a walk along random lines", passed);
+}
+
+int main() {
+    std::mt19937_64 generator(20240428);
+    const BoxPrimitive box(Eigen::Vector3d(-1, -0.5, -2), Eigen::Vector3d(1.5, 0.5, 1), MATERIAL_ID);
+    const SpherePrimitive sphere(Eigen::Vector3d(0.5, -0.25, 0.3), 1.7, MATERIAL_ID);
+    const CylinderPrimitive cylinder(Eigen::Vector3d(0.2, 0.1, -0.3), Eigen::Vector3d(1, 2, -0.5), 0.8, 3.0, MATERIAL_ID);
+    const SlabPrimitive slab(Eigen::Vector3d(0.3, -1, 0.6), 0.4, 0.9, MATERIAL_ID);
+    const SlabPrimitive axis_slab(Eigen::Vector3d(0, 0, -1), 0.5, 1.0, MATERIAL_ID);
+
+    std::cout << "Random lines" << std::endl;
+    bool passed = checkPrimitive("box", box, generator);
+    passed = checkPrimitive("sphere", sphere, generator) && passed;
+    passed = checkPrimitive("cylinder", cylinder, generator) && passed;
+    passed = checkPrimitive("slab", slab, generator) && passed;
+    passed = checkPrimitive("slab along an axis", axis_slab, generator) && passed;
+
+    std::cout << "Parallel lines" << std::endl;
+    const Eigen::Vector3d x_axis(1, 0, 0);
+    const Eigen::Vector3d cylinder_axis = Eigen::Vector3d(1, 2, -0.5).normalized();
+    const Eigen::Vector3d slab_parallel = Eigen::Vector3d(0.3, -1, 0.6).cross(Eigen::Vector3d(0, 0, 1)).normalized();
+    bool parallel_passed = checkLine(box, Eigen::Vector3d(0, 0, 0), x_axis) && checkLine(box, Eigen::Vector3d(0, 0.5, 1), x_axis) &&
+                           checkLine(box, Eigen::Vector3d(0, 0.6, 0), x_axis) &&
+                           box.getEnteringAndExitingLengths(Eigen::Vector3d(0, 0, 0), x_axis) == std::make_pair(-1.0, 1.5);
+    parallel_passed = parallel_passed && checkLine(cylinder, Eigen::Vector3d(0.2, 0.1, -0.3), cylinder_axis) &&
+                      checkLine(cylinder, Eigen::Vector3d(0.2, 0.1, 0.6), cylinder_axis) &&
+                      std::abs(cylinder.getEnteringAndExitingLengths(Eigen::Vector3d(0.2, 0.1, -0.3), cylinder_axis).second - 1.5) < BOUNDARY_TOLERANCE;
+    std::pair<double, double> within = slab.getEnteringAndExitingLengths(Eigen::Vector3d(0, -0.8, 0), slab_parallel);
+    std::pair<double, double> outside = slab.getEnteringAndExitingLengths(Eigen::Vector3d(0, 0, 0), slab_parallel);
+    parallel_passed = parallel_passed && within.first == -INF && within.second == INF && outside.first > outside.second;
+    passed = TestUtils::report("lines parallel to faces, axes and planes", parallel_passed) && passed;
+
+    std::cout << "Bounding boxes" << std::endl;
+    Eigen::AlignedBox3d axis_slab_bounds = axis_slab.getBoundingBox();
+    passed = TestUtils::report("exact for boxes, spheres and slabs along an axis",
+                               box.getBoundingBox().isApprox(Eigen::AlignedBox3d(Eigen::Vector3d(-1, -0.5, -2), Eigen::Vector3d(1.5, 0.5, 1))) &&
+                               sphere.getBoundingBox().isApprox(Eigen::AlignedBox3d(Eigen::Vector3d(-1.2, -1.95, -1.4), Eigen::Vector3d(2.2, 1.45, 2.0))) &&
+                               axis_slab_bounds.min()[2] == -1.5 && axis_slab_bounds.max()[2] == -0.5 &&
+                               axis_slab_bounds.min()[0] == -INF && axis_slab_bounds.max()[1] == INF) && passed;
+
+    std::cout << "Invalid primitives" << std::endl;
+    passed = TestUtils::report("rejected", TestUtils::throws([]() { BoxPrimitive(Eigen::Vector3d(1, 0, 0), Eigen::Vector3d(0, 1, 1), MATERIAL_ID); }) &&
+                               TestUtils::throws([]() { SpherePrimitive(Eigen::Vector3d::Zero(), 0, MATERIAL_ID); }) &&
+                               TestUtils::throws([]() { CylinderPrimitive(Eigen::Vector3d::Zero(), Eigen::Vector3d::Zero(), 1, 1, MATERIAL_ID); }) &&
+                               TestUtils::throws([]() { CylinderPrimitive(Eigen::Vector3d::Zero(), Eigen::Vector3d(0, 0, 1), 1, -1, MATERIAL_ID); }) &&
+                               TestUtils::throws([]() { SlabPrimitive(Eigen::Vector3d(0, 0, 1), 0, 0, MATERIAL_ID); })) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
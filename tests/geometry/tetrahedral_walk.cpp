@@ -0,0 +1,251 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <random>
+
+// Builds a mesh of cubes, each split into six tetrahedra, with a tunnel and a corner cut out of it so it is not
+// convex, and its interior vertices moved at random so its faces are oblique. Checks findTetrahedron against the
+// barycentric coordinates of every tetrahedron at random positions, checks that a ray stays within its tetrahedron up
+// to the exit distance, and walks rays through the mesh from tetrahedron to tetrahedron, each time into a neighbour
+// across the exiting face, until they leave the mesh. Also checks that a mesh file loads the same mesh, that remapping
+// the material indices keeps the material of each tetrahedron, and that invalid meshes are rejected.
+
+const TestUtils::TestDirectory TEST_DIR("tetrahedral_walk");
+const Eigen::Vector3i DIM_CUBES(6, 5, 4);
+const double CUBE_SIZE = 0.5; // cm
+const double MAX_DISPLACEMENT = 0.08 * CUBE_SIZE; // of each interior vertex along each axis
+const int N_POSITIONS = 20000;
+const int N_RAYS = 2000;
+const int N_SAMPLES = 16; // positions checked along each exit distance
+const double BARYCENTRIC_TOLERANCE = 1E-9; // positions nearer to a face than this are not checked
+const double STEP_PAST_FACE = 1E-7; // cm
+// the six tetrahedra of a cube around its diagonal from corner 0 to corner 7, where bit i of a corner is its offset along axis i
+const int CUBE_TETRAHEDRA[6][4] = {{0, 1, 3, 7}, {0, 1, 5, 7}, {0, 2, 3, 7}, {0, 2, 6, 7}, {0, 4, 5, 7}, {0, 4, 6, 7}};
+
+struct Mesh {
+    std::vector<Eigen::Vector3d> vertices;
+    std::vector<std::array<int, 4>> tetrahedra;
+    std::vector<int> material_ids;
+    std::vector<Eigen::Matrix3d> inverse_edges; // of the edges from the first vertex of each tetrahedron, for barycentric coordinates
+};
+
+// a tunnel along z, and a corner, are cut out
+bool hasCube(const Eigen::Vector3i& cube_index) {
+    bool tunnel = (cube_index[0] == 2 || cube_index[0] == 3) && cube_index[1] == 2;
+    bool corner = cube_index[0] >= 4 && cube_index[1] >= 3 && cube_index[2] >= 2;
+    return (cube_index.array() >= 0).all() && (cube_index.array() < DIM_CUBES.array()).all() && !tunnel && !corner;
+}
+
+Mesh makeMesh(std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(-1.0, 1.0);
+    const Eigen::Vector3i dim_vertices = DIM_CUBES + Eigen::Vector3i::Ones();
+    auto vertexNumber = [&dim_vertices](const Eigen::Vector3i& vertex_index) {
+        return vertex_index[0] + vertex_index[1] * dim_vertices[0] + vertex_index[2] * dim_vertices[0] * dim_vertices[1];
+    };
+    Mesh mesh;
+    for (int k = 0; k < dim_vertices[2]; ++k) {
+        for (int j = 0; j < dim_vertices[1]; ++j) {
+            for (int i = 0; i < dim_vertices[0]; ++i) {
+                // only vertices surrounded by cubes move, so the surface of the mesh keeps its shape
+                bool interior = true;
+                for (int corner = 0; corner < 8; ++corner) {
+                    interior = interior && hasCube(Eigen::Vector3i(i - (corner & 1), j - ((corner >> 1) & 1), k - ((corner >> 2) & 1)));
+                }
+                Eigen::Vector3d displacement = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator) * MAX_DISPLACEMENT; });
+                mesh.vertices.push_back(Eigen::Vector3d(i, j, k) * CUBE_SIZE + (interior ? displacement : Eigen::Vector3d::Zero()));
+            }
+        }
+    }
+    for (int k = 0; k < DIM_CUBES[2]; ++k) {
+        for (int j = 0; j < DIM_CUBES[1]; ++j) {
+            for (int i = 0; i < DIM_CUBES[0]; ++i) {
+                if (!hasCube(Eigen::Vector3i(i, j, k))) {
+                    continue;
+                }
+                for (const auto& cube_tetrahedron : CUBE_TETRAHEDRA) {
+                    std::array<int, 4> tetrahedron{};
+                    for (int v = 0; v < 4; ++v) {
+                        int corner = cube_tetrahedron[v];
+                        tetrahedron[v] = vertexNumber(Eigen::Vector3i(i + (corner & 1), j + ((corner >> 1) & 1), k + ((corner >> 2) & 1)));
+                    }
+                    const Eigen::Vector3d& v0 = mesh.vertices[tetrahedron[0]];
+                    Eigen::Matrix3d edges;
+                    edges << mesh.vertices[tetrahedron[1]] - v0, mesh.vertices[tetrahedron[2]] - v0, mesh.vertices[tetrahedron[3]] - v0;
+                    mesh.tetrahedra.push_back(tetrahedron);
+                    mesh.inverse_edges.push_back(edges.inverse());
+                    mesh.material_ids.push_back(std::vector<int>{1, 2, 5}[(i + j + k) % 3]);
+                }
+            }
+        }
+    }
+    return mesh;
+}
+
+// barycentric coordinates of a position in a tetrahedron
+Eigen::Vector4d getBarycentricCoordinates(const Mesh& mesh, int tetrahedron, const Eigen::Vector3d& position) {
+    Eigen::Vector3d coordinates = mesh.inverse_edges[tetrahedron] * (position - mesh.vertices[mesh.tetrahedra[tetrahedron][0]]);
+    return {1 - coordinates.sum(), coordinates[0], coordinates[1], coordinates[2]};
+}
+
+// the tetrahedron containing the position by more than the tolerance, -1 if none contains it, or -2 if it is near a face
+int findTetrahedronBruteForce(const Mesh& mesh, const Eigen::Vector3d& position) {
+    bool near_face = false;
+    for (int t = 0; t < static_cast<int>(mesh.tetrahedra.size()); ++t) {
+        double min_coordinate = getBarycentricCoordinates(mesh, t, position).minCoeff();
+        if (min_coordinate > BARYCENTRIC_TOLERANCE) {
+            return t;
+        }
+        near_face = near_face || min_coordinate > -BARYCENTRIC_TOLERANCE;
+    }
+    return near_face ? -2 : -1;
+}
+
+int countSharedVertices(const Mesh& mesh, int first, int second) {
+    int shared = 0;
+    for (int vertex : mesh.tetrahedra[first]) {
+        shared += std::count(mesh.tetrahedra[second].begin(), mesh.tetrahedra[second].end(), vertex) > 0 ? 1 : 0;
+    }
+    return shared;
+}
+
+bool checkLocation(const TetrahedralMesh& tetrahedral_mesh, const Mesh& mesh, std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(-0.1, 1.1);
+    const Eigen::Vector3d dim_space = DIM_CUBES.cast<double>() * CUBE_SIZE;
+    bool passed = true;
+    int num_inside = 0;
+    int num_outside = 0;
+    for (int n = 0; n < N_POSITIONS; ++n) {
+        Eigen::Vector3d position = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); }).cwiseProduct(dim_space);
+        int expected = findTetrahedronBruteForce(mesh, position);
+        if (expected == -2) {
+            continue;
+        }
+        num_inside += expected >= 0 ? 1 : 0;
+        num_outside += expected == -1 ? 1 : 0;
+        passed = passed && tetrahedral_mesh.findTetrahedron(position) == expected;
+    }
+    std::cout << "  " << num_inside << " positions within the mesh and " << num_outside << " outside of it" << std::endl;
+    return TestUtils::report("tetrahedra match the barycentric coordinates of every tetrahedron", passed);
+}
+
+bool checkWalks(const TetrahedralMesh& tetrahedral_mesh, const Mesh& mesh, std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    std::normal_distribution<double> normal_dist(0.0, 1.0);
+    const Eigen::Vector3d dim_space = DIM_CUBES.cast<double>() * CUBE_SIZE;
+    bool exits_passed = true;
+    bool neighbors_passed = true;
+    bool leaves_passed = true;
+    int num_steps = 0;
+    int num_reentries = 0;
+    for (int n = 0; n < N_RAYS; ++n) {
+        Eigen::Vector3d position = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); }).cwiseProduct(dim_space);
+        Eigen::Vector3d direction = Eigen::Vector3d::NullaryExpr([&]() { return normal_dist(generator); }).normalized();
+        int tetrahedron = tetrahedral_mesh.findTetrahedron(position);
+        if (tetrahedron < 0) {
+            continue;
+        }
+        // walk from tetrahedron to tetrahedron until the ray leaves the mesh
+        while (tetrahedron >= 0) {
+            double distance = tetrahedral_mesh.getExitDistance(tetrahedron, position, direction);
+            for (int s = 0; s < N_SAMPLES; ++s) {
+                double length = distance * (s + uniform_dist(generator)) / N_SAMPLES;
+                exits_passed = exits_passed && getBarycentricCoordinates(mesh, tetrahedron, position + length * direction).minCoeff() > -BARYCENTRIC_TOLERANCE;
+            }
+            position += (distance + STEP_PAST_FACE) * direction;
+            exits_passed = exits_passed && getBarycentricCoordinates(mesh, tetrahedron, position).minCoeff() < 0;
+            int next_tetrahedron = tetrahedral_mesh.findTetrahedron(position);
+            // the next tetrahedron is across the exiting face, unless the ray passed within the step of an edge
+            neighbors_passed = neighbors_passed && (next_tetrahedron < 0 || countSharedVertices(mesh, tetrahedron, next_tetrahedron) >= 2);
+            num_steps++;
+            tetrahedron = next_tetrahedron;
+        }
+        // the ray left the mesh: no position just beyond the exit is within it, but it may enter the mesh again later
+        leaves_passed = leaves_passed && findTetrahedronBruteForce(mesh, position) < 0;
+        for (double length = 0; length < dim_space.norm(); length += CUBE_SIZE / 4) {
+            if (findTetrahedronBruteForce(mesh, position + length * direction) >= 0) {
+                num_reentries++;
+                break;
+            }
+        }
+    }
+    std::cout << "  " << num_steps << " steps across faces, " << num_reentries << " rays enter the mesh again" << std::endl;
+    bool passed = TestUtils::report("rays stay within their tetrahedron up to the exit distance", exits_passed);
+    passed = TestUtils::report("rays walk into a neighbour across the exiting face", neighbors_passed) && passed;
+    return TestUtils::report("rays leave the mesh where the walk ends", leaves_passed) && passed;
+}
+
+bool checkFile(const TetrahedralMesh& tetrahedral_mesh, const Mesh& mesh, std::mt19937_64& generator) {
+    std::string filename = TEST_DIR.file("mesh.txt");
+    {
+        std::ofstream file(filename);
+        file.precision(17);
+        file << "# cubes with a tunnel and a corner cut out\nvertices " << mesh.vertices.size() << "\n";
+        for (const auto& vertex : mesh.vertices) {
+            file << vertex[0] << " " << vertex[1] << " " << vertex[2] << "\n";
+        }
+        file << "tetrahedra " << mesh.tetrahedra.size() << " # six per cube\n";
+        for (size_t t = 0; t < mesh.tetrahedra.size(); ++t) {
+            const std::array<int, 4>& vertices = mesh.tetrahedra[t];
+            file << vertices[0] << " " << vertices[1] << " " << vertices[2] << " " << vertices[3] << " " << mesh.material_ids[t] << "\n";
+        }
+    }
+    TetrahedralMesh loaded(filename);
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    bool same = loaded.getNumOfTetrahedra() == tetrahedral_mesh.getNumOfTetrahedra() &&
+                loaded.getNumOfVertices() == tetrahedral_mesh.getNumOfVertices() &&
+                loaded.getMaterialIds() == tetrahedral_mesh.getMaterialIds() &&
+                loaded.getBoundingBox().isApprox(tetrahedral_mesh.getBoundingBox());
+    for (int n = 0; n < N_POSITIONS / 10; ++n) {
+        Eigen::Vector3d position = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); }).cwiseProduct(DIM_CUBES.cast<double>() * CUBE_SIZE);
+        int tetrahedron = loaded.findTetrahedron(position);
+        same = same && tetrahedron == tetrahedral_mesh.findTetrahedron(position) &&
+               (tetrahedron < 0 || loaded.getVoxel(tetrahedron).materialID == tetrahedral_mesh.getVoxel(tetrahedron).materialID);
+    }
+    bool passed = TestUtils::report("mesh file loads the same mesh", same);
+
+    bool rejected = TestUtils::throws([]() { TetrahedralMesh mesh(TEST_DIR.file("missing.txt")); });
+    for (const std::string contents : {"tetrahedra 0\n", // no vertices
+                                       "vertices 4\n0 0 0\n1 0 0\n0 1 0\ntetrahedra 0\n", // short
+                                       "vertices 4\n0 0 0\n1 0 0\n0 1 0\n0 0 1\ntetrahedra 1\n0 1 2 4 1\n", // missing vertex
+                                       "vertices 4\n0 0 0\n1 0 0\n0 1 0\n1 1 0\ntetrahedra 1\n0 1 2 3 1\n"}) { // flat
+        std::string invalid_filename = TestUtils::writeFile(TEST_DIR.file("invalid.txt"), contents);
+        rejected = rejected && TestUtils::throws([&]() { TetrahedralMesh mesh(invalid_filename); });
+    }
+    passed = TestUtils::report("invalid mesh files rejected", rejected) && passed;
+    return TestUtils::report("material IDs must match the tetrahedra", TestUtils::throws([&mesh]() {
+        TetrahedralMesh tetrahedral_mesh(mesh.vertices, mesh.tetrahedra, std::vector<int>(mesh.tetrahedra.size() - 1, 1));
+    })) && passed;
+}
+
+// remaps the material indices into the lists of two computational domains in turn, which must keep the database
+// material of every tetrahedron and the material IDs of the mesh itself
+bool checkRemap(TetrahedralMesh& tetrahedral_mesh, const Mesh& mesh) {
+    const std::vector<int> material_ids = tetrahedral_mesh.getMaterialIds();
+    const std::vector<std::vector<int>> domain_material_ids = {{3, 5, 4, 2, 1}, {2, 1, 4, 5}};
+    bool passed = true;
+    for (const auto& domain_ids : domain_material_ids) {
+        tetrahedral_mesh.remapMaterialIds(domain_ids);
+        passed = passed && tetrahedral_mesh.getMaterialIds() == material_ids;
+        for (int t = 0; t < tetrahedral_mesh.getNumOfTetrahedra(); ++t) {
+            passed = passed && domain_ids[tetrahedral_mesh.getVoxel(t).materialID] == mesh.material_ids[t];
+        }
+    }
+    passed = TestUtils::report("remapped tetrahedra keep their material, and the mesh its material IDs", passed);
+    return TestUtils::report("materials missing from the list rejected",
+                             TestUtils::throws([&tetrahedral_mesh]() { tetrahedral_mesh.remapMaterialIds({1, 2, 3}); })) && passed;
+}
+
+int main() {
+    std::mt19937_64 generator(20240428);
+    Mesh mesh = makeMesh(generator);
+    TetrahedralMesh tetrahedral_mesh(mesh.vertices, mesh.tetrahedra, mesh.material_ids);
+    std::cout << "Mesh of " << tetrahedral_mesh.getNumOfTetrahedra() << " tetrahedra" << std::endl;
+    // the volumes of the tetrahedra sum to more than that of the cubes if a moved vertex turns one inside out
+    const double cubes_volume = static_cast<double>(mesh.tetrahedra.size() / 6) * std::pow(CUBE_SIZE, 3);
+    bool passed = TestUtils::report("volume of the cubes", std::abs(tetrahedral_mesh.getVolume() - cubes_volume) < 1e-12);
+    passed = checkLocation(tetrahedral_mesh, mesh, generator) && passed;
+    passed = checkWalks(tetrahedral_mesh, mesh, generator) && passed;
+    passed = checkFile(tetrahedral_mesh, mesh, generator) && passed;
+    passed = checkRemap(tetrahedral_mesh, mesh) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <random>
+
+// Rotates a voxel grid about its center and checks that each position of the computational domain looks up the voxel
+// of the unrotated grid it is rotated from, that positions within the bounding box of the rotated grid but outside of
+// the grid are background, and that the voxel does not change within the homogeneous and background distances. The
+// rotation is then undone, which must restore every lookup, and matrices which are not rotations must be rejected.
+
+const TestUtils::TestDirectory TEST_DIR("voxel_grid_rotation");
+const Eigen::Vector3i DIM_VOX(24, 16, 12); // a different length along each axis, so swapped axes are found
+const double SPACING = 0.25; // cm
+const Eigen::Vector3d ORIGIN(7, 6, 5); // cm
+const int N_POSITIONS = 20000;
+const int N_SAMPLES = 16; // positions checked along each homogeneous and background distance
+const double FACE_TOLERANCE = 1E-6; // cm, positions nearer to a face of a voxel are not checked
+const double DISTANCE_TOLERANCE = 1E-9; // cm
+
+// blocks of 8x8x8 voxels of materials 1, 2 and 5, which the octree stores as uniform nodes
+uint8_t getMaterialId(const Eigen::Vector3i& voxel_index) {
+    const std::vector<uint8_t> material_choices = {1, 2, 5};
+    Eigen::Vector3i block_index = voxel_index / 8;
+    return material_choices[(block_index[0] + 2 * block_index[1] + block_index[2]) % 3];
+}
+
+bool nearVoxelFace(const Eigen::Vector3d& voxel_grid_position) {
+    Eigen::Vector3d offsets = voxel_grid_position / SPACING;
+    return ((offsets.array() - offsets.array().round()).abs() < FACE_TOLERANCE / SPACING).any();
+}
+
+// position in the computational domain of a position in the voxel grid, rotated about the center of the grid
+Eigen::Vector3d toDomainPosition(const Eigen::Matrix3d& rotation, const Eigen::Vector3d& voxel_grid_position) {
+    const Eigen::Vector3d half_dim_space = DIM_VOX.cast<double>() * SPACING / 2;
+    return ORIGIN + half_dim_space + rotation * (voxel_grid_position - half_dim_space);
+}
+
+bool checkRotated(ComputationalDomain& comp_domain, const Eigen::Matrix3d& rotation, std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    std::normal_distribution<double> normal_dist(0.0, 1.0);
+    VoxelGrid& voxel_grid = comp_domain.getVoxelGridN(0);
+    const Eigen::Vector3d dim_space = DIM_VOX.cast<double>() * SPACING;
+    const Eigen::Vector3d half_dim_space = dim_space / 2;
+    const Eigen::AlignedBox3d grid_bounds(Eigen::Vector3d::Zero(), dim_space);
+    Eigen::AlignedBox3d rotated_bounds;
+    for (int corner = 0; corner < 8; ++corner) {
+        rotated_bounds.extend(toDomainPosition(rotation, grid_bounds.corner(static_cast<Eigen::AlignedBox3d::CornerType>(corner))));
+    }
+
+    bool voxels_passed = true;
+    bool outside_passed = true;
+    bool homogeneous_passed = true;
+    bool background_passed = true;
+    int num_outside = 0;
+    int num_homogeneous = 0;
+    for (int n = 0; n < N_POSITIONS; ++n) {
+        // positions within the bounding box of the rotated grid, some of which are outside of the grid
+        Eigen::Vector3d position = rotated_bounds.min() + Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); })
+                                                                  .cwiseProduct(rotated_bounds.sizes());
+        Eigen::Vector3d direction = Eigen::Vector3d::NullaryExpr([&]() { return normal_dist(generator); }).normalized();
+        Eigen::Vector3d voxel_grid_position = rotation.transpose() * (position - ORIGIN - half_dim_space) + half_dim_space;
+        if (nearVoxelFace(voxel_grid_position)) {
+            continue;
+        }
+        Voxel voxel = comp_domain.getVoxel(position);
+        Voxel homogeneous_voxel;
+        double homogeneous_distance = comp_domain.getHomogeneousDistance(position, direction, homogeneous_voxel);
+        double background_distance = comp_domain.getBackgroundDistance(position, direction);
+        if (!grid_bounds.contains(voxel_grid_position)) {
+            num_outside++;
+            outside_passed = outside_passed && TestUtils::sameRegion(voxel, comp_domain.background_voxel) && background_distance == 0;
+            continue;
+        }
+        Voxel expected_voxel = voxel_grid.getVoxelUnchecked(voxel_grid_position);
+        voxels_passed = voxels_passed && TestUtils::sameRegion(voxel, expected_voxel) && TestUtils::sameRegion(homogeneous_voxel, expected_voxel);
+
+        // the homogeneous distance is that of the unrotated grid along the direction rotated into it
+        Voxel unrotated_voxel;
+        double unrotated_distance = voxel_grid.getHomogeneousDistance(voxel_grid_position, rotation.transpose() * direction, unrotated_voxel);
+        homogeneous_passed = homogeneous_passed && std::abs(homogeneous_distance - unrotated_distance) < DISTANCE_TOLERANCE;
+        num_homogeneous += homogeneous_distance > 0 ? 1 : 0;
+        for (int s = 0; s < N_SAMPLES && homogeneous_distance > 0; ++s) {
+            double length = homogeneous_distance * (s + uniform_dist(generator)) / N_SAMPLES;
+            homogeneous_passed = homogeneous_passed && TestUtils::sameRegion(comp_domain.getVoxel(position + length * direction), expected_voxel);
+        }
+    }
+
+    // the background ends at the bounding box of the rotated grid
+    for (int n = 0; n < N_POSITIONS / 10; ++n) {
+        Eigen::Vector3d position = Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator) * 20; });
+        Eigen::Vector3d direction = Eigen::Vector3d::NullaryExpr([&]() { return normal_dist(generator); }).normalized();
+        double background_distance = comp_domain.getBackgroundDistance(position, direction);
+        background_passed = background_passed && (background_distance == 0 || !rotated_bounds.contains(position));
+        for (int s = 0; s < N_SAMPLES && background_distance > 0; ++s) {
+            double length = background_distance * (s + uniform_dist(generator)) / N_SAMPLES;
+            background_passed = background_passed && TestUtils::sameRegion(comp_domain.getVoxel(position + length * direction), comp_domain.background_voxel);
+        }
+    }
+    std::cout << "  " << num_outside << " positions in the bounding box but outside of the grid, " << num_homogeneous
+              << " in a uniform node" << std::endl;
+    bool passed = TestUtils::report("voxel of the unrotated grid", voxels_passed);
+    passed = TestUtils::report("background outside of the grid", outside_passed) && passed;
+    passed = TestUtils::report("homogeneous distance of the unrotated grid, and voxel unchanged within it", homogeneous_passed) && passed;
+    return TestUtils::report("background unchanged within the background distance", background_passed) && passed;
+}
+
+// records the voxel at random positions of the grid, looked up through the computational domain
+std::vector<std::pair<Eigen::Vector3d, Voxel>> lookUpUnrotated(ComputationalDomain& comp_domain, std::mt19937_64& generator) {
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    std::vector<std::pair<Eigen::Vector3d, Voxel>> lookups;
+    for (int n = 0; n < N_POSITIONS; ++n) {
+        Eigen::Vector3d position = ORIGIN + Eigen::Vector3d::NullaryExpr([&]() { return uniform_dist(generator); }).cwiseProduct(DIM_VOX.cast<double>() * SPACING);
+        lookups.emplace_back(position, comp_domain.getVoxel(position));
+    }
+    return lookups;
+}
+
+int main() {
+    std::mt19937_64 generator(20240428);
+    TestUtils::writeVoxelFile(TEST_DIR.file("phantom.mvox"), DIM_VOX, Eigen::Vector3d::Constant(SPACING), getMaterialId);
+    const Eigen::Matrix3d rotation = Eigen::AngleAxisd(37.0 * PI / 180.0, Eigen::Vector3d(1, 2, 3).normalized()).toRotationMatrix();
+    std::string json_file_path = TestUtils::writeFile(TEST_DIR.file("domain.json"), R"json({"dim_space": [20, 20, 20], "background_material_name": "Air, Dry (near sea level)",
+        "voxel_grids": [{"file_path": "phantom.mvox", "origin": [7, 6, 5], "octree": true}],
+        "primitives": [{"type": "box", "min": [0, 0, 0], "max": [2, 2, 2], "material_name": "Pb"}]})json");
+    std::string rotated_json_file_path = TestUtils::writeFile(TEST_DIR.file("rotated.json"), R"json({"dim_space": [20, 20, 20], "background_material_name": "Air, Dry (near sea level)",
+        "voxel_grids": [{"file_path": "phantom.mvox", "origin": [7, 6, 5], "octree": true, "rotation": {"axis": [1, 2, 3], "angle": 37}}]})json");
+
+    ComputationalDomain comp_domain(json_file_path);
+    std::vector<std::pair<Eigen::Vector3d, Voxel>> lookups = lookUpUnrotated(comp_domain, generator);
+
+    std::cout << "Rotated" << std::endl;
+    comp_domain.setVoxelGridRotationN(0, rotation);
+    bool passed = TestUtils::report("rotation set", comp_domain.getVoxelGridRotationN(0).isApprox(rotation));
+    ComputationalDomain rotated_domain(rotated_json_file_path);
+    passed = TestUtils::report("rotation of the JSON file", rotated_domain.getVoxelGridRotationN(0).isApprox(rotation, 1e-12)) && passed;
+    passed = checkRotated(comp_domain, rotation, generator) && passed;
+
+    std::cout << "Rotated back" << std::endl;
+    comp_domain.setVoxelGridRotationN(0, Eigen::Matrix3d::Identity());
+    bool restored = true;
+    for (const auto& lookup : lookups) {
+        Voxel voxel = comp_domain.getVoxel(lookup.first);
+        restored = restored && TestUtils::sameRegion(voxel, lookup.second) && voxel.voxel_number == lookup.second.voxel_number;
+    }
+    passed = TestUtils::report("every lookup restored", restored) && passed;
+
+    std::cout << "Invalid rotations" << std::endl;
+    Eigen::Matrix3d reflection = Eigen::Vector3d(1, 1, -1).asDiagonal();
+    bool rejected = TestUtils::throws([&]() { comp_domain.setVoxelGridRotationN(0, reflection); }) &&
+                    TestUtils::throws([&]() { comp_domain.setVoxelGridRotationN(0, 2 * rotation); }) &&
+                    TestUtils::throws([&]() { comp_domain.setVoxelGridRotationN(0, rotation + 0.01 * Eigen::Matrix3d::Ones()); });
+    passed = TestUtils::report("reflections and scaled matrices rejected, and the rotation kept",
+                               rejected && comp_domain.getVoxelGridRotationN(0).isIdentity(0.0)) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
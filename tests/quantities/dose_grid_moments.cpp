@@ -0,0 +1,62 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <random>
+
+// Scores energy deposits in a DoseGrid and checks the count, sum, mean and variance of each voxel, and of the voxels
+// merged into one MomentValue as VoxelGrid::getEnergyDepositedInMaterials does, against a two-pass reference in long
+// double. The deposits sit on a large offset, where a variance taken from a sum of squares cancels to noise.
+
+const int N_VOXELS = 64;
+const int N_DEPOSITS = 1000000;
+const double OFFSET = 1E8; // eV
+const double SPREAD = 1.0; // eV
+const double TOLERANCE = 1E-6; // relative
+
+double maxRelativeError(const MomentValue& value, const TestUtils::Moments& reference) {
+    if (value.getCount() != reference.count) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::max({TestUtils::relativeError(value.getSum(), reference.sum), TestUtils::relativeError(value.getMean(), reference.mean),
+                     TestUtils::relativeError(value.getVariance(), reference.variance)});
+}
+
+int main() {
+    std::mt19937_64 generator(20240428);
+    std::uniform_int_distribution<int> voxel_dist(0, N_VOXELS - 1);
+    std::normal_distribution<double> energy_dist(OFFSET, SPREAD);
+
+    DoseGrid dose_grid(N_VOXELS);
+    std::vector<std::vector<double>> voxel_deposits(N_VOXELS);
+    std::vector<double> deposits;
+    for (int i = 0; i < N_DEPOSITS; ++i) {
+        int voxel_number = voxel_dist(generator);
+        double energy = energy_dist(generator);
+        dose_grid.addValue(voxel_number, energy);
+        voxel_deposits[voxel_number].push_back(energy);
+        deposits.push_back(energy);
+    }
+
+    double max_voxel_error = 0;
+    MomentValue merged;
+    for (int voxel_number = 0; voxel_number < N_VOXELS; ++voxel_number) {
+        max_voxel_error = std::max(max_voxel_error, maxRelativeError(dose_grid.getValue(voxel_number), TestUtils::twoPassMoments(voxel_deposits[voxel_number])));
+        dose_grid.addTo(voxel_number, merged);
+    }
+    double merged_error = maxRelativeError(merged, TestUtils::twoPassMoments(deposits));
+
+    // an empty voxel adds nothing to a merge
+    DoseGrid empty_grid(1);
+    MomentValue unchanged = merged;
+    empty_grid.addTo(0, unchanged);
+    bool empty_passed = unchanged.getCount() == merged.getCount() && unchanged.getMean() == merged.getMean() &&
+                        unchanged.getVariance() == merged.getVariance();
+
+    bool passed = max_voxel_error < TOLERANCE && merged_error < TOLERANCE && empty_passed;
+
+    std::cout << "Deposits of " << OFFSET << " +- " << SPREAD << " eV in " << N_VOXELS << " voxels" << std::endl;
+    std::cout << "  Max relative error per voxel: " << max_voxel_error << std::endl;
+    std::cout << "  Max relative error of the merged voxels: " << merged_error << std::endl;
+    std::cout << "  Merging an empty voxel: " << (empty_passed ? "unchanged" : "changed") << std::endl;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
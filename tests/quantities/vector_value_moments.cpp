@@ -0,0 +1,89 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <random>
+
+// Adds values to VectorValues in chunks of random size, as the thread local tallies of a simulation do, merges them in
+// a random order with operator+, and checks the count, sum, mean, variance, minimum and maximum against a two-pass
+// reference in long double. Also checks that the values are only kept in a merge if both sides keep them.
+
+const int N_VALUES = 1000000;
+const int N_CHUNKS = 257;
+const double OFFSET = 1E6;
+const double SPREAD = 1E-3;
+const double TOLERANCE = 1E-6; // relative
+
+bool checkMerge(std::mt19937_64& generator) {
+    std::normal_distribution<double> value_dist(OFFSET, SPREAD);
+    std::vector<double> values(N_VALUES);
+    for (double& value : values) {
+        value = value_dist(generator);
+    }
+
+    // split at random boundaries, so chunks of one value and empty chunks are merged as well
+    std::uniform_int_distribution<int> boundary_dist(0, N_VALUES);
+    std::vector<int> boundaries = {0, N_VALUES};
+    for (int i = 0; i < N_CHUNKS - 1; ++i) {
+        boundaries.push_back(boundary_dist(generator));
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    std::vector<VectorValue> chunks;
+    for (size_t i = 0; i + 1 < boundaries.size(); ++i) {
+        VectorValue chunk;
+        for (int j = boundaries[i]; j < boundaries[i + 1]; ++j) {
+            chunk.addValue(values[j]);
+        }
+        chunks.push_back(chunk);
+    }
+    std::shuffle(chunks.begin(), chunks.end(), generator);
+    VectorValue merged;
+    for (const auto& chunk : chunks) {
+        merged = merged + chunk;
+    }
+
+    TestUtils::Moments reference = TestUtils::twoPassMoments(values);
+    double sum_error = TestUtils::relativeError(merged.getSum(), reference.sum);
+    double mean_error = TestUtils::relativeError(merged.getMean(), reference.mean);
+    double variance_error = TestUtils::relativeError(merged.getVariance(), reference.variance);
+    bool extremes_passed = merged.getMin() == *std::min_element(values.begin(), values.end()) &&
+                           merged.getMax() == *std::max_element(values.begin(), values.end());
+    bool passed = merged.getCount() == N_VALUES && sum_error < TOLERANCE && mean_error < TOLERANCE &&
+                  variance_error < TOLERANCE && extremes_passed;
+
+    std::cout << N_VALUES << " values of " << OFFSET << " +- " << SPREAD << " merged from " << chunks.size() << " chunks" << std::endl;
+    std::cout << "  Relative error of the sum: " << sum_error << std::endl;
+    std::cout << "  Relative error of the mean: " << mean_error << std::endl;
+    std::cout << "  Relative error of the variance: " << variance_error << std::endl;
+    std::cout << "  Min and max: " << (extremes_passed ? "match" : "differ") << std::endl;
+    std::cout << "  " << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed;
+}
+
+bool checkRetention() {
+    VectorValue retained(true);
+    retained.addValues({1.0, 2.0});
+    VectorValue other_retained(true);
+    other_retained.addValue(3.0);
+    VectorValue not_retained;
+    not_retained.addValue(4.0);
+
+    VectorValue both = retained + other_retained;
+    VectorValue one = retained + not_retained;
+    bool both_passed = both.isRetainingValues() && both.getVector() == std::vector<double>({1.0, 2.0, 3.0});
+    bool one_passed = !one.isRetainingValues() && one.getCount() == 3;
+    bool throws = TestUtils::throws([&]() { not_retained.getVector(); });
+    bool passed = both_passed && one_passed && throws;
+
+    std::cout << "Retention" << std::endl;
+    std::cout << "  Both retaining: " << (both_passed ? "values kept" : "values lost") << std::endl;
+    std::cout << "  One retaining: " << (one_passed ? "values dropped" : "values kept") << std::endl;
+    std::cout << "  getVector without retention: " << (throws ? "throws" : "does not throw") << std::endl;
+    std::cout << "  " << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed;
+}
+
+int main() {
+    std::mt19937_64 generator(20240428);
+    bool passed = checkMerge(generator);
+    passed = checkRetention() && passed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+
+// Runs a batch of phantoms, each a 1 cm slab of a different material in a pencil beam, and checks that the results
+// are processed in the order of the batch and that each case is transported through its own phantom: the primary
+// transmission of each case must agree with that of a separate runSimulation of the same phantom. Also checks that a
+// phantom which cannot be loaded throws when its case is reached, after the cases before it are processed.
+
+const TestUtils::TestDirectory TEST_DIR("batch_prefetch");
+const int N_PHOTONS = 20000;
+const double Z_SCORE_LIMIT = 5.0;
+
+std::string writePhantom(const std::string& material_name) {
+    return TestUtils::writeFile(TEST_DIR.file(material_name.substr(0, material_name.find(',')) + ".json"),
+            R"json({"dim_space": [10, 10, 20], "background_material_name": "Air, Dry (near sea level)", "primitives": [)json"
+            R"json({"type": "box", "min": [0, 0, 5], "max": [10, 10, 6], "material_name": ")json" + material_name + R"json("}]})json");
+}
+
+PhotonSource initializeSource() {
+    std::unique_ptr<EnergySpectrum> spectrum = std::make_unique<MonoenergeticSpectrum>(MonoenergeticSpectrum(60E3));
+    std::unique_ptr<Directionality> directionality = std::make_unique<BeamDirectionality>(BeamDirectionality(Eigen::Vector3d(5, 5, 10)));
+    std::unique_ptr<SourceGeometry> geometry = std::make_unique<PointGeometry>(PointGeometry(Eigen::Vector3d(5, 5, 0)));
+    return {std::move(spectrum), std::move(directionality), std::move(geometry)};
+}
+
+std::vector<std::unique_ptr<SurfaceTally>> initializeSurfaceTallies() {
+    std::vector<std::unique_ptr<SurfaceTally>> tallies;
+    tallies.emplace_back(std::make_unique<DiscSurfaceTally>(Eigen::Vector3d(5, 5, 19), Eigen::Vector3d(0, 0, 1), 0.5,
+                                                            SurfaceQuantityContainerFactory::AllQuantities()));
+    return tallies;
+}
+
+std::vector<std::unique_ptr<VolumeTally>> initializeVolumeTallies() {
+    return {};
+}
+
+double getPrimaryTransmission(PhysicsEngine& physics_engine) {
+    auto quantity_container = physics_engine.getSurfaceQuantityContainers().at(0);
+    auto& count = quantity_container.getCountQuantities().at(CountSurfaceQuantityType::NumberOfPhotons);
+    return static_cast<double>(count.getPrimaryValues().getCount()) / N_PHOTONS;
+}
+
+bool checkBatch(const std::vector<std::string>& json_file_paths) {
+    std::cout << "Batch" << std::endl;
+    PhotonSource source = initializeSource();
+
+    // each phantom on its own, as the reference
+    std::vector<double> reference_transmissions;
+    for (const auto& json_file_path : json_file_paths) {
+        ComputationalDomain comp_domain(json_file_path);
+        InteractionData interaction_data = comp_domain.getInteractionData();
+        PhysicsEngine physics_engine(comp_domain, interaction_data);
+        runSimulation(source, physics_engine, initializeSurfaceTallies, initializeVolumeTallies, N_PHOTONS);
+        reference_transmissions.push_back(getPrimaryTransmission(physics_engine));
+    }
+
+    std::vector<std::string> processed_paths;
+    std::vector<double> transmissions;
+    BatchTimings case_timings;
+    BatchTimings timings = runBatchSimulation(json_file_paths, source, initializeSurfaceTallies, initializeVolumeTallies, N_PHOTONS,
+                                              [&](BatchCase& batch_case, PhysicsEngine& physics_engine) {
+        processed_paths.push_back(batch_case.json_file_path);
+        transmissions.push_back(getPrimaryTransmission(physics_engine));
+        case_timings.total_load_time += batch_case.load_time;
+        case_timings.total_wait_time += batch_case.wait_time;
+        case_timings.total_run_time += batch_case.run_time;
+    });
+
+    bool passed = TestUtils::report("cases processed in order", processed_paths == json_file_paths);
+    bool transmissions_passed = transmissions.size() == reference_transmissions.size();
+    for (size_t i = 0; transmissions_passed && i < transmissions.size(); ++i) {
+        double p = (transmissions[i] + reference_transmissions[i]) / 2;
+        double sigma = std::sqrt(2 * p * (1 - p) / N_PHOTONS);
+        double difference = std::abs(transmissions[i] - reference_transmissions[i]);
+        std::cout << "    " << processed_paths[i] << ": transmission " << transmissions[i] << " (alone "
+                  << reference_transmissions[i] << ")" << std::endl;
+        transmissions_passed = sigma > 0 ? difference < Z_SCORE_LIMIT * sigma : difference == 0;
+    }
+    passed = TestUtils::report("each case transported through its own phantom", transmissions_passed) && passed;
+    passed = TestUtils::report("timings summed over the cases", timings.total_load_time == case_timings.total_load_time &&
+                               timings.total_wait_time == case_timings.total_wait_time && timings.total_run_time == case_timings.total_run_time &&
+                               timings.wall_time >= timings.total_run_time && timings.getOverlapFraction() >= 0 &&
+                               timings.getOverlapFraction() <= 1) && passed;
+    return passed;
+}
+
+bool checkLoadError(const std::vector<std::string>& json_file_paths) {
+    std::cout << "Load error" << std::endl;
+    PhotonSource source = initializeSource();
+    std::vector<std::string> batch = {json_file_paths[0], json_file_paths[1], TEST_DIR.file("missing.json"), json_file_paths[2]};
+    std::vector<std::string> processed_paths;
+    bool passed = TestUtils::report("missing phantom throws", TestUtils::throws([&]() {
+        runBatchSimulation(batch, source, initializeSurfaceTallies, initializeVolumeTallies, N_PHOTONS / 10,
+                           [&](BatchCase& batch_case, PhysicsEngine&) { processed_paths.push_back(batch_case.json_file_path); });
+    }));
+    passed = TestUtils::report("cases before it processed, and none after", processed_paths == std::vector<std::string>(batch.begin(), batch.begin() + 2)) && passed;
+
+    processed_paths.clear();
+    BatchTimings timings = runBatchSimulation({}, source, initializeSurfaceTallies, initializeVolumeTallies, N_PHOTONS,
+                                              [&](BatchCase& batch_case, PhysicsEngine&) { processed_paths.push_back(batch_case.json_file_path); });
+    return TestUtils::report("empty batch", processed_paths.empty() && timings.total_run_time == 0) && passed;
+}
+
+int main() {
+    std::vector<std::string> json_file_paths;
+    for (const std::string material_name : {"Water, Liquid", "Pb", "Al", "Tissue, Soft"}) {
+        json_file_paths.push_back(writePhantom(material_name));
+    }
+    bool passed = checkBatch(json_file_paths);
+    passed = checkLoadError(json_file_paths) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+
+// Transports the same scene in three forms and checks that the surface tallies agree statistically:
+//   - boxes, a slab and a tetrahedral mesh in air, crossed with background and region steps
+//   - a voxel grid over the whole computational domain, which is transported with plain delta tracking, as every
+//     position is within the bounding box of the voxel grid
+//   - the same voxel grid with an octree, crossed with region steps through its uniform nodes
+// The bodies are aligned to the voxels, so the voxel grid is the same geometry. One of them ends at the boundary of
+// the computational domain. The energy deposited in each material is compared between the two voxel grids as well.
+
+const TestUtils::TestDirectory TEST_DIR("region_steps");
+const int N_PHOTONS = 200000;
+const double Z_SCORE_LIMIT = 5.0;
+const Eigen::Vector3d DIM_SPACE(10, 10, 20); // cm
+const double SPACING = 0.25; // cm
+const std::string BACKGROUND = R"json("dim_space": [10, 10, 20], "background_material_name": "Air, Dry (near sea level)")json";
+
+struct Body {
+    Eigen::AlignedBox3d box;
+    int material_id;
+};
+
+// Al box, Al cube (the mesh), water slab over the whole width of the domain, and soft tissue up to the top face
+const std::vector<Body> BODIES = {
+        {Eigen::AlignedBox3d(Eigen::Vector3d(2, 2, 4), Eigen::Vector3d(5, 6, 5)), 2},
+        {Eigen::AlignedBox3d(Eigen::Vector3d(6, 3, 8), Eigen::Vector3d(8, 5, 10)), 2},
+        {Eigen::AlignedBox3d(Eigen::Vector3d(0, 0, 14), Eigen::Vector3d(10, 10, 15)), 1},
+        {Eigen::AlignedBox3d(Eigen::Vector3d(1, 1, 17), Eigen::Vector3d(9, 9, 20)), 5},
+};
+
+// the material of the body containing the center of the voxel, or air
+uint8_t getMaterialId(const Eigen::Vector3i& voxel_index) {
+    Eigen::Vector3d center = TestUtils::voxelCenter(voxel_index, Eigen::Vector3d::Constant(SPACING));
+    uint8_t material_id = 3; // air
+    for (const auto& body : BODIES) {
+        if (body.box.contains(center)) {
+            material_id = static_cast<uint8_t>(body.material_id);
+        }
+    }
+    return material_id;
+}
+
+PhotonSource initializeSource() {
+    std::unique_ptr<EnergySpectrum> spectrum = std::make_unique<MonoenergeticSpectrum>(MonoenergeticSpectrum(60E3));
+    std::unique_ptr<Directionality> directionality = std::make_unique<DiscIsotropicDirectionality>(
+            DiscIsotropicDirectionality(Eigen::Vector3d(5, 5, 20), Eigen::Vector3d(0, 0, 1), 5.0));
+    std::unique_ptr<SourceGeometry> geometry = std::make_unique<PointGeometry>(PointGeometry(Eigen::Vector3d(5, 5, 0)));
+    return {std::move(spectrum), std::move(directionality), std::move(geometry)};
+}
+
+std::vector<std::unique_ptr<SurfaceTally>> initializeSurfaceTallies() {
+    std::vector<std::unique_ptr<SurfaceTally>> tallies;
+    // between the Al bodies and the slab, and between the slab and the soft tissue
+    tallies.emplace_back(std::make_unique<DiscSurfaceTally>(Eigen::Vector3d(5, 5, 12), Eigen::Vector3d(0, 0, 1), 4.0,
+                                                            SurfaceQuantityContainerFactory::AllQuantities()));
+    tallies.emplace_back(std::make_unique<DiscSurfaceTally>(Eigen::Vector3d(5, 5, 16), Eigen::Vector3d(0, 0, 1), 4.0,
+                                                            SurfaceQuantityContainerFactory::AllQuantities()));
+    return tallies;
+}
+
+std::vector<std::unique_ptr<VolumeTally>> initializeVolumeTallies() {
+    return {};
+}
+
+struct Counts {
+    std::vector<std::array<double, 4>> tallies; // primary, single incoherent, single coherent and multiple scatter
+    std::unordered_map<int, MomentValue> energies; // energy deposited in each material of the voxel grid
+};
+
+Counts runScene(const std::string& json_file_path) {
+    ComputationalDomain comp_domain(json_file_path);
+    InteractionData interaction_data = comp_domain.getInteractionData();
+    PhysicsEngine physics_engine(comp_domain, interaction_data);
+    PhotonSource source = initializeSource();
+    runSimulation(source, physics_engine, initializeSurfaceTallies, initializeVolumeTallies, N_PHOTONS);
+
+    Counts counts;
+    for (auto& quantity_container : physics_engine.getSurfaceQuantityContainers()) {
+        auto& count = quantity_container.getCountQuantities().at(CountSurfaceQuantityType::NumberOfPhotons);
+        counts.tallies.push_back({static_cast<double>(count.getPrimaryValues().getCount()),
+                                  static_cast<double>(count.getSingleIncoherentScatterValues().getCount()),
+                                  static_cast<double>(count.getSingleCoherentScatterValues().getCount()),
+                                  static_cast<double>(count.getMultipleScatterValues().getCount())});
+    }
+    if (comp_domain.getNumVoxelGrids() > 0) {
+        counts.energies = comp_domain.getVoxelGridN(0).getEnergyDepositedInMaterials();
+    }
+    return counts;
+}
+
+bool compareTallies(const std::string& name, const Counts& counts, const Counts& reference) {
+    const std::array<std::string, 4> types = {"primary", "single incoherent", "single coherent", "multiple scatter"};
+    bool passed = true;
+    std::cout << name << std::endl;
+    for (size_t t = 0; t < reference.tallies.size(); ++t) {
+        for (size_t i = 0; i < types.size(); ++i) {
+            // difference of two Poisson counts
+            double a = counts.tallies[t][i];
+            double b = reference.tallies[t][i];
+            double z = (a + b) > 0 ? std::abs(a - b) / std::sqrt(a + b) : 0.0;
+            std::cout << "  tally " << t << " " << types[i] << ": " << a << " (plain " << b << ", z = " << z << ")" << std::endl;
+            passed = passed && z < Z_SCORE_LIMIT;
+        }
+    }
+    return passed;
+}
+
+bool compareEnergies(const Counts& counts, const Counts& reference) {
+    bool passed = counts.energies.size() == reference.energies.size();
+    std::cout << "Energy deposited in each material, octree" << std::endl;
+    for (const auto& energy : reference.energies) {
+        const MomentValue& value = counts.energies.at(energy.first);
+        double sigma = std::hypot(value.getSumSTD(), energy.second.getSumSTD());
+        double z = sigma > 0 ? std::abs(value.getSum() - energy.second.getSum()) / sigma : 0.0;
+        std::cout << "  material " << energy.first << ": " << value.getSum() / N_PHOTONS << " eV per photon (plain "
+                  << energy.second.getSum() / N_PHOTONS << ", z = " << z << ")" << std::endl;
+        passed = passed && z < Z_SCORE_LIMIT;
+    }
+    return passed;
+}
+
+int main() {
+    // the cube of BODIES[1], relative to its lower corner
+    TestUtils::writeCubeMesh(TEST_DIR.file("cube.mesh"), 2, 2);
+    TestUtils::writeVoxelFile(TEST_DIR.file("scene.mvox"), (DIM_SPACE / SPACING).array().round().cast<int>(),
+                              Eigen::Vector3d::Constant(SPACING), getMaterialId);
+    std::string bodies_json = TestUtils::writeFile(TEST_DIR.file("bodies.json"), "{" + BACKGROUND + R"json(,
+        "primitives": [
+            {"type": "box", "min": [2, 2, 4], "max": [5, 6, 5], "material_name": "Al"},
+            {"type": "slab", "normal": [0, 0, 1], "offset": 14, "thickness": 1, "material_name": "Water, Liquid"},
+            {"type": "box", "min": [1, 1, 17], "max": [9, 9, 20], "material_name": "Tissue, Soft"}],
+        "tetrahedral_meshes": [{"file_path": "cube.mesh", "origin": [6, 3, 8]}]})json");
+    std::string voxels_json = TestUtils::writeFile(TEST_DIR.file("voxels.json"), "{" + BACKGROUND + R"json(,
+        "voxel_grids": [{"file_path": "scene.mvox", "origin": [0, 0, 0], "score_dose": true}]})json");
+    std::string octree_json = TestUtils::writeFile(TEST_DIR.file("octree.json"), "{" + BACKGROUND + R"json(,
+        "voxel_grids": [{"file_path": "scene.mvox", "origin": [0, 0, 0], "score_dose": true, "octree": true}]})json");
+
+    Counts plain = runScene(voxels_json);
+    Counts bodies = runScene(bodies_json);
+    Counts octree = runScene(octree_json);
+    bool passed = compareTallies("Bodies with background and region steps", bodies, plain);
+    passed = compareTallies("Voxel grid with an octree", octree, plain) && passed;
+    passed = compareEnergies(octree, plain) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
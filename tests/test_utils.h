@@ -0,0 +1,269 @@
+#ifndef MCXRAYTRANSPORT_TEST_UTILS_H
+#define MCXRAYTRANSPORT_TEST_UTILS_H
+
+#include <MIDSX/Core.h>
+#include <zlib.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+
+/**
+ * @brief Helpers shared by the test executables.
+ *
+ * Each test prints one line per check through report, and returns 0 from main if every check passed.
+ */
+namespace TestUtils {
+
+    /**
+     * @brief Class which owns a directory for the files written by a test.
+     *
+     * The directory is created in the temporary directory of the system, and removed with everything in it when the
+     * TestDirectory is destroyed.
+     */
+    class TestDirectory {
+    public:
+        /**
+         * @brief Constructor for the TestDirectory class.
+         *
+         * @param test_name The name of the test, which names the directory.
+         */
+        explicit TestDirectory(const std::string& test_name) :
+                path_(std::filesystem::temp_directory_path() / ("midsx_" + test_name)) {
+            std::filesystem::create_directories(path_);
+        }
+
+        ~TestDirectory() {
+            std::error_code error;
+            std::filesystem::remove_all(path_, error);
+        }
+
+        TestDirectory(const TestDirectory&) = delete;
+        TestDirectory& operator=(const TestDirectory&) = delete;
+
+        /**
+         * @brief Returns the path of a file in the directory.
+         *
+         * @param name The name of the file.
+         * @return The path of the file.
+         */
+        std::string file(const std::string& name) const { return (path_ / name).string(); }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+    inline bool report(const std::string& name, bool passed) {
+        std::cout << "  " << name << ": " << (passed ? "PASSED" : "FAILED") << std::endl;
+        return passed;
+    }
+
+    template <typename Exception = std::runtime_error>
+    bool throws(const std::function<void()>& f) {
+        try {
+            f();
+        } catch (const Exception&) {
+            return true;
+        }
+        return false;
+    }
+
+    inline std::string writeFile(const std::string& filename, const std::string& contents) {
+        std::ofstream(filename) << contents;
+        return filename;
+    }
+
+    // Wilson-Hilferty approximation of the chi-square distribution. Returns the equivalent standard normal z-score
+    inline double chiSquareZScore(double chi_square, int dof) {
+        double a = 2.0 / (9.0 * dof);
+        return (std::cbrt(chi_square / dof) - (1 - a)) / std::sqrt(a);
+    }
+
+    struct ChiSquareResult {
+        double chi_square;
+        int dof;
+        double z_score;
+
+        bool passed() const { return z_score < 3.09; } // p > 0.001
+    };
+
+    // Pearson's chi-square test of observed counts against expected counts. Bins with less than 5 expected counts are
+    // pooled into one bin
+    inline ChiSquareResult chiSquareTest(const std::vector<double>& expected, const std::vector<double>& observed) {
+        double chi_square = 0;
+        double pooled_expected = 0;
+        double pooled_observed = 0;
+        int num_bins = 0;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i] < 5) {
+                pooled_expected += expected[i];
+                pooled_observed += observed[i];
+                continue;
+            }
+            chi_square += (observed[i] - expected[i]) * (observed[i] - expected[i]) / expected[i];
+            num_bins++;
+        }
+        if (pooled_expected > 0) {
+            chi_square += (pooled_observed - pooled_expected) * (pooled_observed - pooled_expected) / pooled_expected;
+            num_bins++;
+        }
+        int dof = num_bins - 1;
+        return {chi_square, dof, chiSquareZScore(chi_square, dof)};
+    }
+
+    inline std::ostream& operator<<(std::ostream& os, const ChiSquareResult& result) {
+        return os << "Chi-square: " << result.chi_square << " (dof = " << result.dof << ", z = " << result.z_score << ") "
+                  << (result.passed() ? "PASSED" : "FAILED");
+    }
+
+    inline double relativeError(double value, long double reference) {
+        return static_cast<double>(std::abs((value - reference) / reference));
+    }
+
+    struct Moments {
+        long count = 0;
+        long double sum = 0;
+        long double mean = 0;
+        long double variance = 0;
+    };
+
+    // count, sum, mean and sample variance in long double, with the variance taken from the deviations from the mean
+    inline Moments twoPassMoments(const std::vector<double>& values) {
+        Moments moments;
+        moments.count = static_cast<long>(values.size());
+        for (double value : values) {
+            moments.sum += value;
+        }
+        moments.mean = moments.sum / moments.count;
+        long double sum_of_squared_deviations = 0;
+        for (double value : values) {
+            sum_of_squared_deviations += (value - moments.mean) * (value - moments.mean);
+        }
+        moments.variance = sum_of_squared_deviations / (moments.count - 1);
+        return moments;
+    }
+
+    // voxel number of a voxel index, with x varying fastest, as voxel files and NIfTI images store them
+    inline int linearNumber(const Eigen::Vector3i& voxel_index, const Eigen::Vector3i& dim_vox) {
+        return voxel_index[0] + voxel_index[1] * dim_vox[0] + voxel_index[2] * dim_vox[0] * dim_vox[1];
+    }
+
+    // center of a voxel, relative to the origin of its voxel grid
+    inline Eigen::Vector3d voxelCenter(const Eigen::Vector3i& voxel_index, const Eigen::Vector3d& spacing) {
+        return (voxel_index.cast<double>() + Eigen::Vector3d::Constant(0.5)).cwiseProduct(spacing);
+    }
+
+    // calls f with the index of every voxel, in the order of linearNumber
+    inline void forEachVoxel(const Eigen::Vector3i& dim_vox, const std::function<void(const Eigen::Vector3i&)>& f) {
+        for (int k = 0; k < dim_vox[2]; ++k) {
+            for (int j = 0; j < dim_vox[1]; ++j) {
+                for (int i = 0; i < dim_vox[0]; ++i) {
+                    f(Eigen::Vector3i(i, j, k));
+                }
+            }
+        }
+    }
+
+    // the value of every voxel, in the order of linearNumber
+    template <typename T>
+    std::vector<T> makeVoxels(const Eigen::Vector3i& dim_vox, const std::function<T(const Eigen::Vector3i&)>& value) {
+        std::vector<T> values;
+        values.reserve(dim_vox.prod());
+        forEachVoxel(dim_vox, [&](const Eigen::Vector3i& voxel_index) { values.push_back(value(voxel_index)); });
+        return values;
+    }
+
+    /**
+     * @brief Writes a gzip compressed NIfTI-1 image of uint8 labels or float32 values, with the spacing in mm.
+     *
+     * @param filename The path of the image (.nii.gz).
+     * @param dim_vox The dimensions of the image in voxels.
+     * @param spacing The size of the voxels (cm).
+     * @param values The value of each voxel, in the order of linearNumber.
+     * @return The path of the image.
+     */
+    template <typename T>
+    std::string writeNIfTI(const std::string& filename, const Eigen::Vector3i& dim_vox, const Eigen::Vector3d& spacing,
+                           const std::vector<T>& values) {
+        static_assert(std::is_same<T, uint8_t>::value || std::is_same<T, float>::value, "Labels are uint8 and values float32");
+        std::vector<char> header(352, 0);
+        auto put = [&header](size_t offset, auto value) { std::memcpy(header.data() + offset, &value, sizeof(value)); };
+        put(0, int32_t(348));
+        put(40, int16_t(3));
+        for (int i = 0; i < 3; ++i) {
+            put(42 + 2 * i, static_cast<int16_t>(dim_vox[i]));
+            put(80 + 4 * i, static_cast<float>(spacing[i] * 10));
+        }
+        put(70, int16_t(std::is_same<T, uint8_t>::value ? 2 : 16));
+        put(72, int16_t(8 * sizeof(T)));
+        put(108, 352.0f);
+        header[123] = 2; // mm
+        std::memcpy(header.data() + 344, "n+1\0", 4);
+        gzFile file = gzopen(filename.c_str(), "wb");
+        gzwrite(file, header.data(), static_cast<unsigned>(header.size()));
+        gzwrite(file, values.data(), static_cast<unsigned>(values.size() * sizeof(T)));
+        gzclose(file);
+        return filename;
+    }
+
+    /**
+     * @brief Writes a voxel file of the material ID of each voxel.
+     *
+     * @param filename The path of the voxel file (.mvox).
+     * @param dim_vox The dimensions of the voxel grid in voxels.
+     * @param spacing The size of the voxels (cm).
+     * @param material_id The database material ID of the voxel at a voxel index.
+     * @return The material ID of each voxel, in the order of linearNumber.
+     */
+    inline std::vector<uint8_t> writeVoxelFile(const std::string& filename, const Eigen::Vector3i& dim_vox, const Eigen::Vector3d& spacing,
+                                               const std::function<uint8_t(const Eigen::Vector3i&)>& material_id) {
+        std::vector<uint8_t> materials = makeVoxels(dim_vox, material_id);
+        VoxelFile::write(filename, dim_vox, spacing, materials.data());
+        return materials;
+    }
+
+    /**
+     * @brief Writes a mesh file of a cube split into six tetrahedra around its diagonal from its lower corner.
+     *
+     * @param filename The path of the mesh file.
+     * @param size The length of the edges of the cube (cm).
+     * @param material_id The database material ID of the cube.
+     * @return The path of the mesh file.
+     */
+    inline std::string writeCubeMesh(const std::string& filename, double size, int material_id) {
+        std::ostringstream mesh;
+        mesh << "vertices 8\n";
+        for (int v = 0; v < 8; ++v) {
+            mesh << size * (v & 1) << " " << size * ((v >> 1) & 1) << " " << size * ((v >> 2) & 1) << "\n";
+        }
+        mesh << "tetrahedra 6\n";
+        for (const auto& vertices : {"0 1 3 7", "0 1 5 7", "0 2 3 7", "0 2 6 7", "0 4 5 7", "0 4 6 7"}) {
+            mesh << vertices << " " << material_id << "\n";
+        }
+        return writeFile(filename, mesh.str());
+    }
+
+    // lengths along the ray at which it enters and exits the box. The ray misses the box if entering > exiting
+    inline std::pair<double, double> getRayBoxLengths(const Eigen::AlignedBox3d& box, const Eigen::Vector3d& position,
+                                                      const Eigen::Vector3d& direction) {
+        double entering = -INF;
+        double exiting = INF;
+        for (int i = 0; i < 3; ++i) {
+            double first = (box.min()[i] - position[i]) / direction[i];
+            double second = (box.max()[i] - position[i]) / direction[i];
+            entering = std::max(entering, std::min(first, second));
+            exiting = std::min(exiting, std::max(first, second));
+        }
+        return {entering, exiting};
+    }
+
+    // true if the voxels are of the same material and density, i.e. of the same homogeneous region
+    inline bool sameRegion(const Voxel& a, const Voxel& b) {
+        return a.materialID == b.materialID && a.density_scale == b.density_scale;
+    }
+}
+
+#endif //MCXRAYTRANSPORT_TEST_UTILS_H
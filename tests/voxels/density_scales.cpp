@@ -0,0 +1,152 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <limits>
+
+// Loads a voxel grid with a density file whose densities differ from voxel to voxel, and checks the density scale
+// factor of every voxel, the largest scale factor of each material, and that the majorant of the interaction data is
+// at least the scaled total cross section of every voxel at every energy. Then transports a pencil beam through a slab
+// whose layers have different densities, and checks its primary transmission against the attenuation of the nominal
+// cross section scaled by the density of each layer. Also checks that density files with invalid densities throw.
+
+const TestUtils::TestDirectory TEST_DIR("density_scales");
+const Eigen::Vector3i DIM_VOX(12, 9, 10);
+const Eigen::Vector3d SPACING(0.2, 0.3, 0.25); // cm
+const double RELATIVE_TOLERANCE = 1E-6; // densities are stored as float32
+const std::string BACKGROUND = R"json("dim_space": [5, 5, 5], "background_material_name": "Air, Dry (near sea level)")json";
+
+// 1 cm cube of Al in layers along z, each at its own multiple of the nominal density, in the beam from z = 0 to the
+// tally at z = 4.5
+const Eigen::Vector3i SLAB_DIM_VOX(4, 4, 4);
+const Eigen::Vector3d SLAB_SPACING(0.25, 0.25, 0.25); // cm
+const std::vector<double> LAYER_DENSITY_SCALES = {0.5, 1.0, 1.5, 2.0};
+const uint8_t SLAB_MATERIAL_ID = 2; // Al
+const double BEAM_ENERGY = 60E3; // eV
+const double TALLY_Z = 4.5; // cm
+const int N_PHOTONS = 20000;
+const double Z_SCORE_LIMIT = 5.0;
+
+// slabs of the database materials 1, 2 and 5 along x
+uint8_t getMaterialId(const Eigen::Vector3i& voxel_index) {
+    return voxel_index[0] < 4 ? 1 : voxel_index[0] < 8 ? 2 : 5;
+}
+
+// from half to twice the nominal density of the material, varying along y and z, so each material has many densities
+float getDensity(const Eigen::Vector3i& voxel_index) {
+    double nominal_density = ElementDatabase::getInstance().getMaterialDensity(getMaterialId(voxel_index));
+    return static_cast<float>(nominal_density * (0.5 + 1.5 * (voxel_index[1] * DIM_VOX[2] + voxel_index[2]) / (DIM_VOX[1] * DIM_VOX[2] - 1)));
+}
+
+std::vector<double> getEnergies() {
+    std::vector<double> energies;
+    for (int i = 0; i <= 400; ++i) {
+        energies.push_back(1E3 * std::pow(150.0, i / 400.0)); // 1 to 150 keV
+    }
+    return energies;
+}
+
+PhotonSource initializeSource() {
+    std::unique_ptr<EnergySpectrum> spectrum = std::make_unique<MonoenergeticSpectrum>(MonoenergeticSpectrum(BEAM_ENERGY));
+    std::unique_ptr<Directionality> directionality = std::make_unique<BeamDirectionality>(BeamDirectionality(Eigen::Vector3d(2, 2, 5)));
+    std::unique_ptr<SourceGeometry> geometry = std::make_unique<PointGeometry>(PointGeometry(Eigen::Vector3d(2, 2, 0)));
+    return {std::move(spectrum), std::move(directionality), std::move(geometry)};
+}
+
+std::vector<std::unique_ptr<SurfaceTally>> initializeSurfaceTallies() {
+    std::vector<std::unique_ptr<SurfaceTally>> tallies;
+    tallies.emplace_back(std::make_unique<DiscSurfaceTally>(Eigen::Vector3d(2, 2, TALLY_Z), Eigen::Vector3d(0, 0, 1), 0.3,
+                                                            SurfaceQuantityContainerFactory::AllQuantities()));
+    return tallies;
+}
+
+std::vector<std::unique_ptr<VolumeTally>> initializeVolumeTallies() {
+    return {};
+}
+
+bool checkTransmission() {
+    const double nominal_density = ElementDatabase::getInstance().getMaterialDensity(SLAB_MATERIAL_ID);
+    TestUtils::writeNIfTI(TEST_DIR.file("slab.nii.gz"), SLAB_DIM_VOX, SLAB_SPACING,
+                          TestUtils::makeVoxels<uint8_t>(SLAB_DIM_VOX, [](const Eigen::Vector3i&) { return SLAB_MATERIAL_ID; }));
+    TestUtils::writeNIfTI(TEST_DIR.file("slab_densities.nii.gz"), SLAB_DIM_VOX, SLAB_SPACING,
+                          TestUtils::makeVoxels<float>(SLAB_DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        return static_cast<float>(nominal_density * LAYER_DENSITY_SCALES[voxel_index[2]]);
+    }));
+    std::string json_filename = TestUtils::writeFile(TEST_DIR.file("slab.json"), "{" + BACKGROUND + R"json(,
+        "voxel_grids": [{"file_path": "slab.nii.gz", "density_file_path": "slab_densities.nii.gz", "origin": [1, 1, 1]}]})json");
+    ComputationalDomain comp_domain(json_filename);
+    InteractionData interaction_data = comp_domain.getInteractionData();
+    PhysicsEngine physics_engine(comp_domain, interaction_data);
+    PhotonSource source = initializeSource();
+    runSimulation(source, physics_engine, initializeSurfaceTallies, initializeVolumeTallies, N_PHOTONS);
+    auto quantity_container = physics_engine.getSurfaceQuantityContainers().at(0);
+    auto& count = quantity_container.getCountQuantities().at(CountSurfaceQuantityType::NumberOfPhotons);
+    double transmission = static_cast<double>(count.getPrimaryValues().getCount()) / N_PHOTONS;
+
+    // optical depth of each layer at its density, and of the air on the rest of the path
+    double slab_cross_section = interaction_data.getMaterialFromId(SLAB_MATERIAL_ID).getData().interpolateTotalCrossSection(BEAM_ENERGY);
+    int air_id = interaction_data.getAnyMaterialIdFromName("Air, Dry (near sea level)");
+    double air_cross_section = interaction_data.getMaterialFromId(air_id).getData().interpolateTotalCrossSection(BEAM_ENERGY);
+    double optical_depth = air_cross_section * (TALLY_Z - SLAB_DIM_VOX[2] * SLAB_SPACING[2]);
+    for (double density_scale : LAYER_DENSITY_SCALES) {
+        optical_depth += density_scale * slab_cross_section * SLAB_SPACING[2];
+    }
+    double expected_transmission = std::exp(-optical_depth);
+    double sigma = std::sqrt(expected_transmission * (1 - expected_transmission) / N_PHOTONS);
+    std::cout << "  Primary transmission: " << transmission << " (expected " << expected_transmission << ")" << std::endl;
+    return TestUtils::report("primary transmission through layers of scaled density",
+                             std::abs(transmission - expected_transmission) < Z_SCORE_LIMIT * sigma);
+}
+
+// a density file with one invalid density, at a voxel in the middle of the grid
+bool throwsOnDensity(const std::string& name, float invalid_density) {
+    TestUtils::writeNIfTI(TEST_DIR.file(name + ".nii.gz"), DIM_VOX, SPACING,
+                          TestUtils::makeVoxels<float>(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        return voxel_index == DIM_VOX / 2 ? invalid_density : getDensity(voxel_index);
+    }));
+    std::string json_filename = TestUtils::writeFile(TEST_DIR.file(name + ".json"), "{" + BACKGROUND + R"json(,
+        "voxel_grids": [{"file_path": "phantom.nii.gz", "density_file_path": ")json" + name + R"json(.nii.gz", "origin": [1, 1, 1]}]})json");
+    return TestUtils::throws([&]() { ComputationalDomain comp_domain(json_filename); });
+}
+
+int main() {
+    TestUtils::writeNIfTI(TEST_DIR.file("phantom.nii.gz"), DIM_VOX, SPACING, TestUtils::makeVoxels<uint8_t>(DIM_VOX, getMaterialId));
+    TestUtils::writeNIfTI(TEST_DIR.file("densities.nii.gz"), DIM_VOX, SPACING, TestUtils::makeVoxels<float>(DIM_VOX, getDensity));
+    std::string json_filename = TestUtils::writeFile(TEST_DIR.file("domain.json"), "{" + BACKGROUND + R"json(,
+        "voxel_grids": [{"file_path": "phantom.nii.gz", "density_file_path": "densities.nii.gz", "origin": [1, 1, 1]}]})json");
+    ComputationalDomain comp_domain(json_filename);
+    InteractionData interaction_data = comp_domain.getInteractionData();
+    const ElementDatabase& database = ElementDatabase::getInstance();
+    std::vector<double> energies = getEnergies();
+
+    bool scales_passed = true;
+    bool majorant_passed = true;
+    std::unordered_map<int, double> max_density_scales;
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        int material_id = getMaterialId(voxel_index);
+        double density = getDensity(voxel_index);
+        double nominal_density = database.getMaterialDensity(material_id);
+        Voxel voxel = comp_domain.getVoxel(Eigen::Vector3d::Ones() + TestUtils::voxelCenter(voxel_index, SPACING));
+        scales_passed = scales_passed && std::abs(voxel.density_scale - density / nominal_density) <= RELATIVE_TOLERANCE * density / nominal_density;
+        max_density_scales[material_id] = std::max(max_density_scales[material_id], static_cast<double>(voxel.density_scale));
+
+        auto& material_data = interaction_data.getMaterialFromId(material_id).getData();
+        for (double energy : energies) {
+            // the cross section of the voxel as delta tracking computes it
+            double cross_section = voxel.density_scale * material_data.interpolateTotalCrossSection(energy);
+            majorant_passed = majorant_passed && interaction_data.interpolateMaxTotalCrossSection(energy) >= cross_section * (1 - 1E-9);
+        }
+    });
+
+    bool passed = TestUtils::report("density scale factors", scales_passed);
+    bool max_scales_passed = true;
+    for (const auto& max_density_scale : max_density_scales) {
+        max_scales_passed = max_scales_passed && comp_domain.getMaxDensityScales().at(max_density_scale.first) == max_density_scale.second &&
+                            interaction_data.getMaxDensityScale(max_density_scale.first) == max_density_scale.second;
+    }
+    passed = TestUtils::report("largest density scale factor of each material", max_scales_passed && max_density_scales.size() == 3) && passed;
+    passed = TestUtils::report("majorant at least every scaled total cross section", majorant_passed) && passed;
+    passed = checkTransmission() && passed;
+    passed = TestUtils::report("negative density throws", throwsOnDensity("negative_densities", -1.0f)) && passed;
+    passed = TestUtils::report("NaN density throws", throwsOnDensity("nan_densities", std::numeric_limits<float>::quiet_NaN())) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <map>
+#include <random>
+
+// Builds the downsampled resolution levels of a voxel grid of random materials and densities, and checks every voxel
+// of each level against a brute-force majority vote of its block: the material most of the voxels have (the lowest ID
+// on a tie) and the mean density scale factor of those voxels. Also checks that every voxel of the full resolution
+// scores its energy in a voxel of its block which has the voted material, with and without an octree.
+
+const TestUtils::TestDirectory TEST_DIR("downsampled_levels");
+const Eigen::Vector3i DIM_VOX(19, 13, 11); // not multiples of 8, so the blocks at the upper faces are clipped
+const Eigen::Vector3d SPACING(0.1, 0.15, 0.2); // cm
+const double DENSITY_SCALE_TOLERANCE = 1E-6;
+
+struct Vote {
+    int material_id = 0;
+    double density_scale = 0;
+};
+
+// majority vote of the block of the full resolution voxels of a downsampled voxel
+Vote voteBlock(const Eigen::Vector3i& downsampled_index, int factor, const std::vector<uint8_t>& materials,
+               const std::vector<double>& density_scales) {
+    std::map<int, int> counts;
+    std::map<int, double> density_scale_sums;
+    const Eigen::Vector3i min_index = downsampled_index * factor;
+    const Eigen::Vector3i max_index = (min_index.array() + factor).min(DIM_VOX.array());
+    for (int k = min_index[2]; k < max_index[2]; ++k) {
+        for (int j = min_index[1]; j < max_index[1]; ++j) {
+            for (int i = min_index[0]; i < max_index[0]; ++i) {
+                int voxel_number = TestUtils::linearNumber(Eigen::Vector3i(i, j, k), DIM_VOX);
+                counts[materials[voxel_number]]++;
+                density_scale_sums[materials[voxel_number]] += density_scales[voxel_number];
+            }
+        }
+    }
+    Vote vote;
+    int majority_count = 0;
+    for (const auto& count : counts) { // in increasing order of material ID, so ties go to the lowest
+        if (count.second > majority_count) {
+            vote.material_id = count.first;
+            majority_count = count.second;
+        }
+    }
+    vote.density_scale = density_scale_sums[vote.material_id] / majority_count;
+    return vote;
+}
+
+bool checkLevels(VoxelGrid& voxel_grid, const std::vector<uint8_t>& materials) {
+    // density scale factors of the full resolution, as the voxel grid computed them from the density file
+    std::vector<double> density_scales(DIM_VOX.prod());
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        density_scales[TestUtils::linearNumber(voxel_index, DIM_VOX)] = voxel_grid.getVoxel(voxel_index).density_scale;
+    });
+
+    bool passed = true;
+    for (int level = 1; level < VoxelGrid::NUM_RESOLUTION_LEVELS; ++level) {
+        const int factor = 1 << level;
+        voxel_grid.setResolutionLevel(level);
+        bool dims_passed = voxel_grid.getDimVox(level) == ((DIM_VOX.array() + factor - 1) / factor).matrix();
+        bool votes_passed = true;
+        bool scoring_passed = true;
+        TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+            Eigen::Vector3i downsampled_index = voxel_index / factor;
+            Vote vote = voteBlock(downsampled_index, factor, materials, density_scales);
+            Voxel voxel = voxel_grid.getVoxelUnchecked(TestUtils::voxelCenter(voxel_index, SPACING));
+            votes_passed = votes_passed && voxel_grid.getMaterialIds()[voxel.materialID] == vote.material_id &&
+                           std::abs(voxel.density_scale - vote.density_scale) < DENSITY_SCALE_TOLERANCE * vote.density_scale;
+
+            // the voxel the energy is scored in: this one if it has the voted material, otherwise one of the block
+            // which has
+            int scored_number = voxel.voxel_number;
+            Eigen::Vector3i scored_index(scored_number % DIM_VOX[0], (scored_number / DIM_VOX[0]) % DIM_VOX[1],
+                                         scored_number / (DIM_VOX[0] * DIM_VOX[1]));
+            int voxel_number = TestUtils::linearNumber(voxel_index, DIM_VOX);
+            bool expected_self = materials[voxel_number] == vote.material_id;
+            scoring_passed = scoring_passed && materials[scored_number] == vote.material_id &&
+                             (scored_index / factor) == downsampled_index &&
+                             (!expected_self || scored_number == voxel_number);
+        });
+        passed = TestUtils::report("level " + std::to_string(level) + " dimensions", dims_passed) && passed;
+        passed = TestUtils::report("level " + std::to_string(level) + " majority materials and density scale factors", votes_passed) && passed;
+        passed = TestUtils::report("level " + std::to_string(level) + " energy scored in a voxel of the voted material", scoring_passed) && passed;
+    }
+
+    // back to the full resolution
+    voxel_grid.setResolutionLevel(0);
+    bool full_resolution = true;
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        Voxel voxel = voxel_grid.getVoxelUnchecked(TestUtils::voxelCenter(voxel_index, SPACING));
+        full_resolution = full_resolution && voxel_grid.getMaterialIds()[voxel.materialID] == materials[TestUtils::linearNumber(voxel_index, DIM_VOX)];
+    });
+    passed = TestUtils::report("full resolution restored", full_resolution && voxel_grid.getResolutionLevel() == 0) && passed;
+
+    return TestUtils::report("invalid level rejected", TestUtils::throws<std::out_of_range>([&]() {
+        voxel_grid.setResolutionLevel(VoxelGrid::NUM_RESOLUTION_LEVELS);
+    })) && passed;
+}
+
+int main() {
+    // materials 1, 2, 3 and 5 in clusters, so blocks have clear majorities as well as ties
+    std::mt19937_64 generator(20240428);
+    std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
+    const std::vector<uint8_t> material_choices = {1, 2, 3, 5};
+    std::vector<uint8_t> materials;
+    std::vector<float> densities;
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        bool cluster = uniform_dist(generator) < 0.6;
+        materials.push_back(cluster ? material_choices[(voxel_index[0] / 3 + voxel_index[1] / 4 + voxel_index[2] / 5) % 4] :
+                                      material_choices[static_cast<int>(uniform_dist(generator) * 4)]);
+        densities.push_back(static_cast<float>(0.5 + uniform_dist(generator)));
+    });
+    std::string filename = TEST_DIR.file("phantom.mvox");
+    VoxelFile::write(filename, DIM_VOX, SPACING, materials.data());
+    std::string density_filename = TestUtils::writeNIfTI(TEST_DIR.file("densities.nii.gz"), DIM_VOX, SPACING, densities);
+
+    bool passed = true;
+    for (bool octree : {false, true}) {
+        std::cout << (octree ? "With an octree" : "Without an octree") << std::endl;
+        VoxelGrid voxel_grid(filename, density_filename);
+        if (octree) {
+            voxel_grid.enableOctree();
+        }
+        voxel_grid.enableDoseScoring();
+        passed = checkLevels(voxel_grid, materials) && passed;
+    }
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+
+// Loads a voxel grid of Al and Pb, whose database IDs are not contiguous and are not the dense indices the
+// computational domain assigns them, and checks that each voxel looks up the material written in the file: the
+// material ID reported for each voxel, the primary transmission of a pencil beam through each material against the
+// attenuation of that material, and the energy reported for each material against the energy scored in its voxel.
+
+const TestUtils::TestDirectory TEST_DIR("material_indices");
+const Eigen::Vector3i DIM_VOX(2, 1, 1);
+const Eigen::Vector3d SPACING(1.0, 2.0, 0.05); // cm
+const Eigen::Vector3d ORIGIN(1, 1, 2); // cm
+const std::vector<std::string> MATERIAL_NAMES = {"Al", "Pb"}; // along x
+const double BEAM_ENERGY = 60E3; // eV
+const double TALLY_Z = 5.0; // cm
+const int N_PHOTONS = 20000;
+const double Z_SCORE_LIMIT = 5.0;
+
+std::vector<int> getMaterialIds() {
+    std::vector<int> material_ids;
+    for (const auto& material_name : MATERIAL_NAMES) {
+        material_ids.push_back(ElementDatabase::getInstance().getMaterialId(material_name));
+    }
+    return material_ids;
+}
+
+// center of the beam through the voxel of the material at material_number
+Eigen::Vector3d getBeamCenter(int material_number) {
+    return ORIGIN + TestUtils::voxelCenter(Eigen::Vector3i(material_number, 0, 0), SPACING);
+}
+
+double getPrimaryTransmission(ComputationalDomain& comp_domain, InteractionData& interaction_data, int material_number) {
+    Eigen::Vector3d beam_center = getBeamCenter(material_number);
+    PhotonSource source(std::make_unique<MonoenergeticSpectrum>(MonoenergeticSpectrum(BEAM_ENERGY)),
+                        std::make_unique<BeamDirectionality>(BeamDirectionality(Eigen::Vector3d(beam_center[0], beam_center[1], TALLY_Z))),
+                        std::make_unique<PointGeometry>(PointGeometry(Eigen::Vector3d(beam_center[0], beam_center[1], 0))));
+    auto initializeSurfaceTallies = [&]() {
+        std::vector<std::unique_ptr<SurfaceTally>> tallies;
+        tallies.emplace_back(std::make_unique<DiscSurfaceTally>(Eigen::Vector3d(beam_center[0], beam_center[1], TALLY_Z), Eigen::Vector3d(0, 0, 1),
+                                                                0.3, SurfaceQuantityContainerFactory::AllQuantities()));
+        return tallies;
+    };
+    auto initializeVolumeTallies = []() { return std::vector<std::unique_ptr<VolumeTally>>(); };
+
+    PhysicsEngine physics_engine(comp_domain, interaction_data);
+    runSimulation(source, physics_engine, initializeSurfaceTallies, initializeVolumeTallies, N_PHOTONS);
+    auto quantity_container = physics_engine.getSurfaceQuantityContainers().at(0);
+    auto& count = quantity_container.getCountQuantities().at(CountSurfaceQuantityType::NumberOfPhotons);
+    return static_cast<double>(count.getPrimaryValues().getCount()) / N_PHOTONS;
+}
+
+int main() {
+    std::vector<int> material_ids = getMaterialIds();
+    TestUtils::writeNIfTI(TEST_DIR.file("phantom.nii.gz"), DIM_VOX, SPACING, TestUtils::makeVoxels<uint8_t>(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        return static_cast<uint8_t>(material_ids[voxel_index[0]]);
+    }));
+    std::string json_filename = TestUtils::writeFile(TEST_DIR.file("domain.json"),
+            R"json({"dim_space": [4, 4, 6], "background_material_name": "Air, Dry (near sea level)",
+                    "voxel_grids": [{"file_path": "phantom.nii.gz", "origin": [1, 1, 2], "score_dose": true}]})json");
+    ComputationalDomain comp_domain(json_filename);
+    InteractionData interaction_data = comp_domain.getInteractionData();
+    bool passed = true;
+
+    std::cout << "Lookups" << std::endl;
+    bool lookups_passed = true;
+    for (size_t i = 0; i < MATERIAL_NAMES.size(); ++i) {
+        Voxel voxel = comp_domain.getVoxel(getBeamCenter(static_cast<int>(i)));
+        int material_id = comp_domain.getMaterialIds()[voxel.materialID];
+        std::cout << "    " << MATERIAL_NAMES[i] << ": database ID " << material_ids[i] << ", index " << static_cast<int>(voxel.materialID) << std::endl;
+        lookups_passed = lookups_passed && material_id == material_ids[i] &&
+                         interaction_data.getMaterialFromId(material_id).getProperties().getName() == MATERIAL_NAMES[i];
+    }
+    passed = TestUtils::report("material of each voxel", lookups_passed) && passed;
+
+    std::cout << "Transport" << std::endl;
+    int air_id = interaction_data.getAnyMaterialIdFromName("Air, Dry (near sea level)");
+    double air_cross_section = interaction_data.getMaterialFromId(air_id).getData().interpolateTotalCrossSection(BEAM_ENERGY);
+    for (size_t i = 0; i < MATERIAL_NAMES.size(); ++i) {
+        double transmission = getPrimaryTransmission(comp_domain, interaction_data, static_cast<int>(i));
+        double cross_section = interaction_data.getMaterialFromId(material_ids[i]).getData().interpolateTotalCrossSection(BEAM_ENERGY);
+        double expected_transmission = std::exp(-cross_section * SPACING[2] - air_cross_section * (TALLY_Z - SPACING[2]));
+        double sigma = std::sqrt(expected_transmission * (1 - expected_transmission) / N_PHOTONS);
+        std::cout << "    " << MATERIAL_NAMES[i] << ": transmission " << transmission << " (expected " << expected_transmission << ")" << std::endl;
+        passed = TestUtils::report("primary transmission through " + MATERIAL_NAMES[i],
+                                   std::abs(transmission - expected_transmission) < Z_SCORE_LIMIT * sigma) && passed;
+    }
+
+    // each voxel is the only voxel of its material, so the energy of a material is the energy scored in its voxel
+    std::unordered_map<int, MomentValue> energies = comp_domain.getVoxelGridN(0).getEnergyDepositedInMaterials();
+    bool energies_passed = energies.size() == MATERIAL_NAMES.size();
+    for (size_t i = 0; energies_passed && i < MATERIAL_NAMES.size(); ++i) {
+        double voxel_energy = comp_domain.getVoxelGridN(0).getDoseGrid().getValue(i).getSum(); // voxel (i, 0, 0)
+        energies_passed = energies.count(material_ids[i]) == 1 && voxel_energy > 0 &&
+                          std::abs(energies.at(material_ids[i]).getSum() - voxel_energy) <= 1E-9 * voxel_energy;
+    }
+    passed = TestUtils::report("energy deposited in each material", energies_passed) && passed;
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
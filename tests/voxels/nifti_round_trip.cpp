@@ -0,0 +1,244 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <zlib.h>
+#include <cstring>
+
+// Writes NIfTI-1 images with known headers and voxels, plain and gzip compressed, in both byte orders, and checks that
+// NIfTIReader reads back the dimensions, zooms, spatial unit, datatype and scaling, and rejects invalid images.
+
+const TestUtils::TestDirectory TEST_DIR("nifti_round_trip");
+
+struct NIfTIImage {
+    std::vector<int16_t> dims = {3, 5, 4, 3, 1, 1, 1, 1};
+    Eigen::Vector3f zooms = Eigen::Vector3f(0.5f, 0.75f, 2.0f);
+    int16_t datatype = 2;
+    int16_t bitpix = 8;
+    float scl_slope = 0.0f;
+    float scl_inter = 0.0f;
+    uint8_t xyzt_units = 2; // mm
+    std::vector<char> extension; // written after the 4 byte extension flag
+    std::vector<char> data; // in the byte order of the machine
+    int element_size = 1;
+};
+
+template <typename T>
+void putField(std::vector<char>& bytes, size_t offset, T value, bool swap_bytes) {
+    char field[sizeof(T)];
+    std::memcpy(field, &value, sizeof(T));
+    if (swap_bytes) {
+        std::reverse(field, field + sizeof(T));
+    }
+    std::memcpy(bytes.data() + offset, field, sizeof(T));
+}
+
+template <typename T>
+void setData(NIfTIImage& image, int16_t datatype, const std::vector<T>& values) {
+    image.datatype = datatype;
+    image.bitpix = static_cast<int16_t>(8 * sizeof(T));
+    image.element_size = sizeof(T);
+    image.data.resize(values.size() * sizeof(T));
+    std::memcpy(image.data.data(), values.data(), image.data.size());
+}
+
+std::vector<char> serialize(const NIfTIImage& image, bool swap_bytes) {
+    std::vector<char> bytes(352, 0);
+    putField<int32_t>(bytes, 0, 348, swap_bytes);
+    for (size_t i = 0; i < image.dims.size(); ++i) {
+        putField<int16_t>(bytes, 40 + 2 * i, image.dims[i], swap_bytes);
+    }
+    putField<int16_t>(bytes, 70, image.datatype, swap_bytes);
+    putField<int16_t>(bytes, 72, image.bitpix, swap_bytes);
+    putField<float>(bytes, 76, 1.0f, swap_bytes); // qfac
+    for (int i = 0; i < 3; ++i) {
+        putField<float>(bytes, 80 + 4 * i, image.zooms[i], swap_bytes);
+    }
+    putField<float>(bytes, 108, static_cast<float>(352 + image.extension.size()), swap_bytes);
+    putField<float>(bytes, 112, image.scl_slope, swap_bytes);
+    putField<float>(bytes, 116, image.scl_inter, swap_bytes);
+    bytes[123] = static_cast<char>(image.xyzt_units);
+    std::memcpy(bytes.data() + 344, "n+1\0", 4);
+    bytes.insert(bytes.end(), image.extension.begin(), image.extension.end());
+    for (size_t i = 0; i < image.data.size(); i += image.element_size) {
+        std::vector<char> element(image.data.begin() + i, image.data.begin() + i + image.element_size);
+        if (swap_bytes) {
+            std::reverse(element.begin(), element.end());
+        }
+        bytes.insert(bytes.end(), element.begin(), element.end());
+    }
+    return bytes;
+}
+
+std::string writeImage(const std::string& name, const NIfTIImage& image, bool compress, bool swap_bytes = false) {
+    std::string filename = TEST_DIR.file(name + (compress ? ".nii.gz" : ".nii"));
+    std::vector<char> bytes = serialize(image, swap_bytes);
+    gzFile file = gzopen(filename.c_str(), compress ? "wb" : "wbT"); // T writes without compression
+    gzwrite(file, bytes.data(), static_cast<unsigned>(bytes.size()));
+    gzclose(file);
+    return filename;
+}
+
+bool checkHeader(const std::string& filename, const NIfTIImage& image, double units) {
+    NIfTIReader reader(filename);
+    return reader.getDimVox() == Eigen::Vector3i(image.dims[1], image.dims[2], image.dims[3]) &&
+           reader.getZooms() == image.zooms.cast<double>() && reader.getUnits() == units &&
+           reader.getNumOfVoxels() == static_cast<int64_t>(image.dims[1]) * image.dims[2] * image.dims[3];
+}
+
+// labels of every datatype which can hold them, plain and compressed, in both byte orders
+bool checkLabels() {
+    std::cout << "Labels" << std::endl;
+    std::vector<uint8_t> labels(5 * 4 * 3);
+    for (size_t i = 0; i < labels.size(); ++i) {
+        labels[i] = static_cast<uint8_t>((i * 37) % 256);
+    }
+    bool passed = true;
+    for (int16_t datatype : {2, 4, 8, 16, 64, 512}) {
+        NIfTIImage image;
+        switch (datatype) {
+            case 2: setData(image, datatype, labels); break;
+            case 4: setData(image, datatype, std::vector<int16_t>(labels.begin(), labels.end())); break;
+            case 8: setData(image, datatype, std::vector<int32_t>(labels.begin(), labels.end())); break;
+            case 16: setData(image, datatype, std::vector<float>(labels.begin(), labels.end())); break;
+            case 64: setData(image, datatype, std::vector<double>(labels.begin(), labels.end())); break;
+            default: setData(image, datatype, std::vector<uint16_t>(labels.begin(), labels.end())); break;
+        }
+        for (bool compress : {false, true}) {
+            for (bool swap_bytes : {false, true}) {
+                std::string filename = writeImage("labels", image, compress, swap_bytes);
+                std::vector<uint8_t> read(labels.size());
+                NIfTIReader reader(filename);
+                reader.readLabels(read.data());
+                passed = TestUtils::report("datatype " + std::to_string(datatype) + (compress ? ", compressed" : "") +
+                                           (swap_bytes ? ", swapped" : ""), checkHeader(filename, image, 0.1) && read == labels) && passed;
+            }
+        }
+    }
+    return passed;
+}
+
+// scl_slope and scl_inter are applied to values and labels, unless the slope is 0 or NaN
+bool checkScaling() {
+    std::cout << "Scaling" << std::endl;
+    NIfTIImage image;
+    std::vector<int16_t> stored(5 * 4 * 3);
+    for (size_t i = 0; i < stored.size(); ++i) {
+        stored[i] = static_cast<int16_t>(static_cast<int>(i) - 20);
+    }
+    setData(image, 4, stored);
+
+    bool passed = true;
+    for (float slope : {0.0f, std::numeric_limits<float>::quiet_NaN(), 0.25f}) {
+        image.scl_slope = slope;
+        image.scl_inter = 7.5f;
+        double expected_slope = slope == 0.25f ? 0.25 : 1.0;
+        double expected_inter = slope == 0.25f ? 7.5 : 0.0;
+        std::vector<double> values(stored.size());
+        NIfTIReader reader(writeImage("scaled", image, true));
+        reader.readValues(values.data());
+        bool values_passed = true;
+        for (size_t i = 0; i < stored.size(); ++i) {
+            values_passed = values_passed && values[i] == stored[i] * expected_slope + expected_inter;
+        }
+        passed = TestUtils::report("values with scl_slope " + std::to_string(slope), values_passed) && passed;
+    }
+
+    // labels are checked after scaling, so stored values of -10 to 49 with a slope of 2 and an intercept of 20 are
+    // labels of 0 to 118, and a slope of 0.5 gives labels which are not integers
+    for (auto& value : stored) {
+        value = static_cast<int16_t>(value + 10);
+    }
+    setData(image, 4, stored);
+    image.scl_slope = 2.0f;
+    image.scl_inter = 20.0f;
+    std::vector<uint8_t> labels(stored.size());
+    NIfTIReader reader(writeImage("scaled_labels", image, false));
+    reader.readLabels(labels.data());
+    bool labels_passed = true;
+    for (size_t i = 0; i < stored.size(); ++i) {
+        labels_passed = labels_passed && labels[i] == stored[i] * 2 + 20;
+    }
+    passed = TestUtils::report("labels with scl_slope 2", labels_passed) && passed;
+    image.scl_slope = 0.5f;
+    std::string filename = writeImage("fractional_labels", image, false);
+    passed = TestUtils::report("fractional labels rejected", TestUtils::throws([&]() {
+        NIfTIReader fractional_reader(filename);
+        fractional_reader.readLabels(labels.data());
+    })) && passed;
+    return passed;
+}
+
+// spatial unit codes, an extension before the data, and an image larger than the decompression chunk
+bool checkLayout() {
+    std::cout << "Header" << std::endl;
+    bool passed = true;
+    const std::vector<std::pair<uint8_t, double>> units = {{0, 0.1}, {1, 100.0}, {2, 0.1}, {3, 1e-4}, {2 | 8, 0.1}};
+    for (const auto& unit : units) {
+        NIfTIImage image;
+        image.xyzt_units = unit.first;
+        setData(image, 2, std::vector<uint8_t>(5 * 4 * 3, 1));
+        passed = TestUtils::report("xyzt_units " + std::to_string(unit.first), checkHeader(writeImage("units", image, true), image, unit.second)) && passed;
+    }
+
+    NIfTIImage image;
+    image.dims = {3, 64, 48, 40, 1, 1, 1, 1};
+    image.extension = std::vector<char>(32, 'x');
+    image.extension[0] = 1; // the extension flag
+    std::vector<float> densities(64 * 48 * 40);
+    for (size_t i = 0; i < densities.size(); ++i) {
+        densities[i] = 0.001f * static_cast<float>(i % 2000);
+    }
+    setData(image, 16, densities);
+    std::string filename = writeImage("large", image, true);
+    std::vector<double> values(densities.size());
+    NIfTIReader reader(filename);
+    reader.readValues(values.data());
+    passed = TestUtils::report("extension and more voxels than a chunk", checkHeader(filename, image, 0.1) &&
+                               std::equal(values.begin(), values.end(), densities.begin(), [](double value, float density) {
+                                   return value == static_cast<double>(density);
+                               })) && passed;
+    passed = TestUtils::report("second read rejected", TestUtils::throws([&]() { reader.readValues(values.data()); })) && passed;
+    return passed;
+}
+
+bool checkInvalid() {
+    std::cout << "Invalid images" << std::endl;
+    bool passed = true;
+    NIfTIImage image;
+    setData(image, 2, std::vector<uint8_t>(5 * 4 * 3, 1));
+
+    NIfTIImage four_d = image;
+    four_d.dims = {4, 5, 4, 3, 2, 1, 1, 1};
+    std::string four_d_filename = writeImage("four_d", four_d, true);
+    passed = TestUtils::report("4D image rejected", TestUtils::throws([&]() { NIfTIReader reader(four_d_filename); })) && passed;
+
+    NIfTIImage unsupported = image;
+    unsupported.datatype = 128; // RGB24
+    std::string unsupported_filename = writeImage("unsupported", unsupported, false);
+    std::vector<double> values(5 * 4 * 3);
+    passed = TestUtils::report("unsupported datatype rejected", TestUtils::throws([&]() {
+        NIfTIReader reader(unsupported_filename);
+        reader.readValues(values.data());
+    })) && passed;
+
+    NIfTIImage truncated = image;
+    truncated.data.resize(truncated.data.size() / 2);
+    std::string truncated_filename = writeImage("truncated", truncated, true);
+    passed = TestUtils::report("truncated image rejected", TestUtils::throws([&]() {
+        NIfTIReader reader(truncated_filename);
+        reader.readValues(values.data());
+    })) && passed;
+
+    std::string not_nifti_filename = TEST_DIR.file("not_nifti.nii");
+    std::ofstream(not_nifti_filename) << std::string(400, 'x');
+    passed = TestUtils::report("non-NIfTI file rejected", TestUtils::throws([&]() { NIfTIReader reader(not_nifti_filename); })) && passed;
+    return passed;
+}
+
+int main() {
+    bool passed = checkLabels();
+    passed = checkScaling() && passed;
+    passed = checkLayout() && passed;
+    passed = checkInvalid() && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
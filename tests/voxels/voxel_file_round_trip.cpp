@@ -0,0 +1,126 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+
+// Writes MIDSX voxel files, maps them back with VoxelFile and checks the dimensions, spacing, material IDs and
+// voxels. Checks that a voxel file converted from a NIfTI image loads into the same VoxelGrid as the image, that
+// truncated files and files with an invalid header are rejected on open, and that verify rejects files whose voxels
+// do not match the checksum or the material IDs of their header.
+
+const TestUtils::TestDirectory TEST_DIR("voxel_file_round_trip");
+const Eigen::Vector3i DIM_VOX(37, 29, 23); // not multiples of the brick or page size
+const Eigen::Vector3d SPACING(0.05, 0.075, 0.2); // cm
+// offsets of fields of the header of a voxel file
+const size_t VERSION_OFFSET = 8;
+const size_t NUM_MATERIALS_OFFSET = 12;
+const size_t MATERIAL_IDS_OFFSET = 80;
+
+// spheres of the database materials 2, 3 and 5 in a block of material 1
+uint8_t getMaterialId(const Eigen::Vector3i& voxel_index) {
+    int r_sq = (voxel_index - Eigen::Vector3i(18, 14, 11)).squaredNorm();
+    return r_sq < 25 ? 5 : r_sq < 64 ? 2 : r_sq < 100 ? 3 : 1;
+}
+
+// overwrites bytes of a copy of a voxel file
+std::string patchCopy(const std::string& filename, const std::string& name, size_t offset, const std::vector<char>& bytes) {
+    std::string copy = TEST_DIR.file(name + ".mvox");
+    std::filesystem::copy_file(filename, copy, std::filesystem::copy_options::overwrite_existing);
+    std::fstream file(copy, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    return copy;
+}
+
+bool checkRoundTrip(const std::vector<uint8_t>& materials, const std::string& filename) {
+    std::cout << "Round trip" << std::endl;
+    VoxelFile::write(filename, DIM_VOX, SPACING, materials.data());
+    VoxelFile voxel_file(filename);
+    bool passed = TestUtils::report("dimensions and spacing", voxel_file.getDimVox() == DIM_VOX && voxel_file.getSpacing() == SPACING);
+    passed = TestUtils::report("material IDs", voxel_file.getMaterialIds() == std::vector<int>({1, 2, 3, 5})) && passed;
+    passed = TestUtils::report("voxels", std::equal(materials.begin(), materials.end(), voxel_file.getMaterials())) && passed;
+    passed = TestUtils::report("voxels page aligned", reinterpret_cast<uintptr_t>(voxel_file.getMaterials()) % VoxelFile::DATA_OFFSET == 0) && passed;
+    passed = TestUtils::report("extension", VoxelFile::isVoxelFile(filename) && !VoxelFile::isVoxelFile("phantom.nii.gz")) && passed;
+    return passed;
+}
+
+bool checkConversion(const std::vector<uint8_t>& materials, const std::string& filename) {
+    std::cout << "NIfTI conversion" << std::endl;
+    std::string nifti_filename = TestUtils::writeNIfTI(TEST_DIR.file("phantom.nii.gz"), DIM_VOX, SPACING, materials);
+    std::string converted_filename = TEST_DIR.file("converted.mvox");
+    VoxelFile::convertNIfTI(nifti_filename, converted_filename);
+    bool passed;
+    {
+        VoxelFile converted(converted_filename);
+        passed = TestUtils::report("voxels", std::equal(materials.begin(), materials.end(), converted.getMaterials()));
+        passed = TestUtils::report("spacing in cm", converted.getSpacing().isApprox(SPACING, 1e-6)) && passed;
+    }
+
+    // both load into the same voxel grid
+    VoxelGrid nifti_grid(nifti_filename);
+    VoxelGrid mapped_grid(filename);
+    bool voxels_match = nifti_grid.getMaterialIds() == mapped_grid.getMaterialIds();
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        int material_id = mapped_grid.getMaterialIds()[mapped_grid.getVoxel(voxel_index).materialID];
+        voxels_match = voxels_match && material_id == materials[TestUtils::linearNumber(voxel_index, DIM_VOX)] &&
+                       nifti_grid.getVoxel(voxel_index).materialID == mapped_grid.getVoxel(voxel_index).materialID;
+    });
+    passed = TestUtils::report("VoxelGrid of the NIfTI image and of the voxel file", voxels_match &&
+                               nifti_grid.getVoxelPosition(DIM_VOX - Eigen::Vector3i::Ones()).isApprox(mapped_grid.getVoxelPosition(DIM_VOX - Eigen::Vector3i::Ones()), 1e-6)) && passed;
+    return passed;
+}
+
+// the header is trusted on open, and verify checks the voxels against it
+bool checkVerify(const std::string& filename) {
+    std::cout << "Verification" << std::endl;
+    auto verifies = [](const std::string& name) {
+        return !TestUtils::throws([&]() {
+            VoxelFile voxel_file(name);
+            voxel_file.verify();
+        });
+    };
+    bool passed = TestUtils::report("valid file verified", verifies(filename));
+
+    // a voxel of material 1 changed to material 2, which is in the header
+    std::string changed = patchCopy(filename, "changed", VoxelFile::DATA_OFFSET + 1, {2});
+    passed = TestUtils::report("voxel which does not match the checksum rejected", !verifies(changed)) && passed;
+    // the header lists materials 1, 2, 3 and 5, so after dropping one a voxel of material 5 is not in it
+    uint32_t num_materials = 3;
+    std::vector<char> num_materials_bytes(sizeof(num_materials));
+    std::memcpy(num_materials_bytes.data(), &num_materials, sizeof(num_materials));
+    std::string dropped = patchCopy(filename, "dropped", NUM_MATERIALS_OFFSET, num_materials_bytes);
+    passed = TestUtils::report("material dropped from the header rejected", !verifies(dropped)) && passed;
+    return passed;
+}
+
+bool checkInvalid(const std::string& filename) {
+    std::cout << "Invalid files" << std::endl;
+    bool passed = true;
+
+    std::string duplicate_material = patchCopy(filename, "duplicate_material", MATERIAL_IDS_OFFSET + 1, {1});
+    passed = TestUtils::report("material listed twice rejected", TestUtils::throws([&]() { VoxelFile voxel_file(duplicate_material); })) && passed;
+    uint32_t version = 2;
+    std::vector<char> version_bytes(sizeof(version));
+    std::memcpy(version_bytes.data(), &version, sizeof(version));
+    std::string other_version = patchCopy(filename, "other_version", VERSION_OFFSET, version_bytes);
+    passed = TestUtils::report("other format version rejected", TestUtils::throws([&]() { VoxelFile voxel_file(other_version); })) && passed;
+    std::string bad_magic = patchCopy(filename, "bad_magic", 0, {'N'});
+    passed = TestUtils::report("bad magic rejected", TestUtils::throws([&]() { VoxelFile voxel_file(bad_magic); })) && passed;
+
+    std::string truncated = patchCopy(filename, "truncated", 0, {});
+    std::filesystem::resize_file(truncated, VoxelFile::DATA_OFFSET + DIM_VOX.prod() - 1);
+    passed = TestUtils::report("truncated file rejected", TestUtils::throws([&]() { VoxelFile voxel_file(truncated); })) && passed;
+    std::filesystem::resize_file(truncated, 100);
+    passed = TestUtils::report("file shorter than the header rejected", TestUtils::throws([&]() { VoxelFile voxel_file(truncated); })) && passed;
+    passed = TestUtils::report("missing file rejected", TestUtils::throws([&]() { VoxelFile voxel_file(TEST_DIR.file("missing.mvox")); })) && passed;
+    return passed;
+}
+
+int main() {
+    std::vector<uint8_t> materials = TestUtils::makeVoxels<uint8_t>(DIM_VOX, getMaterialId);
+    std::string filename = TEST_DIR.file("phantom.mvox");
+    bool passed = checkRoundTrip(materials, filename);
+    passed = checkConversion(materials, filename) && passed;
+    passed = checkVerify(filename) && passed;
+    passed = checkInvalid(filename) && passed;
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include <MIDSX/Core.h>
+#include "test_utils.h"
+#include <set>
+
+// Loads the same voxel grid, with a density file, in the linear and the bricked layout, and checks that every voxel
+// has the same material, density scale factor and dose in both, with and without an octree. The voxel numbers of the
+// bricked layout are checked to be distinct and against a direct computation of the Morton order of the bricks and of
+// the voxels within them.
+
+const TestUtils::TestDirectory TEST_DIR("voxel_layouts");
+const Eigen::Vector3i DIM_VOX(37, 20, 17); // not multiples of the brick size, and not the same number of bricks along each axis
+const Eigen::Vector3d SPACING(0.1, 0.1, 0.2); // cm
+const int BRICK_SIZE = 8;
+
+uint64_t mortonCode(const Eigen::Vector3i& index) {
+    uint64_t code = 0;
+    for (int bit = 0; bit < 21; ++bit) {
+        for (int i = 0; i < 3; ++i) {
+            code |= static_cast<uint64_t>((index[i] >> bit) & 1) << (3 * bit + i);
+        }
+    }
+    return code;
+}
+
+// voxel number in the bricked layout: the rank of the brick in Morton order of the bricks, times the voxels of a
+// brick, plus the Morton code of the voxel within its brick
+int brickedNumber(const Eigen::Vector3i& voxel_index) {
+    const Eigen::Vector3i dim_bricks = (DIM_VOX.array() + BRICK_SIZE - 1) / BRICK_SIZE;
+    const Eigen::Vector3i brick_index = voxel_index / BRICK_SIZE;
+    int rank = 0;
+    for (int k = 0; k < dim_bricks[2]; ++k) {
+        for (int j = 0; j < dim_bricks[1]; ++j) {
+            for (int i = 0; i < dim_bricks[0]; ++i) {
+                rank += mortonCode(Eigen::Vector3i(i, j, k)) < mortonCode(brick_index) ? 1 : 0;
+            }
+        }
+    }
+    const Eigen::Vector3i brick_voxel_index = voxel_index - brick_index * BRICK_SIZE;
+    return rank * BRICK_SIZE * BRICK_SIZE * BRICK_SIZE + static_cast<int>(mortonCode(brick_voxel_index));
+}
+
+bool checkVoxelNumbers(VoxelGrid& bricked) {
+    std::set<int> voxel_numbers;
+    bool reference_passed = true;
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        int voxel_number = bricked.getVoxelNumber(voxel_index);
+        voxel_numbers.insert(voxel_number);
+        reference_passed = reference_passed && voxel_number == brickedNumber(voxel_index);
+    });
+    bool passed = TestUtils::report("voxel numbers match the Morton order", reference_passed);
+    return TestUtils::report("voxel numbers distinct", static_cast<int>(voxel_numbers.size()) == DIM_VOX.prod()) && passed;
+}
+
+// same material, density scale factor and dose of every voxel, looked up by index and by position
+bool checkVoxels(VoxelGrid& linear, VoxelGrid& bricked) {
+    bool voxels_match = linear.getMaterialIds() == bricked.getMaterialIds();
+    bool doses_match = true;
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        Voxel linear_voxel = linear.getVoxel(voxel_index);
+        Voxel bricked_voxel = bricked.getVoxel(voxel_index);
+        Voxel bricked_voxel_at_position = bricked.getVoxelUnchecked(TestUtils::voxelCenter(voxel_index, SPACING));
+        voxels_match = voxels_match && TestUtils::sameRegion(linear_voxel, bricked_voxel) &&
+                       bricked_voxel_at_position.materialID == bricked_voxel.materialID &&
+                       bricked_voxel_at_position.voxel_number == bricked_voxel.voxel_number &&
+                       linear_voxel.voxel_number == TestUtils::linearNumber(voxel_index, DIM_VOX);
+        doses_match = doses_match && linear.getDoseGrid().getValue(linear_voxel.voxel_number).getSum() ==
+                                     bricked.getDoseGrid().getValue(bricked_voxel.voxel_number).getSum();
+    });
+    bool passed = TestUtils::report("materials and density scale factors", voxels_match);
+    passed = TestUtils::report("doses", doses_match) && passed;
+
+    auto linear_energies = linear.getEnergyDepositedInMaterials();
+    auto bricked_energies = bricked.getEnergyDepositedInMaterials();
+    bool energies_match = linear_energies.size() == bricked_energies.size();
+    for (const auto& energy : linear_energies) {
+        energies_match = energies_match && bricked_energies.count(energy.first) &&
+                         std::abs(energy.second.getSum() - bricked_energies.at(energy.first).getSum()) <= 1e-9 * energy.second.getSum() &&
+                         energy.second.getCount() == bricked_energies.at(energy.first).getCount();
+    }
+    return TestUtils::report("energy deposited in each material", energies_match) && passed;
+}
+
+// deposits an energy which depends on the voxel index in every voxel, through the dose grid of the voxel
+void scoreDoses(VoxelGrid& voxel_grid) {
+    voxel_grid.enableDoseScoring();
+    TestUtils::forEachVoxel(DIM_VOX, [&](const Eigen::Vector3i& voxel_index) {
+        Voxel voxel = voxel_grid.getVoxel(voxel_index);
+        voxel.dose_grid->addValue(voxel.voxel_number, 1000.0 + TestUtils::linearNumber(voxel_index, DIM_VOX));
+    });
+}
+
+int main() {
+    // slabs of the database materials 1, 2 and 5 along x, with densities which vary along z
+    std::string filename = TEST_DIR.file("phantom.mvox");
+    std::vector<uint8_t> materials = TestUtils::writeVoxelFile(filename, DIM_VOX, SPACING, [](const Eigen::Vector3i& voxel_index) {
+        return static_cast<uint8_t>(voxel_index[0] < 12 ? 1 : voxel_index[0] < 25 ? 2 : 5);
+    });
+    const std::unordered_map<int, float> nominal_densities = {{1, 1.0f}, {2, 2.699f}, {5, 1.03f}};
+    auto getDensity = [&](const Eigen::Vector3i& voxel_index) {
+        return nominal_densities.at(materials[TestUtils::linearNumber(voxel_index, DIM_VOX)]) * (0.9f + 0.01f * static_cast<float>(voxel_index[2]));
+    };
+    std::string density_filename = TestUtils::writeNIfTI(TEST_DIR.file("densities.nii.gz"), DIM_VOX, SPACING,
+                                                         TestUtils::makeVoxels<float>(DIM_VOX, getDensity));
+
+    bool passed = true;
+    for (bool octree : {false, true}) {
+        std::cout << (octree ? "With an octree" : "Without an octree") << std::endl;
+        VoxelGrid linear(filename, density_filename, VoxelLayout::LINEAR);
+        VoxelGrid bricked(filename, density_filename, VoxelLayout::BRICKED);
+        if (octree) {
+            linear.enableOctree();
+            bricked.enableOctree();
+        }
+        passed = TestUtils::report("layouts", linear.getLayout() == VoxelLayout::LINEAR && bricked.getLayout() == VoxelLayout::BRICKED) && passed;
+        passed = checkVoxelNumbers(bricked) && passed;
+        scoreDoses(linear);
+        scoreDoses(bricked);
+        passed = checkVoxels(linear, bricked) && passed;
+    }
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}